@@ -33,7 +33,9 @@ SOURCES += main.cpp\
     geolib/csToken.cc \
     geolib/csTimeStretch.cc \
     geolib/csTimer.cc \
+    geolib/csTimeline.cc \
     geolib/csTableNew.cc \
+    geolib/csTableCache.cc \
     geolib/csTableAll.cc \
     geolib/csTable.cc \
     geolib/csStandardHeaders.cc \
@@ -45,6 +47,8 @@ SOURCES += main.cpp\
     geolib/csNMOCorrection.cc \
     geolib/csIReader.cc \
     geolib/csIOSelection.cc \
+    geolib/csHeaderIndex.cc \
+    geolib/csThread.cc \
     geolib/csInterpolation.cc \
     geolib/csHeaderInfo.cc \
     geolib/csGeolibUtils.cc \
@@ -70,6 +74,13 @@ SOURCES += main.cpp\
     io/csRSFHeader.cc \
     io/csGeneralSeismicReader.cc \
     io/csASCIIFileReader.cc \
+    io/csBrickVolumeHeader.cc \
+    io/csBrickVolumeWriter.cc \
+    io/csBrickVolumeReader.cc \
+    io/csBrickVolumeConverter.cc \
+    io/csSegyHeader.cc \
+    io/csSegyReader.cc \
+    io/csSegyWriter.cc \
     segd/csStandardSegdHeader.cc \
     segd/csSegdReader.cc \
     segd/csSegdHeader_SEAL.cc \
@@ -92,6 +103,8 @@ SOURCES += main.cpp\
     system/csTraceHeader.cc \
     system/csTraceGather.cc \
     system/csTraceData.cc \
+    system/csTraceDataAllocator.cc \
+    system/csTraceSpillFile.cc \
     system/csTrace.cc \
     system/csTableManagerNew.cc \
     system/csTableManager.cc \
@@ -103,6 +116,8 @@ SOURCES += main.cpp\
     system/csParamManager.cc \
     system/csParamDef.cc \
     system/csMemoryPoolManager.cc \
+    system/csModuleProfile.cc \
+    system/csJobScheduler.cc \
     system/csLogWriter.cc \
     system/csInitExecEnv.cc \
     system/csExecPhaseDef.cc \
@@ -127,10 +142,12 @@ HEADERS  += mainwindow.h \
     geolib/csToken.h \
     geolib/csTimeStretch.h \
     geolib/csTimer.h \
+    geolib/csTimeline.h \
     geolib/csTimeFunction.h \
     geolib/csTime.h \
     geolib/csTableValueList.h \
     geolib/csTableNew.h \
+    geolib/csTableCache.h \
     geolib/csTableAll.h \
     geolib/csTable.h \
     geolib/csStandardHeaders.h \
@@ -144,6 +161,7 @@ HEADERS  += mainwindow.h \
     geolib/csSelection.h \
     geolib/csRotation.h \
     geolib/csQueue.h \
+    geolib/csBoundedQueue.h \
     geolib/csNMOCorrection.h \
     geolib/csMatrixFStyle.h \
     geolib/csMathFunction.h \
@@ -151,6 +169,8 @@ HEADERS  += mainwindow.h \
     geolib/csKey.h \
     geolib/csIReader.h \
     geolib/csIOSelection.h \
+    geolib/csHeaderIndex.h \
+    geolib/csThread.h \
     geolib/csInterpolation.h \
     geolib/csHeaderInfo.h \
     geolib/csGeolibUtils.h \
@@ -183,6 +203,13 @@ HEADERS  += mainwindow.h \
     io/csIODefines.h \
     io/csGeneralSeismicReader.h \
     io/csASCIIFileReader.h \
+    io/csBrickVolumeHeader.h \
+    io/csBrickVolumeWriter.h \
+    io/csBrickVolumeReader.h \
+    io/csBrickVolumeConverter.h \
+    io/csSegyHeader.h \
+    io/csSegyReader.h \
+    io/csSegyWriter.h \
     segd/csStandardSegdHeader.h \
     segd/csSegdReader.h \
     segd/csSegdHeader_SEAL.h \
@@ -205,8 +232,11 @@ HEADERS  += mainwindow.h \
     system/csTraceHeaderDef.h \
     system/csTraceHeaderData.h \
     system/csTraceHeader.h \
+    system/csHeaderRef.h \
     system/csTraceGather.h \
     system/csTraceData.h \
+    system/csTraceDataAllocator.h \
+    system/csTraceSpillFile.h \
     system/csTrace.h \
     system/csTableManagerNew.h \
     system/csTableManager.h \
@@ -216,6 +246,9 @@ HEADERS  += mainwindow.h \
     system/csSeismicWriter.h \
     system/csSeismicReader.h \
     system/csRunManager.h \
+    system/csPipelineStage.h \
+    system/csPipelineReplicaStage.h \
+    system/csPipelineEnsembleStage.h \
     system/csParamManager.h \
     system/csParamDescription.h \
     system/csParamDef.h \
@@ -223,6 +256,8 @@ HEADERS  += mainwindow.h \
     system/csModule.h \
     system/csMethodRetriever.h \
     system/csMemoryPoolManager.h \
+    system/csModuleProfile.h \
+    system/csJobScheduler.h \
     system/csLogWriter.h \
     system/csInitExecEnv.h \
     system/csHelp.h \
@@ -235,4 +270,9 @@ HEADERS  += mainwindow.h \
 
 FORMS    += mainwindow.ui
 
+LIBS     += -lpthread
 
+
+
+# Link all standard modules statically instead of loading them at run time (requires cseis_modules_all.h)
+#DEFINES  += CS_STATIC_MODULES
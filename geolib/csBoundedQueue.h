@@ -0,0 +1,195 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_BOUNDED_QUEUE_H
+#define CS_BOUNDED_QUEUE_H
+
+#include "geolib_defines.h"
+#include "csThread.h"
+#include "csTimeline.h"
+
+namespace cseis_geolib {
+
+/**
+ * Bounded single-producer/single-consumer queue
+ *
+ * Fixed-size ring buffer for passing items from exactly one producer thread to exactly one consumer thread.
+ * As long as the queue is neither full nor empty, push() and pop() only update the ring buffer indices,
+ * without taking a lock. A thread that has to wait (producer: queue full, consumer: queue empty) spins for
+ * a short while and then sleeps on a condition variable until the other side wakes it up.
+ *
+ * The producer calls close() after the last item has been pushed. abort() releases all waiting threads,
+ * for example when an error occurred in another thread.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+template<typename T>
+class csBoundedQueue {
+public:
+  /**
+   * @param capacity  Maximum number of items in queue. Rounded up to the next power of two
+   */
+  csBoundedQueue( int capacity );
+  ~csBoundedQueue();
+  /**
+   * Push item to end of queue. Wait while queue is full. Producer thread only.
+   * @return false if queue has been aborted
+   */
+  bool push( T const& item );
+  /**
+   * Pop item from front of queue. Wait while queue is empty. Consumer thread only.
+   * @return false if queue has been closed and all items have been popped, or if queue has been aborted
+   */
+  bool pop( T& item );
+  /**
+   * Retrieve item at front of queue without removing it. Wait while queue is empty. Consumer thread only.
+   * @return false if queue has been closed and all items have been popped, or if queue has been aborted
+   */
+  bool front( T& item );
+  /**
+   * Signal that no more items will be pushed. Producer thread only.
+   */
+  void close();
+  /**
+   * Abort queue. All subsequent and currently waiting push/pop operations return false.
+   * May be called from any thread.
+   */
+  void abort();
+  bool isAborted() const { return( __atomic_load_n( &myIsAborted, __ATOMIC_ACQUIRE ) != 0 ); }
+  int capacity() const { return myCapacity; }
+  /// @return Number of items currently in queue. Only approximate while other threads access the queue
+  int size() const {
+    return (int)( __atomic_load_n( &myTail, __ATOMIC_ACQUIRE ) - __atomic_load_n( &myHead, __ATOMIC_ACQUIRE ) );
+  }
+
+private:
+  /// Number of polls before a waiting thread goes to sleep
+  static int const NUM_SPINS = 200;
+  bool waitNotEmpty();
+  bool waitNotFull();
+
+  T* myItems;
+  int myCapacity;
+  csInt64_t myMask;
+  // Producer and consumer indices are kept on separate cache lines
+  char myPad0[64];
+  /// Index of next item to pop. Written by consumer thread only
+  csInt64_t myHead;
+  char myPad1[64];
+  /// Index of next item to push. Written by producer thread only
+  csInt64_t myTail;
+  char myPad2[64];
+  int myIsClosed;
+  int myIsAborted;
+  int myIsConsumerWaiting;
+  int myIsProducerWaiting;
+  csMutex myMutex;
+  csCondition myCondNotEmpty;
+  csCondition myCondNotFull;
+
+  csBoundedQueue( csBoundedQueue const& obj );
+  csBoundedQueue& operator=( csBoundedQueue const& obj );
+};
+
+//-------------------------------------------------
+template<typename T> csBoundedQueue<T>::csBoundedQueue( int capacity ) {
+  myCapacity = 1;
+  while( myCapacity < capacity ) myCapacity *= 2;
+  myMask  = myCapacity - 1;
+  myItems = new T[myCapacity];
+  myHead  = 0;
+  myTail  = 0;
+  myIsClosed  = 0;
+  myIsAborted = 0;
+  myIsConsumerWaiting = 0;
+  myIsProducerWaiting = 0;
+}
+template<typename T> csBoundedQueue<T>::~csBoundedQueue() {
+  delete [] myItems;
+}
+//-------------------------------------------------
+template<typename T> bool csBoundedQueue<T>::push( T const& item ) {
+  if( !waitNotFull() ) return false;
+  csInt64_t tail = myTail;
+  myItems[tail & myMask] = item;
+  __atomic_store_n( &myTail, tail+1, __ATOMIC_SEQ_CST );
+  // Consumer sets its waiting flag before re-checking the tail index, so either it sees the new item or we see the flag
+  if( __atomic_load_n( &myIsConsumerWaiting, __ATOMIC_SEQ_CST ) ) {
+    myMutex.lock();
+    myCondNotEmpty.signal();
+    myMutex.unlock();
+  }
+  return true;
+}
+//-------------------------------------------------
+template<typename T> bool csBoundedQueue<T>::pop( T& item ) {
+  if( !waitNotEmpty() ) return false;
+  csInt64_t head = myHead;
+  item = myItems[head & myMask];
+  __atomic_store_n( &myHead, head+1, __ATOMIC_SEQ_CST );
+  if( __atomic_load_n( &myIsProducerWaiting, __ATOMIC_SEQ_CST ) ) {
+    myMutex.lock();
+    myCondNotFull.signal();
+    myMutex.unlock();
+  }
+  return true;
+}
+//-------------------------------------------------
+template<typename T> bool csBoundedQueue<T>::front( T& item ) {
+  if( !waitNotEmpty() ) return false;
+  item = myItems[myHead & myMask];
+  return true;
+}
+//-------------------------------------------------
+template<typename T> void csBoundedQueue<T>::close() {
+  __atomic_store_n( &myIsClosed, 1, __ATOMIC_SEQ_CST );
+  myMutex.lock();
+  myCondNotEmpty.broadcast();
+  myMutex.unlock();
+}
+template<typename T> void csBoundedQueue<T>::abort() {
+  __atomic_store_n( &myIsAborted, 1, __ATOMIC_SEQ_CST );
+  myMutex.lock();
+  myCondNotEmpty.broadcast();
+  myCondNotFull.broadcast();
+  myMutex.unlock();
+}
+//-------------------------------------------------
+template<typename T> bool csBoundedQueue<T>::waitNotEmpty() {
+  for( int i = 0; i < NUM_SPINS; i++ ) {
+    if( __atomic_load_n( &myTail, __ATOMIC_ACQUIRE ) != myHead ) return !isAborted();
+    if( __atomic_load_n( &myIsClosed, __ATOMIC_ACQUIRE ) || isAborted() ) break;
+  }
+  csTimeline::Event event( "wait for input", "queue" );
+  myMutex.lock();
+  __atomic_store_n( &myIsConsumerWaiting, 1, __ATOMIC_SEQ_CST );
+  while( __atomic_load_n( &myTail, __ATOMIC_SEQ_CST ) == myHead &&
+         !__atomic_load_n( &myIsClosed, __ATOMIC_SEQ_CST ) && !isAborted() ) {
+    myCondNotEmpty.wait( &myMutex );
+  }
+  __atomic_store_n( &myIsConsumerWaiting, 0, __ATOMIC_SEQ_CST );
+  myMutex.unlock();
+  return( __atomic_load_n( &myTail, __ATOMIC_ACQUIRE ) != myHead && !isAborted() );
+}
+//-------------------------------------------------
+template<typename T> bool csBoundedQueue<T>::waitNotFull() {
+  for( int i = 0; i < NUM_SPINS; i++ ) {
+    if( myTail - __atomic_load_n( &myHead, __ATOMIC_ACQUIRE ) < (csInt64_t)myCapacity ) return !isAborted();
+    if( isAborted() ) return false;
+  }
+  csTimeline::Event event( "wait for space", "queue" );
+  myMutex.lock();
+  __atomic_store_n( &myIsProducerWaiting, 1, __ATOMIC_SEQ_CST );
+  while( myTail - __atomic_load_n( &myHead, __ATOMIC_SEQ_CST ) >= (csInt64_t)myCapacity && !isAborted() ) {
+    myCondNotFull.wait( &myMutex );
+  }
+  __atomic_store_n( &myIsProducerWaiting, 0, __ATOMIC_SEQ_CST );
+  myMutex.unlock();
+  return !isAborted();
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,242 @@
+
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <algorithm>
+#include "csHeaderIndex.h"
+#include "csIReader.h"
+#include "csFlexHeader.h"
+#include "csFileUtils.h"
+#include "csException.h"
+
+#ifndef PLATFORM_WINDOWS
+extern "C" {
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+}
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+using namespace cseis_geolib;
+
+int const csHeaderIndex::SCAN_BLOCK_SIZE = 4096;
+
+namespace {
+  static char const INDEX_ID_TEXT[] = "CSHDRIDX";
+
+  /// Byte locations in index file header
+  static int const BYTE_LOC_VERSION    = 8;
+  static int const BYTE_LOC_TYPE       = 12;
+  static int const BYTE_LOC_DATA_SIZE  = 16;
+  static int const BYTE_LOC_DATA_TIME  = 24;
+  static int const BYTE_LOC_NUM_TRACES = 28;
+  static int const BYTE_LOC_NAME_LEN   = 32;
+  static int const BYTE_LOC_NAME       = 40;
+
+  struct IndexEntry {
+    double value;
+    int traceIndex;
+    bool operator<( IndexEntry const& obj ) const {
+      if( value != obj.value ) return( value < obj.value );
+      return( traceIndex < obj.traceIndex );
+    }
+  };
+}
+
+csHeaderIndex::csHeaderIndex() {
+  myFileData     = NULL;
+  myFileByteSize = 0;
+  myIsMapped     = false;
+  myValues       = NULL;
+  myTraceIndices = NULL;
+  myNumTraces    = 0;
+  myHdrType      = TYPE_UNKNOWN;
+}
+csHeaderIndex::~csHeaderIndex() {
+  close();
+}
+//--------------------------------------------------------------------
+std::string csHeaderIndex::indexFilename( std::string const& dataFilename, std::string const& headerName ) {
+  return( dataFilename + "." + headerName + ".idx" );
+}
+bool csHeaderIndex::isIndexableType( type_t hdrType ) {
+  return( hdrType == TYPE_INT || hdrType == TYPE_FLOAT || hdrType == TYPE_DOUBLE );
+}
+//--------------------------------------------------------------------
+bool csHeaderIndex::create( csIReader* reader, std::string const& dataFilename, std::string const& headerName ) {
+  if( (int)headerName.length() >= MAX_HEADER_NAME_LENGTH ) return false;
+  csInt64_t dataFileSize;
+  int dataTimeStamp;
+  if( !csFileUtils::retrieveFileInfo( dataFilename, &dataFileSize, &dataTimeStamp ) ) return false;
+  // Data file may still be in the process of being written. Do not index, see class description
+  if( (int)time(NULL) - dataTimeStamp < MIN_SOURCE_AGE_S ) return false;
+
+  type_t hdrType;
+  if( !reader->setHeaderToPeek( headerName, hdrType ) ) return false;
+  if( !isIndexableType( hdrType ) ) return false;
+
+  int numTraces = reader->numTraces();
+  IndexEntry* entries = new IndexEntry[std::max(numTraces,1)];
+  csFlexHeader* flexHdrBlock = new csFlexHeader[SCAN_BLOCK_SIZE];
+  reader->moveToTrace( 0 );
+  for( int itrc1 = 0; itrc1 < numTraces; itrc1 += SCAN_BLOCK_SIZE ) {
+    int numTracesBlock = std::min( SCAN_BLOCK_SIZE, numTraces-itrc1 );
+    if( !reader->peekHeaderValues( flexHdrBlock, itrc1, numTracesBlock ) ) {
+      delete [] entries;
+      delete [] flexHdrBlock;
+      throw( csException("csHeaderIndex::create: Error occurred when scanning header values for traces #%d-%d", itrc1+1, itrc1+numTracesBlock) );
+    }
+    for( int itrc = 0; itrc < numTracesBlock; itrc++ ) {
+      entries[itrc1+itrc].value      = flexHdrBlock[itrc].doubleValue();
+      entries[itrc1+itrc].traceIndex = itrc1+itrc;
+    }
+  }
+  delete [] flexHdrBlock;
+  reader->moveToTrace( 0 );
+  std::sort( entries, entries+numTraces );
+
+  char fileHeader[FILE_HEADER_BYTE_SIZE];
+  memset( fileHeader, 0, FILE_HEADER_BYTE_SIZE );
+  int version = VERSION;
+  int typeInt = (int)hdrType;
+  int nameLength = (int)headerName.length();
+  memcpy( &fileHeader[0], INDEX_ID_TEXT, 8 );
+  memcpy( &fileHeader[BYTE_LOC_VERSION], &version, 4 );
+  memcpy( &fileHeader[BYTE_LOC_TYPE], &typeInt, 4 );
+  memcpy( &fileHeader[BYTE_LOC_DATA_SIZE], &dataFileSize, 8 );
+  memcpy( &fileHeader[BYTE_LOC_DATA_TIME], &dataTimeStamp, 4 );
+  memcpy( &fileHeader[BYTE_LOC_NUM_TRACES], &numTraces, 4 );
+  memcpy( &fileHeader[BYTE_LOC_NAME_LEN], &nameLength, 4 );
+  memcpy( &fileHeader[BYTE_LOC_NAME], headerName.c_str(), nameLength );
+
+  // Write to temporary file first, then rename: Other jobs only ever see a complete index file
+  std::string filename = indexFilename( dataFilename, headerName );
+  char pidText[32];
+  sprintf( pidText, ".tmp%d", (int)getpid() );
+  std::string filenameTmp = filename + pidText;
+  FILE* fout = fopen( filenameTmp.c_str(), "wb" );
+  if( fout == NULL ) {
+    delete [] entries;
+    return false;
+  }
+  bool success = ( fwrite( fileHeader, FILE_HEADER_BYTE_SIZE, 1, fout ) == 1 );
+  // Write value column, then trace index column, in blocks
+  int const blockSize = 65536;
+  double* valueBlock = new double[blockSize];
+  int* indexBlock    = new int[blockSize];
+  for( int i1 = 0; i1 < numTraces && success; i1 += blockSize ) {
+    int num = std::min( blockSize, numTraces-i1 );
+    for( int i = 0; i < num; i++ ) valueBlock[i] = entries[i1+i].value;
+    success = ( (int)fwrite( valueBlock, sizeof(double), num, fout ) == num );
+  }
+  for( int i1 = 0; i1 < numTraces && success; i1 += blockSize ) {
+    int num = std::min( blockSize, numTraces-i1 );
+    for( int i = 0; i < num; i++ ) indexBlock[i] = entries[i1+i].traceIndex;
+    success = ( (int)fwrite( indexBlock, sizeof(int), num, fout ) == num );
+  }
+  delete [] valueBlock;
+  delete [] indexBlock;
+  delete [] entries;
+  success = ( fclose( fout ) == 0 ) && success;
+
+  if( !success || ::rename( filenameTmp.c_str(), filename.c_str() ) != 0 ) {
+    ::remove( filenameTmp.c_str() );
+    return false;
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+bool csHeaderIndex::open( std::string const& dataFilename, std::string const& headerName ) {
+  close();
+  csInt64_t dataFileSize;
+  int dataTimeStamp;
+  if( !csFileUtils::retrieveFileInfo( dataFilename, &dataFileSize, &dataTimeStamp ) ) return false;
+  if( (int)time(NULL) - dataTimeStamp < MIN_SOURCE_AGE_S ) return false;
+
+  std::string filename = indexFilename( dataFilename, headerName );
+  csInt64_t fileSize;
+  int timeStamp;
+  if( !csFileUtils::retrieveFileInfo( filename, &fileSize, &timeStamp ) ) return false;
+  if( fileSize < FILE_HEADER_BYTE_SIZE ) return false;
+
+#ifdef PLATFORM_WINDOWS
+  FILE* fin = fopen( filename.c_str(), "rb" );
+  if( fin == NULL ) return false;
+  myFileData = new char[fileSize];
+  bool success = ( fread( myFileData, fileSize, 1, fin ) == 1 );
+  fclose( fin );
+  myIsMapped = false;
+  myFileByteSize = fileSize;
+  if( !success ) {
+    close();
+    return false;
+  }
+#else
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if( fd < 0 ) return false;
+  void* ptr = mmap( NULL, (size_t)fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+  ::close( fd );
+  if( ptr == MAP_FAILED ) return false;
+  myFileData = (char*)ptr;
+  myIsMapped = true;
+  myFileByteSize = fileSize;
+#endif
+
+  int version;
+  int typeInt;
+  csInt64_t indexDataFileSize;
+  int indexDataTimeStamp;
+  int nameLength;
+  memcpy( &version, &myFileData[BYTE_LOC_VERSION], 4 );
+  memcpy( &typeInt, &myFileData[BYTE_LOC_TYPE], 4 );
+  memcpy( &indexDataFileSize, &myFileData[BYTE_LOC_DATA_SIZE], 8 );
+  memcpy( &indexDataTimeStamp, &myFileData[BYTE_LOC_DATA_TIME], 4 );
+  memcpy( &myNumTraces, &myFileData[BYTE_LOC_NUM_TRACES], 4 );
+  memcpy( &nameLength, &myFileData[BYTE_LOC_NAME_LEN], 4 );
+
+  if( strncmp( myFileData, INDEX_ID_TEXT, 8 ) || version != VERSION ||
+      indexDataFileSize != dataFileSize || indexDataTimeStamp != dataTimeStamp ||
+      nameLength != (int)headerName.length() || strncmp( &myFileData[BYTE_LOC_NAME], headerName.c_str(), nameLength ) ||
+      myNumTraces < 0 || fileSize != (csInt64_t)FILE_HEADER_BYTE_SIZE + (csInt64_t)myNumTraces * (csInt64_t)(sizeof(double)+sizeof(int)) ) {
+    close();
+    return false;
+  }
+  myHdrType      = (type_t)typeInt;
+  myValues       = reinterpret_cast<double const*>( &myFileData[FILE_HEADER_BYTE_SIZE] );
+  myTraceIndices = reinterpret_cast<int const*>( &myFileData[FILE_HEADER_BYTE_SIZE + (csInt64_t)myNumTraces*sizeof(double)] );
+  return true;
+}
+//--------------------------------------------------------------------
+void csHeaderIndex::close() {
+  if( myFileData != NULL ) {
+#ifndef PLATFORM_WINDOWS
+    if( myIsMapped ) {
+      munmap( myFileData, (size_t)myFileByteSize );
+    }
+    else {
+      delete [] myFileData;
+    }
+#else
+    delete [] myFileData;
+#endif
+    myFileData = NULL;
+  }
+  myFileByteSize = 0;
+  myIsMapped     = false;
+  myValues       = NULL;
+  myTraceIndices = NULL;
+  myNumTraces    = 0;
+  myHdrType      = TYPE_UNKNOWN;
+}
+//--------------------------------------------------------------------
+int csHeaderIndex::lowerBound( double value ) const {
+  return (int)( std::lower_bound( myValues, myValues+myNumTraces, value ) - myValues );
+}
+int csHeaderIndex::upperBound( double value ) const {
+  return (int)( std::upper_bound( myValues, myValues+myNumTraces, value ) - myValues );
+}
@@ -0,0 +1,89 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_HEADER_INDEX_H
+#define CS_HEADER_INDEX_H
+
+#include <string>
+#include "geolib_defines.h"
+
+namespace cseis_geolib {
+  class csIReader;
+
+/**
+ * Persistent trace header index
+ *
+ * Sidecar file holding the values of one trace header for all traces of a seismic file, sorted by header value.
+ * The file is columnar: A fixed-size file header, followed by the sorted header values (stored as double),
+ * followed by the corresponding trace indices. Traces with identical header values are stored in trace order.
+ * The index is tied to the data file by the data file's size and time stamp. A stale index is never used.
+ * Data files modified less than MIN_SOURCE_AGE_S seconds ago are neither indexed nor looked up in an existing index,
+ * since a later modification within the same second could not be detected.
+ *
+ * The index file is memory-mapped when opened, so repeated selections on the same file only touch the
+ * pages that are actually needed.
+ */
+class csHeaderIndex {
+ public:
+  static int const VERSION = 1;
+  static int const FILE_HEADER_BYTE_SIZE = 128;
+  static int const MAX_HEADER_NAME_LENGTH = 88;
+  static int const MIN_SOURCE_AGE_S = 2;
+  /// Number of traces whose header values are read in one call when creating the index
+  static int const SCAN_BLOCK_SIZE;
+
+ public:
+  csHeaderIndex();
+  ~csHeaderIndex();
+  /**
+   * @return Name of index file belonging to given seismic data file and trace header
+   */
+  static std::string indexFilename( std::string const& dataFilename, std::string const& headerName );
+  /**
+   * Create index file by scanning the given header for all traces in the data file.
+   * The index file is first written to a temporary file which is then renamed, so that concurrent jobs never see a partial index.
+   *
+   * @param reader        Reader of seismic data file, with file header already read in
+   * @param dataFilename  Name of seismic data file
+   * @param headerName    Name of trace header to index
+   * @return false if the header type cannot be indexed, the data file was modified too recently, or the index file could not be written
+   */
+  static bool create( cseis_geolib::csIReader* reader, std::string const& dataFilename, std::string const& headerName );
+  /**
+   * Open (memory-map) existing index file.
+   * @return false if the index file does not exist, is corrupt, or is out of date with regards to the data file
+   */
+  bool open( std::string const& dataFilename, std::string const& headerName );
+  void close();
+  bool isOpen() const { return myFileData != NULL; }
+
+  int numTraces() const { return myNumTraces; }
+  cseis_geolib::type_t headerType() const { return myHdrType; }
+  /// @return Header value of i'th entry in sort order
+  inline double value( int index ) const { return myValues[index]; }
+  /// @return Trace index of i'th entry in sort order
+  inline int traceIndex( int index ) const { return myTraceIndices[index]; }
+  /// @return Index of first entry with header value >= given value
+  int lowerBound( double value ) const;
+  /// @return Index of first entry with header value > given value
+  int upperBound( double value ) const;
+
+ private:
+  static bool isIndexableType( cseis_geolib::type_t hdrType );
+
+  char* myFileData;
+  csInt64_t myFileByteSize;
+  bool myIsMapped;
+  double const* myValues;
+  int const* myTraceIndices;
+  int myNumTraces;
+  cseis_geolib::type_t myHdrType;
+
+  csHeaderIndex( csHeaderIndex const& obj );
+  csHeaderIndex& operator=( csHeaderIndex const& obj );
+};
+
+} // end namespace
+
+#endif
@@ -8,10 +8,15 @@
 #include "csSelection.h"
 #include "csSortManager.h"
 #include "csVector.h"
+#include "csHeaderIndex.h"
+#include "csThread.h"
+#include <algorithm>
 
 using namespace std;
 using namespace cseis_geolib;
 
+const int csIOSelection::SCAN_BLOCK_SIZE = 4096;
+
 csIOSelection::csIOSelection( std::string const& headerName, int sortOrder, int sortMethod ) {
   myHdrName   = headerName;
   mySortOrder = sortOrder;
@@ -23,6 +28,8 @@ csIOSelection::csIOSelection( std::string const& headerName, int sortOrder, int
     mySortManager = new csSortManager( 1, sortMethod );
   }
   myCurrentSelectedIndex = -1;
+  myIsPresorted = false;
+  myNumThreads  = 1;
 }
 csIOSelection::~csIOSelection() {
   if( mySortManager != NULL ) {
@@ -34,7 +41,152 @@ csIOSelection::~csIOSelection() {
     mySelectedTraceIndexList = NULL;
   }
 }
+void csIOSelection::setNumThreads( int numThreads ) {
+  myNumThreads = std::max( 1, numThreads );
+}
+//--------------------------------------------------------------------
+void csIOSelection::scanRange( cseis_geolib::csIReader* reader, csSelection* selection, int firstTraceIndex, int lastTraceIndex, int sortOrder,
+                               cseis_geolib::csVector<int>* traceIndexList, cseis_geolib::csVector<csFlexNumber*>* valueList )
+{
+  csFlexHeader* flexHdrBlock = new csFlexHeader[SCAN_BLOCK_SIZE];
+  for( int itrc1 = firstTraceIndex; itrc1 < lastTraceIndex; itrc1 += SCAN_BLOCK_SIZE ) {
+    int numTracesBlock = std::min( SCAN_BLOCK_SIZE, lastTraceIndex-itrc1 );
+    if( !reader->peekHeaderValues( flexHdrBlock, itrc1, numTracesBlock ) ) {
+      delete [] flexHdrBlock;
+      throw( csException("csIOSelection::initialize: Error occurred when scanning header values for traces #%d-%d", itrc1+1, itrc1+numTracesBlock) );
+    }
+    for( int itrc = 0; itrc < numTracesBlock; itrc++ ) {
+      csFlexNumber value( &flexHdrBlock[itrc] );
+      if( selection->contains( &value ) ) {
+        traceIndexList->insertEnd( itrc1+itrc );
+        if( sortOrder != csIOSelection::SORT_NONE ) valueList->insertEnd( new csFlexNumber(&value,sortOrder == SORT_DECREASING) );
+      }
+    }
+  }
+  delete [] flexHdrBlock;
+}
+//--------------------------------------------------------------------
+namespace {
+  /**
+   * Worker thread scanning one contiguous range of traces with its own reader
+   */
+  class csHeaderScanThread : public csThread {
+  public:
+    csHeaderScanThread( csIReader* reader, std::string const& hdrName, std::string const& selectionText,
+                        int firstTraceIndex, int lastTraceIndex, int sortOrder ) {
+      myReader = reader;
+      myHdrName = hdrName;
+      mySelectionText = selectionText;
+      myFirstTraceIndex = firstTraceIndex;
+      myLastTraceIndex  = lastTraceIndex;
+      mySortOrder = sortOrder;
+      myIsError = false;
+    }
+    ~csHeaderScanThread() {
+      join();
+      delete myReader;
+      for( int i = 0; i < valueList.size(); i++ ) {
+        delete valueList.at(i);
+      }
+    }
+    csVector<int> traceIndexList;
+    csVector<csFlexNumber*> valueList;
+    bool myIsError;
+    std::string myErrorMessage;
+    void scan() {
+      try {
+        type_t hdrType;
+        if( !myReader->setHeaderToPeek( myHdrName, hdrType ) ) {
+          throw( csException("Trace header '%s' not found", myHdrName.c_str()) );
+        }
+        csSelection selection( 1, &hdrType );
+        selection.add( mySelectionText );
+        csIOSelection::scanRange( myReader, &selection, myFirstTraceIndex, myLastTraceIndex, mySortOrder, &traceIndexList, &valueList );
+      }
+      catch( csException& e ) {
+        myIsError = true;
+        myErrorMessage = e.getMessage();
+      }
+    }
+  protected:
+    void run() {
+      scan();
+    }
+  private:
+    csIReader* myReader;
+    std::string myHdrName;
+    std::string mySelectionText;
+    int myFirstTraceIndex;
+    int myLastTraceIndex;
+    int mySortOrder;
+  };
+}
+//--------------------------------------------------------------------
+void csIOSelection::scanParallel( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText, int numThreads,
+                                  cseis_geolib::csVector<csFlexNumber*>* valueList )
+{
+  int numTraces = reader->numTraces();
+  csVector<csHeaderScanThread*> threadList( numThreads );
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    csIReader* scanReader = reader->createScanReader();
+    if( scanReader == NULL ) break;
+    int firstTraceIndex = (int)( ((csInt64_t)numTraces * ithread) / numThreads );
+    int lastTraceIndex  = (int)( ((csInt64_t)numTraces * (ithread+1)) / numThreads );
+    threadList.insertEnd( new csHeaderScanThread( scanReader, myHdrName, hdrValueSelectionText, firstTraceIndex, lastTraceIndex, mySortOrder ) );
+  }
+  if( threadList.size() < numThreads ) {
+    // Reader does not support independent scan readers: Scan serially
+    for( int ithread = 0; ithread < threadList.size(); ithread++ ) {
+      delete threadList.at(ithread);
+    }
+    cseis_geolib::type_t hdrType;
+    reader->setHeaderToPeek( myHdrName, hdrType );
+    csSelection selection( 1, &hdrType );
+    selection.add( hdrValueSelectionText );
+    scanRange( reader, &selection, 0, numTraces, mySortOrder, mySelectedTraceIndexList, valueList );
+    return;
+  }
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    if( !threadList.at(ithread)->start() ) {
+      threadList.at(ithread)->scan();  // Could not create thread: Scan this range in calling thread
+    }
+  }
+  // Merge partial selections in trace order
+  std::string errorMessage;
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    csHeaderScanThread* thread = threadList.at(ithread);
+    thread->join();
+    if( thread->myIsError ) {
+      if( errorMessage.length() == 0 ) errorMessage = thread->myErrorMessage;
+    }
+    else {
+      for( int i = 0; i < thread->traceIndexList.size(); i++ ) {
+        mySelectedTraceIndexList->insertEnd( thread->traceIndexList.at(i) );
+      }
+      for( int i = 0; i < thread->valueList.size(); i++ ) {
+        valueList->insertEnd( thread->valueList.at(i) );
+      }
+      thread->valueList.clear();
+    }
+  }
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    delete threadList.at(ithread);
+  }
+  if( errorMessage.length() != 0 ) {
+    for( int i = 0; i < valueList->size(); i++ ) {
+      delete valueList->at(i);
+    }
+    valueList->clear();
+    throw( csException("csIOSelection::initialize: Error occurred in parallel header scan: %s", errorMessage.c_str()) );
+  }
+}
+//--------------------------------------------------------------------
 bool csIOSelection::initialize( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText ) {
+  // Discard result of previous call
+  mySelectedTraceIndexList->clear();
+  myNumSelectedTraces    = 0;
+  myCurrentSelectedIndex = -1;
+  myIsPresorted = false;
   cseis_geolib::type_t hdrType;
   reader->setHeaderToPeek( myHdrName, hdrType );
   reader->moveToTrace( 0 );  // CHANGE: Save current file position?
@@ -42,20 +194,12 @@ bool csIOSelection::initialize( cseis_geolib::csIReader* reader, std::string con
   selection.add( hdrValueSelectionText );
   int numTraces = reader->numTraces();
   cseis_geolib::csVector<csFlexNumber*> selectedValueList;
-  for( int itrc = 0; itrc < numTraces; itrc++ ) {
-    csFlexHeader flexHdr;
-    if( reader->peekHeaderValue( &flexHdr, itrc ) ) {
-      csFlexNumber value(&flexHdr);
-      if( selection.contains( &value ) ) {
-        mySelectedTraceIndexList->insertEnd(itrc);
-        if( mySortOrder != csIOSelection::SORT_NONE ) selectedValueList.insertEnd( new csFlexNumber(&value,mySortOrder == SORT_DECREASING) );
-        //        fprintf(stderr,"SET value #%d   %d\n", selectedValueList.size(), selectedValueList.at( selectedValueList.size()-1 )->intValue()  );
-        // fflush(stderr);
-      }
-    }
-    else {
-      throw( csException("csIOSelection::initialize: Error occurred when scanning header value for trace #%d", itrc+1) );
-    }
+  int numThreads = std::min( myNumThreads, numTraces / MIN_TRACES_PER_THREAD );
+  if( numThreads > 1 ) {
+    scanParallel( reader, hdrValueSelectionText, numThreads, &selectedValueList );
+  }
+  else {
+    scanRange( reader, &selection, 0, numTraces, mySortOrder, mySelectedTraceIndexList, &selectedValueList );
   }
   // Move reader back to beginning
   reader->moveToTrace( 0 );
@@ -93,6 +237,153 @@ bool csIOSelection::initialize( cseis_geolib::csIReader* reader, std::string con
   return true;
 }
 
+namespace {
+  /// Range of entries in header index
+  struct IndexRange {
+    int start;
+    int end;
+    bool isExact;
+    bool operator<( IndexRange const& obj ) const { return( start < obj.start ); }
+  };
+  /**
+   * Evaluate selection once per distinct header value in given range of index entries
+   * @return Number of selected entries
+   */
+  int selectRuns( csHeaderIndex const& index, csSelection& selection, int start, int end,
+                  csVector<int>& runStartList, csVector<int>& runEndList )
+  {
+    type_t hdrType = index.headerType();
+    int numSelected = 0;
+    int i1 = start;
+    while( i1 < end ) {
+      double valueDouble = index.value(i1);
+      int i2 = std::min( end, index.upperBound( valueDouble ) );
+      csFlexNumber value;
+      if( hdrType == TYPE_INT ) value.setIntValue( (int)valueDouble );
+      else if( hdrType == TYPE_FLOAT ) value.setFloatValue( (float)valueDouble );
+      else value.setDoubleValue( valueDouble );
+      if( selection.contains( &value ) ) {
+        runStartList.insertEnd( i1 );
+        runEndList.insertEnd( i2 );
+        numSelected += i2 - i1;
+      }
+      i1 = i2;
+    }
+    return numSelected;
+  }
+}
+
+bool csIOSelection::initialize( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText, std::string const& dataFilename ) {
+  // Discard result of previous call
+  mySelectedTraceIndexList->clear();
+  myNumSelectedTraces    = 0;
+  myCurrentSelectedIndex = -1;
+  myIsPresorted = false;
+  csHeaderIndex index;
+  if( !index.open( dataFilename, myHdrName ) ) {
+    if( !csHeaderIndex::create( reader, dataFilename, myHdrName ) || !index.open( dataFilename, myHdrName ) ) {
+      return initialize( reader, hdrValueSelectionText );
+    }
+  }
+  cseis_geolib::type_t hdrType = index.headerType();
+  csSelection selection( 1, &hdrType );
+  selection.add( hdrValueSelectionText );
+
+  // Runs of selected index entries, in index order. Traces with equal values are contiguous in the index.
+  int numTraces = index.numTraces();
+  cseis_geolib::csVector<int> runStartList;
+  cseis_geolib::csVector<int> runEndList;
+  int numSelected = 0;
+  cseis_geolib::csVector<csSelection::Range> rangeList;
+  if( selection.getRanges( rangeList ) ) {
+    // Look up bounds of each selection range in index, then merge overlapping index ranges
+    int numRanges = rangeList.size();
+    IndexRange* indexRanges = new IndexRange[std::max(numRanges,1)];
+    int numIndexRanges = 0;
+    for( int irange = 0; irange < numRanges; irange++ ) {
+      csSelection::Range const& range = rangeList.at(irange);
+      IndexRange& indexRange = indexRanges[numIndexRanges];
+      indexRange.start   = range.isMinInclusive ? index.lowerBound( range.minValue ) : index.upperBound( range.minValue );
+      indexRange.end     = range.isMaxInclusive ? index.upperBound( range.maxValue ) : index.lowerBound( range.maxValue );
+      indexRange.isExact = range.isExact;
+      if( indexRange.start < indexRange.end ) numIndexRanges += 1;
+    }
+    std::sort( indexRanges, indexRanges+numIndexRanges );
+    int irange = 0;
+    while( irange < numIndexRanges ) {
+      int start = indexRanges[irange].start;
+      int end   = indexRanges[irange].end;
+      bool isExact = indexRanges[irange].isExact;
+      irange += 1;
+      while( irange < numIndexRanges && indexRanges[irange].start <= end ) {
+        end = std::max( end, indexRanges[irange].end );
+        isExact = isExact && indexRanges[irange].isExact;
+        irange += 1;
+      }
+      if( isExact ) {
+        runStartList.insertEnd( start );
+        runEndList.insertEnd( end );
+        numSelected += end - start;
+      }
+      else {
+        numSelected += selectRuns( index, selection, start, end, runStartList, runEndList );
+      }
+    }
+    delete [] indexRanges;
+  }
+  else {
+    numSelected = selectRuns( index, selection, 0, numTraces, runStartList, runEndList );
+  }
+
+  mySelectedTraceIndexList->clear();
+  myNumSelectedTraces = numSelected;
+  if( myNumSelectedTraces == 0 ) {
+    return false;
+  }
+  int numRuns = runStartList.size();
+  if( mySortOrder == csIOSelection::SORT_NONE ) {
+    int* traceIndexList = new int[numSelected];
+    int counter = 0;
+    for( int irun = 0; irun < numRuns; irun++ ) {
+      for( int i = runStartList.at(irun); i < runEndList.at(irun); i++ ) {
+        traceIndexList[counter++] = index.traceIndex(i);
+      }
+    }
+    std::sort( traceIndexList, traceIndexList+numSelected );
+    for( int i = 0; i < numSelected; i++ ) {
+      mySelectedTraceIndexList->insertEnd( traceIndexList[i] );
+    }
+    delete [] traceIndexList;
+  }
+  else {
+    // Index is sorted by increasing header value. Within each value, traces are kept in file order.
+    if( mySortOrder != SORT_DECREASING ) {
+      for( int irun = 0; irun < numRuns; irun++ ) {
+        for( int i = runStartList.at(irun); i < runEndList.at(irun); i++ ) {
+          mySelectedTraceIndexList->insertEnd( index.traceIndex(i) );
+        }
+      }
+    }
+    else {
+      // Runs may contain several header values: Walk each run backwards, one header value at a time
+      for( int irun = numRuns-1; irun >= 0; irun-- ) {
+        int runStart = runStartList.at(irun);
+        int i2 = runEndList.at(irun);
+        while( i2 > runStart ) {
+          int i1 = std::max( runStart, index.lowerBound( index.value(i2-1) ) );
+          for( int i = i1; i < i2; i++ ) {
+            mySelectedTraceIndexList->insertEnd( index.traceIndex(i) );
+          }
+          i2 = i1;
+        }
+      }
+    }
+    myIsPresorted = true;
+  }
+  myCurrentSelectedIndex = -1;
+  return true;
+}
+
 int csIOSelection::getNextTraceIndex() {
   //  fprintf(stdout,"csIOSelection::getTraceIndex(): Call %d/%d.\n", myCurrentSelectedIndex+1, myNumSelectedTraces);
   myCurrentSelectedIndex += 1;
@@ -101,7 +392,7 @@ int csIOSelection::getNextTraceIndex() {
     //fprintf(stdout,"csIOSelection::getTraceIndex(): Incorrect call to function. All traces have already been returned.\n");
     return -1;
   }
-  if( mySortOrder == SORT_NONE ) {
+  if( mySortOrder == SORT_NONE || myIsPresorted ) {
     //    fprintf(stdout,"    ...selected trace index:  %d\n",  mySelectedTraceIndexList->at(myCurrentSelectedIndex) );
     return mySelectedTraceIndexList->at(myCurrentSelectedIndex);
   }
@@ -13,6 +13,8 @@ namespace cseis_geolib {
   class csFlexHeader;
   template <typename T> class csVector;
   class csSortManager;
+  class csSelection;
+  class csFlexNumber;
 
 /**
  * IOSelection
@@ -23,6 +25,10 @@ class csIOSelection {
   static const int SORT_NONE = 0;
   static const int SORT_INCREASING = 1;
   static const int SORT_DECREASING = 2;
+  /// Number of traces whose header values are fetched in one batch
+  static const int SCAN_BLOCK_SIZE;
+  /// Minimum number of traces per thread in parallel header scan
+  static const int MIN_TRACES_PER_THREAD = 16384;
 
  public:
   /**
@@ -38,11 +44,39 @@ class csIOSelection {
   /**
    * Initialize header selection
    * Note that this method may take a long time to complete, since it will determine pointers to all selected traces in the input file, and perform the necessary sort
+   * Calling initialize() again replaces the previous selection.
    *
    * @param reader The data reader object
    * @param hdrValueSelectionText  A string defining the selection of certain trace header values. Selection syntax is explained on www.seaseis.com
    */
   bool initialize( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText );
+  /**
+   * Initialize header selection using persistent header index file.
+   * The index file is created on first use, and re-created whenever it is out of date with regards to the data file.
+   * If the header cannot be indexed (unsupported type, or index file cannot be written), a full header scan is performed instead.
+   * Selection ranges are looked up in the sorted index by binary search. Only inverted selections, and ranges with an increment,
+   * are evaluated value by value.
+   *
+   * @param reader The data reader object
+   * @param hdrValueSelectionText  A string defining the selection of certain trace header values.
+   * @param dataFilename  Name of seismic data file opened by reader
+   */
+  bool initialize( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText, std::string const& dataFilename );
+  /**
+   * Set number of threads used for header scan in initialize().
+   * Each thread scans one contiguous range of traces with its own reader, see csIReader::createScanReader().
+   * Readers that do not support independent scan readers are always scanned serially.
+   * @param numThreads  Number of threads. Default: 1 (serial scan)
+   */
+  void setNumThreads( int numThreads );
+  /**
+   * Scan header values in given trace range, and add selected traces to output lists
+   * @param firstTraceIndex  First trace to scan
+   * @param lastTraceIndex   Scan up to but not including this trace
+   * @param valueList        Values of selected traces. Only filled if sortOrder is not SORT_NONE
+   */
+  static void scanRange( cseis_geolib::csIReader* reader, cseis_geolib::csSelection* selection, int firstTraceIndex, int lastTraceIndex, int sortOrder,
+                         cseis_geolib::csVector<int>* traceIndexList, cseis_geolib::csVector<cseis_geolib::csFlexNumber*>* valueList );
   /**
    * Call this method to reset header selection.
    * After the call, method getNextTraceIndex() will return the first selected trace
@@ -55,10 +89,17 @@ class csIOSelection {
   int getNextTraceIndex();
 
  private:
+  void scanParallel( cseis_geolib::csIReader* reader, std::string const& hdrValueSelectionText, int numThreads,
+                     cseis_geolib::csVector<cseis_geolib::csFlexNumber*>* valueList );
+
   std::string myHdrName;
   int myNumSelectedTraces;
   int mySortOrder;
   int myCurrentSelectedIndex;
+  /// true if selected trace index list is already in sort order
+  bool myIsPresorted;
+  /// Number of threads used for header scan
+  int myNumThreads;
   cseis_geolib::csVector<int>* mySelectedTraceIndexList;
   cseis_geolib::csSortManager* mySortManager;
 };
@@ -1,5 +1,6 @@
 
 #include "csIReader.h"
+#include "csFlexHeader.h"
 
 using namespace cseis_geolib;
 
@@ -8,3 +9,9 @@ csIReader::csIReader() {
 csIReader::~csIReader() {
 }
 
+bool csIReader::peekHeaderValues( csFlexHeader* values, int firstTraceIndex, int numTraces ) {
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    if( !peekHeaderValue( &values[itrc], firstTraceIndex+itrc ) ) return false;
+  }
+  return true;
+}
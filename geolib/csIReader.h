@@ -27,6 +27,20 @@ class csIReader {
   virtual bool setHeaderToPeek( std::string const& headerName ) = 0;
   virtual bool setHeaderToPeek( std::string const& headerName, cseis_geolib::type_t& headerType ) = 0;
   virtual bool peekHeaderValue( cseis_geolib::csFlexHeader* value, int traceIndex ) = 0;
+  /**
+   * Peek header values of a contiguous block of traces.
+   * Default implementation calls peekHeaderValue() for each trace. Readers should override this to fetch the block in one read.
+   * @param values          (o) Header values, one for each trace
+   * @param firstTraceIndex (i) Index of first trace in block
+   * @param numTraces       (i) Number of traces in block
+   */
+  virtual bool peekHeaderValues( cseis_geolib::csFlexHeader* values, int firstTraceIndex, int numTraces );
+  /**
+   * Create independent reader on the same file, for concurrent header scans.
+   * The returned reader is ready for setHeaderToPeek() and peekHeaderValue(). The caller takes ownership.
+   * @return NULL if the reader does not support this
+   */
+  virtual csIReader* createScanReader() const { return NULL; }
   //  virtual bool peekHeaderValue( cseis_geolib::csFlexNumber* value, int traceIndex = -1 ) = 0;
 };
 
@@ -155,6 +155,20 @@ bool csSelection::contains( csFlexNumber const* const values ) {
   return isSelected;
 }
 
+//--------------------------------------------------------------------------------
+bool csSelection::getRanges( csVector<Range>& rangeList ) const {
+  rangeList.clear();
+  if( myNumHeaders != 1 ) return false;
+  for( int iField = 0; iField < mySelectionList->size(); iField++ ) {
+    Range range;
+    if( !mySelectionList->at(iField)->getBounds( range.minValue, range.isMinInclusive, range.maxValue, range.isMaxInclusive, range.isExact ) ) {
+      rangeList.clear();
+      return false;
+    }
+    rangeList.insertEnd( range );
+  }
+  return true;
+}
 
 //--------------------------------------------------------------------------------
 void csSelection::dump() {
@@ -67,6 +67,16 @@ public:
 
   static int const NONE    = -1;
 
+  /// Interval of values, see getRanges()
+  struct Range {
+    double minValue;
+    double maxValue;
+    bool isMinInclusive;
+    bool isMaxInclusive;
+    /// true if all values in interval are selected
+    bool isExact;
+  };
+
 public:
   csSelection( int numHeaders, type_t const* hdrTypes );
   ~csSelection();
@@ -82,6 +92,13 @@ public:
   */
   bool contains( csFlexNumber const* const values );
   /**
+  * Intervals enclosing all selected values. Only supported for selections on one header.
+  * Values outside all intervals are never selected. Values inside an interval that is not exact must still be checked with contains().
+  * @param rangeList (o) One interval for each selection field
+  * @return false if the selection cannot be split into intervals (inverted selection, more than one header)
+  */
+  bool getRanges( csVector<Range>& rangeList ) const;
+  /**
   * Clear selection
   */
   void clear();
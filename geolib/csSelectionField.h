@@ -37,6 +37,16 @@ public:
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax ) {}
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax, csFlexNumber const& rangeInc ) {}
   virtual void setWidth( csFlexNumber const& width ) {}
+  /**
+  * Interval containing all selected values
+  * @param minValue (o) Lower end of interval
+  * @param isMinInclusive (o) true if lower end is part of the interval
+  * @param maxValue (o) Upper end of interval
+  * @param isMaxInclusive (o) true if upper end is part of the interval
+  * @param isExact (o) true if all values in the interval are selected, false if the interval also contains values that are not selected
+  * @return false if the selected values cannot be enclosed in one interval (inverted selection)
+  */
+  virtual bool getBounds( double& /*minValue*/, bool& /*isMinInclusive*/, double& /*maxValue*/, bool& /*isMaxInclusive*/, bool& /*isExact*/ ) const { return false; }
 protected:
   /// false if inverse of selection shall be taken
   bool myDoInvert;
@@ -87,6 +87,61 @@ bool csSelectionFieldDouble::contains( csFlexNumber const& value_in ) const {
   return( !myDoInvert ? ret : !ret );
 }
 
+//--------------------------------------------------------------------------------
+bool csSelectionFieldDouble::getBounds( double& minValue, bool& isMinInclusive, double& maxValue, bool& isMaxInclusive, bool& isExact ) const {
+  if( myDoInvert ) return false;
+  minValue = -HUGE_VAL;
+  maxValue = HUGE_VAL;
+  isMinInclusive = true;
+  isMaxInclusive = true;
+  isExact = true;
+  switch( mySelectType ) {
+  case csSelection::SELECTION_SINGLE:
+    minValue = myValue;
+    maxValue = myValue;
+    break;
+  case csSelection::SELECTION_RANGE:
+    minValue = myRangeMin;
+    maxValue = myRangeMax;
+    break;
+  case csSelection::SELECTION_RANGE_INC:
+    minValue = myRangeMin;
+    maxValue = myRangeMax;
+    isExact  = false;
+    break;
+  case csSelection::SELECTION_RANGE_INC_WIDTH:
+    minValue = myRangeMin-myWidth;
+    maxValue = myRangeMax+myWidth;
+    isExact  = false;
+    break;
+  case csSelection::SELECTION_OPERATOR:
+    switch( myOperator ) {
+    case csSelection::OPERATOR_SMALLER:
+      maxValue = myValue;
+      isMaxInclusive = false;
+      break;
+    case csSelection::OPERATOR_GREATER:
+      minValue = myValue;
+      isMinInclusive = false;
+      break;
+    case csSelection::OPERATOR_SMALLER_EQUAL:
+      maxValue = myValue;
+      break;
+    case csSelection::OPERATOR_GREATER_EQUAL:
+      minValue = myValue;
+      break;
+    default:
+      return false;
+    }
+    break;
+  case csSelection::SELECTION_ALL:
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
 void csSelectionFieldDouble::dump() const {
 
   if( mySelectType == csSelection::SELECTION_SINGLE ) {
@@ -25,6 +25,7 @@ public:
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax );
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax, csFlexNumber const& rangeInc );
   virtual void setWidth( csFlexNumber const& width );
+  virtual bool getBounds( double& minValue, bool& isMinInclusive, double& maxValue, bool& isMaxInclusive, bool& isExact ) const;
   virtual void dump() const;
 private:
   double myValue;
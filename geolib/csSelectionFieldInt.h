@@ -26,6 +26,7 @@ public:
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax );
   virtual void setRange( csFlexNumber const& rangeMin, csFlexNumber const& rangeMax, csFlexNumber const& rangeInc );
   virtual void setWidth( csFlexNumber const& width );
+  virtual bool getBounds( double& minValue, bool& isMinInclusive, double& maxValue, bool& isMaxInclusive, bool& isExact ) const;
 
 private:
   int myValue;
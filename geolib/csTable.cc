@@ -6,6 +6,7 @@
 #include "csVector.h"
 #include "csGeolibUtils.h"
 #include "geolib_string_utils.h"
+#include "csTableCache.h"
 #include <string>
 #include <cstring>
 
@@ -29,6 +30,7 @@ csTable::csTable() {
   myIndexFirstValueCol = 0;
   myHasReadTableContents = false;
   myHasBeenInitialized   = false;
+  myCache = NULL;
 
   myCurrentTimeFunction = new csTimeFunction<double>();
 }
@@ -63,18 +65,27 @@ csTable::~csTable() {
     myColumnTypes = NULL;
   }
   clearBuffers();
+  if( myCache != NULL ) {
+    delete myCache;
+    myCache = NULL;
+  }
 }
 void csTable::clearBuffers() {
+  // Arrays read from table cache point into the cache, and are freed with it
   if( myValues1D != NULL ) {
-    for( int ival = 0; ival < myNumValues; ival++ ) {
-      delete myValues1D[ival];
+    if( myCache == NULL ) {
+      for( int ival = 0; ival < myNumValues; ival++ ) {
+        delete [] myValues1D[ival];
+      }
     }
     delete [] myValues1D;
     myValues1D = NULL;
   }
   if( myKeyValues != NULL ) {
-    for( int i = 0; i < myNumLocations; i++ ) {
-      delete [] myKeyValues[i];
+    if( myCache == NULL ) {
+      for( int i = 0; i < myNumLocations; i++ ) {
+        delete [] myKeyValues[i];
+      }
     }
     delete [] myKeyValues;
     myKeyValues = NULL;
@@ -190,6 +201,12 @@ void csTable::readTableContents( type_t const* types, int numCols ) {
     else throw( csException("Wrong column type specified. Table columns must have number types. Specified column type: '%s'", csGeolibUtils::typeText(types[icol])) );
   }
 
+  if( readCache() ) {
+    fclose( myFile );
+    myFile = NULL;
+    return;
+  }
+
   // 2) Read in all values, key values, time values...
   csVector<double> timeList;
   csVector<double> valueListTime;
@@ -298,13 +315,14 @@ void csTable::readTableContents( type_t const* types, int numCols ) {
   }
   if( myTableDimension == TABLE_DIM_1D ) {
     fprintf(stderr,"1D table: %d %d\n", myNumValues, myNumLocations);
-    myValues1D = new double*[myNumValues];
+    myValues1D = new double const*[myNumValues];
     for( int ival = 0; ival < myNumValues; ival++ ) {
-      myValues1D[ival] = new double[myNumLocations];
+      double* values = new double[myNumLocations];
       for( int i = 0; i < myNumLocations; i++ ) {
-        myValues1D[ival][i] = valueList[ival].at(i);
+        values[i] = valueList[ival].at(i);
         //        delete valueList[ival].at(i);  // Free csFlexNumber pointer
       }
+      myValues1D[ival] = values;
     }
   }
   else if( myTableDimension == TABLE_DIM_2D ) {
@@ -322,9 +340,118 @@ void csTable::readTableContents( type_t const* types, int numCols ) {
   if( keysNew ) {
     delete [] keysNew;
   }
+  writeCache();
+}
 
+//-----------------------------------------------------------------------------------
+//
+int* csTable::cacheSignature( int& signatureLength ) const {
+  signatureLength = 5;
+  int* signature = new int[signatureLength];
+  signature[0] = csTableCache::TABLE_CLASS_TABLE;
+  signature[1] = myTableDimension;
+  signature[2] = myNumCols;
+  signature[3] = myNumKeys;
+  signature[4] = myNumValues;
+  return signature;
+}
+//-----------------------------------------------------------------------------------
+// Cache layout: Number of locations, number of locations with key values, key values (location by location), followed by
+// either the value columns (1D table) or the time functions (2D table: number of knee points, times, values)
+//
+void csTable::writeCache() const {
+  int signatureLength;
+  int* signature = cacheSignature( signatureLength );
+  csTableCache cache;
+  bool success = cache.beginWrite( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success ) return;
+
+  int numKeyLocations = ( myKeyValues != NULL ) ? myNumLocations : 0;
+  cache.appendValue( myNumLocations );
+  cache.appendValue( numKeyLocations );
+  for( int iloc = 0; iloc < numKeyLocations; iloc++ ) {
+    cache.appendValues( myKeyValues[iloc], myNumKeys );
+  }
+  if( myTableDimension == TABLE_DIM_1D ) {
+    for( int ival = 0; ival < myNumValues; ival++ ) {
+      cache.appendValues( myValues1D[ival], myNumLocations );
+    }
+  }
+  else {
+    for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
+      csTimeFunction<double> const* timeFunc = myTimeFunctions2D[iloc];
+      int numValues = timeFunc->numValues();
+      cache.appendValue( numValues );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->timeAtIndex(i) );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->valueAtIndex(i) );
+    }
+  }
+  cache.commit();
 }
+//-----------------------------------------------------------------------------------
+// Key values and 1D table values point directly into the memory-mapped cache, which is kept open for the lifetime of the table.
+// Time functions are copied, since csTimeFunction holds its own copy of times and values.
+//
+bool csTable::readCache() {
+  int signatureLength;
+  int* signature = cacheSignature( signatureLength );
+  csTableCache* cache = new csTableCache();
+  bool success = cache->open( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success || !readCache( cache ) ) {
+    delete cache;
+    return false;
+  }
+  myCache = cache;
+  return true;
+}
+bool csTable::readCache( csTableCache* cache ) {
+  int numLocations = 0;
+  int numKeyLocations = 0;
+  if( !cache->readInt( numLocations ) || !cache->readInt( numKeyLocations ) || numLocations <= 0 ||
+      ( numKeyLocations != 0 && numKeyLocations != numLocations ) ) return false;
+  double const* keyValues = cache->readValues( myNumKeys*numKeyLocations );
+  if( keyValues == NULL ) return false;
+
+  if( myTableDimension == TABLE_DIM_1D ) {
+    double const* values = cache->readValues( myNumValues*numLocations );
+    if( values == NULL || !cache->isAtEnd() ) return false;
+    myValues1D = new double const*[myNumValues];
+    for( int ival = 0; ival < myNumValues; ival++ ) {
+      myValues1D[ival] = &values[ival*numLocations];
+    }
+  }
+  else {
+    csTimeFunction<double>** timeFunctions = new csTimeFunction<double>*[numLocations];
+    int numRead = 0;
+    for( ; numRead < numLocations; numRead++ ) {
+      int numValues = 0;
+      double const* times  = NULL;
+      double const* values = NULL;
+      if( !cache->readInt( numValues ) || (times = cache->readValues( numValues )) == NULL || (values = cache->readValues( numValues )) == NULL ) break;
+      timeFunctions[numRead] = new csTimeFunction<double>();
+      timeFunctions[numRead]->set( values, times, numValues );
+    }
+    if( numRead < numLocations || !cache->isAtEnd() ) {
+      for( int iloc = 0; iloc < numRead; iloc++ ) {
+        delete timeFunctions[iloc];
+      }
+      delete [] timeFunctions;
+      return false;
+    }
+    myTimeFunctions2D = timeFunctions;
+  }
 
+  myNumLocations = numLocations;
+  if( numKeyLocations > 0 ) {
+    myKeyValues = new double const*[myNumLocations];
+    for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
+      myKeyValues[iloc] = &keyValues[iloc*myNumKeys];
+    }
+  }
+  return true;
+}
 //-----------------------------------------------------------------------------------
 //
 void csTable::initialize_simpleTimeTable( int numLocations ) {
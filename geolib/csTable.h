@@ -13,6 +13,7 @@
 namespace cseis_geolib {
   template<typename T> class csTimeFunction;
   template<typename T> class csVector;
+  class csTableCache;
 
 /**
 * Table of input time functions, specified at key locations
@@ -109,7 +110,7 @@ private:
    * Values at each 1D location (for 1D tables)
    * There may be more than one value at one location, i.e. a list of values
    */
-  double** myValues1D;
+  double const** myValues1D;
 //  csVector<double>** myValues1D;
   /// Key values at each location (for 1D & 2D tables)
   double const** myKeyValues;
@@ -126,12 +127,21 @@ private:
   int myIndexFirstValueCol;
   bool myHasReadTableContents;
   bool myHasBeenInitialized;
+  /// Open table cache that key and value arrays point into. NULL if table was read from the ASCII file
+  csTableCache* myCache;
 
 private:
   void clearBuffers();
   double interpolate2D( double const* keyValues_in, double time ) const;
   double interpolate1D( int indexValue, double const* keyValues_in ) const;
   void findKeyLocation( double const* keyValues_in, int& locLeft, int& locRight, double& weight ) const;
+  /// Read table contents from compiled table cache, see csTableCache. @return false if no valid cache exists
+  bool readCache();
+  bool readCache( csTableCache* cache );
+  /// Write table contents to compiled table cache
+  void writeCache() const;
+  /// @return Signature of this table, identifying the table setup that the cache was written with
+  int* cacheSignature( int& signatureLength ) const;
 };
 
 } // end namespace
@@ -9,6 +9,7 @@
 #include "csSort.h"
 #include "csSortManager.h"
 #include "csFlexNumber.h"
+#include "csTableCache.h"
 #include <string>
 #include <cstring>
 #include <algorithm>
@@ -18,6 +19,7 @@ using namespace cseis_geolib;
 csTableAll::csTableAll( int tableType ) {
   myValues     = NULL;
   myKeyValues  = NULL;
+  myCache      = NULL;
   myKeyNames   = NULL;
   myValueNames = NULL;
   myColumnTypes = NULL;
@@ -80,11 +82,18 @@ csTableAll::~csTableAll() {
     delete myCurrentTimeFunction;
     myCurrentTimeFunction = NULL;
   }
+  if( myCache != NULL ) {
+    delete myCache;
+    myCache = NULL;
+  }
 }
 void csTableAll::clearBuffers() {
+  // Key values read from table cache point into the cache, and are freed with it
   if( myKeyValues != NULL ) {
-    for( int i = 0; i < myNumKeys; i++ ) {
-      delete [] myKeyValues[i];
+    if( myCache == NULL ) {
+      for( int i = 0; i < myNumKeys; i++ ) {
+        delete [] myKeyValues[i];
+      }
     }
     delete [] myKeyValues;
     myKeyValues = NULL;
@@ -190,6 +199,11 @@ void csTableAll::initialize( std::string const& filename, int methodInterpolatio
 //
 void csTableAll::readTableContents( bool doSort ) {
 //void csTableAll::readTableContents( type_t const* columnTypes, int numCols ) {
+  if( readCache( doSort ) ) {
+    fclose( myFile );
+    myFile = NULL;
+    return;
+  }
 
   // 2) Read in all values, key values, time values...
   double* keysCurrent = NULL;
@@ -288,15 +302,14 @@ void csTableAll::readTableContents( bool doSort ) {
       keyValueList.insertEnd( keysTMP );
       myNumLocations += 1;
     }
-    myKeyValues = new double*[myNumKeys];
-    for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
-      myKeyValues[ikey] = new double[myNumLocations];
-    }
+    myKeyValues = new double const*[myNumKeys];
     if( !doSort ) {
       for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+        double* keys = new double[myNumLocations];
         for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
-          myKeyValues[ikey][iloc] = keyValueList.at(iloc)[ikey];
+          keys[iloc] = keyValueList.at(iloc)[ikey];
         }
+        myKeyValues[ikey] = keys;
       }
     }
     else {
@@ -310,10 +323,12 @@ void csTableAll::readTableContents( bool doSort ) {
       sortManager.sort();
 
       for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+        double* keys = new double[myNumLocations];
         for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
           int locIndex = sortManager.sortedIndex(iloc);
-          myKeyValues[ikey][iloc] = keyValueList.at(locIndex)[ikey];;
+          keys[iloc] = keyValueList.at(locIndex)[ikey];;
         }
+        myKeyValues[ikey] = keys;
       }
     }
   }
@@ -359,6 +374,7 @@ void csTableAll::readTableContents( bool doSort ) {
   for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
     delete [] keyValueList.at(iloc);
   }
+  writeCache( doSort );
 }
   
 
@@ -609,6 +625,130 @@ void csTableAll::addData_internal( csVector<double>* valueList ) {
 }
 //-----------------------------------------------------------------------------------
 //
+int* csTableAll::cacheSignature( bool doSort, int& signatureLength ) const {
+  signatureLength = 7;
+  int* signature = new int[signatureLength];
+  signature[0] = csTableCache::TABLE_CLASS_TABLE_ALL;
+  signature[1] = myTableType;
+  signature[2] = doSort ? 1 : 0;
+  signature[3] = myNumCols;
+  signature[4] = myNumKeys;
+  signature[5] = myNumValues;
+  signature[6] = ( myTableType == TABLE_TYPE_TIME_FUNCTION ) ? myIndexTimeCol : -1;
+  return signature;
+}
+//-----------------------------------------------------------------------------------
+// Cache layout: Number of locations, key values (key by key), followed by either
+// the time functions (number of knee points, times, values) or the value lists (number of lines, values column by column)
+//
+void csTableAll::writeCache( bool doSort ) const {
+  int signatureLength;
+  int* signature = cacheSignature( doSort, signatureLength );
+  csTableCache cache;
+  bool success = cache.beginWrite( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success ) return;
+
+  cache.appendValue( myNumLocations );
+  for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+    cache.appendValues( myKeyValues[ikey], myNumLocations );
+  }
+  if( myTableType == TABLE_TYPE_TIME_FUNCTION ) {
+    for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
+      csTimeFunction<double> const* timeFunc = myTimeFunctions2D[iloc];
+      int numValues = timeFunc->numValues();
+      cache.appendValue( numValues );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->timeAtIndex(i) );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->valueAtIndex(i) );
+    }
+  }
+  else {
+    cache.appendValue( myValues->size() );
+    for( int ilist = 0; ilist < myValues->size(); ilist++ ) {
+      TableValueList const* tvl = myValues->at(ilist);
+      cache.appendValue( tvl->numLines() );
+      for( int ival = 0; ival < myNumValues; ival++ ) {
+        cache.appendValues( tvl->getAll(ival), tvl->numLines() );
+      }
+    }
+  }
+  cache.commit();
+}
+//-----------------------------------------------------------------------------------
+// Key values and value lists point directly into the memory-mapped cache, which is kept open for the lifetime of the table.
+// Time functions are copied, since csTimeFunction holds its own copy of times and values.
+//
+bool csTableAll::readCache( bool doSort ) {
+  int signatureLength;
+  int* signature = cacheSignature( doSort, signatureLength );
+  csTableCache* cache = new csTableCache();
+  bool success = cache->open( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success || !readCache( cache ) ) {
+    delete cache;
+    return false;
+  }
+  myCache = cache;
+  return true;
+}
+bool csTableAll::readCache( csTableCache* cache ) {
+  int numLocations = 0;
+  if( !cache->readInt( numLocations ) || numLocations <= 0 ) return false;
+  double const* keyValues = cache->readValues( myNumKeys*numLocations );
+  if( keyValues == NULL ) return false;
+
+  if( myTableType == TABLE_TYPE_TIME_FUNCTION ) {
+    csTimeFunction<double>** timeFunctions = new csTimeFunction<double>*[numLocations];
+    int numRead = 0;
+    for( ; numRead < numLocations; numRead++ ) {
+      int numValues = 0;
+      double const* times  = NULL;
+      double const* values = NULL;
+      if( !cache->readInt( numValues ) || (times = cache->readValues( numValues )) == NULL || (values = cache->readValues( numValues )) == NULL ) break;
+      timeFunctions[numRead] = new csTimeFunction<double>();
+      timeFunctions[numRead]->set( values, times, numValues );
+    }
+    if( numRead < numLocations || !cache->isAtEnd() ) {
+      for( int iloc = 0; iloc < numRead; iloc++ ) {
+        delete timeFunctions[iloc];
+      }
+      delete [] timeFunctions;
+      return false;
+    }
+    myTimeFunctions2D = timeFunctions;
+  }
+  else {
+    int numLists = 0;
+    if( !cache->readInt( numLists ) ) return false;
+    csVector<TableValueList*> valueLists( numLists );
+    for( int ilist = 0; ilist < numLists; ilist++ ) {
+      int numLines = 0;
+      double const* values = NULL;
+      if( !cache->readInt( numLines ) || (values = cache->readValues( myNumValues*numLines )) == NULL ) break;
+      valueLists.insertEnd( new TableValueList( myNumValues, numLines, values ) );
+    }
+    if( valueLists.size() < numLists || !cache->isAtEnd() ) {
+      for( int ilist = 0; ilist < valueLists.size(); ilist++ ) {
+        delete valueLists.at(ilist);
+      }
+      return false;
+    }
+    for( int ilist = 0; ilist < numLists; ilist++ ) {
+      myValues->insertEnd( valueLists.at(ilist) );
+    }
+  }
+
+  myNumLocations = numLocations;
+  if( myNumKeys > 0 ) {
+    myKeyValues = new double const*[myNumKeys];
+    for( int ikey = 0; ikey < myNumKeys; ikey++ ) {
+      myKeyValues[ikey] = &keyValues[ikey*myNumLocations];
+    }
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------------
+//
 double csTableAll::interpolate( int valueIndex, double const* keyValues_in ) const {
   if( myNumKeys < 2 ) {
     int locLeft   = 0;
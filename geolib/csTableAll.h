@@ -14,6 +14,7 @@ namespace cseis_geolib {
 
   template<typename T> class csTimeFunction;
   template <typename T> class csVector;
+  class csTableCache;
 
   class TableValueList {
   public:
@@ -21,6 +22,14 @@ namespace cseis_geolib {
       myNumLines   = theNumLines;
       myNumCols    = theNumCols;
       values       = new double[myNumCols*myNumLines];
+      constValues  = values;
+    }
+    /// Refer to values owned by the caller, for example a memory-mapped table cache. Values are stored column by column, and cannot be set
+    TableValueList( int theNumCols, int theNumLines, double const* theValues ) {
+      myNumLines   = theNumLines;
+      myNumCols    = theNumCols;
+      values       = NULL;
+      constValues  = theValues;
     }
     ~TableValueList() {
       if( values != NULL ) {
@@ -32,15 +41,17 @@ namespace cseis_geolib {
       values[indexCol*myNumLines+indexLine] = value;
     }
     double get( int indexCol, int indexLine = 0 ) const {
-      return values[indexCol*myNumLines+indexLine];
+      return constValues[indexCol*myNumLines+indexLine];
     }
     double const* getAll( int indexCol ) const {
-      return &values[indexCol*myNumLines];
+      return &constValues[indexCol*myNumLines];
     }
     int numColumns() const { return myNumCols; }
     int numLines() const { return myNumLines; }
   private:
+    /// Values owned by this object. NULL if values are owned by the caller
     double* values;
+    double const* constValues;
     int myNumCols;
     int myNumLines;
   };
@@ -148,7 +159,9 @@ protected:
   int myNumLocations;
 
   /// Key values at each location (for 1D & 2D tables)
-  double ** myKeyValues;
+  double const** myKeyValues;
+  /// Open table cache that key and value arrays point into. NULL if table was read from the ASCII file
+  csTableCache* myCache;
 
   // Index values, column locations in input file
   /// Number of columns in table
@@ -169,6 +182,13 @@ protected:
   double interpolate( int valueIndex, double const* keyValues_in ) const;
   void clearBuffers();
   void addData_internal( cseis_geolib::csVector<double>* valueList );
+  /// Read table contents from compiled table cache, see csTableCache. @return false if no valid cache exists
+  bool readCache( bool doSort );
+  bool readCache( csTableCache* cache );
+  /// Write table contents to compiled table cache
+  void writeCache( bool doSort ) const;
+  /// @return Signature of this table, identifying the table setup that the cache was written with
+  int* cacheSignature( bool doSort, int& signatureLength ) const;
 
   //------------------------------------------------------------------------------------
   // Time function
@@ -0,0 +1,276 @@
+
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include "csTableCache.h"
+#include "csFileUtils.h"
+
+#ifndef PLATFORM_WINDOWS
+extern "C" {
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+}
+#else
+#include <process.h>
+#define getpid _getpid
+#endif
+
+using namespace cseis_geolib;
+
+namespace {
+  static char const CACHE_ID_TEXT[] = "CSTBLCCH";
+
+  /// Byte locations in cache file header
+  static int const BYTE_LOC_VERSION     = 8;
+  static int const BYTE_LOC_SIG_LENGTH  = 12;
+  static int const BYTE_LOC_TABLE_SIZE  = 16;
+  static int const BYTE_LOC_TABLE_TIME  = 24;
+  static int const BYTE_LOC_NUM_VALUES  = 32;
+
+  /// @return Byte location of first value, following the signature. Values are aligned to 8 bytes
+  csInt64_t dataByteLoc( int signatureLength ) {
+    return( csTableCache::FILE_HEADER_BYTE_SIZE + ( ( signatureLength*sizeof(int) + 7 ) / 8 ) * 8 );
+  }
+}
+
+bool csTableCache::theIsEnabled = true;
+
+csTableCache::csTableCache() {
+  myFileData     = NULL;
+  myFileByteSize = 0;
+  myIsMapped     = false;
+  myValues       = NULL;
+  myNumValues    = 0;
+  myReadIndex    = 0;
+
+  myWriteFile        = NULL;
+  myWriteBlock       = NULL;
+  myWriteBlockSize   = 0;
+  myNumValuesWritten = 0;
+  myWriteError       = false;
+}
+csTableCache::~csTableCache() {
+  close();
+  abort();
+}
+//--------------------------------------------------------------------
+std::string csTableCache::cacheFilename( std::string const& tableFilename, int const* signature, int signatureLength ) {
+  char const* className = "table";
+  if( signatureLength > 0 && signature[0] == TABLE_CLASS_TABLE_ALL ) className = "tableall";
+  else if( signatureLength > 0 && signature[0] == TABLE_CLASS_TABLE_NEW ) className = "tablenew";
+  // FNV-1a hash of signature
+  unsigned int hash = 2166136261U;
+  unsigned char const* bytes = reinterpret_cast<unsigned char const*>( signature );
+  for( int i = 0; i < signatureLength*(int)sizeof(int); i++ ) {
+    hash = ( hash ^ bytes[i] ) * 16777619U;
+  }
+  char text[64];
+  sprintf( text, ".%s.%08x.cstbl", className, hash );
+  return( tableFilename + text );
+}
+void csTableCache::setEnabled( bool enable ) {
+  theIsEnabled = enable;
+}
+bool csTableCache::isEnabled() {
+  return theIsEnabled;
+}
+//--------------------------------------------------------------------
+bool csTableCache::open( std::string const& tableFilename, int const* signature, int signatureLength ) {
+  close();
+  if( !theIsEnabled ) return false;
+  csInt64_t tableFileSize;
+  int tableTimeStamp;
+  if( !csFileUtils::retrieveFileInfo( tableFilename, &tableFileSize, &tableTimeStamp ) ) return false;
+
+  std::string filename = cacheFilename( tableFilename, signature, signatureLength );
+  csInt64_t fileSize;
+  int timeStamp;
+  if( !csFileUtils::retrieveFileInfo( filename, &fileSize, &timeStamp ) ) return false;
+  if( fileSize < dataByteLoc( signatureLength ) ) return false;
+
+#ifdef PLATFORM_WINDOWS
+  FILE* fin = fopen( filename.c_str(), "rb" );
+  if( fin == NULL ) return false;
+  myFileData = new char[fileSize];
+  bool success = ( fread( myFileData, fileSize, 1, fin ) == 1 );
+  fclose( fin );
+  myIsMapped = false;
+  myFileByteSize = fileSize;
+  if( !success ) {
+    close();
+    return false;
+  }
+#else
+  int fd = ::open( filename.c_str(), O_RDONLY );
+  if( fd < 0 ) return false;
+  void* ptr = mmap( NULL, (size_t)fileSize, PROT_READ, MAP_SHARED, fd, 0 );
+  ::close( fd );
+  if( ptr == MAP_FAILED ) return false;
+  myFileData = (char*)ptr;
+  myIsMapped = true;
+  myFileByteSize = fileSize;
+#endif
+
+  int version;
+  int cacheSignatureLength;
+  csInt64_t cacheTableFileSize;
+  int cacheTableTimeStamp;
+  memcpy( &version, &myFileData[BYTE_LOC_VERSION], 4 );
+  memcpy( &cacheSignatureLength, &myFileData[BYTE_LOC_SIG_LENGTH], 4 );
+  memcpy( &cacheTableFileSize, &myFileData[BYTE_LOC_TABLE_SIZE], 8 );
+  memcpy( &cacheTableTimeStamp, &myFileData[BYTE_LOC_TABLE_TIME], 4 );
+  memcpy( &myNumValues, &myFileData[BYTE_LOC_NUM_VALUES], 8 );
+
+  if( strncmp( myFileData, CACHE_ID_TEXT, 8 ) || version != VERSION ||
+      cacheTableFileSize != tableFileSize || cacheTableTimeStamp != tableTimeStamp ||
+      cacheSignatureLength != signatureLength ||
+      memcmp( &myFileData[FILE_HEADER_BYTE_SIZE], signature, signatureLength*sizeof(int) ) ||
+      myNumValues < 0 || fileSize != dataByteLoc( signatureLength ) + myNumValues * (csInt64_t)sizeof(double) ) {
+    close();
+    return false;
+  }
+  myValues    = reinterpret_cast<double const*>( &myFileData[dataByteLoc( signatureLength )] );
+  myReadIndex = 0;
+  return true;
+}
+//--------------------------------------------------------------------
+bool csTableCache::readInt( int& value ) {
+  if( myReadIndex >= myNumValues ) return false;
+  value = (int)myValues[myReadIndex++];
+  return true;
+}
+double const* csTableCache::readValues( int numValues ) {
+  if( numValues < 0 || myReadIndex + numValues > myNumValues ) return NULL;
+  double const* ptr = &myValues[myReadIndex];
+  myReadIndex += numValues;
+  return ptr;
+}
+//--------------------------------------------------------------------
+void csTableCache::close() {
+  if( myFileData != NULL ) {
+#ifndef PLATFORM_WINDOWS
+    if( myIsMapped ) {
+      munmap( myFileData, (size_t)myFileByteSize );
+    }
+    else {
+      delete [] myFileData;
+    }
+#else
+    delete [] myFileData;
+#endif
+    myFileData = NULL;
+  }
+  myFileByteSize = 0;
+  myIsMapped     = false;
+  myValues       = NULL;
+  myNumValues    = 0;
+  myReadIndex    = 0;
+}
+//--------------------------------------------------------------------
+bool csTableCache::beginWrite( std::string const& tableFilename, int const* signature, int signatureLength ) {
+  abort();
+  if( !theIsEnabled ) return false;
+  csInt64_t tableFileSize;
+  int tableTimeStamp;
+  if( !csFileUtils::retrieveFileInfo( tableFilename, &tableFileSize, &tableTimeStamp ) ) return false;
+  // Table file may still be in the process of being written. Do not cache, see class description
+  if( (int)time(NULL) - tableTimeStamp < MIN_SOURCE_AGE_S ) return false;
+
+  // Write to temporary file first, then rename: Other jobs only ever see a complete cache file
+  myWriteFilename = cacheFilename( tableFilename, signature, signatureLength );
+  char pidText[32];
+  sprintf( pidText, ".tmp%d", (int)getpid() );
+  myWriteFilenameTmp = myWriteFilename + pidText;
+  myWriteFile = fopen( myWriteFilenameTmp.c_str(), "wb" );
+  if( myWriteFile == NULL ) return false;
+
+  // Number of values is not known yet. It is filled in in commit()
+  char fileHeader[FILE_HEADER_BYTE_SIZE];
+  memset( fileHeader, 0, FILE_HEADER_BYTE_SIZE );
+  int version = VERSION;
+  memcpy( &fileHeader[0], CACHE_ID_TEXT, 8 );
+  memcpy( &fileHeader[BYTE_LOC_VERSION], &version, 4 );
+  memcpy( &fileHeader[BYTE_LOC_SIG_LENGTH], &signatureLength, 4 );
+  memcpy( &fileHeader[BYTE_LOC_TABLE_SIZE], &tableFileSize, 8 );
+  memcpy( &fileHeader[BYTE_LOC_TABLE_TIME], &tableTimeStamp, 4 );
+
+  int numPadBytes = (int)( dataByteLoc( signatureLength ) - FILE_HEADER_BYTE_SIZE - signatureLength*sizeof(int) );
+  char padding[8];
+  memset( padding, 0, 8 );
+  myWriteError = ( fwrite( fileHeader, FILE_HEADER_BYTE_SIZE, 1, myWriteFile ) != 1 );
+  if( signatureLength > 0 ) {
+    myWriteError = myWriteError || ( (int)fwrite( signature, sizeof(int), signatureLength, myWriteFile ) != signatureLength );
+  }
+  if( numPadBytes > 0 ) {
+    myWriteError = myWriteError || ( fwrite( padding, numPadBytes, 1, myWriteFile ) != 1 );
+  }
+  if( myWriteBlock == NULL ) {
+    myWriteBlock = new double[WRITE_BLOCK_SIZE];
+  }
+  myWriteBlockSize   = 0;
+  myNumValuesWritten = 0;
+  if( myWriteError ) {
+    abort();
+    return false;
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+void csTableCache::appendValue( double value ) {
+  if( myWriteFile == NULL ) return;
+  if( myWriteBlockSize == WRITE_BLOCK_SIZE ) flushWriteBlock();
+  myWriteBlock[myWriteBlockSize++] = value;
+}
+void csTableCache::appendValues( double const* values, int numValues ) {
+  if( myWriteFile == NULL ) return;
+  while( numValues > 0 ) {
+    if( myWriteBlockSize == WRITE_BLOCK_SIZE ) flushWriteBlock();
+    int numCopy = WRITE_BLOCK_SIZE - myWriteBlockSize;
+    if( numCopy > numValues ) numCopy = numValues;
+    memcpy( &myWriteBlock[myWriteBlockSize], values, numCopy*sizeof(double) );
+    myWriteBlockSize += numCopy;
+    values    += numCopy;
+    numValues -= numCopy;
+  }
+}
+bool csTableCache::flushWriteBlock() {
+  if( myWriteBlockSize > 0 && !myWriteError ) {
+    myWriteError = ( (int)fwrite( myWriteBlock, sizeof(double), myWriteBlockSize, myWriteFile ) != myWriteBlockSize );
+  }
+  myNumValuesWritten += myWriteBlockSize;
+  myWriteBlockSize = 0;
+  return !myWriteError;
+}
+//--------------------------------------------------------------------
+bool csTableCache::commit() {
+  if( myWriteFile == NULL ) return false;
+  bool success = flushWriteBlock();
+  if( success ) {
+    success = ( fseek( myWriteFile, BYTE_LOC_NUM_VALUES, SEEK_SET ) == 0 ) &&
+      ( fwrite( &myNumValuesWritten, 8, 1, myWriteFile ) == 1 );
+  }
+  success = ( fclose( myWriteFile ) == 0 ) && success;
+  myWriteFile = NULL;
+  if( !success || ::rename( myWriteFilenameTmp.c_str(), myWriteFilename.c_str() ) != 0 ) {
+    ::remove( myWriteFilenameTmp.c_str() );
+    return false;
+  }
+  return true;
+}
+void csTableCache::abort() {
+  if( myWriteFile != NULL ) {
+    fclose( myWriteFile );
+    myWriteFile = NULL;
+    ::remove( myWriteFilenameTmp.c_str() );
+  }
+  if( myWriteBlock != NULL ) {
+    delete [] myWriteBlock;
+    myWriteBlock = NULL;
+  }
+  myWriteBlockSize   = 0;
+  myNumValuesWritten = 0;
+  myWriteError       = false;
+}
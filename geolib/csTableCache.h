@@ -0,0 +1,129 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_TABLE_CACHE_H
+#define CS_TABLE_CACHE_H
+
+#include <cstdio>
+#include <string>
+#include "geolib_defines.h"
+
+namespace cseis_geolib {
+
+/**
+ * Compiled table cache
+ *
+ * Binary sidecar file holding the parsed contents of an ASCII table file (sorted key values, value columns,
+ * time functions), so that repeated jobs using the same table skip the ASCII parsing and sorting step.
+ * The cache file is written next to the table file, see cacheFilename(). Its name depends on the table class and signature, so that
+ * jobs reading the same table file through different table classes or with different key columns use separate cache files.
+ *
+ * File layout: A fixed-size file header, followed by a 'signature', followed by a flat array of doubles.
+ * The signature is a list of integers describing how the table was read in (table class, table type, key and
+ * value columns, sort flag...). The meaning of the double array is defined by the table class writing the cache.
+ * Table classes may point directly into the double array of an open cache, see readValues(). In this case the cache must be kept open
+ * for the lifetime of the table, and all jobs using the same table share the same pages in memory.
+ *
+ * The cache is tied to the table file by the table file's size and time stamp. A stale cache, or a cache written
+ * with a different signature, is never used. Table files modified less than MIN_SOURCE_AGE_S seconds before the
+ * cache is written are not cached, since a later modification within the same second could not be detected.
+ *
+ * The cache file is memory-mapped when opened. Reading the cache is purely optional: All failures
+ * (missing, stale or corrupt cache, write-protected directory...) simply make the caller fall back to parsing the
+ * ASCII table file.
+ */
+class csTableCache {
+ public:
+  static int const VERSION = 1;
+  static int const FILE_HEADER_BYTE_SIZE = 64;
+  static int const MIN_SOURCE_AGE_S = 2;
+  /// Table class identifiers, used as first entry of the cache signature
+  static int const TABLE_CLASS_TABLE     = 1;
+  static int const TABLE_CLASS_TABLE_ALL = 2;
+  static int const TABLE_CLASS_TABLE_NEW = 3;
+
+ public:
+  csTableCache();
+  ~csTableCache();
+  /**
+   * @return Name of cache file belonging to given table file and signature: <table_file>.<table_class>.<signature_hash>.cstbl
+   */
+  static std::string cacheFilename( std::string const& tableFilename, int const* signature, int signatureLength );
+  /**
+   * Enable/disable use of table cache files for all tables. Enabled by default.
+   */
+  static void setEnabled( bool enable );
+  static bool isEnabled();
+
+  //--------------------------------------------------------------------
+  // Reading
+  /**
+   * Open (memory-map) existing cache file.
+   * @return false if the cache file does not exist, is corrupt, out of date, or was written with a different signature
+   */
+  bool open( std::string const& tableFilename, int const* signature, int signatureLength );
+  /**
+   * @return Next value from cache, converted to int. Returns false if the end of the cache has been reached
+   */
+  bool readInt( int& value );
+  /**
+   * @return Pointer to next 'numValues' values in cache, or NULL if the end of the cache has been reached.
+   * The pointer remains valid until the cache is closed
+   */
+  double const* readValues( int numValues );
+  /**
+   * @return true if all values in cache have been read
+   */
+  bool isAtEnd() const { return myReadIndex == myNumValues; }
+  void close();
+
+  //--------------------------------------------------------------------
+  // Writing
+  /**
+   * Start writing cache file. Values are first written to a temporary file, which is renamed in commit().
+   * @return false if the table file is too recent to be cached, or the cache file cannot be created
+   */
+  bool beginWrite( std::string const& tableFilename, int const* signature, int signatureLength );
+  void appendValue( double value );
+  void appendValues( double const* values, int numValues );
+  /**
+   * Finish writing cache file.
+   * @return false if an error occurred when writing the cache file. In this case, no cache file is left behind
+   */
+  bool commit();
+  /**
+   * Discard cache file being written
+   */
+  void abort();
+
+ private:
+  static bool theIsEnabled;
+  static int const WRITE_BLOCK_SIZE = 8192;
+
+  bool flushWriteBlock();
+
+  // Reading
+  char* myFileData;
+  csInt64_t myFileByteSize;
+  bool myIsMapped;
+  double const* myValues;
+  csInt64_t myNumValues;
+  csInt64_t myReadIndex;
+
+  // Writing
+  std::FILE* myWriteFile;
+  std::string myWriteFilename;
+  std::string myWriteFilenameTmp;
+  double* myWriteBlock;
+  int myWriteBlockSize;
+  csInt64_t myNumValuesWritten;
+  bool myWriteError;
+
+  csTableCache( csTableCache const& obj );
+  csTableCache& operator=( csTableCache const& obj );
+};
+
+} // end namespace
+
+#endif
@@ -9,6 +9,7 @@
 #include "csSort.h"
 #include "csSortManager.h"
 #include "csFlexNumber.h"
+#include "csTableCache.h"
 #include <string>
 #include <cstring>
 #include <algorithm>
@@ -31,6 +32,7 @@ csTableNew::csTableNew( int tableType ) {
 void csTableNew::init( int tableType ) {
   myValues     = NULL;
   myKeyValues  = NULL;
+  myCache      = NULL;
   myFile       = NULL;
   myNumKeys    = 0;
   myNumInterpKeys    = 0;
@@ -99,6 +101,10 @@ csTableNew::~csTableNew() {
     delete myCurrentTimeFunction;
     myCurrentTimeFunction = NULL;
   }
+  if( myCache != NULL ) {
+    delete myCache;
+    myCache = NULL;
+  }
 }
 void csTableNew::addKey( int columnIndex, bool doInterpolate ) {
   if( doInterpolate ) {
@@ -165,9 +171,12 @@ void csTableNew::addValue( int columnIndex ) {
 
 
 void csTableNew::clearBuffers() {
+  // Key values read from table cache point into the cache, and are freed with it
   if( myKeyValues != NULL ) {
-    for( int i = 0; i < myNumAllKeys; i++ ) {
-      delete [] myKeyValues[i];
+    if( myCache == NULL ) {
+      for( int i = 0; i < myNumAllKeys; i++ ) {
+        delete [] myKeyValues[i];
+      }
     }
     delete [] myKeyValues;
     myKeyValues = NULL;
@@ -209,7 +218,13 @@ void csTableNew::initialize( std::string const& filename, bool doSort ) {
       myKeyAllCols[ikey+myNumKeys] = myKeyInterpCols[ikey];
     }
   }
+  if( readCache( doSort ) ) {
+    fclose( myFile );
+    myFile = NULL;
+    return;
+  }
   readTableContents( doSort );
+  writeCache( doSort );
 }
 
 
@@ -339,15 +354,14 @@ void csTableNew::readTableContents( bool doSort ) {
       keyValueList.insertEnd( keysTMP );
       myNumLocations += 1;
     }
-    myKeyValues = new double*[myNumAllKeys];
-    for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
-      myKeyValues[ikey] = new double[myNumLocations];
-    }
+    myKeyValues = new double const*[myNumAllKeys];
     if( !doSort ) {
       for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
+        double* keys = new double[myNumLocations];
         for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
-          myKeyValues[ikey][iloc] = keyValueList.at(iloc)[ikey];
+          keys[iloc] = keyValueList.at(iloc)[ikey];
         }
+        myKeyValues[ikey] = keys;
       }
     }
     else {
@@ -361,10 +375,12 @@ void csTableNew::readTableContents( bool doSort ) {
       sortManager.sort();
 
       for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
+        double* keys = new double[myNumLocations];
         for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
           int locIndex = sortManager.sortedIndex(iloc);
-          myKeyValues[ikey][iloc] = keyValueList.at(locIndex)[ikey];;
+          keys[iloc] = keyValueList.at(locIndex)[ikey];;
         }
+        myKeyValues[ikey] = keys;
       }
     }
   }
@@ -660,6 +676,137 @@ void csTableNew::addData_internal( csVector<double>* valueList ) {
 }
 //-----------------------------------------------------------------------------------
 //
+int* csTableNew::cacheSignature( bool doSort, int& signatureLength ) const {
+  signatureLength = 7 + myNumAllKeys + myNumValues;
+  int* signature = new int[signatureLength];
+  int counter = 0;
+  signature[counter++] = csTableCache::TABLE_CLASS_TABLE_NEW;
+  signature[counter++] = myTableType;
+  signature[counter++] = doSort ? 1 : 0;
+  signature[counter++] = myNumKeys;
+  signature[counter++] = myNumInterpKeys;
+  signature[counter++] = myNumValues;
+  signature[counter++] = ( myTableType == TABLE_TYPE_TIME_FUNCTION ) ? myIndexTimeCol : -1;
+  for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
+    signature[counter++] = myKeyAllCols[ikey];
+  }
+  for( int ival = 0; ival < myNumValues; ival++ ) {
+    signature[counter++] = myValueColumns[ival];
+  }
+  return signature;
+}
+//-----------------------------------------------------------------------------------
+// Cache layout: Number of locations, key values (key by key), followed by either
+// the time functions (number of knee points, times, values) or the value lists (number of lines, values column by column)
+//
+void csTableNew::writeCache( bool doSort ) const {
+  int signatureLength;
+  int* signature = cacheSignature( doSort, signatureLength );
+  csTableCache cache;
+  bool success = cache.beginWrite( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success ) return;
+
+  cache.appendValue( myNumLocations );
+  for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
+    cache.appendValues( myKeyValues[ikey], myNumLocations );
+  }
+  if( myTableType == TABLE_TYPE_TIME_FUNCTION ) {
+    for( int iloc = 0; iloc < myNumLocations; iloc++ ) {
+      csTimeFunction<double> const* timeFunc = myTimeFunctions2D[iloc];
+      int numValues = timeFunc->numValues();
+      cache.appendValue( numValues );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->timeAtIndex(i) );
+      for( int i = 0; i < numValues; i++ ) cache.appendValue( timeFunc->valueAtIndex(i) );
+    }
+  }
+  else {
+    cache.appendValue( myValues->size() );
+    for( int ilist = 0; ilist < myValues->size(); ilist++ ) {
+      csTableValueList const* tvl = myValues->at(ilist);
+      cache.appendValue( tvl->numLines() );
+      for( int ival = 0; ival < myNumValues; ival++ ) {
+        cache.appendValues( tvl->getAll(ival), tvl->numLines() );
+      }
+    }
+  }
+  cache.commit();
+}
+//-----------------------------------------------------------------------------------
+// Key values and value lists point directly into the memory-mapped cache, which is kept open for the lifetime of the table.
+// Time functions are copied, since csTimeFunction holds its own copy of times and values.
+//
+bool csTableNew::readCache( bool doSort ) {
+  int signatureLength;
+  int* signature = cacheSignature( doSort, signatureLength );
+  csTableCache* cache = new csTableCache();
+  bool success = cache->open( myFilename, signature, signatureLength );
+  delete [] signature;
+  if( !success || !readCache( cache ) ) {
+    delete cache;
+    return false;
+  }
+  myCache = cache;
+  return true;
+}
+bool csTableNew::readCache( csTableCache* cache ) {
+  int numLocations = 0;
+  if( !cache->readInt( numLocations ) || numLocations <= 0 ) return false;
+  double const* keyValues = cache->readValues( myNumAllKeys*numLocations );
+  if( keyValues == NULL ) return false;
+
+  if( myTableType == TABLE_TYPE_TIME_FUNCTION ) {
+    csTimeFunction<double>** timeFunctions = new csTimeFunction<double>*[numLocations];
+    int numRead = 0;
+    for( ; numRead < numLocations; numRead++ ) {
+      int numValues = 0;
+      double const* times  = NULL;
+      double const* values = NULL;
+      if( !cache->readInt( numValues ) || (times = cache->readValues( numValues )) == NULL || (values = cache->readValues( numValues )) == NULL ) break;
+      timeFunctions[numRead] = new csTimeFunction<double>();
+      timeFunctions[numRead]->set( values, times, numValues );
+    }
+    if( numRead < numLocations || !cache->isAtEnd() ) {
+      for( int iloc = 0; iloc < numRead; iloc++ ) {
+        delete timeFunctions[iloc];
+      }
+      delete [] timeFunctions;
+      return false;
+    }
+    myTimeFunctions2D = timeFunctions;
+  }
+  else {
+    int numLists = 0;
+    if( !cache->readInt( numLists ) ) return false;
+    csVector<csTableValueList*> valueLists( numLists );
+    for( int ilist = 0; ilist < numLists; ilist++ ) {
+      int numLines = 0;
+      double const* values = NULL;
+      if( !cache->readInt( numLines ) || (values = cache->readValues( myNumValues*numLines )) == NULL ) break;
+      valueLists.insertEnd( new csTableValueList( myNumValues, numLines, values ) );
+    }
+    if( valueLists.size() < numLists || !cache->isAtEnd() ) {
+      for( int ilist = 0; ilist < valueLists.size(); ilist++ ) {
+        delete valueLists.at(ilist);
+      }
+      return false;
+    }
+    for( int ilist = 0; ilist < numLists; ilist++ ) {
+      myValues->insertEnd( valueLists.at(ilist) );
+    }
+  }
+
+  myNumLocations = numLocations;
+  if( myNumAllKeys > 0 ) {
+    myKeyValues = new double const*[myNumAllKeys];
+    for( int ikey = 0; ikey < myNumAllKeys; ikey++ ) {
+      myKeyValues[ikey] = &keyValues[ikey*myNumLocations];
+    }
+  }
+  return true;
+}
+//-----------------------------------------------------------------------------------
+//
 double csTableNew::interpolate( int valueIndex, double const* keyValues_in ) const {
   // If there are keys that shall not be interpolated, search for these first and narrow down the locations:
   int locStart = 0;
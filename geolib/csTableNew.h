@@ -15,6 +15,7 @@ namespace cseis_geolib {
 
   template<typename T> class csTimeFunction;
   template <typename T> class csVector;
+  class csTableCache;
 
 /**
 * CSEIS ASCII Table - Base class
@@ -171,7 +172,9 @@ protected:
   int myNumLocations;
 
   /// Key values at each location (for 1D & 2D tables)
-  double ** myKeyValues;
+  double const** myKeyValues;
+  /// Open table cache that key and value arrays point into. NULL if table was read from the ASCII file
+  csTableCache* myCache;
 
   // Index values, column locations in input file
   /// Number of columns in table
@@ -192,6 +195,13 @@ protected:
   double interpolate( int valueIndex, double const* keyValues_in ) const;
   void clearBuffers();
   void addData_internal( cseis_geolib::csVector<double>* valueList );
+  /// Read table contents from compiled table cache, see csTableCache. @return false if no valid cache exists
+  bool readCache( bool doSort );
+  bool readCache( csTableCache* cache );
+  /// Write table contents to compiled table cache
+  void writeCache( bool doSort ) const;
+  /// @return Signature of this table, identifying the table setup that the cache was written with
+  int* cacheSignature( bool doSort, int& signatureLength ) const;
 
   //------------------------------------------------------------------------------------
   // Time function
@@ -14,6 +14,14 @@ class csTableValueList {
     myNumLines   = numLines;
     myNumCols    = numCols;
     myValues       = new double[myNumCols*myNumLines];
+    myConstValues  = myValues;
+  }
+  /// Refer to values owned by the caller, for example a memory-mapped table cache. Values are stored column by column, and cannot be set
+  csTableValueList( int numCols, int numLines, double const* values ) {
+    myNumLines    = numLines;
+    myNumCols     = numCols;
+    myValues      = NULL;
+    myConstValues = values;
   }
   ~csTableValueList() {
     if( myValues != NULL ) {
@@ -25,15 +33,17 @@ class csTableValueList {
     myValues[indexCol*myNumLines+indexLine] = value;
   }
   double get( int indexCol, int indexLine = 0 ) const {
-    return myValues[indexCol*myNumLines+indexLine];
+    return myConstValues[indexCol*myNumLines+indexLine];
   }
   double const* getAll( int indexCol ) const {
-    return &myValues[indexCol*myNumLines];
+    return &myConstValues[indexCol*myNumLines];
   }
   int numColumns() const { return myNumCols; }
   int numLines() const { return myNumLines; }
  private:
+  /// Values owned by this object. NULL if values are owned by the caller
   double* myValues;
+  double const* myConstValues;
   int myNumCols;
   int myNumLines;
 };
@@ -0,0 +1,53 @@
+
+
+#include "csThread.h"
+
+#include <sys/time.h>
+#include <cerrno>
+extern "C" {
+  #include <unistd.h>
+}
+
+using namespace cseis_geolib;
+
+bool csCondition::timedWait( csMutex* mutex, int milliseconds ) {
+  struct timeval now;
+  gettimeofday( &now, NULL );
+  struct timespec timeout;
+  long long nanoseconds = (long long)now.tv_usec * 1000LL + (long long)milliseconds * 1000000LL;
+  timeout.tv_sec  = now.tv_sec + (time_t)( nanoseconds / 1000000000LL );
+  timeout.tv_nsec = (long)( nanoseconds % 1000000000LL );
+  return( pthread_cond_timedwait( &myCond, &mutex->myMutex, &timeout ) != ETIMEDOUT );
+}
+
+csThread::csThread() {
+  myIsRunning = false;
+}
+csThread::~csThread() {
+  join();
+}
+bool csThread::start() {
+  if( myIsRunning ) return false;
+  if( pthread_create( &myThread, NULL, csThread::threadFunction, this ) != 0 ) {
+    return false;
+  }
+  myIsRunning = true;
+  return true;
+}
+void csThread::join() {
+  if( myIsRunning ) {
+    pthread_join( myThread, NULL );
+    myIsRunning = false;
+  }
+}
+void* csThread::threadFunction( void* obj ) {
+  reinterpret_cast<csThread*>( obj )->run();
+  return NULL;
+}
+int csThread::numProcessors() {
+#ifdef _SC_NPROCESSORS_ONLN
+  long num = sysconf( _SC_NPROCESSORS_ONLN );
+  if( num > 0 ) return (int)num;
+#endif
+  return 1;
+}
@@ -0,0 +1,100 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_THREAD_H
+#define CS_THREAD_H
+
+#include "geolib_platform_dependent.h"
+#include <pthread.h>
+
+namespace cseis_geolib {
+
+/**
+ * Mutex
+ * Thin wrapper around POSIX mutex
+ */
+class csMutex {
+ public:
+  csMutex() { pthread_mutex_init( &myMutex, NULL ); }
+  ~csMutex() { pthread_mutex_destroy( &myMutex ); }
+  inline void lock() { pthread_mutex_lock( &myMutex ); }
+  inline void unlock() { pthread_mutex_unlock( &myMutex ); }
+ private:
+  friend class csCondition;
+  pthread_mutex_t myMutex;
+  csMutex( csMutex const& obj );
+  csMutex& operator=( csMutex const& obj );
+};
+
+/**
+ * Scoped mutex lock: Locks mutex in constructor, unlocks it in destructor
+ */
+class csMutexLock {
+ public:
+  csMutexLock( csMutex* mutex ) : myMutex(mutex) { myMutex->lock(); }
+  ~csMutexLock() { myMutex->unlock(); }
+ private:
+  csMutex* myMutex;
+  csMutexLock( csMutexLock const& obj );
+  csMutexLock& operator=( csMutexLock const& obj );
+};
+
+/**
+ * Condition variable
+ * Thin wrapper around POSIX condition variable
+ */
+class csCondition {
+ public:
+  csCondition() { pthread_cond_init( &myCond, NULL ); }
+  ~csCondition() { pthread_cond_destroy( &myCond ); }
+  /// Wait for signal. Mutex must be locked by calling thread
+  inline void wait( csMutex* mutex ) { pthread_cond_wait( &myCond, &mutex->myMutex ); }
+  /// Wait for signal, at most the given time. Mutex must be locked by calling thread. @return false if time ran out
+  bool timedWait( csMutex* mutex, int milliseconds );
+  inline void signal() { pthread_cond_signal( &myCond ); }
+  inline void broadcast() { pthread_cond_broadcast( &myCond ); }
+ private:
+  pthread_cond_t myCond;
+  csCondition( csCondition const& obj );
+  csCondition& operator=( csCondition const& obj );
+};
+
+/**
+ * Thread
+ * Derived classes implement method run(), which is executed in a separate thread after start() has been called.
+ * Exceptions thrown in run() must be caught inside run().
+ */
+class csThread {
+ public:
+  csThread();
+  virtual ~csThread();
+  /**
+   * Start thread
+   * @return false if thread could not be created
+   */
+  bool start();
+  /**
+   * Wait for thread to finish
+   */
+  void join();
+  bool isRunning() const { return myIsRunning; }
+  /**
+   * @return Number of online processors, or 1 if unknown
+   */
+  static int numProcessors();
+
+ protected:
+  virtual void run() = 0;
+
+ private:
+  static void* threadFunction( void* obj );
+  pthread_t myThread;
+  bool myIsRunning;
+  csThread( csThread const& obj );
+  csThread& operator=( csThread const& obj );
+};
+
+} // end namespace
+
+#endif
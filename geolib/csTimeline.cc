@@ -0,0 +1,213 @@
+
+
+#include <cstdio>
+#include <ctime>
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include "csTimeline.h"
+#include "csThread.h"
+#include "geolib_platform_dependent.h"
+
+using namespace cseis_geolib;
+
+namespace {
+  /// Recorded event. Instantaneous events have a negative duration
+  struct Record {
+    char const* name;
+    char const* category;
+    csInt64_t startTime;
+    csInt64_t duration;
+    csInt64_t arg;
+  };
+  /// Ring buffer of one thread
+  struct ThreadBuffer {
+    Record* records;
+    int capacity;
+    /// Total number of events recorded, including overwritten ones
+    csInt64_t numRecords;
+    int threadId;
+    std::string threadName;
+    /// false once thread has exited. Buffer is kept until the next call to enable()
+    bool isThreadAlive;
+    ThreadBuffer* next;
+  };
+
+  cseis_geolib::csMutex bufferMutex;
+  ThreadBuffer* firstBuffer = NULL;
+  int numEventsPerThread = cseis_geolib::csTimeline::DEFAULT_NUM_EVENTS;
+  int nextThreadId = 1;
+  csInt64_t originTime = 0;
+
+  pthread_key_t bufferKey;
+  pthread_once_t bufferKeyOnce = PTHREAD_ONCE_INIT;
+  void releaseThreadBuffer( void* ptr ) {
+    cseis_geolib::csMutexLock lock( &bufferMutex );
+    ((ThreadBuffer*)ptr)->isThreadAlive = false;
+  }
+  void createBufferKey() {
+    pthread_key_create( &bufferKey, releaseThreadBuffer );
+  }
+  ThreadBuffer* threadBuffer() {
+    pthread_once( &bufferKeyOnce, createBufferKey );
+    ThreadBuffer* buffer = (ThreadBuffer*)pthread_getspecific( bufferKey );
+    if( buffer == NULL ) {
+      cseis_geolib::csMutexLock lock( &bufferMutex );
+      buffer = new ThreadBuffer();
+      buffer->records       = new Record[numEventsPerThread];
+      buffer->capacity      = numEventsPerThread;
+      buffer->numRecords    = 0;
+      buffer->threadId      = nextThreadId++;
+      buffer->isThreadAlive = true;
+      buffer->next          = firstBuffer;
+      firstBuffer = buffer;
+      pthread_setspecific( bufferKey, buffer );
+    }
+    return buffer;
+  }
+  /// @return Current time in nanoseconds
+  csInt64_t currentTime() {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+    return( (csInt64_t)ts.tv_sec * 1000000000LL + (csInt64_t)ts.tv_nsec );
+#else
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return( (csInt64_t)tv.tv_sec * 1000000000LL + (csInt64_t)tv.tv_usec * 1000LL );
+#endif
+  }
+  void addRecord( char const* name, char const* category, csInt64_t startTime, csInt64_t duration, csInt64_t arg ) {
+    ThreadBuffer* buffer = threadBuffer();
+    Record& record = buffer->records[buffer->numRecords % buffer->capacity];
+    record.name      = name;
+    record.category  = category;
+    record.startTime = startTime;
+    record.duration  = duration;
+    record.arg       = arg;
+    buffer->numRecords += 1;
+  }
+  void writeString( FILE* fout, char const* text ) {
+    fputc( '"', fout );
+    for( char const* c = text; *c != '\0'; c++ ) {
+      if( *c == '"' || *c == '\\' ) {
+        fputc( '\\', fout );
+        fputc( *c, fout );
+      }
+      else if( (unsigned char)*c < 0x20 ) {
+        fprintf( fout, "\\u%04x", (unsigned int)(unsigned char)*c );
+      }
+      else {
+        fputc( *c, fout );
+      }
+    }
+    fputc( '"', fout );
+  }
+}
+
+bool csTimeline::myIsEnabled = false;
+
+//--------------------------------------------------------------------
+void csTimeline::Event::begin( char const* name, char const* category ) {
+  myName      = name;
+  myCategory  = category;
+  myArg       = -1;
+  myStartTime = currentTime();
+}
+void csTimeline::Event::end() {
+  addRecord( myName, myCategory, myStartTime, currentTime() - myStartTime, myArg );
+}
+//--------------------------------------------------------------------
+void csTimeline::enable( int numEvents ) {
+  cseis_geolib::csMutexLock lock( &bufferMutex );
+  if( numEvents < 1 ) numEvents = 1;
+  numEventsPerThread = numEvents;
+  // Free buffers of threads that have exited, and clear the others
+  ThreadBuffer** bufferPtr = &firstBuffer;
+  while( *bufferPtr != NULL ) {
+    ThreadBuffer* buffer = *bufferPtr;
+    if( !buffer->isThreadAlive ) {
+      *bufferPtr = buffer->next;
+      delete [] buffer->records;
+      delete buffer;
+      continue;
+    }
+    if( buffer->capacity != numEventsPerThread ) {
+      delete [] buffer->records;
+      buffer->records  = new Record[numEventsPerThread];
+      buffer->capacity = numEventsPerThread;
+    }
+    buffer->numRecords = 0;
+    bufferPtr = &buffer->next;
+  }
+  originTime  = currentTime();
+  myIsEnabled = true;
+}
+void csTimeline::disable() {
+  myIsEnabled = false;
+}
+void csTimeline::addInstant( char const* name, char const* category, csInt64_t arg ) {
+  addRecord( name, category, currentTime(), -1, arg );
+}
+void csTimeline::setThreadName( std::string const& name ) {
+  if( !myIsEnabled ) return;
+  ThreadBuffer* buffer = threadBuffer();
+  cseis_geolib::csMutexLock lock( &bufferMutex );
+  buffer->threadName = name;
+}
+csInt64_t csTimeline::numDroppedEvents() {
+  cseis_geolib::csMutexLock lock( &bufferMutex );
+  csInt64_t numDropped = 0;
+  for( ThreadBuffer* buffer = firstBuffer; buffer != NULL; buffer = buffer->next ) {
+    if( buffer->numRecords > buffer->capacity ) numDropped += buffer->numRecords - buffer->capacity;
+  }
+  return numDropped;
+}
+//--------------------------------------------------------------------
+bool csTimeline::writeJSON( std::string const& filename ) {
+  csInt64_t numDropped = numDroppedEvents();
+  FILE* fout = fopen( filename.c_str(), "w" );
+  if( fout == NULL ) return false;
+
+  cseis_geolib::csMutexLock lock( &bufferMutex );
+  int pid = (int)getpid();
+  fprintf( fout, "{\n  \"displayTimeUnit\": \"ms\",\n" );
+  fprintf( fout, "  \"otherData\": { \"droppedEvents\": %lld },\n", (long long)numDropped );
+  fprintf( fout, "  \"traceEvents\": [\n" );
+  bool isFirst = true;
+  for( ThreadBuffer* buffer = firstBuffer; buffer != NULL; buffer = buffer->next ) {
+    fprintf( fout, "%s    {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": ",
+             isFirst ? "" : ",\n", pid, buffer->threadId );
+    if( buffer->threadName.empty() ) {
+      fprintf( fout, "\"thread %d\"", buffer->threadId );
+    }
+    else {
+      writeString( fout, buffer->threadName.c_str() );
+    }
+    fprintf( fout, "}},\n    {\"name\": \"thread_sort_index\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"sort_index\": %d}}",
+             pid, buffer->threadId, buffer->threadId );
+    isFirst = false;
+
+    csInt64_t firstRecord = ( buffer->numRecords > buffer->capacity ) ? buffer->numRecords - buffer->capacity : 0;
+    for( csInt64_t irec = firstRecord; irec < buffer->numRecords; irec++ ) {
+      Record const& record = buffer->records[irec % buffer->capacity];
+      fprintf( fout, ",\n    {\"name\": " );
+      writeString( fout, record.name );
+      fprintf( fout, ", \"cat\": " );
+      writeString( fout, record.category );
+      fprintf( fout, ", \"pid\": %d, \"tid\": %d, \"ts\": %.3f", pid, buffer->threadId, (double)(record.startTime - originTime) * 1.0e-3 );
+      if( record.duration >= 0 ) {
+        fprintf( fout, ", \"ph\": \"X\", \"dur\": %.3f", (double)record.duration * 1.0e-3 );
+      }
+      else {
+        fprintf( fout, ", \"ph\": \"i\", \"s\": \"t\"" );
+      }
+      if( record.arg >= 0 ) {
+        fprintf( fout, ", \"args\": {\"n\": %lld}", (long long)record.arg );
+      }
+      fprintf( fout, "}" );
+    }
+  }
+  fprintf( fout, "\n  ]\n}\n" );
+  return( fclose( fout ) == 0 );
+}
@@ -0,0 +1,91 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_TIMELINE_H
+#define CS_TIMELINE_H
+
+#include <string>
+#include "geolib_defines.h"
+
+namespace cseis_geolib {
+
+/**
+ * Timeline of flow execution
+ *
+ * Records timed events, for example the exec phase calls of each module, read and write calls of I/O classes,
+ * or waits for a full or empty queue. The timeline is written to file in Chrome trace event format (JSON), which
+ * can be viewed in chrome://tracing or in the Perfetto UI (ui.perfetto.dev), with one row per thread.
+ *
+ * Recording is switched off by default. It is switched on by enable() before the exec phase starts, and switched
+ * off again by disable() after all threads have finished. While switched off, recording an event costs one branch.
+ *
+ * Every thread records into its own ring buffer, without locking. When the ring buffer is full, the oldest events
+ * are overwritten. Event names and categories are not copied: They must remain valid until the timeline has been written.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csTimeline {
+public:
+  /**
+   * Timed event: Starts when the object is constructed, and ends when it is destroyed
+   */
+  class Event {
+  public:
+    inline Event( char const* name, char const* category ) {
+      myName = NULL;
+      if( myIsEnabled ) begin( name, category );
+    }
+    inline ~Event() {
+      if( myName != NULL ) end();
+    }
+    /// Set number shown with event, e.g. the number of traces
+    inline void setArg( csInt64_t arg ) { myArg = arg; }
+  private:
+    void begin( char const* name, char const* category );
+    void end();
+    char const* myName;
+    char const* myCategory;
+    csInt64_t myStartTime;
+    csInt64_t myArg;
+    Event( Event const& obj );
+  };
+
+public:
+  /// Default size of ring buffer of each thread, in number of events
+  static int const DEFAULT_NUM_EVENTS = 65536;
+
+  static inline bool isEnabled() { return myIsEnabled; }
+  /**
+   * Switch on recording, and discard all previously recorded events
+   * @param numEventsPerThread  Size of ring buffer of each thread
+   */
+  static void enable( int numEventsPerThread = DEFAULT_NUM_EVENTS );
+  /// Switch off recording. Recorded events are kept until written
+  static void disable();
+  /**
+   * Record instantaneous event, for example the growth of a buffer
+   */
+  static inline void instant( char const* name, char const* category, csInt64_t arg = -1 ) {
+    if( myIsEnabled ) addInstant( name, category, arg );
+  }
+  /// Set name of calling thread, shown in the timeline viewer
+  static void setThreadName( std::string const& name );
+  /**
+   * Write all recorded events to file, in Chrome trace event format
+   * @return false if file could not be written
+   */
+  static bool writeJSON( std::string const& filename );
+  /// @return Number of events that were overwritten because a ring buffer was full
+  static csInt64_t numDroppedEvents();
+
+private:
+  static void addInstant( char const* name, char const* category, csInt64_t arg );
+  static bool myIsEnabled;
+};
+
+} // namespace
+
+#endif
@@ -1,8 +1,139 @@
 
 
 #include "geolib_endian.h"
+#include "geolib_platform_dependent.h"
 #include <cstring>
 
+#ifdef ARCHITECTURE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+  int detectSimdLevel() {
+#ifdef ARCHITECTURE_X86_SIMD
+    // Required if called before static constructors have run
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx2") )  return cseis_geolib::SIMD_LEVEL_AVX2;
+    if( __builtin_cpu_supports("ssse3") ) return cseis_geolib::SIMD_LEVEL_SSSE3;
+    if( __builtin_cpu_supports("sse2") )  return cseis_geolib::SIMD_LEVEL_SSE2;
+#endif
+    return cseis_geolib::SIMD_LEVEL_NONE;
+  }
+  int const CPU_SIMD_LEVEL = detectSimdLevel();
+  int theSimdLevel = CPU_SIMD_LEVEL;
+
+  /// Arrays smaller than this are swapped by the scalar code
+  int const MIN_BYTES_SIMD = 32;
+
+  inline unsigned short bswap16( unsigned short value ) {
+    return (unsigned short)( (value >> 8) | (value << 8) );
+  }
+  inline unsigned int bswap32( unsigned int value ) {
+#ifdef __GNUC__
+    return __builtin_bswap32( value );
+#else
+    return( (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24) );
+#endif
+  }
+  inline unsigned long long bswap64( unsigned long long value ) {
+#ifdef __GNUC__
+    return __builtin_bswap64( value );
+#else
+    return( ((unsigned long long)bswap32( (unsigned int)value ) << 32) | bswap32( (unsigned int)(value >> 32) ) );
+#endif
+  }
+
+  //--------------------------------------------------------------------
+  // Scalar code. Words are copied through a local variable, so input and output may be identical.
+  //
+  void swapScalar2( char const* arrayIn, char* arrayOut, int numWords ) {
+    unsigned short value;
+    for( int i = 0; i < numWords; i++ ) {
+      memcpy( &value, &arrayIn[2*i], 2 );
+      value = bswap16( value );
+      memcpy( &arrayOut[2*i], &value, 2 );
+    }
+  }
+  void swapScalar4( char const* arrayIn, char* arrayOut, int numWords ) {
+    unsigned int value;
+    for( int i = 0; i < numWords; i++ ) {
+      memcpy( &value, &arrayIn[4*i], 4 );
+      value = bswap32( value );
+      memcpy( &arrayOut[4*i], &value, 4 );
+    }
+  }
+  void swapScalar8( char const* arrayIn, char* arrayOut, int numWords ) {
+    unsigned long long value;
+    for( int i = 0; i < numWords; i++ ) {
+      memcpy( &value, &arrayIn[8*i], 8 );
+      value = bswap64( value );
+      memcpy( &arrayOut[8*i], &value, 8 );
+    }
+  }
+
+#ifdef ARCHITECTURE_X86_SIMD
+  //--------------------------------------------------------------------
+  // SIMD code: Byte shuffle of 16/32 bytes at a time. Remaining bytes are swapped by the scalar code.
+  //
+  __attribute__((target("ssse3")))
+  int swapSSSE3( char const* arrayIn, char* arrayOut, int size, __m128i mask ) {
+    int i = 0;
+    for( ; i+16 <= size; i += 16 ) {
+      __m128i v = _mm_loadu_si128( reinterpret_cast<__m128i const*>( &arrayIn[i] ) );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( &arrayOut[i] ), _mm_shuffle_epi8( v, mask ) );
+    }
+    return i;
+  }
+  __attribute__((target("avx2")))
+  int swapAVX2( char const* arrayIn, char* arrayOut, int size, __m128i mask128 ) {
+    __m256i mask = _mm256_broadcastsi128_si256( mask128 );
+    int i = 0;
+    for( ; i+64 <= size; i += 64 ) {
+      __m256i v1 = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( &arrayIn[i] ) );
+      __m256i v2 = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( &arrayIn[i+32] ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &arrayOut[i] ), _mm256_shuffle_epi8( v1, mask ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &arrayOut[i+32] ), _mm256_shuffle_epi8( v2, mask ) );
+    }
+    for( ; i+32 <= size; i += 32 ) {
+      __m256i v = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( &arrayIn[i] ) );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( &arrayOut[i] ), _mm256_shuffle_epi8( v, mask ) );
+    }
+    return i;
+  }
+  /// @return Number of bytes swapped by SIMD code
+  int swapSIMD( char const* arrayIn, char* arrayOut, int size, int numBytesSwap ) {
+    if( size < MIN_BYTES_SIMD || theSimdLevel < cseis_geolib::SIMD_LEVEL_SSSE3 ) return 0;
+    __m128i mask;
+    if( numBytesSwap == 2 ) {
+      mask = _mm_setr_epi8( 1,0, 3,2, 5,4, 7,6, 9,8, 11,10, 13,12, 15,14 );
+    }
+    else if( numBytesSwap == 4 ) {
+      mask = _mm_setr_epi8( 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 );
+    }
+    else {
+      mask = _mm_setr_epi8( 7,6,5,4,3,2,1,0, 15,14,13,12,11,10,9,8 );
+    }
+    if( theSimdLevel >= cseis_geolib::SIMD_LEVEL_AVX2 ) {
+      int numBytesDone = swapAVX2( arrayIn, arrayOut, size, mask );
+      return numBytesDone + swapSSSE3( &arrayIn[numBytesDone], &arrayOut[numBytesDone], size-numBytesDone, mask );
+    }
+    return swapSSSE3( arrayIn, arrayOut, size, mask );
+  }
+#else
+  int swapSIMD( char const*, char*, int, int ) {
+    return 0;
+  }
+#endif
+}
+
+//--------------------------------------------------------------------
+int cseis_geolib::simdLevel() {
+  return theSimdLevel;
+}
+void cseis_geolib::setMaxSimdLevel( int level ) {
+  theSimdLevel = ( level < CPU_SIMD_LEVEL ) ? level : CPU_SIMD_LEVEL;
+}
+
 bool cseis_geolib::isPlatformLittleEndian() {
   union {
     unsigned char  cc[2];
@@ -17,70 +148,47 @@ bool cseis_geolib::isPlatformLittleEndian() {
 }
 
 void cseis_geolib::swapEndian4( char* array, int size ) {
-  char tmp;
-  if( size == 4 ) {
-    tmp = array[0];
-    array[0] = array[3];
-    array[3] = tmp;
-    tmp = array[1];
-    array[1] = array[2];
-    array[2] = tmp;
-  }
-  else {
-    for( int i = 0; i < size; i+=4 ) {
-      tmp        = array[i+3];
-      array[i+3] = array[i];
-      array[i]   = tmp;
-      tmp        = array[i+2];
-      array[i+2] = array[i+1];
-      array[i+1] = tmp;
-    }
-  }
+  swapEndian4( array, array, size );
+}
+void cseis_geolib::swapEndian4( char const* arrayIn, char* arrayOut, int size ) {
+  int numBytesDone = swapSIMD( arrayIn, arrayOut, size, 4 );
+  swapScalar4( &arrayIn[numBytesDone], &arrayOut[numBytesDone], (size-numBytesDone)/4 );
 }
 
 void cseis_geolib::swapEndian2( char* array, int size ) {
-  if( size == 2 ) {
-    char c2[2];
-    memcpy( c2, array, 2  );
-    array[0] = c2[1];
-    array[1] = c2[0];
-  }
-  else {
-    char* arrayNew = new char[size];
-    memcpy( arrayNew, array, size );
-    for( int i = 0; i < size; i+=2 ) {
-      array[i]   = arrayNew[i+1];
-      array[i+1] = arrayNew[i];
-    }
-    delete [] arrayNew;
-  }
+  swapEndian2( array, array, size );
+}
+void cseis_geolib::swapEndian2( char const* arrayIn, char* arrayOut, int size ) {
+  int numBytesDone = swapSIMD( arrayIn, arrayOut, size, 2 );
+  swapScalar2( &arrayIn[numBytesDone], &arrayOut[numBytesDone], (size-numBytesDone)/2 );
+}
+
+void cseis_geolib::swapEndian8( char* array, int size ) {
+  swapEndian8( array, array, size );
+}
+void cseis_geolib::swapEndian8( char const* arrayIn, char* arrayOut, int size ) {
+  int numBytesDone = swapSIMD( arrayIn, arrayOut, size, 8 );
+  swapScalar8( &arrayIn[numBytesDone], &arrayOut[numBytesDone], (size-numBytesDone)/8 );
 }
 
 void cseis_geolib::swapEndian( char* array, int numBytesSwap, int numTotalBytes ) {
-  char* arrayNew = new char[numTotalBytes];
-  memcpy( arrayNew, array, numTotalBytes );
-  for( int startPos = 0; startPos < numTotalBytes; startPos += numBytesSwap ) {
-    int endPos = startPos+numBytesSwap-1;
-    for( int ib = 0; ib < numBytesSwap; ib++ ) {
-      array[startPos+ib] = arrayNew[endPos-ib];
-    }
+  if( numBytesSwap == 2 ) {
+    swapEndian2( array, numTotalBytes );
   }
-  delete [] arrayNew;
-}
-void cseis_geolib::swapEndian8( char* array, int size ) {
-  char* arrayNew = new char[size];
-  memcpy( arrayNew, array, size );
-  for( int i = 0; i < size; i+=8 ) {
-    array[i]   = arrayNew[i+7];
-    array[i+1] = arrayNew[i+6];
-    array[i+2] = arrayNew[i+5];
-    array[i+3] = arrayNew[i+4];
-    array[i+4] = arrayNew[i+3];
-    array[i+5] = arrayNew[i+2];
-    array[i+6] = arrayNew[i+1];
-    array[i+7] = arrayNew[i];
+  else if( numBytesSwap == 4 ) {
+    swapEndian4( array, numTotalBytes );
+  }
+  else if( numBytesSwap == 8 ) {
+    swapEndian8( array, numTotalBytes );
+  }
+  else if( numBytesSwap > 1 ) {
+    for( int startPos = 0; startPos+numBytesSwap <= numTotalBytes; startPos += numBytesSwap ) {
+      int endPos = startPos+numBytesSwap-1;
+      for( int ib = 0; ib < numBytesSwap/2; ib++ ) {
+        char tmp = array[startPos+ib];
+        array[startPos+ib] = array[endPos-ib];
+        array[endPos-ib]   = tmp;
+      }
+    }
   }
-  delete [] arrayNew;
 }
-
-
@@ -22,6 +22,24 @@ namespace cseis_geolib {
 */
 bool isPlatformLittleEndian();
 
+/// SIMD instruction sets used by the endian swap and number conversion methods
+static int const SIMD_LEVEL_NONE  = 0;
+static int const SIMD_LEVEL_SSE2  = 1;
+static int const SIMD_LEVEL_SSSE3 = 2;
+static int const SIMD_LEVEL_AVX2  = 3;
+
+/**
+* @return SIMD level used by the endian swap and number conversion methods.
+*         This is the highest level supported by the CPU, determined once at program start, unless restricted by setMaxSimdLevel()
+*/
+int simdLevel();
+
+/**
+* Restrict SIMD level used by the endian swap and number conversion methods, for example to compare against the scalar code.
+* @param level  Maximum SIMD level, SIMD_LEVEL_NONE for scalar code only
+*/
+void setMaxSimdLevel( int level );
+
 /**
 * Endian-swap 4-byte words
 * Swap every 4 bytes from (1234) to (4321)
@@ -29,6 +47,14 @@ bool isPlatformLittleEndian();
 * @param size   Number of bytes in array (Must be multiple of 4)
 */
 void swapEndian4( char* array, int size );
+/**
+* Endian-swap 4-byte words, writing result to output array
+* Use this instead of a separate copy and in-place swap. Input and output arrays may be identical, but must not overlap otherwise.
+* @param arrayIn   Input data array
+* @param arrayOut  Output data array
+* @param size      Number of bytes in array (Must be multiple of 4)
+*/
+void swapEndian4( char const* arrayIn, char* arrayOut, int size );
 
 /**
 * Endian-swap 2-byte words
@@ -37,14 +63,22 @@ void swapEndian4( char* array, int size );
 * @param size   Number of bytes in array (Must be multiple of 2)
 */
 void swapEndian2( char* array, int size );
+/**
+* Endian-swap 2-byte words, writing result to output array, see swapEndian4()
+*/
+void swapEndian2( char const* arrayIn, char* arrayOut, int size );
 
 /**
 * Endian-swap 8-byte words
 * Swap every 8 bytes from (1234) to (4321)
 * @param array  Data array
-* @param size   Number of bytes in array (Must be multiple of 4)
+* @param size   Number of bytes in array (Must be multiple of 8)
 */
 void swapEndian8( char* array, int size );
+/**
+* Endian-swap 8-byte words, writing result to output array, see swapEndian4()
+*/
+void swapEndian8( char const* arrayIn, char* arrayOut, int size );
 
 /**
 * Endian-swap any-byte words
@@ -37,6 +37,14 @@
  #define ARCHITECTURE_ITANIUM 1
 #endif
 
+/*
+ * x86 SIMD code paths (SSE2/SSSE3/AVX2) are compiled using per-function target attributes and selected at run time,
+ * so no special compiler flags are required. Define CSEIS_NO_SIMD to build the portable scalar code only.
+ */
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__) && !defined(CSEIS_NO_SIMD)
+ #define ARCHITECTURE_X86_SIMD 1
+#endif
+
 /*
  * Apparently, the Gnu g++ compiler works with either separator, on both Windows and Unix systems
 #ifndef PLATFORM_WINDOWS
@@ -2,11 +2,16 @@
 
 #include "methods_number_conversions.h"
 #include "geolib_endian.h"
+#include "geolib_platform_dependent.h"
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
 #include <cstring>
 
+#ifdef ARCHITECTURE_X86_SIMD
+#include <immintrin.h>
+#endif
+
 namespace{
 const char e2a[] = {
   '@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@','@',
@@ -39,6 +44,241 @@ const short a2e[] = {
   32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,
   32,32,32,32,32,32,32,32,32,32,32,32,32,32,32,32
 };
+
+inline unsigned bswap32( unsigned value ) {
+#ifdef __GNUC__
+  return __builtin_bswap32( value );
+#else
+  return( (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) | (value << 24) );
+#endif
+}
+
+/// Convert single IBM floating point value (given as 32bit word in platform byte order) to IEEE
+inline unsigned ibm2ieeeValue( unsigned fraction ) {
+  int signum = fraction >> 31;
+  fraction <<= 1;
+  int exponent = fraction >> 25;
+  fraction <<= 7;
+
+  if( fraction == 0 ) {
+    exponent = 0;
+  }
+  else {
+    exponent = (exponent << 2) - 130;
+
+    while (fraction < 0x80000000) {
+      --exponent;
+      fraction <<= 1;
+    }
+
+    if( exponent <= 0 ) {
+      if( exponent < -24 ) {
+        fraction = 0;
+      }
+      else {
+        fraction >>= -exponent;
+      }
+      exponent = 0;
+    }
+    else if( exponent >= 255 ) {
+      fraction = 0;
+      exponent = 255;
+    }
+    else {
+      fraction <<= 1;
+    }
+  }
+  return( (fraction >> 9) | (exponent << 23) | (signum << 31) );
+}
+
+/// Convert single IEEE floating point value (given as 32bit word in platform byte order) to IBM
+inline unsigned ieee2ibmValue( unsigned fraction ) {
+  int signum = fraction >> 31;
+  fraction <<= 1;
+  int exponent = fraction >> 24;
+  fraction <<= 8;
+
+  if( exponent > 0 && exponent != 255 ) {
+    fraction = (fraction >> 1) | 0x80000000;
+    exponent += 130;
+    fraction >>= -exponent & 3;
+    exponent = (exponent + 3) >> 2;
+
+    while (fraction < 0x10000000) {
+      --exponent;
+      fraction <<= 4;
+    }
+  }
+  else { // fraction == 0 || fraction == 255
+    if( exponent == 255 ) {
+      fraction = 0xffffff00;
+      exponent = 0x7f;
+    }
+  }
+  return( (fraction >> 8) | (exponent << 24) | (signum << 31) );
+}
+
+#ifdef ARCHITECTURE_X86_SIMD
+//--------------------------------------------------------------------
+// SIMD conversion
+//
+// IBM to IEEE: The 24bit IBM fraction converts exactly to a normalised float. Its exponent is then corrected by
+// 4*(IBM exponent) - 280, without any branches or normalisation loop. Results that fall into the IEEE denormal range
+// are rare and are recomputed by the scalar code.
+// IEEE to IBM: The IBM exponent is (E+133)/4; the fraction (with leading 1) is shifted right by (-(E+2))&3 bits.
+// Zero/denormal and Inf/NaN input are handled by masks, reproducing the results of the scalar code.
+//
+// The kernels return the number of values converted. Remaining values are converted by the scalar code.
+//
+__attribute__((target("sse2")))
+inline __m128i blendSSE2( __m128i mask, __m128i valueTrue, __m128i valueFalse ) {
+  return _mm_or_si128( _mm_and_si128( mask, valueTrue ), _mm_andnot_si128( mask, valueFalse ) );
+}
+__attribute__((target("sse2")))
+inline __m128i swapSSE2( __m128i v ) {
+  v = _mm_or_si128( _mm_slli_epi32( v, 16 ), _mm_srli_epi32( v, 16 ) );
+  return _mm_or_si128( _mm_slli_epi16( v, 8 ), _mm_srli_epi16( v, 8 ) );
+}
+__attribute__((target("avx2")))
+inline __m256i blendAVX2( __m256i mask, __m256i valueTrue, __m256i valueFalse ) {
+  return _mm256_blendv_epi8( valueFalse, valueTrue, mask );
+}
+
+__attribute__((target("sse2")))
+int ibm2ieeeSSE2( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  __m128i const maskSign  = _mm_set1_epi32( (int)0x80000000 );
+  __m128i const maskExp   = _mm_set1_epi32( 0x7f );
+  __m128i const maskFrac  = _mm_set1_epi32( 0x00ffffff );
+  __m128i const expOffset = _mm_set1_epi32( 280 );
+  __m128i const expMax    = _mm_set1_epi32( 254 );
+  __m128i const one       = _mm_set1_epi32( 1 );
+  __m128i const infinity  = _mm_set1_epi32( 0x7f800000 );
+  int i = 0;
+  for( ; i+4 <= numValues; i += 4 ) {
+    __m128i x = _mm_loadu_si128( reinterpret_cast<__m128i const*>( &valuesIn[4*i] ) );
+    if( doSwapEndian ) x = swapSSE2( x );
+    __m128i sign = _mm_and_si128( x, maskSign );
+    __m128i frac = _mm_and_si128( x, maskFrac );
+    __m128i expAdjust = _mm_sub_epi32( _mm_slli_epi32( _mm_and_si128( _mm_srli_epi32( x, 24 ), maskExp ), 2 ), expOffset );
+    __m128i fracFloat = _mm_castps_si128( _mm_cvtepi32_ps( frac ) );
+    __m128i exponent  = _mm_add_epi32( _mm_srli_epi32( fracFloat, 23 ), expAdjust );
+    __m128i result    = _mm_add_epi32( fracFloat, _mm_slli_epi32( expAdjust, 23 ) );
+    result = blendSSE2( _mm_cmpgt_epi32( exponent, expMax ), infinity, result );
+    __m128i isZero = _mm_cmpeq_epi32( frac, _mm_setzero_si128() );
+    result = _mm_or_si128( _mm_andnot_si128( isZero, result ), sign );
+    int denormal = _mm_movemask_ps( _mm_castsi128_ps( _mm_andnot_si128( isZero, _mm_cmpgt_epi32( one, exponent ) ) ) );
+    if( denormal ) {
+      unsigned input[4];
+      unsigned output[4];
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( input ), x );
+      _mm_storeu_si128( reinterpret_cast<__m128i*>( output ), result );
+      for( int k = 0; k < 4; k++ ) {
+        if( denormal & (1 << k) ) output[k] = ibm2ieeeValue( input[k] );
+      }
+      result = _mm_loadu_si128( reinterpret_cast<__m128i const*>( output ) );
+    }
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( &valuesOut[4*i] ), result );
+  }
+  return i;
+}
+__attribute__((target("avx2")))
+int ibm2ieeeAVX2( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  __m256i const maskSwap  = _mm256_setr_epi8( 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12, 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 );
+  __m256i const maskSign  = _mm256_set1_epi32( (int)0x80000000 );
+  __m256i const maskExp   = _mm256_set1_epi32( 0x7f );
+  __m256i const maskFrac  = _mm256_set1_epi32( 0x00ffffff );
+  __m256i const expOffset = _mm256_set1_epi32( 280 );
+  __m256i const expMax    = _mm256_set1_epi32( 254 );
+  __m256i const one       = _mm256_set1_epi32( 1 );
+  __m256i const infinity  = _mm256_set1_epi32( 0x7f800000 );
+  int i = 0;
+  for( ; i+8 <= numValues; i += 8 ) {
+    __m256i x = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( &valuesIn[4*i] ) );
+    if( doSwapEndian ) x = _mm256_shuffle_epi8( x, maskSwap );
+    __m256i sign = _mm256_and_si256( x, maskSign );
+    __m256i frac = _mm256_and_si256( x, maskFrac );
+    __m256i expAdjust = _mm256_sub_epi32( _mm256_slli_epi32( _mm256_and_si256( _mm256_srli_epi32( x, 24 ), maskExp ), 2 ), expOffset );
+    __m256i fracFloat = _mm256_castps_si256( _mm256_cvtepi32_ps( frac ) );
+    __m256i exponent  = _mm256_add_epi32( _mm256_srli_epi32( fracFloat, 23 ), expAdjust );
+    __m256i result    = _mm256_add_epi32( fracFloat, _mm256_slli_epi32( expAdjust, 23 ) );
+    result = blendAVX2( _mm256_cmpgt_epi32( exponent, expMax ), infinity, result );
+    __m256i isZero = _mm256_cmpeq_epi32( frac, _mm256_setzero_si256() );
+    result = _mm256_or_si256( _mm256_andnot_si256( isZero, result ), sign );
+    int denormal = _mm256_movemask_ps( _mm256_castsi256_ps( _mm256_andnot_si256( isZero, _mm256_cmpgt_epi32( one, exponent ) ) ) );
+    if( denormal ) {
+      unsigned input[8];
+      unsigned output[8];
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( input ), x );
+      _mm256_storeu_si256( reinterpret_cast<__m256i*>( output ), result );
+      for( int k = 0; k < 8; k++ ) {
+        if( denormal & (1 << k) ) output[k] = ibm2ieeeValue( input[k] );
+      }
+      result = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( output ) );
+    }
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( &valuesOut[4*i] ), result );
+  }
+  return i;
+}
+
+__attribute__((target("sse2")))
+int ieee2ibmSSE2( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  __m128i const maskSign    = _mm_set1_epi32( (int)0x80000000 );
+  __m128i const maskExp     = _mm_set1_epi32( 0xff );
+  __m128i const maskMant    = _mm_set1_epi32( 0x007fffff );
+  __m128i const leadingBit  = _mm_set1_epi32( 0x00800000 );
+  __m128i const two         = _mm_set1_epi32( 2 );
+  __m128i const one         = _mm_set1_epi32( 1 );
+  __m128i const expOffset   = _mm_set1_epi32( 133 );
+  __m128i const expInfinity = _mm_set1_epi32( 255 );
+  __m128i const maxValue    = _mm_set1_epi32( 0x7fffffff );
+  int i = 0;
+  for( ; i+4 <= numValues; i += 4 ) {
+    __m128i x = _mm_loadu_si128( reinterpret_cast<__m128i const*>( &valuesIn[4*i] ) );
+    __m128i sign = _mm_and_si128( x, maskSign );
+    __m128i expIEEE = _mm_and_si128( _mm_srli_epi32( x, 23 ), maskExp );
+    __m128i mant = _mm_and_si128( x, maskMant );
+    __m128i shift = _mm_and_si128( _mm_sub_epi32( _mm_setzero_si128(), _mm_add_epi32( expIEEE, two ) ), _mm_set1_epi32( 3 ) );
+    __m128i frac = _mm_or_si128( mant, leadingBit );
+    frac = blendSSE2( _mm_cmpeq_epi32( _mm_and_si128( shift, one ), one ), _mm_srli_epi32( frac, 1 ), frac );
+    frac = blendSSE2( _mm_cmpeq_epi32( _mm_and_si128( shift, two ), two ), _mm_srli_epi32( frac, 2 ), frac );
+    __m128i result = _mm_or_si128( frac, _mm_slli_epi32( _mm_srli_epi32( _mm_add_epi32( expIEEE, expOffset ), 2 ), 24 ) );
+    result = blendSSE2( _mm_cmpeq_epi32( expIEEE, _mm_setzero_si128() ), _mm_slli_epi32( mant, 1 ), result );
+    result = blendSSE2( _mm_cmpeq_epi32( expIEEE, expInfinity ), maxValue, result );
+    result = _mm_or_si128( result, sign );
+    if( doSwapEndian ) result = swapSSE2( result );
+    _mm_storeu_si128( reinterpret_cast<__m128i*>( &valuesOut[4*i] ), result );
+  }
+  return i;
+}
+__attribute__((target("avx2")))
+int ieee2ibmAVX2( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  __m256i const maskSwap    = _mm256_setr_epi8( 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12, 3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12 );
+  __m256i const maskSign    = _mm256_set1_epi32( (int)0x80000000 );
+  __m256i const maskExp     = _mm256_set1_epi32( 0xff );
+  __m256i const maskMant    = _mm256_set1_epi32( 0x007fffff );
+  __m256i const leadingBit  = _mm256_set1_epi32( 0x00800000 );
+  __m256i const two         = _mm256_set1_epi32( 2 );
+  __m256i const expOffset   = _mm256_set1_epi32( 133 );
+  __m256i const expInfinity = _mm256_set1_epi32( 255 );
+  __m256i const maxValue    = _mm256_set1_epi32( 0x7fffffff );
+  int i = 0;
+  for( ; i+8 <= numValues; i += 8 ) {
+    __m256i x = _mm256_loadu_si256( reinterpret_cast<__m256i const*>( &valuesIn[4*i] ) );
+    __m256i sign = _mm256_and_si256( x, maskSign );
+    __m256i expIEEE = _mm256_and_si256( _mm256_srli_epi32( x, 23 ), maskExp );
+    __m256i mant = _mm256_and_si256( x, maskMant );
+    __m256i shift = _mm256_and_si256( _mm256_sub_epi32( _mm256_setzero_si256(), _mm256_add_epi32( expIEEE, two ) ), _mm256_set1_epi32( 3 ) );
+    __m256i frac = _mm256_srlv_epi32( _mm256_or_si256( mant, leadingBit ), shift );
+    __m256i result = _mm256_or_si256( frac, _mm256_slli_epi32( _mm256_srli_epi32( _mm256_add_epi32( expIEEE, expOffset ), 2 ), 24 ) );
+    result = blendAVX2( _mm256_cmpeq_epi32( expIEEE, _mm256_setzero_si256() ), _mm256_slli_epi32( mant, 1 ), result );
+    result = blendAVX2( _mm256_cmpeq_epi32( expIEEE, expInfinity ), maxValue, result );
+    result = _mm256_or_si256( result, sign );
+    if( doSwapEndian ) result = _mm256_shuffle_epi8( result, maskSwap );
+    _mm256_storeu_si256( reinterpret_cast<__m256i*>( &valuesOut[4*i] ), result );
+  }
+  return i;
+}
+#endif
 }
 
 /**
@@ -88,85 +328,48 @@ short cseis_geolib::char2ebcdic( char c ) {
 }
 
 void cseis_geolib::ibm2ieee( unsigned char* values, int numValues ) {
-  register unsigned fraction;
-  register int exponent;
-  register int signum;
-
-  for( int i = 0; i < numValues; i++ ) {
-    memcpy( &fraction, &values[i*4], 4 );
-
-    signum = fraction >> 31;
-    fraction <<= 1;
-    exponent = fraction >> 25;
-    fraction <<= 7;
-    
-    if( fraction == 0 ) {
-      exponent = 0;
-    }
-    else {
-      exponent = (exponent << 2) - 130;
-    
-      while (fraction < 0x80000000) {
-        --exponent;
-        fraction <<= 1;
-      }
-    
-      if( exponent <= 0 ) {
-        if( exponent < -24 ) {
-          fraction = 0;
-        }
-        else {
-          fraction >>= -exponent;
-        }
-        exponent = 0;
-      }
-      else if( exponent >= 255 ) {
-        fraction = 0;
-        exponent = 255;
-      }
-      else {
-        fraction <<= 1;
-      }
-    }
-    
-    fraction = (fraction >> 9) | (exponent << 23) | (signum << 31);
-    memcpy( &values[i*4], &fraction, 4 );
+  ibm2ieee( values, values, numValues, false );
+}
+void cseis_geolib::ibm2ieee( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  int i = 0;
+#ifdef ARCHITECTURE_X86_SIMD
+  int level = simdLevel();
+  if( level >= SIMD_LEVEL_AVX2 ) {
+    i = ibm2ieeeAVX2( valuesIn, valuesOut, numValues, doSwapEndian );
+  }
+  else if( level >= SIMD_LEVEL_SSE2 ) {
+    i = ibm2ieeeSSE2( valuesIn, valuesOut, numValues, doSwapEndian );
+  }
+#endif
+  unsigned value;
+  for( ; i < numValues; i++ ) {
+    memcpy( &value, &valuesIn[i*4], 4 );
+    if( doSwapEndian ) value = bswap32( value );
+    value = ibm2ieeeValue( value );
+    memcpy( &valuesOut[i*4], &value, 4 );
   }
 }
 
 void cseis_geolib::ieee2ibm( unsigned char* values, int numValues ) {
-  register unsigned fraction;
-  register int exponent;
-  register int signum;
-
-  for( int i = 0; i < numValues; i++ ) {
-    memcpy( &fraction, &values[i*4], 4 );
-    signum = fraction >> 31;
-    fraction <<= 1;
-    exponent = fraction >> 24;
-    fraction <<= 8;
-
-    if( exponent > 0 && exponent != 255 ) {
-      fraction = (fraction >> 1) | 0x80000000;
-      exponent += 130;
-      fraction >>= -exponent & 3;
-      exponent = (exponent + 3) >> 2;
-    
-      while (fraction < 0x10000000) {
-        --exponent;
-        fraction <<= 4;
-      }
-    }
-    else { // fraction == 0 || fraction == 255
-      if( exponent == 255 ) {
-        fraction = 0xffffff00;
-        exponent = 0x7f;
-      }
-    }
-    
-    fraction = (fraction >> 8) | (exponent << 24) | (signum << 31);
-    memcpy( &values[i*4], &fraction, 4 );
+  ieee2ibm( values, values, numValues, false );
+}
+void cseis_geolib::ieee2ibm( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+  int i = 0;
+#ifdef ARCHITECTURE_X86_SIMD
+  int level = simdLevel();
+  if( level >= SIMD_LEVEL_AVX2 ) {
+    i = ieee2ibmAVX2( valuesIn, valuesOut, numValues, doSwapEndian );
+  }
+  else if( level >= SIMD_LEVEL_SSE2 ) {
+    i = ieee2ibmSSE2( valuesIn, valuesOut, numValues, doSwapEndian );
+  }
+#endif
+  unsigned value;
+  for( ; i < numValues; i++ ) {
+    memcpy( &value, &valuesIn[i*4], 4 );
+    value = ieee2ibmValue( value );
+    if( doSwapEndian ) value = bswap32( value );
+    memcpy( &valuesOut[i*4], &value, 4 );
   }
-
 }
 
@@ -22,8 +22,26 @@ namespace cseis_geolib {
   */
   short char2ebcdic( char c );
 
+  /**
+  * Convert IBM floating point values to IEEE floating point values, in place
+  * Values are given in platform byte order.
+  */
   void ibm2ieee( unsigned char* values, int numValues );
+  /**
+  * Convert IBM floating point values to IEEE floating point values, writing result to output array
+  * Input and output arrays may be identical, but must not overlap otherwise.
+  * @param doSwapEndian  true if input values shall be endian-swapped before conversion (e.g. big endian SEG-Y data on little endian platform)
+  */
+  void ibm2ieee( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian );
+  /**
+  * Convert IEEE floating point values to IBM floating point values, in place
+  */
   void ieee2ibm( unsigned char* values, int numValues );
+  /**
+  * Convert IEEE floating point values to IBM floating point values, writing result to output array, see ibm2ieee()
+  * @param doSwapEndian  true if output values shall be endian-swapped after conversion
+  */
+  void ieee2ibm( unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian );
 
 } // end namespace
 
@@ -3,16 +3,205 @@
 
 #include <string>
 #include <cstring>
+#include <cstdlib>
 #include <limits>
+#include <algorithm>
 #include "csASCIIFileReader.h"
 #include "geolib/csVector.h"
 #include "geolib/csException.h"
+#include "geolib/csFileUtils.h"
+#include "geolib/csThread.h"
 #include "geolib/geolib_string_utils.h"
 
+#ifndef PLATFORM_WINDOWS
+extern "C" {
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+}
+#endif
+
 using namespace std;
 using namespace cseis_io;
 using namespace cseis_geolib;
 
+namespace {
+  double const POWERS_OF_TEN[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                   1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+  int const MAX_FAST_EXPONENT = 22;
+  unsigned long long const MAX_FAST_MANTISSA = 1ULL << 53;
+
+  /// Copy token to null-terminated string, for the rare tokens that are not handled by the fast parsers
+  std::string tokenString( char const* ptr, char const* end ) {
+    return std::string( ptr, end-ptr );
+  }
+  /**
+   * Convert token to double. Returns exactly the same value as atof() on the token.
+   * Plain decimal numbers with up to 19 significant digits and small exponents are converted directly:
+   * Mantissa and power of ten are then both exact doubles, so one multiplication/division is correctly rounded.
+   * All other tokens are passed to atof().
+   */
+  double parseDouble( char const* ptr, char const* end ) {
+    char const* p = ptr;
+    bool isNegative = false;
+    if( p < end && (*p == '-' || *p == '+') ) {
+      isNegative = ( *p == '-' );
+      p++;
+    }
+    unsigned long long mantissa = 0;
+    int numDigits = 0;
+    int exponent  = 0;
+    bool hasDigits = false;
+    while( p < end && *p >= '0' && *p <= '9' ) {
+      hasDigits = true;
+      if( mantissa != 0 || *p != '0' ) {
+        if( ++numDigits > 19 ) return atof( tokenString(ptr,end).c_str() );
+        mantissa = mantissa*10 + (*p - '0');
+      }
+      p++;
+    }
+    if( p < end && *p == '.' ) {
+      p++;
+      while( p < end && *p >= '0' && *p <= '9' ) {
+        hasDigits = true;
+        if( mantissa != 0 || *p != '0' ) {
+          if( ++numDigits > 19 ) return atof( tokenString(ptr,end).c_str() );
+          mantissa = mantissa*10 + (*p - '0');
+        }
+        exponent -= 1;
+        p++;
+      }
+    }
+    if( !hasDigits ) return atof( tokenString(ptr,end).c_str() );
+    if( p < end && (*p == 'e' || *p == 'E') ) {
+      p++;
+      bool isNegativeExp = false;
+      if( p < end && (*p == '-' || *p == '+') ) {
+        isNegativeExp = ( *p == '-' );
+        p++;
+      }
+      if( p == end || *p < '0' || *p > '9' ) return atof( tokenString(ptr,end).c_str() );
+      int exp = 0;
+      while( p < end && *p >= '0' && *p <= '9' ) {
+        if( exp < 10000 ) exp = exp*10 + (*p - '0');
+        p++;
+      }
+      exponent += isNegativeExp ? -exp : exp;
+    }
+    // atof() stops at the first character that cannot continue the number: Only accept delimiters that tokenize() keeps inside tokens
+    if( p != end && *p != ',' && *p != ';' ) return atof( tokenString(ptr,end).c_str() );
+
+    double value;
+    if( mantissa == 0 ) {
+      value = 0.0;
+    }
+    else if( mantissa > MAX_FAST_MANTISSA || exponent < -MAX_FAST_EXPONENT || exponent > MAX_FAST_EXPONENT ) {
+      return atof( tokenString(ptr,end).c_str() );
+    }
+    else if( exponent < 0 ) {
+      value = (double)mantissa / POWERS_OF_TEN[-exponent];
+    }
+    else {
+      value = (double)mantissa * POWERS_OF_TEN[exponent];
+    }
+    return( isNegative ? -value : value );
+  }
+  /**
+   * Convert token to int. Returns the same value as atoi() on the token.
+   */
+  int parseInt( char const* ptr, char const* end ) {
+    char const* p = ptr;
+    bool isNegative = false;
+    if( p < end && (*p == '-' || *p == '+') ) {
+      isNegative = ( *p == '-' );
+      p++;
+    }
+    int value = 0;
+    int numDigits = 0;
+    while( p < end && *p >= '0' && *p <= '9' ) {
+      if( ++numDigits > 9 ) return atoi( tokenString(ptr,end).c_str() );
+      value = value*10 + (*p - '0');
+      p++;
+    }
+    return( isNegative ? -value : value );
+  }
+
+  /**
+   * Parsed lines of one chunk of the data section
+   */
+  struct csASCIIParsedChunk {
+    csASCIIParsedChunk() : values(1024), lineFirstValue(256), lineNumValues(256), lineIntValue3(256) {}
+    csVector<double> values;
+    csVector<int> lineFirstValue;
+    csVector<int> lineNumValues;
+    csVector<int> lineIntValue3;
+  };
+
+  /**
+   * Parse all lines in given range. Tokens are delimited in the same way as in cseis_geolib::tokenize(), without creating token strings.
+   */
+  void parseChunk( char const* begin, char const* end, csASCIIParsedChunk* chunk ) {
+    char const* linePtr = begin;
+    while( linePtr < end ) {
+      char const* lineEnd = (char const*)memchr( linePtr, NEW_LINE, end-linePtr );
+      char const* nextLine = ( lineEnd == NULL ) ? end : lineEnd+1;
+      if( lineEnd == NULL ) lineEnd = end;
+      while( lineEnd > linePtr && (lineEnd[-1] == NEW_LINE || lineEnd[-1] == CARRIAGE_RETURN) ) lineEnd--;
+
+      int numValues = 0;
+      int intValue3 = 0;
+      chunk->lineFirstValue.insertEnd( chunk->values.size() );
+      char const* ptr = linePtr;
+      while( ptr < lineEnd ) {
+        while( ptr < lineEnd && (*ptr == WHITE_SPACE || *ptr == TAB || *ptr == COMMA || *ptr == SEMICOLON) ) ptr++;
+        if( ptr == lineEnd ) break;
+        char const* tokenStart;
+        char const* tokenEnd;
+        bool isQuoted = ( *ptr == DOUBLE_QUOTE );
+        if( isQuoted ) {
+          ptr++;
+          tokenStart = ptr;
+          while( ptr < lineEnd && (*ptr != DOUBLE_QUOTE || ptr[-1] == BACK_SLASH) ) ptr++;
+          tokenEnd = ptr;
+          ptr++;
+        }
+        else {
+          if( *ptr == LETTER_COMMENT ) break;  // Remaining text are comments
+          tokenStart = ptr;
+          while( ptr < lineEnd && *ptr != WHITE_SPACE && *ptr != TAB ) ptr++;
+          tokenEnd = ptr;
+        }
+        if( isQuoted ) {
+          std::string token = tokenString( tokenStart, tokenEnd );
+          chunk->values.insertEnd( atof( token.c_str() ) );
+          if( numValues == 2 ) intValue3 = atoi( token.c_str() );
+        }
+        else {
+          chunk->values.insertEnd( parseDouble( tokenStart, tokenEnd ) );
+          if( numValues == 2 ) intValue3 = parseInt( tokenStart, tokenEnd );
+        }
+        numValues += 1;
+      }
+      chunk->lineNumValues.insertEnd( numValues );
+      chunk->lineIntValue3.insertEnd( intValue3 );
+      linePtr = nextLine;
+    }
+  }
+
+  class csASCIIParseThread : public csThread {
+  public:
+    csASCIIParseThread( char const* begin, char const* end ) : myBegin(begin), myEnd(end) {}
+    void parse() { parseChunk( myBegin, myEnd, &myChunk ); }
+    csASCIIParsedChunk const* chunk() const { return &myChunk; }
+  protected:
+    void run() { parse(); }
+  private:
+    char const* myBegin;
+    char const* myEnd;
+    csASCIIParsedChunk myChunk;
+  };
+}
+
 ASCIIParam::ASCIIParam() {
   sampleList    = new cseis_geolib::csVector<float>(512);
   sampleInt     = 0.0;
@@ -48,22 +237,161 @@ void ASCIIParam::clear() {
 //--------------------------------------------------------------------------------
 //
 csASCIIFileReader::csASCIIFileReader( std::string const& filename, int format ) {
+  myFilename = filename;
   myFormat = format;
   myCurrentTraceIndex = 0;
   myCounterLines = 0;
   myIsAtEOF   = false;
-  myFileASCII = fopen( filename.c_str(), "r" );  myCurrentTraceIndex = 0;
-
-  if( myFileASCII == NULL ) {
+  myData      = NULL;
+  myDataSize  = 0;
+  myIsMapped  = false;
+  myLinePos   = 0;
+  myBufferSize = 1024;
+  myBuffer     = new char[myBufferSize];
+  myBuffer[0]  = '\0';
+
+  myIsParsed       = false;
+  myParsedValues   = NULL;
+  myLineFirstValue = NULL;
+  myLineNumValues  = NULL;
+  myLineIntValue3  = NULL;
+  myNumParsedLines = 0;
+  myCurrentParsedLine = 0;
+  myNumThreads = csThread::numProcessors();
+
+  FILE* fileTest = fopen( filename.c_str(), "r" );
+  if( fileTest == NULL ) {
     throw( cseis_geolib::csException("Could not open file '%s'", filename.c_str() ) );
   }
+  fclose( fileTest );
+  myDataSize = csFileUtils::retrieveFileSize( filename );
+  if( myDataSize > 0 ) {
+#ifdef PLATFORM_WINDOWS
+    FILE* fin = fopen( filename.c_str(), "rb" );
+    char* data = new char[myDataSize];
+    bool success = ( fin != NULL && fread( data, myDataSize, 1, fin ) == 1 );
+    if( fin != NULL ) fclose( fin );
+    myData = data;
+    if( !success ) throw( cseis_geolib::csException("Could not read file '%s'", filename.c_str() ) );
+#else
+    int fd = ::open( filename.c_str(), O_RDONLY );
+    void* ptr = ( fd < 0 ) ? MAP_FAILED : mmap( NULL, (size_t)myDataSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    if( fd >= 0 ) ::close( fd );
+    if( ptr == MAP_FAILED ) {
+      throw( cseis_geolib::csException("Could not map file '%s' into memory", filename.c_str() ) );
+    }
+    myData = (char const*)ptr;
+    myIsMapped = true;
+    madvise( ptr, (size_t)myDataSize, MADV_SEQUENTIAL );
+#endif
+  }
 }
 
 csASCIIFileReader::~csASCIIFileReader() {
-  if( myFileASCII != NULL ) {
-    fclose( myFileASCII );
-    myFileASCII = NULL;
+  if( myData != NULL ) {
+#ifndef PLATFORM_WINDOWS
+    if( myIsMapped ) munmap( const_cast<char*>(myData), (size_t)myDataSize );
+#else
+    delete [] myData;
+#endif
+    myData = NULL;
+  }
+  if( myBuffer != NULL ) {
+    delete [] myBuffer;
+    myBuffer = NULL;
+  }
+  if( myParsedValues != NULL ) {
+    delete [] myParsedValues;
+    delete [] myLineFirstValue;
+    delete [] myLineNumValues;
+    delete [] myLineIntValue3;
+    myParsedValues = NULL;
+  }
+}
+
+void csASCIIFileReader::setNumThreads( int numThreads ) {
+  myNumThreads = std::max( numThreads, 1 );
+}
+//--------------------------------------------------------------------------------
+// Read next line into myBuffer, including new line character (same as fgets, but without line length limit)
+bool csASCIIFileReader::readLine() {
+  if( myLinePos >= myDataSize ) return false;
+  char const* linePtr = &myData[myLinePos];
+  char const* lineEnd = (char const*)memchr( linePtr, NEW_LINE, myDataSize-myLinePos );
+  int length = ( lineEnd == NULL ) ? (int)(myDataSize-myLinePos) : (int)(lineEnd-linePtr) + 1;
+  if( length+1 > myBufferSize ) {
+    delete [] myBuffer;
+    myBufferSize = length+1;
+    myBuffer = new char[myBufferSize];
+  }
+  memcpy( myBuffer, linePtr, length );
+  myBuffer[length] = '\0';
+  myLinePos += length;
+  return true;
+}
+void csASCIIFileReader::rewindFile() {
+  myLinePos = 0;
+}
+//--------------------------------------------------------------------------------
+// Parse all lines from current position to end of file, split into line-aligned chunks parsed in parallel
+void csASCIIFileReader::parseDataSection() {
+  myIsParsed = true;
+  char const* begin = &myData[std::min(myLinePos,myDataSize)];
+  char const* end   = &myData[myDataSize];
+  if( myData == NULL ) begin = end = NULL;
+  csInt64_t numBytes = end - begin;
+  int numThreads = (int)std::min( (csInt64_t)myNumThreads, numBytes / MIN_BYTES_PER_THREAD + 1 );
+
+  csVector<csASCIIParseThread*> threadList;
+  char const* chunkBegin = begin;
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    char const* chunkEnd = end;
+    if( ithread < numThreads-1 ) {
+      chunkEnd = begin + (numBytes * (ithread+1)) / numThreads;
+      if( chunkEnd < chunkBegin ) chunkEnd = chunkBegin;
+      char const* newLine = (char const*)memchr( chunkEnd, NEW_LINE, end-chunkEnd );
+      chunkEnd = ( newLine == NULL ) ? end : newLine+1;
+    }
+    threadList.insertEnd( new csASCIIParseThread( chunkBegin, chunkEnd ) );
+    chunkBegin = chunkEnd;
+  }
+  // First chunk is parsed by calling thread
+  for( int ithread = 1; ithread < numThreads; ithread++ ) {
+    if( !threadList.at(ithread)->start() ) threadList.at(ithread)->parse();
   }
+  threadList.at(0)->parse();
+  int numValues = 0;
+  myNumParsedLines = 0;
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    threadList.at(ithread)->join();
+    numValues        += threadList.at(ithread)->chunk()->values.size();
+    myNumParsedLines += threadList.at(ithread)->chunk()->lineNumValues.size();
+  }
+  myParsedValues   = new double[std::max(numValues,1)];
+  myLineFirstValue = new int[std::max(myNumParsedLines,1)];
+  myLineNumValues  = new int[std::max(myNumParsedLines,1)];
+  myLineIntValue3  = new int[std::max(myNumParsedLines,1)];
+  int valueOffset = 0;
+  int lineOffset  = 0;
+  for( int ithread = 0; ithread < numThreads; ithread++ ) {
+    csASCIIParsedChunk const* chunk = threadList.at(ithread)->chunk();
+    int numChunkValues = chunk->values.size();
+    int numChunkLines  = chunk->lineNumValues.size();
+    if( numChunkValues > 0 ) memcpy( &myParsedValues[valueOffset], chunk->values.toArray(), numChunkValues*sizeof(double) );
+    if( numChunkLines > 0 ) {
+      memcpy( &myLineNumValues[lineOffset], chunk->lineNumValues.toArray(), numChunkLines*sizeof(int) );
+      memcpy( &myLineIntValue3[lineOffset], chunk->lineIntValue3.toArray(), numChunkLines*sizeof(int) );
+    }
+    int const* firstValue = chunk->lineFirstValue.toArray();
+    for( int iline = 0; iline < numChunkLines; iline++ ) {
+      myLineFirstValue[lineOffset+iline] = firstValue[iline] + valueOffset;
+    }
+    valueOffset += numChunkValues;
+    lineOffset  += numChunkLines;
+    delete threadList.at(ithread);
+  }
+  myCurrentParsedLine = 0;
+  myLinePos = myDataSize;
 }
 
 bool csASCIIFileReader::isAtEOF() const {
@@ -80,7 +408,7 @@ bool csASCIIFileReader::initialize( ASCIIParam* param ) {
     cseis_geolib::csVector<std::string> tokenList;
     int counter = 0;
     bool isNucleusPlus = false;
-    while( fgets( myBuffer, 1024, myFileASCII ) != NULL && isReadingHdr ) {
+    while( readLine() && isReadingHdr ) {
       counter += 1;
       tokenList.clear();
       cseis_geolib::tokenize( myBuffer, tokenList, false );
@@ -128,9 +456,9 @@ bool csASCIIFileReader::initialize( ASCIIParam* param ) {
     if( !success ) return false;
     param->myNumSamples = param->sampleList->size();
     // Rewind input file and set pointer back to start of data
-    rewind( myFileASCII );
+    rewindFile();
     for( int i = 0; i < counter; i++ ) {
-      success = fgets( myBuffer, 1024, myFileASCII );
+      success = readLine();
     }
     myIsAtEOF = false;
     myCurrentTraceIndex = 0;
@@ -149,7 +477,8 @@ bool csASCIIFileReader::initialize( ASCIIParam* param ) {
     param->timeFirstSamp = timeList.at(0);
     param->timeLastSamp  = timeList.at(myNumSamples-1);
     param->sampleInt = (float)( timeList.at(1) - timeList.at(0) );
-    rewind( myFileASCII );
+    // Rewind: Start again from first parsed line
+    myCurrentParsedLine = 0;
   }
   //----------------------------------------------------------------------
   //
@@ -170,7 +499,7 @@ bool csASCIIFileReader::initializeZMap( ASCIIParam* param,
   if( myCurrentTraceIndex > 0 ) return false;
   if( myFormat != FORMAT_ZMAP ) throw( csException("csASCIIFileReader::initializeZMap: Wrong ASCII file format. This is a program bug in the calling function") );
 
-    if( fgets( myBuffer, 1024, myFileASCII ) == NULL ) {
+    if( !readLine() ) {
       throw( csException("ASCII input file contains no data.") );
     }
     myCounterLines = 1;
@@ -178,7 +507,7 @@ bool csASCIIFileReader::initializeZMap( ASCIIParam* param,
     if( myBuffer[0] != '!' ) {
       throw( csException("Unexpected character found in line #%d: %s", myCounterLines+1, myBuffer) );
     }
-    while( fgets( myBuffer, 1024, myFileASCII ) != NULL ) {
+    while( readLine() ) {
       if( myBuffer[0] != '!' ) {
 	break;
       }
@@ -188,14 +517,14 @@ bool csASCIIFileReader::initializeZMap( ASCIIParam* param,
     if( myBuffer[0] != '@' ) {
       throw( csException("Unexpected character found in line #%d: %s", myCounterLines+1, myBuffer) );
     }
-    if( fgets( myBuffer, 1024, myFileASCII ) == NULL ) {
+    if( !readLine() ) {
       throw( csException("Unexpected end of file") );
     }
     csVector<std::string> valueList;
     tokenize( myBuffer, valueList );
     myZMap_noValue = atof(valueList.at(1).c_str());
 
-    if( fgets( myBuffer, 1024, myFileASCII ) == NULL ) {
+    if( !readLine() ) {
       throw( csException("Unexpected end of file") );
     }
     valueList.clear();
@@ -212,10 +541,10 @@ bool csASCIIFileReader::initializeZMap( ASCIIParam* param,
     zmap_y2   = atof(valueList.at(5).c_str());
     param->sampleInt = 1000 * (zmap_x1-zmap_x2) / param->myNumSamples;
 
-    if( fgets( myBuffer, 1024, myFileASCII ) == NULL ) {
+    if( !readLine() ) {
       throw( csException("Unexpected end of file") );
     }
-    if( fgets( myBuffer, 1024, myFileASCII ) == NULL ) {
+    if( !readLine() ) {
       throw( csException("Unexpected end of file") );
     }
     myNumSamples = param->myNumSamples;
@@ -248,7 +577,7 @@ bool csASCIIFileReader::readNextTrace( ASCIIParam* param ) {
 
   if( myFormat == FORMAT_NUCLEUS_SIGNATURE ) {
     cseis_geolib::csVector<std::string> valueList;
-    while( fgets( myBuffer, 1024, myFileASCII ) != NULL ) {
+    while( readLine() ) {
       tokenize( myBuffer, valueList );
       if( valueList.size() == 0 ) continue;  // Read over blank lines
       for( int i = 0; i < valueList.size(); i++ ) {
@@ -278,27 +607,24 @@ bool csASCIIFileReader::readNextTrace( ASCIIParam* param ) {
     }
   }
   else if( myFormat == FORMAT_ZMAP ) {
-    csVector<std::string> valueList;
-    int counterLines  = 0;
-    bool success = fgets( myBuffer, 1024, myFileASCII );
-    if( !success ) {
+    if( !myIsParsed ) parseDataSection();
+    if( myCurrentParsedLine == myNumParsedLines ) {
       myIsAtEOF = true;
       retValue = false;
     }
     else {
       retValue = true;
-      while( success ) {
-        valueList.clear();
-        tokenize( myBuffer, valueList );
-        for( int i = 0; i < valueList.size(); i++ ) {
-          double value = atof(valueList.at(i).c_str());
+      while( myCurrentParsedLine < myNumParsedLines ) {
+        int iline = myCurrentParsedLine++;
+        double const* values = &myParsedValues[myLineFirstValue[iline]];
+        int numValues = myLineNumValues[iline];
+        for( int i = 0; i < numValues; i++ ) {
+          double value = values[i];
           if( value == myZMap_noValue ) value = 0.0;
           param->sampleList->insertEnd(value);
           if( param->sampleList->size() >= myNumSamples ) break;
         }
-        counterLines += 1;
         if( param->sampleList->size() >= myNumSamples ) break;
-        success = fgets( myBuffer, 1024, myFileASCII );
       }
     }
   }
@@ -316,41 +642,40 @@ bool csASCIIFileReader::readOneTraceColumnFormat( cseis_geolib::csVector<double>
                                                   int traceIndexToRead )
 {
   sampleList->clear();
-  cseis_geolib::csVector<std::string> valueList;
+  if( !myIsParsed ) parseDataSection();
 
   int counter = 0;
   double timePrev    = 0.0;
   double timeCurrent = 0.0;
   int trcIndex = traceIndexToRead;
 
-  while( counter < maxSamplesToRead && fgets( myBuffer, 1024, myFileASCII ) != NULL ) {
-    valueList.clear();
-    cseis_geolib::tokenize( myBuffer, valueList );
-    if( valueList.size() == 2 ) {
+  while( counter < maxSamplesToRead && myCurrentParsedLine < myNumParsedLines ) {
+    int iline = myCurrentParsedLine++;
+    int numValues = myLineNumValues[iline];
+    double const* values = &myParsedValues[myLineFirstValue[iline]];
+    if( numValues == 2 ) {
       // Nothing..
     }
-    else if( valueList.size() > 2 ) {
-      trcIndex = atoi( valueList.at(2).c_str() );
+    else if( numValues > 2 ) {
+      trcIndex = myLineIntValue3[iline];
     }
-    else if( valueList.size() == 0 ) {
+    else if( numValues == 0 ) {
       continue; // Skip blank lines
     }
-    else { //  if( valueList.size() < 2 ) {
+    else { //  if( numValues < 2 ) {
       throw( cseis_geolib::csException("Incorrect number of columns (=%d) in input file, line #%d",
-                                       valueList.size(), counter+myCounterLines ));
+                                       numValues, counter+myCounterLines ));
     }
-    timeCurrent = atof( valueList.at(0).c_str() );
+    timeCurrent = values[0];
 
     if( timeCurrent < timePrev || trcIndex != traceIndexToRead ) { // Time jumps backwards, new trace index --> New trace
       return false;
     }
     timeList->insertEnd(timeCurrent);
-    float sampleValue = atof( valueList.at(1).c_str() );
+    float sampleValue = values[1];
     sampleList->insertEnd( sampleValue );
 
     counter += 1;
   }
   return true;
 }
-
-
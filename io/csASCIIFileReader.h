@@ -7,6 +7,8 @@
 #define CS_ASCII_FILE_READER_H
 
 #include <cstdio>
+#include <string>
+#include "geolib/geolib_defines.h"
 
 namespace cseis_geolib {
   template <typename T> class csVector;
@@ -34,12 +36,21 @@ class ASCIIParam {
   cseis_geolib::csVector<float>* sampleList;
 };
 
+/**
+ * Reader for ASCII seismic files
+ *
+ * The input file is memory-mapped. For column and ZMap formats, the data section is parsed once, in
+ * line-aligned chunks on several threads, into a flat list of numeric values. Traces are then assembled
+ * from the parsed values. Lines may have any length.
+ */
 class csASCIIFileReader {
  public:
   static int const FORMAT_NUCLEUS_SIGNATURE = 11;
   static int const FORMAT_COLUMNS  = 12;
   static int const FORMAT_ZMAP     = 13;
   static int const FORMAT_NUCLEUS_PLUS = 14;
+  /// Minimum number of bytes parsed by one thread
+  static int const MIN_BYTES_PER_THREAD = 4*1024*1024;
 
   /**
    * @param filename  ASCII file name.
@@ -60,6 +71,10 @@ class csASCIIFileReader {
                        double& zmap_x2,
                        double& zmap_y2 );
   bool isAtEOF() const;
+  /**
+   * Set number of threads used to parse the data section. Default: Number of processors
+   */
+  void setNumThreads( int numThreads );
 
  private:
   //  bool readOneTraceColumnFormat( ASCIIParam* param );
@@ -68,9 +83,32 @@ class csASCIIFileReader {
                                  int maxSamplesToRead,
                                  int traceIndexToRead );
 
-  FILE* myFileASCII;
+  bool readLine();
+  void rewindFile();
+  void parseDataSection();
+
+  std::string myFilename;
   int myFormat;
-  char myBuffer[1024];
+  /// File contents (memory-mapped)
+  char const* myData;
+  csInt64_t myDataSize;
+  bool myIsMapped;
+  /// Byte position of next line to read
+  csInt64_t myLinePos;
+  /// Current line, null-terminated
+  char* myBuffer;
+  int myBufferSize;
+
+  /// Parsed data section: Numeric value of each token, and per line index of first value, number of values, and integer value of 3rd token
+  bool myIsParsed;
+  double* myParsedValues;
+  int* myLineFirstValue;
+  int* myLineNumValues;
+  int* myLineIntValue3;
+  int myNumParsedLines;
+  int myCurrentParsedLine;
+  int myNumThreads;
+
   int myNumColumns;
   int myCounterLines;
   int myCurrentTraceIndex;
@@ -0,0 +1,236 @@
+
+
+#include "csBrickVolumeConverter.h"
+#include "csBrickVolumeWriter.h"
+#include "csGeneralSeismicReader.h"
+#include "csSeismicIOConfig.h"
+#include "csRSFReader.h"
+#include "csRSFHeader.h"
+#include "geolib/csException.h"
+#include <cstring>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <algorithm>
+
+using namespace cseis_io;
+
+int const csBrickVolumeConverter::NUM_TRACES_BLOCK = 1024;
+
+namespace {
+  /// @return Header value of given trace from header column returned by csGeneralSeismicReader::readTraces()
+  int columnValue( char const* column, cseis_geolib::type_t type, int traceIndex ) {
+    switch( type ) {
+    case cseis_geolib::TYPE_INT: {
+      int value;
+      memcpy( &value, &column[traceIndex*sizeof(int)], sizeof(int) );
+      return value;
+    }
+    case cseis_geolib::TYPE_FLOAT: {
+      float value;
+      memcpy( &value, &column[traceIndex*sizeof(float)], sizeof(float) );
+      return (int)floor( value + 0.5f );
+    }
+    case cseis_geolib::TYPE_DOUBLE: {
+      double value;
+      memcpy( &value, &column[traceIndex*sizeof(double)], sizeof(double) );
+      return (int)floor( value + 0.5 );
+    }
+    case cseis_geolib::TYPE_INT64: {
+      csInt64_t value;
+      memcpy( &value, &column[traceIndex*sizeof(csInt64_t)], sizeof(csInt64_t) );
+      return (int)value;
+    }
+    }
+    return 0;
+  }
+  int gcd( int a, int b ) {
+    while( b != 0 ) {
+      int tmp = a % b;
+      a = b;
+      b = tmp;
+    }
+    return a;
+  }
+  /// Set first line number and increment from RSF axis if these are integers, otherwise number lines from 1
+  void setLineNumbering( double orig, double step, int& first, int& inc ) {
+    if( orig == floor(orig) && step == floor(step) && step != 0.0 ) {
+      first = (int)orig;
+      inc   = (int)step;
+    }
+    else {
+      first = 1;
+      inc   = 1;
+    }
+  }
+}
+
+//--------------------------------------------------------------------
+int csBrickVolumeConverter::convertCSEIS( std::string const& filenameIn, std::string const& filenameOut, int brickSize,
+                                          std::string const& hdrNameInline, std::string const& hdrNameCrossline ) {
+  csGeneralSeismicReader reader( filenameIn, true, NUM_TRACES_BLOCK );
+  if( !reader.readFileHeader() ) {
+    throw( cseis_geolib::csException("Error when reading file header of input file '%s'", filenameIn.c_str()) );
+  }
+  int hdrIndices[2];
+  hdrIndices[0] = reader.headerIndex( hdrNameInline );
+  hdrIndices[1] = reader.headerIndex( hdrNameCrossline );
+  for( int i = 0; i < 2; i++ ) {
+    std::string const& name = ( i == 0 ) ? hdrNameInline : hdrNameCrossline;
+    if( hdrIndices[i] < 0 ) {
+      throw( cseis_geolib::csException("Trace header '%s' not found in input file '%s'", name.c_str(), filenameIn.c_str()) );
+    }
+    cseis_geolib::type_t type = reader.headerType( hdrIndices[i] );
+    if( type != cseis_geolib::TYPE_INT && type != cseis_geolib::TYPE_FLOAT && type != cseis_geolib::TYPE_DOUBLE && type != cseis_geolib::TYPE_INT64 ) {
+      throw( cseis_geolib::csException("Trace header '%s' has unsupported type for inline/crossline number", name.c_str()) );
+    }
+  }
+  cseis_geolib::type_t typeIL = reader.headerType( hdrIndices[0] );
+  cseis_geolib::type_t typeXL = reader.headerType( hdrIndices[1] );
+  int numTraces  = reader.numTraces();
+  int numSamples = reader.getSeismicConfig()->numSamples;
+  if( numTraces <= 0 ) {
+    throw( cseis_geolib::csException("Input file '%s' contains no traces", filenameIn.c_str()) );
+  }
+
+  char* hdrColumns[2];
+  hdrColumns[0] = new char[NUM_TRACES_BLOCK*sizeof(double)];
+  hdrColumns[1] = new char[NUM_TRACES_BLOCK*sizeof(double)];
+  float* samples = new float[(size_t)NUM_TRACES_BLOCK*numSamples];
+  int* traceInlines = new int[numTraces];
+
+  // Pass 1: Determine inline/crossline range and increment from trace headers only
+  int minIL = std::numeric_limits<int>::max();
+  int maxIL = std::numeric_limits<int>::min();
+  int minXL = minIL;
+  int maxXL = maxIL;
+  int refIL = 0;
+  int refXL = 0;
+  int stepIL = 0;
+  int stepXL = 0;
+  for( int itrc = 0; itrc < numTraces; itrc += NUM_TRACES_BLOCK ) {
+    int numRead = reader.readTraces( std::min( NUM_TRACES_BLOCK, numTraces-itrc ), NULL, 0, 2, hdrIndices, hdrColumns );
+    for( int i = 0; i < numRead; i++ ) {
+      int il = columnValue( hdrColumns[0], typeIL, i );
+      int xl = columnValue( hdrColumns[1], typeXL, i );
+      traceInlines[itrc+i] = il;
+      if( itrc == 0 && i == 0 ) {
+        refIL = il;
+        refXL = xl;
+      }
+      stepIL = gcd( stepIL, abs(il - refIL) );
+      stepXL = gcd( stepXL, abs(xl - refXL) );
+      if( il < minIL ) minIL = il;
+      if( il > maxIL ) maxIL = il;
+      if( xl < minXL ) minXL = xl;
+      if( xl > maxXL ) maxXL = xl;
+    }
+    if( numRead == 0 ) break;
+  }
+  if( stepIL == 0 ) stepIL = 1;
+  if( stepXL == 0 ) stepXL = 1;
+
+  csBrickVolumeHeader hdr;
+  hdr.setConfig( reader.getSeismicConfig() );
+  hdr.brickSize      = brickSize;
+  hdr.firstInline    = minIL;
+  hdr.inlineStep     = stepIL;
+  hdr.numInlines     = (maxIL - minIL) / stepIL + 1;
+  hdr.firstCrossline = minXL;
+  hdr.crosslineStep  = stepXL;
+  hdr.numCrosslines  = (maxXL - minXL) / stepXL + 1;
+
+  csBrickVolumeWriter writer( filenameOut );
+  if( !writer.writeFileHeader( &hdr ) ) {
+    throw( cseis_geolib::csException("Error when writing file header of output file '%s'", filenameOut.c_str()) );
+  }
+  // Order traces by slab (brickSize inlines), keeping the input order within each slab: The writer holds one slab in memory,
+  // so every slab is then filled and written out once, whatever the sort order of the input file
+  int numSlabs = ( hdr.numInlines + brickSize - 1 ) / brickSize;
+  int* slabFirstTrace = new int[numSlabs+1];
+  int* traceOrder = new int[numTraces];
+  for( int islab = 0; islab <= numSlabs; islab++ ) {
+    slabFirstTrace[islab] = 0;
+  }
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    traceInlines[itrc] = hdr.inlineIndex( traceInlines[itrc] ) / brickSize;
+    slabFirstTrace[traceInlines[itrc]+1] += 1;
+  }
+  for( int islab = 0; islab < numSlabs; islab++ ) {
+    slabFirstTrace[islab+1] += slabFirstTrace[islab];
+  }
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    traceOrder[slabFirstTrace[traceInlines[itrc]]++] = itrc;
+  }
+
+  // Pass 2: Copy traces into bricks, slab by slab. Consecutive input traces of the same slab are read in one block
+  int numConverted = 0;
+  bool success = true;
+  int iorder = 0;
+  while( iorder < numTraces && success ) {
+    int firstTrace = traceOrder[iorder];
+    int numTracesRun = 1;
+    while( numTracesRun < NUM_TRACES_BLOCK && iorder+numTracesRun < numTraces && traceOrder[iorder+numTracesRun] == firstTrace+numTracesRun ) {
+      numTracesRun += 1;
+    }
+    if( !reader.moveToTrace( firstTrace, numTracesRun ) ) {
+      success = false;
+      break;
+    }
+    int numRead = reader.readTraces( numTracesRun, samples, numSamples, 2, hdrIndices, hdrColumns );
+    for( int i = 0; i < numRead && success; i++ ) {
+      success = writer.writeTrace( columnValue( hdrColumns[0], typeIL, i ), columnValue( hdrColumns[1], typeXL, i ), &samples[(size_t)i*numSamples] );
+      if( success ) numConverted += 1;
+    }
+    if( numRead < numTracesRun ) success = false;
+    iorder += numTracesRun;
+  }
+  success = writer.close() && success;
+  delete [] hdrColumns[0];
+  delete [] hdrColumns[1];
+  delete [] samples;
+  delete [] traceInlines;
+  delete [] slabFirstTrace;
+  delete [] traceOrder;
+  if( !success ) {
+    throw( cseis_geolib::csException("Error when writing bricked volume to output file '%s'", filenameOut.c_str()) );
+  }
+  return numConverted;
+}
+//--------------------------------------------------------------------
+int csBrickVolumeConverter::convertRSF( std::string const& filenameIn, std::string const& filenameOut, int brickSize ) {
+  csRSFReader reader( filenameIn, NUM_TRACES_BLOCK, false );
+  csRSFHeader rsfHdr;
+  reader.initialize( &rsfHdr );
+
+  csBrickVolumeHeader hdr;
+  hdr.brickSize     = brickSize;
+  hdr.numSamples    = reader.numSamples();
+  hdr.sampleInt     = reader.sampleInt();
+  hdr.domain        = reader.getCSEISDomain();
+  hdr.numCrosslines = rsfHdr.n2;
+  hdr.numInlines    = ( rsfHdr.n3 > 0 ) ? rsfHdr.n3 : 1;
+  setLineNumbering( rsfHdr.o2, rsfHdr.d2, hdr.firstCrossline, hdr.crosslineStep );
+  setLineNumbering( rsfHdr.o3, rsfHdr.d3, hdr.firstInline, hdr.inlineStep );
+
+  csBrickVolumeWriter writer( filenameOut );
+  if( !writer.writeFileHeader( &hdr ) ) {
+    throw( cseis_geolib::csException("Error when writing file header of output file '%s'", filenameOut.c_str()) );
+  }
+  float* samples = new float[hdr.numSamples];
+  int numTraces = reader.numTraces();
+  int numConverted = 0;
+  bool success = true;
+  for( int itrc = 0; itrc < numTraces && success; itrc++ ) {
+    if( !reader.getNextTrace( reinterpret_cast<cseis_geolib::byte_t*>( samples ), hdr.numSamples ) ) break;
+    // RSF traces are ordered by dimension 2 (crossline) fastest
+    success = writer.writeTraceAtIndex( itrc / hdr.numCrosslines, itrc % hdr.numCrosslines, samples );
+    if( success ) numConverted += 1;
+  }
+  success = writer.close() && success;
+  delete [] samples;
+  if( !success ) {
+    throw( cseis_geolib::csException("Error when writing bricked volume to output file '%s'", filenameOut.c_str()) );
+  }
+  return numConverted;
+}
@@ -0,0 +1,48 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_BRICK_VOLUME_CONVERTER_H
+#define CS_BRICK_VOLUME_CONVERTER_H
+
+#include <string>
+
+namespace cseis_io {
+
+/**
+ * Conversion of trace-sequential seismic files to bricked 3D volume files, see csBrickVolumeHeader
+ */
+class csBrickVolumeConverter {
+ public:
+  static int const NUM_TRACES_BLOCK;
+ public:
+  /**
+   * Convert Cseis file to bricked volume.
+   * The inline/crossline range and increment are determined in a first pass over the trace headers.
+   * Traces may be in any order: They are copied slab by slab (brickSize inlines at a time), so that each slab of the output
+   * file is written once. Inline-sorted input is read sequentially, other input with one seek per run of consecutive traces.
+   * @param filenameIn       Input Cseis file
+   * @param filenameOut      Output bricked volume file
+   * @param brickSize        Brick size in samples, inlines and crosslines
+   * @param hdrNameInline    Name of trace header holding inline number
+   * @param hdrNameCrossline Name of trace header holding crossline number
+   * @return Number of traces converted
+   */
+  static int convertCSEIS( std::string const& filenameIn, std::string const& filenameOut, int brickSize,
+                           std::string const& hdrNameInline, std::string const& hdrNameCrossline );
+  /**
+   * Convert 3D RSF file to bricked volume.
+   * RSF dimension 1 is the sample axis, dimension 2 the crossline axis, and dimension 3 the inline axis.
+   * Inline/crossline numbers are taken from the origin and increment of dimensions 3 and 2 if these are integer values,
+   * otherwise inlines and crosslines are numbered from 1.
+   * @return Number of traces converted
+   */
+  static int convertRSF( std::string const& filenameIn, std::string const& filenameOut, int brickSize );
+
+ private:
+  csBrickVolumeConverter();
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,149 @@
+
+
+#include "csBrickVolumeHeader.h"
+#include "csSeismicIOConfig.h"
+#include "geolib/geolib_platform_dependent.h"
+#include <cstring>
+
+using namespace cseis_io;
+
+namespace {
+  static char const BRICK_ID_TEXT[] = "CSBRICKV";
+}
+
+csBrickVolumeHeader::csBrickVolumeHeader() {
+  brickSize  = DEFAULT_BRICK_SIZE;
+  numSamples = 0;
+  sampleInt  = 0;
+  domain     = 0;
+
+  firstInline    = 0;
+  inlineStep     = 1;
+  numInlines     = 0;
+  firstCrossline = 0;
+  crosslineStep  = 1;
+  numCrosslines  = 0;
+
+  grid_orig_x  = 0.0;
+  grid_orig_y  = 0.0;
+  grid_orig_il = 0;
+  grid_orig_xl = 0;
+  grid_binsize_il = 0.0;
+  grid_binsize_xl = 0.0;
+  grid_azim_il = 0.0;
+  grid_azim_xl = 0.0;
+
+  numBricksSample    = 0;
+  numBricksCrossline = 0;
+  numBricksInline    = 0;
+}
+csBrickVolumeHeader::~csBrickVolumeHeader() {
+}
+//--------------------------------------------------------------------
+void csBrickVolumeHeader::setConfig( csSeismicIOConfig const* config ) {
+  numSamples = config->numSamples;
+  sampleInt  = config->sampleInt;
+  domain     = config->domain;
+  grid_orig_x     = config->grid_orig_x;
+  grid_orig_y     = config->grid_orig_y;
+  grid_orig_il    = config->grid_orig_il;
+  grid_orig_xl    = config->grid_orig_xl;
+  grid_binsize_il = config->grid_binsize_il;
+  grid_binsize_xl = config->grid_binsize_xl;
+  grid_azim_il    = config->grid_azim_il;
+  grid_azim_xl    = config->grid_azim_xl;
+}
+void csBrickVolumeHeader::getConfig( csSeismicIOConfig* config ) const {
+  config->numSamples = numSamples;
+  config->sampleInt  = sampleInt;
+  config->domain     = domain;
+  config->grid_orig_x     = grid_orig_x;
+  config->grid_orig_y     = grid_orig_y;
+  config->grid_orig_il    = grid_orig_il;
+  config->grid_orig_xl    = grid_orig_xl;
+  config->grid_binsize_il = grid_binsize_il;
+  config->grid_binsize_xl = grid_binsize_xl;
+  config->grid_azim_il    = grid_azim_il;
+  config->grid_azim_xl    = grid_azim_xl;
+  config->numTraces       = numInlines * numCrosslines;
+  config->byteSizeSamples = numSamples * 4;
+}
+//--------------------------------------------------------------------
+void csBrickVolumeHeader::computeBricks() {
+  numBricksSample    = ( numSamples + brickSize - 1 ) / brickSize;
+  numBricksCrossline = ( numCrosslines + brickSize - 1 ) / brickSize;
+  numBricksInline    = ( numInlines + brickSize - 1 ) / brickSize;
+}
+//--------------------------------------------------------------------
+int csBrickVolumeHeader::inlineIndex( int inlineNumber ) const {
+  int diff = inlineNumber - firstInline;
+  if( diff % inlineStep != 0 ) return -1;
+  int index = diff / inlineStep;
+  if( index < 0 || index >= numInlines ) return -1;
+  return index;
+}
+int csBrickVolumeHeader::crosslineIndex( int crosslineNumber ) const {
+  int diff = crosslineNumber - firstCrossline;
+  if( diff % crosslineStep != 0 ) return -1;
+  int index = diff / crosslineStep;
+  if( index < 0 || index >= numCrosslines ) return -1;
+  return index;
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeHeader::write( FILE* file ) const {
+  char buffer[FILE_HEADER_BYTE_SIZE];
+  memset( buffer, 0, FILE_HEADER_BYTE_SIZE );
+  int version = VERSION;
+  memcpy( &buffer[0], BRICK_ID_TEXT, 8 );
+  memcpy( &buffer[8], &version, 4 );
+  memcpy( &buffer[12], &brickSize, 4 );
+  memcpy( &buffer[16], &numSamples, 4 );
+  memcpy( &buffer[20], &sampleInt, 4 );
+  memcpy( &buffer[24], &domain, 4 );
+  memcpy( &buffer[28], &firstInline, 4 );
+  memcpy( &buffer[32], &inlineStep, 4 );
+  memcpy( &buffer[36], &numInlines, 4 );
+  memcpy( &buffer[40], &firstCrossline, 4 );
+  memcpy( &buffer[44], &crosslineStep, 4 );
+  memcpy( &buffer[48], &numCrosslines, 4 );
+  memcpy( &buffer[52], &grid_orig_il, 4 );
+  memcpy( &buffer[56], &grid_orig_xl, 4 );
+  memcpy( &buffer[64], &grid_orig_x, 8 );
+  memcpy( &buffer[72], &grid_orig_y, 8 );
+  memcpy( &buffer[80], &grid_binsize_il, 8 );
+  memcpy( &buffer[88], &grid_binsize_xl, 8 );
+  memcpy( &buffer[96], &grid_azim_il, 8 );
+  memcpy( &buffer[104], &grid_azim_xl, 8 );
+  if( fseeko64( file, 0, SEEK_SET ) != 0 ) return false;
+  return( fwrite( buffer, FILE_HEADER_BYTE_SIZE, 1, file ) == 1 );
+}
+bool csBrickVolumeHeader::read( FILE* file ) {
+  char buffer[FILE_HEADER_BYTE_SIZE];
+  if( fseeko64( file, 0, SEEK_SET ) != 0 ) return false;
+  if( fread( buffer, FILE_HEADER_BYTE_SIZE, 1, file ) != 1 ) return false;
+  if( strncmp( buffer, BRICK_ID_TEXT, 8 ) ) return false;
+  int version;
+  memcpy( &version, &buffer[8], 4 );
+  if( version != VERSION ) return false;
+  memcpy( &brickSize, &buffer[12], 4 );
+  memcpy( &numSamples, &buffer[16], 4 );
+  memcpy( &sampleInt, &buffer[20], 4 );
+  memcpy( &domain, &buffer[24], 4 );
+  memcpy( &firstInline, &buffer[28], 4 );
+  memcpy( &inlineStep, &buffer[32], 4 );
+  memcpy( &numInlines, &buffer[36], 4 );
+  memcpy( &firstCrossline, &buffer[40], 4 );
+  memcpy( &crosslineStep, &buffer[44], 4 );
+  memcpy( &numCrosslines, &buffer[48], 4 );
+  memcpy( &grid_orig_il, &buffer[52], 4 );
+  memcpy( &grid_orig_xl, &buffer[56], 4 );
+  memcpy( &grid_orig_x, &buffer[64], 8 );
+  memcpy( &grid_orig_y, &buffer[72], 8 );
+  memcpy( &grid_binsize_il, &buffer[80], 8 );
+  memcpy( &grid_binsize_xl, &buffer[88], 8 );
+  memcpy( &grid_azim_il, &buffer[96], 8 );
+  memcpy( &grid_azim_xl, &buffer[104], 8 );
+  if( brickSize <= 0 || numSamples < 0 || numInlines < 0 || numCrosslines < 0 || inlineStep == 0 || crosslineStep == 0 ) return false;
+  computeBricks();
+  return true;
+}
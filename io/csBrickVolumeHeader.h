@@ -0,0 +1,99 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_BRICK_VOLUME_HEADER_H
+#define CS_BRICK_VOLUME_HEADER_H
+
+#include <cstdio>
+#include "geolib/geolib_defines.h"
+
+namespace cseis_io {
+
+class csSeismicIOConfig;
+
+/**
+ * File header of bricked 3D volume file
+ *
+ * A bricked volume stores a regular 3D grid of samples (inline x crossline x sample) in cubic bricks
+ * of brickSize^3 samples. Within one brick, samples are stored fastest, then crosslines, then inlines.
+ * Bricks are stored sample-brick fastest, then crossline-brick, then inline-brick. Edge bricks are
+ * padded with zeros, so that every brick has the same byte size and the file position of each brick
+ * can be computed directly.
+ * All values are stored in native byte order, as in the Cseis format.
+ */
+class csBrickVolumeHeader {
+ public:
+  static int const VERSION = 1;
+  static int const FILE_HEADER_BYTE_SIZE = 512;
+  static int const DEFAULT_BRICK_SIZE = 64;
+
+ public:
+  csBrickVolumeHeader();
+  ~csBrickVolumeHeader();
+  /**
+   * Set super header information (number of samples, sample interval, domain, grid definition) from Cseis I/O config
+   */
+  void setConfig( csSeismicIOConfig const* config );
+  /**
+   * Copy super header information to Cseis I/O config
+   */
+  void getConfig( csSeismicIOConfig* config ) const;
+  /**
+   * Compute number of bricks in each dimension. Call after all dimensions have been set.
+   */
+  void computeBricks();
+
+  bool write( FILE* file ) const;
+  bool read( FILE* file );
+
+  /// @return Index of given inline number, or -1 if inline is not on grid
+  int inlineIndex( int inlineNumber ) const;
+  /// @return Index of given crossline number, or -1 if crossline is not on grid
+  int crosslineIndex( int crosslineNumber ) const;
+
+  /// @return Number of samples in one brick
+  inline csInt64_t brickNumSamples() const { return (csInt64_t)brickSize * (csInt64_t)brickSize * (csInt64_t)brickSize; }
+  /// @return Size in bytes of one brick
+  inline csInt64_t brickByteSize() const { return brickNumSamples() * (csInt64_t)sizeof(float); }
+  /// @return Sequential index of brick
+  inline csInt64_t brickIndex( int brickInline, int brickCrossline, int brickSample ) const {
+    return ( (csInt64_t)brickInline * (csInt64_t)numBricksCrossline + (csInt64_t)brickCrossline ) * (csInt64_t)numBricksSample + (csInt64_t)brickSample;
+  }
+  /// @return File position of brick
+  inline csInt64_t brickBytePos( csInt64_t brickIndex ) const {
+    return (csInt64_t)FILE_HEADER_BYTE_SIZE + brickIndex * brickByteSize();
+  }
+  /// @return Total number of bricks
+  inline csInt64_t numBricks() const { return (csInt64_t)numBricksInline * (csInt64_t)numBricksCrossline * (csInt64_t)numBricksSample; }
+
+ public:
+  int    brickSize;
+  int    numSamples;
+  float  sampleInt;
+  int    domain;
+
+  int    firstInline;
+  int    inlineStep;
+  int    numInlines;
+  int    firstCrossline;
+  int    crosslineStep;
+  int    numCrosslines;
+
+  double grid_orig_x;
+  double grid_orig_y;
+  int    grid_orig_il;
+  int    grid_orig_xl;
+  double grid_binsize_il;
+  double grid_binsize_xl;
+  double grid_azim_il;
+  double grid_azim_xl;
+
+  int    numBricksSample;
+  int    numBricksCrossline;
+  int    numBricksInline;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,136 @@
+
+
+#include "csBrickVolumeReader.h"
+#include "geolib/csException.h"
+#include "geolib/geolib_platform_dependent.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace cseis_io;
+
+csBrickVolumeReader::csBrickVolumeReader( std::string filename, int cacheMegaBytes ) {
+  myFilename = filename;
+  myCacheNumBricks  = 0;
+  myCacheBricks     = NULL;
+  myCacheBrickIndex = NULL;
+  myCacheLastUsed   = NULL;
+  myCacheCounter    = 0;
+
+  myFile = fopen( myFilename.c_str(), "rb" );
+  if( myFile == NULL ) {
+    throw( cseis_geolib::csException("Cannot open file '%s'", myFilename.c_str() ) );
+  }
+  if( !myHdr.read( myFile ) ) {
+    close();
+    throw( cseis_geolib::csException("File '%s' is not a bricked volume file, or has an unsupported version", myFilename.c_str() ) );
+  }
+
+  csInt64_t cacheBytes = (csInt64_t)cacheMegaBytes * 1024 * 1024;
+  myCacheNumBricks = (int)std::min( std::max( cacheBytes / myHdr.brickByteSize(), (csInt64_t)1 ), std::max( myHdr.numBricks(), (csInt64_t)1 ) );
+  myCacheBricks     = new float*[myCacheNumBricks];
+  myCacheBrickIndex = new csInt64_t[myCacheNumBricks];
+  myCacheLastUsed   = new csInt64_t[myCacheNumBricks];
+  for( int ic = 0; ic < myCacheNumBricks; ic++ ) {
+    myCacheBricks[ic]     = NULL;
+    myCacheBrickIndex[ic] = -1;
+    myCacheLastUsed[ic]   = 0;
+  }
+}
+csBrickVolumeReader::~csBrickVolumeReader() {
+  close();
+  if( myCacheBricks != NULL ) {
+    for( int ic = 0; ic < myCacheNumBricks; ic++ ) {
+      if( myCacheBricks[ic] != NULL ) delete [] myCacheBricks[ic];
+    }
+    delete [] myCacheBricks;
+    delete [] myCacheBrickIndex;
+    delete [] myCacheLastUsed;
+    myCacheBricks = NULL;
+  }
+}
+void csBrickVolumeReader::close() {
+  if( myFile != NULL ) {
+    fclose( myFile );
+    myFile = NULL;
+  }
+}
+//--------------------------------------------------------------------
+float const* csBrickVolumeReader::getBrick( int brickInline, int brickCrossline, int brickSample ) {
+  csInt64_t brickIndex = myHdr.brickIndex( brickInline, brickCrossline, brickSample );
+  myCacheCounter += 1;
+  int lruIndex = 0;
+  for( int ic = 0; ic < myCacheNumBricks; ic++ ) {
+    if( myCacheBrickIndex[ic] == brickIndex ) {
+      myCacheLastUsed[ic] = myCacheCounter;
+      return myCacheBricks[ic];
+    }
+    if( myCacheLastUsed[ic] < myCacheLastUsed[lruIndex] ) lruIndex = ic;
+  }
+  if( myFile == NULL ) return NULL;
+  // Cache miss: Replace least recently used brick
+  if( myCacheBricks[lruIndex] == NULL ) {
+    myCacheBricks[lruIndex] = new float[myHdr.brickNumSamples()];
+  }
+  myCacheBrickIndex[lruIndex] = -1;
+  if( fseeko64( myFile, myHdr.brickBytePos( brickIndex ), SEEK_SET ) != 0 ) return NULL;
+  if( fread( myCacheBricks[lruIndex], myHdr.brickByteSize(), 1, myFile ) != 1 ) return NULL;
+  myCacheBrickIndex[lruIndex] = brickIndex;
+  myCacheLastUsed[lruIndex]   = myCacheCounter;
+  return myCacheBricks[lruIndex];
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeReader::readSubCube( int firstInlineIndex, int numInlinesOut, int firstCrosslineIndex, int numCrosslinesOut,
+                                       int firstSample, int numSamplesOut, float* cube ) {
+  if( firstInlineIndex < 0 || numInlinesOut <= 0 || firstInlineIndex + numInlinesOut > myHdr.numInlines ||
+      firstCrosslineIndex < 0 || numCrosslinesOut <= 0 || firstCrosslineIndex + numCrosslinesOut > myHdr.numCrosslines ||
+      firstSample < 0 || numSamplesOut <= 0 || firstSample + numSamplesOut > myHdr.numSamples ) {
+    return false;
+  }
+  int bs = myHdr.brickSize;
+  int lastInlineIndex    = firstInlineIndex + numInlinesOut - 1;
+  int lastCrosslineIndex = firstCrosslineIndex + numCrosslinesOut - 1;
+  int lastSample         = firstSample + numSamplesOut - 1;
+
+  // Visit bricks in file order
+  for( int bil = firstInlineIndex/bs; bil <= lastInlineIndex/bs; bil++ ) {
+    int il1 = std::max( firstInlineIndex, bil*bs );
+    int il2 = std::min( lastInlineIndex, bil*bs + bs - 1 );
+    for( int bxl = firstCrosslineIndex/bs; bxl <= lastCrosslineIndex/bs; bxl++ ) {
+      int xl1 = std::max( firstCrosslineIndex, bxl*bs );
+      int xl2 = std::min( lastCrosslineIndex, bxl*bs + bs - 1 );
+      for( int bsamp = firstSample/bs; bsamp <= lastSample/bs; bsamp++ ) {
+        int s1 = std::max( firstSample, bsamp*bs );
+        int s2 = std::min( lastSample, bsamp*bs + bs - 1 );
+        float const* brick = getBrick( bil, bxl, bsamp );
+        if( brick == NULL ) return false;
+        int numCopy = s2 - s1 + 1;
+        for( int il = il1; il <= il2; il++ ) {
+          for( int xl = xl1; xl <= xl2; xl++ ) {
+            float const* ptrIn = &brick[ ( (csInt64_t)(il - bil*bs) * bs + (xl - bxl*bs) ) * bs + (s1 - bsamp*bs) ];
+            float* ptrOut = &cube[ ( (csInt64_t)(il - firstInlineIndex) * numCrosslinesOut + (xl - firstCrosslineIndex) ) * numSamplesOut + (s1 - firstSample) ];
+            if( numCopy == 1 ) {
+              *ptrOut = *ptrIn;
+            }
+            else {
+              memcpy( ptrOut, ptrIn, numCopy*sizeof(float) );
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeReader::readInline( int inlineIndex, float* buffer ) {
+  return readSubCube( inlineIndex, 1, 0, myHdr.numCrosslines, 0, myHdr.numSamples, buffer );
+}
+bool csBrickVolumeReader::readCrossline( int crosslineIndex, float* buffer ) {
+  return readSubCube( 0, myHdr.numInlines, crosslineIndex, 1, 0, myHdr.numSamples, buffer );
+}
+bool csBrickVolumeReader::readTimeSlice( int sampleIndex, float* buffer ) {
+  return readSubCube( 0, myHdr.numInlines, 0, myHdr.numCrosslines, sampleIndex, 1, buffer );
+}
+bool csBrickVolumeReader::readTrace( int inlineIndex, int crosslineIndex, float* samples ) {
+  return readSubCube( inlineIndex, 1, crosslineIndex, 1, 0, myHdr.numSamples, samples );
+}
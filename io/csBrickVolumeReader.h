@@ -0,0 +1,89 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_BRICK_VOLUME_READER_H
+#define CS_BRICK_VOLUME_READER_H
+
+#include <cstdio>
+#include <string>
+#include "csBrickVolumeHeader.h"
+
+namespace cseis_io {
+
+class csSeismicIOConfig;
+
+/**
+ * Reader for bricked 3D volume files, see csBrickVolumeHeader
+ *
+ * All access methods read only the bricks that intersect the requested part of the volume.
+ * Recently used bricks are kept in a small LRU cache, so that consecutive slices through the
+ * same bricks (e.g. neighbouring inlines) are served from memory.
+ * Inline, crossline and sample positions are given as 0-based indices, see inlineIndex() and
+ * crosslineIndex() for conversion from inline/crossline numbers.
+ */
+class csBrickVolumeReader {
+ public:
+  static int const DEFAULT_CACHE_MEGABYTES = 256;
+ public:
+  /**
+   * @param filename         Name of bricked volume file
+   * @param cacheMegaBytes   Maximum size of brick cache in megabytes. At least one brick is always cached.
+   */
+  csBrickVolumeReader( std::string filename, int cacheMegaBytes = DEFAULT_CACHE_MEGABYTES );
+  ~csBrickVolumeReader();
+
+  csBrickVolumeHeader const* header() const { return &myHdr; }
+  void getConfig( csSeismicIOConfig* config ) const { myHdr.getConfig( config ); }
+  inline int numSamples() const { return myHdr.numSamples; }
+  inline int numInlines() const { return myHdr.numInlines; }
+  inline int numCrosslines() const { return myHdr.numCrosslines; }
+  inline int inlineIndex( int inlineNumber ) const { return myHdr.inlineIndex( inlineNumber ); }
+  inline int crosslineIndex( int crosslineNumber ) const { return myHdr.crosslineIndex( crosslineNumber ); }
+
+  /**
+   * Read sub-cube
+   * Output is ordered samples fastest, then crosslines, then inlines:
+   * cube[ ( il*numCrosslinesOut + xl ) * numSamplesOut + isamp ]
+   * @return false if requested sub-cube is not inside the volume, or if a read error occurred
+   */
+  bool readSubCube( int firstInlineIndex, int numInlinesOut, int firstCrosslineIndex, int numCrosslinesOut,
+                    int firstSample, int numSamplesOut, float* cube );
+  /**
+   * Read one inline. Output: buffer[xl*numSamples + isamp]
+   */
+  bool readInline( int inlineIndex, float* buffer );
+  /**
+   * Read one crossline. Output: buffer[il*numSamples + isamp]
+   */
+  bool readCrossline( int crosslineIndex, float* buffer );
+  /**
+   * Read one time/depth slice. Output: buffer[il*numCrosslines + xl]
+   */
+  bool readTimeSlice( int sampleIndex, float* buffer );
+  /**
+   * Read single trace
+   */
+  bool readTrace( int inlineIndex, int crosslineIndex, float* samples );
+  void close();
+
+ private:
+  float const* getBrick( int brickInline, int brickCrossline, int brickSample );
+
+  std::string myFilename;
+  FILE* myFile;
+  csBrickVolumeHeader myHdr;
+
+  int myCacheNumBricks;
+  float** myCacheBricks;
+  csInt64_t* myCacheBrickIndex;
+  csInt64_t* myCacheLastUsed;
+  csInt64_t myCacheCounter;
+
+  csBrickVolumeReader( csBrickVolumeReader const& obj );
+  csBrickVolumeReader& operator=( csBrickVolumeReader const& obj );
+};
+
+} // end namespace
+
+#endif
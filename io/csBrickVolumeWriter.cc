@@ -0,0 +1,133 @@
+
+
+#include "csBrickVolumeWriter.h"
+#include "geolib/csException.h"
+#include "geolib/geolib_platform_dependent.h"
+#include <cstring>
+#include <algorithm>
+
+using namespace cseis_io;
+
+csBrickVolumeWriter::csBrickVolumeWriter( std::string filename, bool overwrite ) {
+  myFilename = filename;
+  myFile = NULL;
+  mySlabBuffer     = NULL;
+  mySlabNumSamples = 0;
+  myCurrentSlab    = -1;
+  myIsSlabModified = false;
+  myIsSlabWritten  = NULL;
+
+  if( !overwrite ) {
+    myFile = fopen( myFilename.c_str(), "rb" );
+    if( myFile != NULL ) {
+      fclose( myFile );
+      myFile = NULL;
+      throw( cseis_geolib::csException("File exists and shall NOT be overwritten: '%s'", myFilename.c_str() ) );
+    }
+  }
+  // Open for update: Slabs may have to be read back in if traces are not sorted by inline
+  myFile = fopen( myFilename.c_str(), "w+b" );
+  if( myFile == NULL ) {
+    throw( cseis_geolib::csException("Cannot open file '%s'", myFilename.c_str() ) );
+  }
+}
+csBrickVolumeWriter::~csBrickVolumeWriter() {
+  close();
+  if( mySlabBuffer != NULL ) {
+    delete [] mySlabBuffer;
+    mySlabBuffer = NULL;
+  }
+  if( myIsSlabWritten != NULL ) {
+    delete [] myIsSlabWritten;
+    myIsSlabWritten = NULL;
+  }
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeWriter::writeFileHeader( csBrickVolumeHeader const* hdr ) {
+  if( myFile == NULL || mySlabBuffer != NULL ) return false;
+  myHdr = *hdr;
+  if( myHdr.brickSize <= 0 || myHdr.numSamples <= 0 || myHdr.numInlines <= 0 || myHdr.numCrosslines <= 0 ||
+      myHdr.inlineStep == 0 || myHdr.crosslineStep == 0 ) {
+    throw( cseis_geolib::csException("csBrickVolumeWriter: Inconsistent volume dimensions: %d samples, %d inlines, %d crosslines, brick size %d",
+                                     myHdr.numSamples, myHdr.numInlines, myHdr.numCrosslines, myHdr.brickSize) );
+  }
+  myHdr.computeBricks();
+  mySlabNumSamples = (csInt64_t)myHdr.numBricksCrossline * (csInt64_t)myHdr.numBricksSample * myHdr.brickNumSamples();
+  mySlabBuffer = new float[mySlabNumSamples];
+  myIsSlabWritten = new bool[myHdr.numBricksInline];
+  for( int islab = 0; islab < myHdr.numBricksInline; islab++ ) {
+    myIsSlabWritten[islab] = false;
+  }
+  myCurrentSlab = -1;
+  myIsSlabModified = false;
+  return myHdr.write( myFile );
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeWriter::writeTrace( int inlineNumber, int crosslineNumber, float const* samples ) {
+  int ilIndex = myHdr.inlineIndex( inlineNumber );
+  int xlIndex = myHdr.crosslineIndex( crosslineNumber );
+  if( ilIndex < 0 || xlIndex < 0 ) return false;
+  return writeTraceAtIndex( ilIndex, xlIndex, samples );
+}
+bool csBrickVolumeWriter::writeTraceAtIndex( int inlineIndex, int crosslineIndex, float const* samples ) {
+  if( myFile == NULL || mySlabBuffer == NULL ) return false;
+  if( inlineIndex < 0 || inlineIndex >= myHdr.numInlines || crosslineIndex < 0 || crosslineIndex >= myHdr.numCrosslines ) return false;
+
+  int brickSize = myHdr.brickSize;
+  int slabIndex = inlineIndex / brickSize;
+  if( slabIndex != myCurrentSlab ) {
+    if( !flushSlab() ) return false;
+    if( !loadSlab( slabIndex ) ) return false;
+  }
+  int brickXL = crosslineIndex / brickSize;
+  // Offset of trace inside brick
+  csInt64_t traceOffset = ( (csInt64_t)(inlineIndex % brickSize) * brickSize + (crosslineIndex % brickSize) ) * brickSize;
+  for( int brickSample = 0; brickSample < myHdr.numBricksSample; brickSample++ ) {
+    int firstSample = brickSample * brickSize;
+    int numSamples  = std::min( brickSize, myHdr.numSamples - firstSample );
+    csInt64_t brickIndex = (csInt64_t)brickXL * myHdr.numBricksSample + brickSample;
+    memcpy( &mySlabBuffer[brickIndex * myHdr.brickNumSamples() + traceOffset], &samples[firstSample], numSamples*sizeof(float) );
+  }
+  myIsSlabModified = true;
+  return true;
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeWriter::flushSlab() {
+  if( myCurrentSlab < 0 || !myIsSlabModified ) return true;
+  csInt64_t bytePos = myHdr.brickBytePos( myHdr.brickIndex( myCurrentSlab, 0, 0 ) );
+  if( fseeko64( myFile, bytePos, SEEK_SET ) != 0 ) return false;
+  if( fwrite( mySlabBuffer, sizeof(float), mySlabNumSamples, myFile ) != (size_t)mySlabNumSamples ) return false;
+  myIsSlabWritten[myCurrentSlab] = true;
+  myIsSlabModified = false;
+  return true;
+}
+bool csBrickVolumeWriter::loadSlab( int slabIndex ) {
+  myCurrentSlab = slabIndex;
+  myIsSlabModified = false;
+  if( !myIsSlabWritten[slabIndex] ) {
+    memset( mySlabBuffer, 0, mySlabNumSamples*sizeof(float) );
+    return true;
+  }
+  csInt64_t bytePos = myHdr.brickBytePos( myHdr.brickIndex( slabIndex, 0, 0 ) );
+  if( fseeko64( myFile, bytePos, SEEK_SET ) != 0 ) return false;
+  return( fread( mySlabBuffer, sizeof(float), mySlabNumSamples, myFile ) == (size_t)mySlabNumSamples );
+}
+//--------------------------------------------------------------------
+bool csBrickVolumeWriter::close() {
+  if( myFile == NULL ) return true;
+  bool success = true;
+  if( mySlabBuffer != NULL ) {
+    success = flushSlab();
+    // Zero-fill slabs that have not been written, so that every brick exists on disk
+    for( int islab = 0; islab < myHdr.numBricksInline && success; islab++ ) {
+      if( !myIsSlabWritten[islab] ) {
+        success = loadSlab( islab );
+        myIsSlabModified = true;
+        success = success && flushSlab();
+      }
+    }
+  }
+  if( fclose( myFile ) != 0 ) success = false;
+  myFile = NULL;
+  return success;
+}
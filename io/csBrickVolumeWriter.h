@@ -0,0 +1,75 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_BRICK_VOLUME_WRITER_H
+#define CS_BRICK_VOLUME_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include "csBrickVolumeHeader.h"
+
+namespace cseis_io {
+
+/**
+ * Writer for bricked 3D volume files, see csBrickVolumeHeader
+ *
+ * The writer holds one slab of bricks in memory, i.e. brickSize inlines times all crosslines and samples.
+ * Traces may be written in any order, but should be grouped by slab: Whenever a trace falls outside the current
+ * slab, the whole slab is written to disk and the new slab is loaded (or zeroed if it has not been written before).
+ * Writing traces that alternate between slabs, e.g. crossline-sorted input, therefore costs a full slab write and read
+ * per trace. csBrickVolumeConverter orders its input traces by slab.
+ * Bins without a trace are zero-filled.
+ */
+class csBrickVolumeWriter {
+ public:
+  /**
+   * @param filename  Name of output file
+   * @param overwrite true to overwrite even if file exists
+   */
+  csBrickVolumeWriter( std::string filename, bool overwrite = true );
+  ~csBrickVolumeWriter();
+  /**
+   * Write file header
+   * Call only once before writing trace data. All grid dimensions and the brick size must be set in the header.
+   */
+  bool writeFileHeader( csBrickVolumeHeader const* hdr );
+  /**
+   * Write trace at given inline/crossline number
+   * @return false if trace does not lie on grid, or if an error occurred when writing to disk
+   */
+  bool writeTrace( int inlineNumber, int crosslineNumber, float const* samples );
+  /**
+   * Write trace at given inline/crossline index
+   */
+  bool writeTraceAtIndex( int inlineIndex, int crosslineIndex, float const* samples );
+  /**
+   * Flush current slab, zero-fill all bricks that were never written, and close file
+   */
+  bool close();
+  csBrickVolumeHeader const* header() const { return &myHdr; }
+
+ private:
+  bool flushSlab();
+  bool loadSlab( int slabIndex );
+
+  std::string myFilename;
+  FILE* myFile;
+  csBrickVolumeHeader myHdr;
+
+  /// Bricks of current slab, in file order
+  float* mySlabBuffer;
+  csInt64_t mySlabNumSamples;
+  /// Current slab = index of inline brick held in slab buffer, -1 if none
+  int myCurrentSlab;
+  bool myIsSlabModified;
+  /// true for slabs that have been written to disk
+  bool* myIsSlabWritten;
+
+  csBrickVolumeWriter( csBrickVolumeWriter const& obj );
+  csBrickVolumeWriter& operator=( csBrickVolumeWriter const& obj );
+};
+
+} // end namespace
+
+#endif
@@ -29,6 +29,8 @@ csGeneralSeismicReader::csGeneralSeismicReader( std::string filename, bool enabl
   myConfig = new csSeismicIOConfig();
   myHdrValueBlock = NULL;
   myTraceBuffer   = NULL;
+  myHdrBlockBuffer = NULL;
+  myHdrBlockBufferNumTraces = 0;
 
   myIntPtr   = NULL;
   myFloatPtr = NULL;
@@ -51,6 +53,10 @@ csGeneralSeismicReader::~csGeneralSeismicReader() {
     delete [] myHdrValueBlock;
     myHdrValueBlock = NULL;
   }
+  if( myHdrBlockBuffer != NULL ) {
+    delete [] myHdrBlockBuffer;
+    myHdrBlockBuffer = NULL;
+  }
   if( myReader != NULL ) {
     delete myReader;
     myReader = NULL;
@@ -218,6 +224,50 @@ bool csGeneralSeismicReader::readTrace( float* samples ) {
   return myReader->readTrace( samples, myHdrValueBlock );
 }
 
+int csGeneralSeismicReader::hdrValueBlockSize() const {
+  return myConfig->byteSizeHdrValueBlock;
+}
+
+int csGeneralSeismicReader::headerByteSize( int hdrIndex ) const {
+  if( hdrIndex == numTraceHeaders() - 1 ) {
+    return( myConfig->byteSizeHdrValueBlock - myByteLocation[hdrIndex] );
+  }
+  else {
+    return( myByteLocation[hdrIndex + 1] - myByteLocation[hdrIndex] );
+  }
+}
+
+int csGeneralSeismicReader::readTraces( int numTraces, float* samples, size_t stride, char* hdrValueBlocks ) {
+  int numTracesRead = myReader->readTraces( numTraces, samples, stride, hdrValueBlocks );
+  if( numTracesRead > 0 && hdrValueBlocks != NULL ) {
+    memcpy( myHdrValueBlock, &hdrValueBlocks[(numTracesRead-1)*myConfig->byteSizeHdrValueBlock], myConfig->byteSizeHdrValueBlock );
+  }
+  return numTracesRead;
+}
+
+int csGeneralSeismicReader::readTraces( int numTraces, float* samples, size_t stride, int numHeaders, int const* hdrIndices, char** hdrColumns ) {
+  int blockSize = myConfig->byteSizeHdrValueBlock;
+  if( numTraces > myHdrBlockBufferNumTraces ) {
+    if( myHdrBlockBuffer != NULL ) delete [] myHdrBlockBuffer;
+    myHdrBlockBuffer = new char[numTraces*blockSize];
+    myHdrBlockBufferNumTraces = numTraces;
+  }
+  int numTracesRead = readTraces( numTraces, samples, stride, myHdrBlockBuffer );
+  for( int icol = 0; icol < numHeaders; icol++ ) {
+    int hdrIndex = hdrIndices[icol];
+    if( hdrIndex < 0 || hdrIndex >= numTraceHeaders() ) {
+      throw( cseis_geolib::csException("csGeneralSeismicReader::readTraces: Incorrect header index: %d. This is a program bug in the calling function", hdrIndex) );
+    }
+    int byteLoc  = myByteLocation[hdrIndex];
+    int byteSize = headerByteSize( hdrIndex );
+    char* column = hdrColumns[icol];
+    for( int itrc = 0; itrc < numTracesRead; itrc++ ) {
+      memcpy( &column[itrc*byteSize], &myHdrBlockBuffer[itrc*blockSize + byteLoc], byteSize );
+    }
+  }
+  return numTracesRead;
+}
+
 //--------------------------------------------------------------------
 int csGeneralSeismicReader::numTraces(void) {
  return myReader->numTraces();
@@ -40,6 +40,34 @@ public:
   bool moveToTrace( int traceIndex );
   float const* readTraceReturnPointer();
   bool readTrace( float* samples );
+  /**
+   * Read block of consecutive traces in one call
+   * If hdrValueBlocks is given, header values of the last trace read can be retrieved via hdrIntValue() etc. after the call.
+   * If hdrValueBlocks is NULL, hdrIntValue() etc. keep returning the header values of the trace read before.
+   * @param numTraces      (i) Number of traces to read
+   * @param samples        (o) Trace samples. Samples of trace i start at samples[i*stride]. Pass NULL if samples shall not be read.
+   * @param stride         (i) Number of floats between first samples of consecutive traces, must be >= number of samples
+   * @param hdrValueBlocks (o) Trace header value blocks, hdrValueBlockSize() bytes per trace. Pass NULL if headers shall not be read.
+   * @return Number of traces read. Smaller than numTraces if end of file was reached.
+   */
+  int readTraces( int numTraces, float* samples, size_t stride, char* hdrValueBlocks );
+  /**
+   * Read block of consecutive traces in one call, returning selected trace headers in columns
+   * Column j receives the values of header hdrIndices[j] for all traces, in the header's native type
+   * (for example int[numTraces] for an int header), see headerType() and headerByteSize().
+   * @param numTraces   (i) Number of traces to read
+   * @param samples     (o) Trace samples, see readTraces(). Pass NULL if samples shall not be read.
+   * @param stride      (i) Number of floats between first samples of consecutive traces
+   * @param numHeaders  (i) Number of header columns
+   * @param hdrIndices  (i) Header index of each column
+   * @param hdrColumns  (o) Column buffers, each of size numTraces*headerByteSize(hdrIndices[j]) bytes
+   * @return Number of traces read.
+   */
+  int readTraces( int numTraces, float* samples, size_t stride, int numHeaders, int const* hdrIndices, char** hdrColumns );
+  /// @return Size in bytes of trace header value block of one trace
+  int hdrValueBlockSize() const;
+  /// @return Size in bytes of one trace header value
+  int headerByteSize( int hdrIndex ) const;
    
   void closeFile();
 
@@ -74,6 +102,8 @@ private:
   float*  myTraceBuffer;
   
   char*   myHdrValueBlock;          // byte header buffer
+  char*   myHdrBlockBuffer;         // header buffer for multiple traces, used by columnar readTraces()
+  int     myHdrBlockBufferNumTraces;
   int*    myIntPtr;                 // header buffer as int
   float*  myFloatPtr;               // header buffer as float
   
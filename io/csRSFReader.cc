@@ -54,6 +54,9 @@ csRSFReader::csRSFReader( std::string filenameRSF, int numTracesBuffer, bool rev
   myCurrentTraceIndex = 0;
 
   myFileBin = NULL;
+
+  mySliceBuffer     = NULL;
+  mySliceBufferSize = 0;
 }
 //-----------------------------------------------------------------------------------------
 csRSFReader::~csRSFReader() {
@@ -66,6 +69,10 @@ csRSFReader::~csRSFReader() {
     delete [] myDataBuffer;
     myDataBuffer = NULL;
   }
+  if( mySliceBuffer ) {
+    delete [] mySliceBuffer;
+    mySliceBuffer = NULL;
+  }
   if( myFileBin ) {
     myFileBin->close();
     delete myFileBin;
@@ -294,6 +301,124 @@ bool csRSFReader::readDataBuffer() {
   
   return true;
 }
+//--------------------------------------------------------
+int csRSFReader::numDim3() const {
+  return( myHdr->n3 > 0 ? myHdr->n3 : 1 );
+}
+bool csRSFReader::readTimeSlice( int sampleIndex, float* buffer ) {
+  return readWindow( sampleIndex, 1, 1, 0, myHdr->n2, 1, 0, numDim3(), 1, buffer );
+}
+bool csRSFReader::readDim3Slice( int indexDim3, float* buffer ) {
+  return readWindow( 0, myNumSamples, 1, 0, myHdr->n2, 1, indexDim3, 1, 1, buffer );
+}
+bool csRSFReader::readDim2Slice( int indexDim2, float* buffer ) {
+  return readWindow( 0, myNumSamples, 1, indexDim2, 1, 1, 0, numDim3(), 1, buffer );
+}
+//--------------------------------------------------------
+// Read numBytes from given absolute byte position into slice buffer. Seek only if file is not already positioned there.
+bool csRSFReader::readBytesAt( csInt64_t bytePos, int numBytes, csInt64_t& filePos ) {
+  if( filePos != bytePos ) {
+    myFileBin->clear();
+    myFileBin->seekg( 0, std::ios_base::beg );
+    if( !seekg_relative( bytePos ) ) return false;
+  }
+  myFileBin->read( mySliceBuffer, numBytes );
+  if( myFileBin->fail() ) {
+    filePos = -1;
+    return false;
+  }
+  filePos = bytePos + numBytes;
+  if( myDoSwapEndian ) {
+    swapEndian4( mySliceBuffer, numBytes );
+  }
+  return true;
+}
+//--------------------------------------------------------
+bool csRSFReader::readWindow( int firstSample, int numSamples, int stepSample,
+                              int firstDim2, int numDim2, int stepDim2,
+                              int firstDim3, int numDim3Out, int stepDim3,
+                              float* buffer, bool sampleSlowest ) {
+  if( !myHasBeenInitialized ) {
+    throw( cseis_geolib::csException("csRSFReader::readWindow: Input file has not been initialized yet. This is a program bug in the calling function") );
+  }
+  if( numSamples <= 0 || numDim2 <= 0 || numDim3Out <= 0 || stepSample <= 0 || stepDim2 <= 0 || stepDim3 <= 0 ) return false;
+  int lastSample = firstSample + (numSamples-1)*stepSample;
+  int lastDim2   = firstDim2 + (numDim2-1)*stepDim2;
+  int lastDim3   = firstDim3 + (numDim3Out-1)*stepDim3;
+  if( firstSample < 0 || lastSample >= myNumSamples || firstDim2 < 0 || lastDim2 >= myHdr->n2 || firstDim3 < 0 || lastDim3 >= numDim3() ) {
+    return false;
+  }
+
+  if( mySliceBuffer == NULL ) {
+    mySliceBufferSize = SLICE_BUFFER_BYTES;
+    if( myTraceByteSize > mySliceBufferSize ) mySliceBufferSize = myTraceByteSize;
+    mySliceBuffer = new char[mySliceBufferSize];
+  }
+  // Number of bytes to read for one trace
+  int spanBytes = (lastSample - firstSample + 1) * mySampleByteSize;
+  csInt64_t strideBytes = (csInt64_t)stepDim2 * (csInt64_t)myTraceByteSize;
+  // Number of output traces per block read: Read neighbouring traces in one go unless they are far apart
+  int tracesPerBlock = 1;
+  if( strideBytes - spanBytes <= SLICE_MAX_GAP_BYTES ) {
+    tracesPerBlock = (int)( (mySliceBufferSize - spanBytes) / strideBytes ) + 1;
+  }
+  csInt64_t planeSize = (csInt64_t)numDim3Out * (csInt64_t)numDim2;
+  csInt64_t filePos = -1;
+  bool success = true;
+
+  for( int i3 = 0; i3 < numDim3Out && success; i3++ ) {
+    csInt64_t traceIndexFirst = (csInt64_t)(firstDim3 + i3*stepDim3) * (csInt64_t)myHdr->n2 + firstDim2;
+    for( int i2First = 0; i2First < numDim2 && success; i2First += tracesPerBlock ) {
+      int numTracesBlock = std::min( tracesPerBlock, numDim2 - i2First );
+      csInt64_t bytePos = ( traceIndexFirst + (csInt64_t)i2First*stepDim2 ) * myTraceByteSize + (csInt64_t)firstSample * mySampleByteSize;
+      int numBytes = (int)( (csInt64_t)(numTracesBlock-1) * strideBytes ) + spanBytes;
+      success = readBytesAt( bytePos, numBytes, filePos );
+      if( !success ) break;
+
+      csInt64_t outIndexFirst = (csInt64_t)i3 * numDim2 + i2First;
+      if( !sampleSlowest ) {
+        for( int itrc = 0; itrc < numTracesBlock; itrc++ ) {
+          float const* samplesIn = reinterpret_cast<float const*>( &mySliceBuffer[itrc*strideBytes] );
+          float* samplesOut = &buffer[(outIndexFirst + itrc) * numSamples];
+          if( stepSample == 1 ) {
+            memcpy( samplesOut, samplesIn, numSamples*sizeof(float) );
+          }
+          else {
+            for( int isamp = 0; isamp < numSamples; isamp++ ) {
+              samplesOut[isamp] = samplesIn[isamp*stepSample];
+            }
+          }
+        }
+      }
+      else {
+        // Transpose block in tiles, so that both input traces and output slices are accessed in cache-friendly chunks
+        for( int itrc1 = 0; itrc1 < numTracesBlock; itrc1 += TRANSPOSE_TILE_SIZE ) {
+          int itrc2 = std::min( itrc1 + TRANSPOSE_TILE_SIZE, numTracesBlock );
+          for( int isamp1 = 0; isamp1 < numSamples; isamp1 += TRANSPOSE_TILE_SIZE ) {
+            int isamp2 = std::min( isamp1 + TRANSPOSE_TILE_SIZE, numSamples );
+            for( int itrc = itrc1; itrc < itrc2; itrc++ ) {
+              float const* samplesIn = reinterpret_cast<float const*>( &mySliceBuffer[itrc*strideBytes] );
+              float* ptrOut = &buffer[outIndexFirst + itrc];
+              for( int isamp = isamp1; isamp < isamp2; isamp++ ) {
+                ptrOut[isamp*planeSize] = samplesIn[isamp*stepSample];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  // Restore file position for sequential reading via getNextTrace()
+  myFileBin->clear();
+  myFileBin->seekg( 0, std::ios_base::beg );
+  seekg_relative( (csInt64_t)myCurrentFileTraceIndex * (csInt64_t)myTraceByteSize );
+  if( !success ) {
+    throw( cseis_geolib::csException("csRSFReader::readWindow: Unexpected error occurred when reading in data from input file '%s'", myFilenameRSF.c_str()) );
+  }
+  return true;
+}
+
 void csRSFReader::dump( FILE* stream ) {
   myHdr->dump( stream );
 }
@@ -20,6 +20,14 @@ namespace cseis_io {
 
 class csRSFReader {
 //---------------------------------------------------------------------------------------
+public:
+  /// Maximum size of read buffer used for slice/window reads
+  static int const SLICE_BUFFER_BYTES = 8*1024*1024;
+  /// Maximum number of unused bytes between two traces that are still read in one go in slice/window reads
+  static int const SLICE_MAX_GAP_BYTES = 256*1024;
+  /// Tile size for transposition of sample/trace blocks
+  static int const TRANSPOSE_TILE_SIZE = 16;
+
 public:
   csRSFReader( std::string filename, int nTracesBuffer, bool reverseByteOrder );
   ~csRSFReader();
@@ -47,6 +55,47 @@ public:
   bool peekHeaderValue( cseis_geolib::csFlexHeader* hdrValue, int traceIndex = -1 );   
 
   bool getNextTrace( cseis_geolib::byte_t* buffer, int numSamplesToRead );
+
+  /**
+   * Read strided window of samples from RSF cube, independent of the current trace position
+   * Traces in each dim3 line are read in large blocks covering several traces, so that every part of the file is read at most once.
+   * The current trace position for getNextTrace() is not changed.
+   * Output order: buffer[ ( i3*numDim2 + i2 )*numSamples + isamp ], or, if sampleSlowest is true,
+   * buffer[ ( isamp*numDim3 + i3 )*numDim2 + i2 ] (= stack of time slices)
+   * @param firstSample  Index of first sample (0 = first sample in trace)
+   * @param numSamples   Number of output samples
+   * @param stepSample   Increment between output samples
+   * @param firstDim2    Index of first position along dimension 2
+   * @param numDim2      Number of output positions along dimension 2
+   * @param stepDim2     Increment along dimension 2
+   * @param firstDim3    Index of first position along dimension 3
+   * @param numDim3      Number of output positions along dimension 3
+   * @param stepDim3     Increment along dimension 3
+   * @param buffer       Output buffer, size numSamples*numDim2*numDim3
+   * @param sampleSlowest true if output shall be transposed so that the sample axis is the slowest axis
+   * @return false if window lies outside of cube
+   */
+  bool readWindow( int firstSample, int numSamples, int stepSample,
+                   int firstDim2, int numDim2, int stepDim2,
+                   int firstDim3, int numDim3, int stepDim3,
+                   float* buffer, bool sampleSlowest = false );
+  /**
+   * Read time (depth) slice at given sample index
+   * Output: buffer[ i3*n2 + i2 ]
+   */
+  bool readTimeSlice( int sampleIndex, float* buffer );
+  /**
+   * Read all traces at given dim3 index (e.g. one inline)
+   * Output: buffer[ i2*n1 + isamp ]
+   */
+  bool readDim3Slice( int indexDim3, float* buffer );
+  /**
+   * Read all traces at given dim2 index (e.g. one crossline)
+   * Output: buffer[ i3*n1 + isamp ]
+   */
+  bool readDim2Slice( int indexDim2, float* buffer );
+  /// @return Number of positions along dimension 3 (1 for 2D file)
+  int numDim3() const;
   float const* getNextTracePointer();
   void dump( FILE* stream );
 
@@ -68,6 +117,7 @@ public:
 private:
 
   bool seekg_relative( csInt64_t bytePosRelative );
+  bool readBytesAt( csInt64_t bytePos, int numBytes, csInt64_t& filePos );
   void convert2standardUnit();
   
   csRSFHeader* myHdr;
@@ -107,6 +157,10 @@ private:
   int   myNumSamples;
 
   bool myHasBeenInitialized;
+
+  /// Read buffer for slice/window reads
+  char* mySliceBuffer;
+  int   mySliceBufferSize;
 //-----------------------------------------------------------------------------------------
 //
 private:
@@ -0,0 +1,299 @@
+
+
+#include "csSegyHeader.h"
+#include "geolib/geolib_endian.h"
+#include <cstring>
+
+using namespace cseis_io;
+
+namespace {
+  /// Byte offsets in binary header
+  static int const BIN_JOB_ID            = 0;
+  static int const BIN_LINE              = 4;
+  static int const BIN_REEL              = 8;
+  static int const BIN_TRACES_PER_ENS    = 12;
+  static int const BIN_AUX_PER_ENS       = 14;
+  static int const BIN_SAMPLE_INT        = 16;
+  static int const BIN_NUM_SAMPLES       = 20;
+  static int const BIN_FORMAT            = 24;
+  static int const BIN_FOLD              = 26;
+  static int const BIN_SORT              = 28;
+  static int const BIN_MEAS_SYSTEM       = 54;
+  static int const BIN_EXT_NUM_SAMPLES   = 68;
+  static int const BIN_EXT_SAMPLE_INT    = 72;
+  static int const BIN_BYTE_ORDER        = 96;
+  static int const BIN_REVISION          = 300;
+  static int const BIN_FIXED_LENGTH      = 302;
+  static int const BIN_NUM_EXT_TEXT      = 304;
+  static int const BIN_NUM_EXT_TRC_HDR   = 306;
+  static int const BIN_NUM_TRACES        = 312;  // Bytes 3513-3520
+  static int const BIN_FIRST_TRACE       = 320;  // Bytes 3521-3528
+
+  bool isSupportedFormat( int formatCode ) {
+    return( formatCode == csSegyFileHeader::FORMAT_IBM || formatCode == csSegyFileHeader::FORMAT_INT32 ||
+            formatCode == csSegyFileHeader::FORMAT_INT16 || formatCode == csSegyFileHeader::FORMAT_IEEE ||
+            formatCode == csSegyFileHeader::FORMAT_DOUBLE || formatCode == csSegyFileHeader::FORMAT_INT8 );
+  }
+  csInt64_t readInt8Bytes( char const* ptr, bool doSwapEndian ) {
+    csInt64_t value;
+    memcpy( &value, ptr, 8 );
+    if( doSwapEndian ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&value), 8 );
+    return value;
+  }
+  void writeInt8Bytes( char* ptr, csInt64_t value, bool doSwapEndian ) {
+    if( doSwapEndian ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&value), 8 );
+    memcpy( ptr, &value, 8 );
+  }
+}
+
+//--------------------------------------------------------------------
+csSegyFileHeader::csSegyFileHeader() {
+  jobID        = 0;
+  lineNumber   = 0;
+  reelNumber   = 0;
+  numTracesPerEnsemble    = 0;
+  numAuxTracesPerEnsemble = 0;
+  sampleIntUS  = 0;
+  numSamples   = 0;
+  formatCode   = FORMAT_IBM;
+  ensembleFold = 0;
+  sortCode     = 0;
+  measurementSystem  = 1;
+  revision           = 0x0100;
+  isFixedLength      = true;
+  numExtTextHeaders  = 0;
+  numExtTraceHeaders = 0;
+  numTracesInFile    = 0;
+  firstTraceByteOffset = 0;
+  isLittleEndian     = false;
+}
+//--------------------------------------------------------------------
+bool csSegyFileHeader::decode( char const* binHdr ) {
+  bool isPlatformLE = cseis_geolib::isPlatformLittleEndian();
+  int byteOrder = csSegyHeaderMap::readInt( &binHdr[BIN_BYTE_ORDER], 4, isPlatformLE );
+  if( byteOrder == BYTE_ORDER_CONSTANT ) {
+    isLittleEndian = false;
+  }
+  else if( byteOrder == 0x04030201 ) {
+    isLittleEndian = true;
+  }
+  else {
+    int formatBE = csSegyHeaderMap::readInt( &binHdr[BIN_FORMAT], 2, isPlatformLE );
+    int formatLE = csSegyHeaderMap::readInt( &binHdr[BIN_FORMAT], 2, !isPlatformLE );
+    isLittleEndian = ( !isSupportedFormat( formatBE ) && isSupportedFormat( formatLE ) );
+  }
+  bool doSwap = ( isLittleEndian != isPlatformLE );
+
+  jobID        = csSegyHeaderMap::readInt( &binHdr[BIN_JOB_ID], 4, doSwap );
+  lineNumber   = csSegyHeaderMap::readInt( &binHdr[BIN_LINE], 4, doSwap );
+  reelNumber   = csSegyHeaderMap::readInt( &binHdr[BIN_REEL], 4, doSwap );
+  numTracesPerEnsemble    = csSegyHeaderMap::readInt( &binHdr[BIN_TRACES_PER_ENS], 2, doSwap );
+  numAuxTracesPerEnsemble = csSegyHeaderMap::readInt( &binHdr[BIN_AUX_PER_ENS], 2, doSwap );
+  sampleIntUS  = (unsigned short)csSegyHeaderMap::readInt( &binHdr[BIN_SAMPLE_INT], 2, doSwap );
+  numSamples   = (unsigned short)csSegyHeaderMap::readInt( &binHdr[BIN_NUM_SAMPLES], 2, doSwap );
+  formatCode   = csSegyHeaderMap::readInt( &binHdr[BIN_FORMAT], 2, doSwap );
+  ensembleFold = csSegyHeaderMap::readInt( &binHdr[BIN_FOLD], 2, doSwap );
+  sortCode     = csSegyHeaderMap::readInt( &binHdr[BIN_SORT], 2, doSwap );
+  measurementSystem = csSegyHeaderMap::readInt( &binHdr[BIN_MEAS_SYSTEM], 2, doSwap );
+  // Revision: Major and minor revision number, one byte each
+  revision = ( (unsigned char)binHdr[BIN_REVISION] << 8 ) | (unsigned char)binHdr[BIN_REVISION+1];
+  isFixedLength = ( revision == 0 || csSegyHeaderMap::readInt( &binHdr[BIN_FIXED_LENGTH], 2, doSwap ) != 0 );
+  numExtTextHeaders    = 0;
+  numExtTraceHeaders   = 0;
+  numTracesInFile      = 0;
+  firstTraceByteOffset = 0;
+  if( revision >= 0x0100 ) {
+    numExtTextHeaders = csSegyHeaderMap::readInt( &binHdr[BIN_NUM_EXT_TEXT], 2, doSwap );
+  }
+  if( revision >= 0x0200 ) {
+    int extNumSamples = csSegyHeaderMap::readInt( &binHdr[BIN_EXT_NUM_SAMPLES], 4, doSwap );
+    if( extNumSamples > 0 ) numSamples = extNumSamples;
+    double extSampleInt;
+    memcpy( &extSampleInt, &binHdr[BIN_EXT_SAMPLE_INT], 8 );
+    if( doSwap ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&extSampleInt), 8 );
+    if( extSampleInt > 0 ) sampleIntUS = extSampleInt;
+    numExtTraceHeaders   = csSegyHeaderMap::readInt( &binHdr[BIN_NUM_EXT_TRC_HDR], 4, doSwap );
+    numTracesInFile      = readInt8Bytes( &binHdr[BIN_NUM_TRACES], doSwap );
+    firstTraceByteOffset = readInt8Bytes( &binHdr[BIN_FIRST_TRACE], doSwap );
+    if( numExtTraceHeaders < 0 ) numExtTraceHeaders = 0;
+  }
+  return( isSupportedFormat( formatCode ) && numSamples > 0 && numExtTextHeaders >= -1 );
+}
+//--------------------------------------------------------------------
+void csSegyFileHeader::encode( char* binHdr ) const {
+  bool doSwap = ( isLittleEndian != cseis_geolib::isPlatformLittleEndian() );
+  memset( binHdr, 0, BIN_HEADER_BYTE_SIZE );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_JOB_ID], 4, jobID, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_LINE], 4, lineNumber, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_REEL], 4, reelNumber, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_TRACES_PER_ENS], 2, numTracesPerEnsemble, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_AUX_PER_ENS], 2, numAuxTracesPerEnsemble, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_SAMPLE_INT], 2, ( sampleIntUS < 65536 ) ? (int)( sampleIntUS + 0.5 ) : 0, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_NUM_SAMPLES], 2, ( numSamples < 65536 ) ? numSamples : 0, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_FORMAT], 2, formatCode, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_FOLD], 2, ensembleFold, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_SORT], 2, sortCode, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_MEAS_SYSTEM], 2, measurementSystem, doSwap );
+  binHdr[BIN_REVISION]   = (char)( (revision >> 8) & 0xff );
+  binHdr[BIN_REVISION+1] = (char)( revision & 0xff );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_FIXED_LENGTH], 2, isFixedLength ? 1 : 0, doSwap );
+  csSegyHeaderMap::writeInt( &binHdr[BIN_NUM_EXT_TEXT], 2, numExtTextHeaders, doSwap );
+  if( revision >= 0x0200 ) {
+    csSegyHeaderMap::writeInt( &binHdr[BIN_EXT_NUM_SAMPLES], 4, numSamples, doSwap );
+    double extSampleInt = sampleIntUS;
+    if( doSwap ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&extSampleInt), 8 );
+    memcpy( &binHdr[BIN_EXT_SAMPLE_INT], &extSampleInt, 8 );
+    csSegyHeaderMap::writeInt( &binHdr[BIN_BYTE_ORDER], 4, BYTE_ORDER_CONSTANT, doSwap );
+    csSegyHeaderMap::writeInt( &binHdr[BIN_NUM_EXT_TRC_HDR], 4, numExtTraceHeaders, doSwap );
+    writeInt8Bytes( &binHdr[BIN_NUM_TRACES], numTracesInFile, doSwap );
+    writeInt8Bytes( &binHdr[BIN_FIRST_TRACE], firstTraceByteOffset, doSwap );
+  }
+}
+//--------------------------------------------------------------------
+int csSegyFileHeader::sampleByteSize() const {
+  switch( formatCode ) {
+  case FORMAT_IBM:
+  case FORMAT_INT32:
+  case FORMAT_IEEE:
+    return 4;
+  case FORMAT_INT16:
+    return 2;
+  case FORMAT_DOUBLE:
+    return 8;
+  case FORMAT_INT8:
+    return 1;
+  }
+  return 0;
+}
+int csSegyFileHeader::traceByteSize( int numSamples_in ) const {
+  return( TRACE_HEADER_BYTE_SIZE * ( 1 + numExtTraceHeaders ) + numSamples_in * sampleByteSize() );
+}
+
+//--------------------------------------------------------------------
+//--------------------------------------------------------------------
+csSegyHeaderMap::csSegyHeaderMap() {
+  addHeader( "seq",         1, 4, "Trace sequence number within line" );
+  addHeader( "trcno",       5, 4, "Trace sequence number within file" );
+  addHeader( "ffid",        9, 4, "Field file ID number" );
+  addHeader( "chan",       13, 4, "Channel number" );
+  addHeader( "source",     17, 4, "Energy source point number" );
+  addHeader( "cmp",        21, 4, "CMP number" );
+  addHeader( "chan_ens",   25, 4, "Trace number within ensemble" );
+  addHeader( "trc_type",   29, 2, "Trace identification code" );
+  addHeader( "fold_vert",  31, 2, "Number of vertically summed traces" );
+  addHeader( "fold",       33, 2, "Number of horizontally stacked traces" );
+  addHeader( "data_type",  35, 2, "Data use" );
+  addHeader( "offset",     37, 4, "Source-receiver offset" );
+  addHeader( "rec_elev",   41, 4, "Receiver group elevation" );
+  addHeader( "sou_elev",   45, 4, "Surface elevation at source" );
+  addHeader( "sou_z",      49, 4, "Source depth below surface" );
+  addHeader( "rec_datum",  53, 4, "Datum elevation at receiver group" );
+  addHeader( "sou_datum",  57, 4, "Datum elevation at source" );
+  addHeader( "sou_wdep",   61, 4, "Water depth at source" );
+  addHeader( "rec_wdep",   65, 4, "Water depth at receiver group" );
+  addHeader( "scalar_elev",  69, 2, "Scalar for elevations and depths" );
+  addHeader( "scalar_coord", 71, 2, "Scalar for coordinates" );
+  addHeader( "sou_x",      73, 4, "Source X coordinate" );
+  addHeader( "sou_y",      77, 4, "Source Y coordinate" );
+  addHeader( "rec_x",      81, 4, "Receiver X coordinate" );
+  addHeader( "rec_y",      85, 4, "Receiver Y coordinate" );
+  addHeader( "unit_coord", 89, 2, "Coordinate units" );
+  addHeader( "stat_sou",   99, 2, "Source static correction [ms]" );
+  addHeader( "stat_rec",  101, 2, "Receiver group static correction [ms]" );
+  addHeader( "stat_tot",  103, 2, "Total static applied [ms]" );
+  addHeader( "delay_time",  109, 2, "Delay recording time [ms]" );
+  addHeader( "mute_start",  111, 2, "Mute time start [ms]" );
+  addHeader( "mute_end",    113, 2, "Mute time end [ms]" );
+  addHeader( "nsamp",       115, 2, "Number of samples in this trace" );
+  addHeader( "sampint_us",  117, 2, "Sample interval of this trace [us]" );
+  addHeader( "gain_type",   119, 2, "Gain type of field instruments" );
+  addHeader( "gain",        121, 2, "Instrument gain constant [dB]" );
+  addHeader( "filt_low_freq",  149, 2, "Low-cut frequency [Hz]" );
+  addHeader( "filt_high_freq", 151, 2, "High-cut frequency [Hz]" );
+  addHeader( "filt_low_db",    153, 2, "Low-cut slope [dB/oct]" );
+  addHeader( "filt_high_db",   155, 2, "High-cut slope [dB/oct]" );
+  addHeader( "time_year",   157, 2, "Year data recorded" );
+  addHeader( "time_day",    159, 2, "Day of year" );
+  addHeader( "time_hour",   161, 2, "Hour of day" );
+  addHeader( "time_min",    163, 2, "Minute of hour" );
+  addHeader( "time_sec",    165, 2, "Second of minute" );
+  addHeader( "time_code",   167, 2, "Time basis code" );
+  addHeader( "cmp_x",       181, 4, "CMP X coordinate" );
+  addHeader( "cmp_y",       185, 4, "CMP Y coordinate" );
+  addHeader( "row",         189, 4, "Inline number" );
+  addHeader( "col",         193, 4, "Crossline number" );
+}
+csSegyHeaderMap::csSegyHeaderMap( csSegyHeaderMap const& obj ) {
+  copyFrom( obj );
+}
+csSegyHeaderMap::~csSegyHeaderMap() {
+}
+csSegyHeaderMap& csSegyHeaderMap::operator=( csSegyHeaderMap const& obj ) {
+  if( this != &obj ) {
+    myNames.clear();
+    myDescs.clear();
+    myByteOffsets.clear();
+    myByteSizes.clear();
+    copyFrom( obj );
+  }
+  return *this;
+}
+void csSegyHeaderMap::copyFrom( csSegyHeaderMap const& obj ) {
+  for( int i = 0; i < obj.numHeaders(); i++ ) {
+    myNames.insertEnd( obj.myNames.at(i) );
+    myDescs.insertEnd( obj.myDescs.at(i) );
+    myByteOffsets.insertEnd( obj.myByteOffsets.at(i) );
+    myByteSizes.insertEnd( obj.myByteSizes.at(i) );
+  }
+}
+//--------------------------------------------------------------------
+void csSegyHeaderMap::addHeader( std::string const& name, int byteLoc, int byteSize, std::string const& desc ) {
+  int hdrIndex = headerIndex( name );
+  if( hdrIndex < 0 ) {
+    myNames.insertEnd( name );
+    myDescs.insertEnd( desc );
+    myByteOffsets.insertEnd( byteLoc-1 );
+    myByteSizes.insertEnd( byteSize );
+  }
+  else {
+    if( !desc.empty() ) myDescs.set( desc, hdrIndex );
+    myByteOffsets.set( byteLoc-1, hdrIndex );
+    myByteSizes.set( byteSize, hdrIndex );
+  }
+}
+int csSegyHeaderMap::headerIndex( std::string const& name ) const {
+  for( int i = 0; i < myNames.size(); i++ ) {
+    if( !myNames.at(i).compare( name ) ) return i;
+  }
+  return -1;
+}
+//--------------------------------------------------------------------
+int csSegyHeaderMap::value( char const* traceHdr, int hdrIndex, bool doSwapEndian ) const {
+  return readInt( &traceHdr[myByteOffsets.at(hdrIndex)], myByteSizes.at(hdrIndex), doSwapEndian );
+}
+void csSegyHeaderMap::setValue( char* traceHdr, int hdrIndex, int value, bool doSwapEndian ) const {
+  writeInt( &traceHdr[myByteOffsets.at(hdrIndex)], myByteSizes.at(hdrIndex), value, doSwapEndian );
+}
+int csSegyHeaderMap::readInt( char const* ptr, int byteSize, bool doSwapEndian ) {
+  if( byteSize == 2 ) {
+    short value;
+    memcpy( &value, ptr, 2 );
+    if( doSwapEndian ) cseis_geolib::swapEndian2( reinterpret_cast<char*>(&value), 2 );
+    return value;
+  }
+  int value;
+  memcpy( &value, ptr, 4 );
+  if( doSwapEndian ) cseis_geolib::swapEndian4( reinterpret_cast<char*>(&value), 4 );
+  return value;
+}
+void csSegyHeaderMap::writeInt( char* ptr, int byteSize, int value, bool doSwapEndian ) {
+  if( byteSize == 2 ) {
+    short valueShort = (short)value;
+    if( doSwapEndian ) cseis_geolib::swapEndian2( reinterpret_cast<char*>(&valueShort), 2 );
+    memcpy( ptr, &valueShort, 2 );
+  }
+  else {
+    if( doSwapEndian ) cseis_geolib::swapEndian4( reinterpret_cast<char*>(&value), 4 );
+    memcpy( ptr, &value, 4 );
+  }
+}
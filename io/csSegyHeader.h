@@ -0,0 +1,133 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_SEGY_HEADER_H
+#define CS_SEGY_HEADER_H
+
+#include <string>
+#include "geolib/geolib_defines.h"
+#include "geolib/csVector.h"
+
+namespace cseis_io {
+
+/**
+ * SEG-Y binary file header, revisions 0, 1 and 2
+ *
+ * Only the fields required for reading/writing traces are held as members. All byte locations given below are
+ * 1-based file byte positions, as in the SEG-Y standard.
+ */
+class csSegyFileHeader {
+ public:
+  static int const TEXT_HEADER_BYTE_SIZE  = 3200;
+  static int const BIN_HEADER_BYTE_SIZE   = 400;
+  static int const TRACE_HEADER_BYTE_SIZE = 240;
+  /// Integer constant at bytes 3297-3300 (rev 2), used to detect the byte order of the file
+  static int const BYTE_ORDER_CONSTANT = 16909060;
+
+  static int const FORMAT_IBM    = 1;
+  static int const FORMAT_INT32  = 2;
+  static int const FORMAT_INT16  = 3;
+  static int const FORMAT_IEEE   = 5;
+  static int const FORMAT_DOUBLE = 6;
+  static int const FORMAT_INT8   = 8;
+
+ public:
+  csSegyFileHeader();
+  /**
+   * Decode binary header
+   * Byte order is taken from the rev 2 byte order constant if set, otherwise big endian is assumed
+   * unless the format code only makes sense in little endian byte order.
+   * @param binHdr  400-byte binary header
+   * @return false if the sample format or number of samples is not supported
+   */
+  bool decode( char const* binHdr );
+  /**
+   * Encode binary header. Fields not held in this class are set to zero.
+   * @param binHdr  (o) 400-byte binary header
+   */
+  void encode( char* binHdr ) const;
+  /// @return Number of bytes per sample for current format code, or 0 if format code is not supported
+  int sampleByteSize() const;
+  /// @return Number of bytes of one trace, including trace header(s), for the given number of samples
+  int traceByteSize( int numSamples_in ) const;
+
+  int jobID;
+  int lineNumber;
+  int reelNumber;
+  int numTracesPerEnsemble;
+  int numAuxTracesPerEnsemble;
+  /// Sample interval [us]
+  double sampleIntUS;
+  int numSamples;
+  int formatCode;
+  int ensembleFold;
+  int sortCode;
+  int measurementSystem;
+  /// SEG-Y revision, e.g. 0x0100 for rev 1.0
+  int revision;
+  bool isFixedLength;
+  /// Number of 3200-byte extended textual headers following the binary header. -1: Variable number, terminated by ((SEG: EndText)) stanza
+  int numExtTextHeaders;
+  /// Number of additional 240-byte trace headers per trace (rev 2)
+  int numExtTraceHeaders;
+  /// Number of traces in file (rev 2), 0 if not set
+  csInt64_t numTracesInFile;
+  /// Byte offset of first trace (rev 2), 0 if not set
+  csInt64_t firstTraceByteOffset;
+  bool isLittleEndian;
+};
+
+/**
+ * Mapping of SEG-Y trace header bytes to named header values
+ *
+ * Pre-defined with the standard SEG-Y rev 1 trace header fields, using Cseis standard header names
+ * where one exists. Header values are raw integer values: Coordinate and elevation scalars are not applied.
+ * Custom byte locations can be added, or standard ones redefined, with addHeader().
+ */
+class csSegyHeaderMap {
+ public:
+  csSegyHeaderMap();
+  csSegyHeaderMap( csSegyHeaderMap const& obj );
+  ~csSegyHeaderMap();
+  csSegyHeaderMap& operator=( csSegyHeaderMap const& obj );
+  /**
+   * Add header, or redefine byte location of existing header
+   * @param name      Header name
+   * @param byteLoc   1-based byte location in trace header
+   * @param byteSize  Number of bytes, 2 or 4
+   */
+  void addHeader( std::string const& name, int byteLoc, int byteSize, std::string const& desc = "" );
+  int numHeaders() const { return myNames.size(); }
+  /// @return Index of header with given name, or -1 if header does not exist
+  int headerIndex( std::string const& name ) const;
+  std::string const& name( int hdrIndex ) const { return myNames.at(hdrIndex); }
+  std::string const& desc( int hdrIndex ) const { return myDescs.at(hdrIndex); }
+  /// @return 0-based byte offset in trace header
+  int byteOffset( int hdrIndex ) const { return myByteOffsets.at(hdrIndex); }
+  int byteSize( int hdrIndex ) const { return myByteSizes.at(hdrIndex); }
+  /**
+   * @return Value of given header from raw trace header
+   * @param doSwapEndian  true if trace header is stored in non-native byte order
+   */
+  int value( char const* traceHdr, int hdrIndex, bool doSwapEndian ) const;
+  /**
+   * Set value of given header in raw trace header
+   */
+  void setValue( char* traceHdr, int hdrIndex, int value, bool doSwapEndian ) const;
+
+  /// @return Integer value of given size at given byte location, see value()
+  static int readInt( char const* ptr, int byteSize, bool doSwapEndian );
+  static void writeInt( char* ptr, int byteSize, int value, bool doSwapEndian );
+
+ private:
+  void copyFrom( csSegyHeaderMap const& obj );
+  cseis_geolib::csVector<std::string> myNames;
+  cseis_geolib::csVector<std::string> myDescs;
+  cseis_geolib::csVector<int> myByteOffsets;
+  cseis_geolib::csVector<int> myByteSizes;
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,368 @@
+
+
+#include "csSegyReader.h"
+#include "geolib/csException.h"
+#include "geolib/csFlexHeader.h"
+#include "geolib/csFileUtils.h"
+#include "geolib/csTimeline.h"
+#include "geolib/csVector.h"
+#include "geolib/geolib_endian.h"
+#include "geolib/geolib_platform_dependent.h"
+#include "geolib/methods_number_conversions.h"
+#include <cstring>
+#include <cctype>
+
+#ifndef PLATFORM_WINDOWS
+extern "C" {
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+}
+#endif
+
+using namespace cseis_io;
+
+namespace {
+  /// Byte offset of number of samples in trace header
+  static int const TRC_NUM_SAMPLES = 114;
+  static int const SAMPLE_BUFFER_ALIGNMENT = 64;
+}
+
+//--------------------------------------------------------------------
+csSegyReader::csSegyReader( std::string filename, bool doMemoryMap ) {
+  myFilename     = filename;
+  myDoMemoryMap  = doMemoryMap;
+  myDoSwapEndian = false;
+  myNumSamples   = 0;
+  myNumTraces    = 0;
+  myTraceByteSize     = 0;
+  myFirstTraceBytePos = 0;
+  myTraceOffsets      = NULL;
+  myCurrentTraceIndex = 0;
+  myPeekHdrIndex      = -1;
+  myFile         = NULL;
+  myFileData     = NULL;
+  myFileByteSize = 0;
+  myIsMapped     = false;
+  myReadBuffer   = NULL;
+  myReadBufferSize    = 0;
+  mySampleBufferAlloc = NULL;
+  mySampleBuffer      = NULL;
+
+  int timeStamp;
+  if( !cseis_geolib::csFileUtils::retrieveFileInfo( myFilename, &myFileByteSize, &timeStamp ) ) {
+    throw( cseis_geolib::csException("Cannot open file '%s'", myFilename.c_str() ) );
+  }
+  if( myFileByteSize < csSegyFileHeader::TEXT_HEADER_BYTE_SIZE + csSegyFileHeader::BIN_HEADER_BYTE_SIZE ) {
+    throw( cseis_geolib::csException("File '%s' is too small to be a SEG-Y file", myFilename.c_str() ) );
+  }
+
+#ifndef PLATFORM_WINDOWS
+  if( myDoMemoryMap ) {
+    int fd = ::open( myFilename.c_str(), O_RDONLY );
+    if( fd >= 0 ) {
+      void* ptr = mmap( NULL, (size_t)myFileByteSize, PROT_READ, MAP_SHARED, fd, 0 );
+      ::close( fd );
+      if( ptr != MAP_FAILED ) {
+        myFileData = (char*)ptr;
+        myIsMapped = true;
+      }
+    }
+  }
+#endif
+  if( !myIsMapped ) {
+    myFile = fopen( myFilename.c_str(), "rb" );
+    if( myFile == NULL ) {
+      throw( cseis_geolib::csException("Cannot open file '%s'", myFilename.c_str() ) );
+    }
+  }
+
+  char const* binHdr = dataAt( csSegyFileHeader::TEXT_HEADER_BYTE_SIZE, csSegyFileHeader::BIN_HEADER_BYTE_SIZE );
+  if( binHdr == NULL || !myFileHdr.decode( binHdr ) ) {
+    close();
+    throw( cseis_geolib::csException("File '%s' is not a SEG-Y file, or uses an unsupported sample format", myFilename.c_str() ) );
+  }
+  myDoSwapEndian = ( myFileHdr.isLittleEndian != cseis_geolib::isPlatformLittleEndian() );
+  readTextHeader();
+  computeTraceOffsets();
+
+  mySampleBufferAlloc = new char[myNumSamples*sizeof(float) + SAMPLE_BUFFER_ALIGNMENT];
+  size_t misalignment = (size_t)mySampleBufferAlloc % SAMPLE_BUFFER_ALIGNMENT;
+  mySampleBuffer = reinterpret_cast<float*>( mySampleBufferAlloc + ( misalignment == 0 ? 0 : SAMPLE_BUFFER_ALIGNMENT - misalignment ) );
+}
+csSegyReader::~csSegyReader() {
+  close();
+  if( myTraceOffsets != NULL ) {
+    delete [] myTraceOffsets;
+    myTraceOffsets = NULL;
+  }
+  if( myReadBuffer != NULL ) {
+    delete [] myReadBuffer;
+    myReadBuffer = NULL;
+  }
+  if( mySampleBufferAlloc != NULL ) {
+    delete [] mySampleBufferAlloc;
+    mySampleBufferAlloc = NULL;
+  }
+}
+void csSegyReader::close() {
+  if( myFile != NULL ) {
+    fclose( myFile );
+    myFile = NULL;
+  }
+#ifndef PLATFORM_WINDOWS
+  if( myIsMapped ) {
+    munmap( myFileData, (size_t)myFileByteSize );
+  }
+#endif
+  myFileData = NULL;
+  myIsMapped = false;
+}
+//--------------------------------------------------------------------
+char const* csSegyReader::dataAt( csInt64_t bytePos, int numBytes ) {
+  if( bytePos < 0 || bytePos + numBytes > myFileByteSize ) return NULL;
+  if( myIsMapped ) return &myFileData[bytePos];
+  if( myFile == NULL ) return NULL;
+  if( numBytes > myReadBufferSize ) {
+    if( myReadBuffer != NULL ) delete [] myReadBuffer;
+    myReadBuffer     = new char[numBytes];
+    myReadBufferSize = numBytes;
+  }
+  cseis_geolib::csTimeline::Event event( "read buffer", "io" );
+  event.setArg( numBytes );
+  if( fseeko64( myFile, bytePos, SEEK_SET ) != 0 ) return NULL;
+  if( fread( myReadBuffer, numBytes, 1, myFile ) != 1 ) return NULL;
+  return myReadBuffer;
+}
+//--------------------------------------------------------------------
+void csSegyReader::readTextHeader() {
+  int const size = csSegyFileHeader::TEXT_HEADER_BYTE_SIZE;
+  unsigned char const* text = reinterpret_cast<unsigned char const*>( dataAt( 0, size ) );
+  myTextHeader.clear();
+  if( text == NULL ) return;
+  // EBCDIC: Letters and digits have the high bit set. Standard text headers start with 'C' (EBCDIC 0xC3)
+  int numHighBit = 0;
+  int numAlnum   = 0;
+  for( int i = 0; i < size; i++ ) {
+    if( text[i] >= 0x80 ) numHighBit += 1;
+    else if( isalnum( text[i] ) ) numAlnum += 1;
+  }
+  bool isEbcdic = ( text[0] == 0xC3 || numHighBit > numAlnum );
+  myTextHeader.resize( size );
+  for( int i = 0; i < size; i++ ) {
+    char c = isEbcdic ? cseis_geolib::ebcdic2char( (short)text[i] ) : (char)text[i];
+    myTextHeader[i] = ( c == '\0' ) ? ' ' : c;
+  }
+}
+//--------------------------------------------------------------------
+void csSegyReader::computeTraceOffsets() {
+  int const textSize = csSegyFileHeader::TEXT_HEADER_BYTE_SIZE;
+  myFirstTraceBytePos = myFileHdr.firstTraceByteOffset;
+  if( myFirstTraceBytePos <= 0 ) {
+    myFirstTraceBytePos = textSize + csSegyFileHeader::BIN_HEADER_BYTE_SIZE;
+    if( myFileHdr.numExtTextHeaders > 0 ) {
+      myFirstTraceBytePos += (csInt64_t)myFileHdr.numExtTextHeaders * textSize;
+    }
+    else if( myFileHdr.numExtTextHeaders < 0 ) {
+      // Variable number of extended textual headers, the last one containing the stanza ((SEG: EndText))
+      bool isEndFound = false;
+      while( !isEndFound && myFirstTraceBytePos + textSize <= myFileByteSize ) {
+        char const* text = dataAt( myFirstTraceBytePos, textSize );
+        if( text == NULL ) break;
+        std::string strASCII( text, textSize );
+        std::string strEBCDIC( textSize, ' ' );
+        for( int i = 0; i < textSize; i++ ) {
+          strEBCDIC[i] = cseis_geolib::ebcdic2char( (short)(unsigned char)text[i] );
+        }
+        isEndFound = ( strASCII.find("EndText") != std::string::npos || strEBCDIC.find("EndText") != std::string::npos );
+        myFirstTraceBytePos += textSize;
+      }
+    }
+  }
+
+  myNumSamples    = myFileHdr.numSamples;
+  myTraceByteSize = myFileHdr.traceByteSize( myNumSamples );
+  csInt64_t dataByteSize = myFileByteSize - myFirstTraceBytePos;
+  if( dataByteSize < 0 ) dataByteSize = 0;
+
+  // Fixed trace length: Always for rev 0, otherwise as flagged in the file header. Files flagged as variable-length
+  // with a data size matching the fixed trace length are also read as fixed-length files.
+  bool isFixedLength = myFileHdr.isFixedLength;
+  if( !isFixedLength && dataByteSize % myTraceByteSize == 0 ) {
+    char const* trcHdr = dataAt( myFirstTraceBytePos, csSegyFileHeader::TRACE_HEADER_BYTE_SIZE );
+    int numSamplesTrace = ( trcHdr != NULL ) ? (unsigned short)csSegyHeaderMap::readInt( &trcHdr[TRC_NUM_SAMPLES], 2, myDoSwapEndian ) : 0;
+    isFixedLength = ( numSamplesTrace == 0 || numSamplesTrace == myNumSamples );
+  }
+
+  if( isFixedLength ) {
+    csInt64_t numTraces = dataByteSize / myTraceByteSize;
+    if( myFileHdr.numTracesInFile > 0 && myFileHdr.numTracesInFile < numTraces ) numTraces = myFileHdr.numTracesInFile;
+    myNumTraces = (int)numTraces;
+    return;
+  }
+
+  // Variable trace length: Scan all trace headers once
+  cseis_geolib::csVector<csInt64_t> offsetList;
+  csInt64_t bytePos = myFirstTraceBytePos;
+  int maxNumSamples = 0;
+  while( bytePos + csSegyFileHeader::TRACE_HEADER_BYTE_SIZE <= myFileByteSize ) {
+    char const* trcHdr = dataAt( bytePos, csSegyFileHeader::TRACE_HEADER_BYTE_SIZE );
+    if( trcHdr == NULL ) break;
+    int numSamplesTrace = (unsigned short)csSegyHeaderMap::readInt( &trcHdr[TRC_NUM_SAMPLES], 2, myDoSwapEndian );
+    if( numSamplesTrace == 0 ) numSamplesTrace = myFileHdr.numSamples;
+    csInt64_t traceByteSize = myFileHdr.traceByteSize( numSamplesTrace );
+    if( bytePos + traceByteSize > myFileByteSize ) break;
+    offsetList.insertEnd( bytePos );
+    if( numSamplesTrace > maxNumSamples ) maxNumSamples = numSamplesTrace;
+    bytePos += traceByteSize;
+    if( myFileHdr.numTracesInFile > 0 && offsetList.size() == myFileHdr.numTracesInFile ) break;
+  }
+  myNumTraces    = offsetList.size();
+  myTraceOffsets = new csInt64_t[myNumTraces+1];
+  for( int itrc = 0; itrc < myNumTraces; itrc++ ) {
+    myTraceOffsets[itrc] = offsetList.at(itrc);
+  }
+  myTraceOffsets[myNumTraces] = bytePos;
+  if( maxNumSamples > myNumSamples ) myNumSamples = maxNumSamples;
+  myTraceByteSize = myFileHdr.traceByteSize( myNumSamples );
+}
+//--------------------------------------------------------------------
+int csSegyReader::numSamples( int traceIndex ) const {
+  if( traceIndex < 0 || traceIndex >= myNumTraces ) return 0;
+  if( myTraceOffsets == NULL ) return myNumSamples;
+  int hdrByteSize = myFileHdr.traceByteSize( 0 );
+  return (int)( ( myTraceOffsets[traceIndex+1] - myTraceOffsets[traceIndex] - hdrByteSize ) / myFileHdr.sampleByteSize() );
+}
+char const* csSegyReader::traceHeader( int traceIndex ) {
+  if( traceIndex < 0 || traceIndex >= myNumTraces ) return NULL;
+  return dataAt( traceBytePos( traceIndex ), csSegyFileHeader::TRACE_HEADER_BYTE_SIZE );
+}
+int csSegyReader::headerIntValue( int traceIndex, int hdrIndex ) {
+  char const* trcHdr = traceHeader( traceIndex );
+  if( trcHdr == NULL ) {
+    throw( cseis_geolib::csException("csSegyReader::headerIntValue: Cannot read trace header of trace index %d", traceIndex) );
+  }
+  return myHdrMap.value( trcHdr, hdrIndex, myDoSwapEndian );
+}
+//--------------------------------------------------------------------
+bool csSegyReader::readTrace( int traceIndex, float* samples ) {
+  int numSamplesTrace = numSamples( traceIndex );
+  if( numSamplesTrace <= 0 ) return false;
+  if( numSamplesTrace > myNumSamples ) numSamplesTrace = myNumSamples;
+  int hdrByteSize = myFileHdr.traceByteSize( 0 );
+  char const* data = dataAt( traceBytePos( traceIndex ) + hdrByteSize, numSamplesTrace * myFileHdr.sampleByteSize() );
+  if( data == NULL ) return false;
+  convertSamples( data, samples, numSamplesTrace );
+  for( int isamp = numSamplesTrace; isamp < myNumSamples; isamp++ ) {
+    samples[isamp] = 0.0f;
+  }
+  return true;
+}
+float const* csSegyReader::readTrace( int traceIndex ) {
+  if( !readTrace( traceIndex, mySampleBuffer ) ) return NULL;
+  return mySampleBuffer;
+}
+float const* csSegyReader::getNextTrace() {
+  if( myCurrentTraceIndex >= myNumTraces ) return NULL;
+  float const* samples = readTrace( myCurrentTraceIndex );
+  if( samples != NULL ) myCurrentTraceIndex += 1;
+  return samples;
+}
+//--------------------------------------------------------------------
+void csSegyReader::convertSamples( char const* dataIn, float* samples, int numSamplesIn ) const {
+  char* dataOut = reinterpret_cast<char*>( samples );
+  switch( myFileHdr.formatCode ) {
+  case csSegyFileHeader::FORMAT_IBM:
+    cseis_geolib::ibm2ieee( reinterpret_cast<unsigned char const*>( dataIn ), reinterpret_cast<unsigned char*>( dataOut ), numSamplesIn, myDoSwapEndian );
+    break;
+  case csSegyFileHeader::FORMAT_IEEE:
+    if( myDoSwapEndian ) {
+      cseis_geolib::swapEndian4( dataIn, dataOut, numSamplesIn*4 );
+    }
+    else {
+      memcpy( dataOut, dataIn, numSamplesIn*4 );
+    }
+    break;
+  case csSegyFileHeader::FORMAT_INT32: {
+    if( myDoSwapEndian ) {
+      cseis_geolib::swapEndian4( dataIn, dataOut, numSamplesIn*4 );
+    }
+    else {
+      memcpy( dataOut, dataIn, numSamplesIn*4 );
+    }
+    int value;
+    for( int isamp = 0; isamp < numSamplesIn; isamp++ ) {
+      memcpy( &value, &dataOut[4*isamp], 4 );
+      samples[isamp] = (float)value;
+    }
+    break;
+  }
+  case csSegyFileHeader::FORMAT_INT16:
+    for( int isamp = 0; isamp < numSamplesIn; isamp++ ) {
+      samples[isamp] = (float)csSegyHeaderMap::readInt( &dataIn[2*isamp], 2, myDoSwapEndian );
+    }
+    break;
+  case csSegyFileHeader::FORMAT_INT8:
+    for( int isamp = 0; isamp < numSamplesIn; isamp++ ) {
+      samples[isamp] = (float)(signed char)dataIn[isamp];
+    }
+    break;
+  case csSegyFileHeader::FORMAT_DOUBLE: {
+    double value;
+    for( int isamp = 0; isamp < numSamplesIn; isamp++ ) {
+      memcpy( &value, &dataIn[8*isamp], 8 );
+      if( myDoSwapEndian ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&value), 8 );
+      samples[isamp] = (float)value;
+    }
+    break;
+  }
+  }
+}
+//--------------------------------------------------------------------
+bool csSegyReader::moveToTrace( int traceIndex ) {
+  if( traceIndex < 0 || traceIndex >= myNumTraces ) return false;
+  myCurrentTraceIndex = traceIndex;
+  return true;
+}
+bool csSegyReader::setHeaderToPeek( std::string const& headerName ) {
+  myPeekHdrIndex = myHdrMap.headerIndex( headerName );
+  return( myPeekHdrIndex >= 0 );
+}
+bool csSegyReader::setHeaderToPeek( std::string const& headerName, cseis_geolib::type_t& headerType ) {
+  headerType = cseis_geolib::TYPE_INT;
+  return setHeaderToPeek( headerName );
+}
+bool csSegyReader::peekHeaderValue( cseis_geolib::csFlexHeader* value, int traceIndex ) {
+  if( myPeekHdrIndex < 0 ) {
+    throw( cseis_geolib::csException("csSegyReader::peekHeaderValue: No header has been set for checking. This is a program bug in the calling function") );
+  }
+  if( traceIndex < 0 ) traceIndex = myCurrentTraceIndex;
+  char const* trcHdr = traceHeader( traceIndex );
+  if( trcHdr == NULL ) return false;
+  value->setIntValue( myHdrMap.value( trcHdr, myPeekHdrIndex, myDoSwapEndian ) );
+  return true;
+}
+bool csSegyReader::peekHeaderValues( cseis_geolib::csFlexHeader* values, int firstTraceIndex, int numTraces ) {
+  if( myPeekHdrIndex < 0 ) {
+    throw( cseis_geolib::csException("csSegyReader::peekHeaderValues: No header has been set for checking. This is a program bug in the calling function") );
+  }
+  if( firstTraceIndex < 0 || firstTraceIndex + numTraces > myNumTraces ) return false;
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    char const* trcHdr = traceHeader( firstTraceIndex + itrc );
+    if( trcHdr == NULL ) return false;
+    values[itrc].setIntValue( myHdrMap.value( trcHdr, myPeekHdrIndex, myDoSwapEndian ) );
+  }
+  return true;
+}
+cseis_geolib::csIReader* csSegyReader::createScanReader() const {
+  csSegyReader* reader = NULL;
+  try {
+    reader = new csSegyReader( myFilename, myDoMemoryMap );
+  }
+  catch( cseis_geolib::csException& ) {
+    return NULL;
+  }
+  reader->myHdrMap = myHdrMap;
+  return reader;
+}
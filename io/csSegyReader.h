@@ -0,0 +1,135 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_SEGY_READER_H
+#define CS_SEGY_READER_H
+
+#include <cstdio>
+#include <string>
+#include "csSegyHeader.h"
+#include "geolib/csIReader.h"
+
+namespace cseis_io {
+
+/**
+ * Reader for SEG-Y files, revisions 0, 1 and 2
+ *
+ * The file is memory-mapped where possible. Otherwise, data is read with standard file I/O into an internal buffer.
+ * Traces can be accessed randomly by trace index. For fixed-length files, trace positions are computed directly.
+ * For variable-length files, all trace headers are scanned once in the constructor to build a trace offset index.
+ *
+ * Trace header values are decoded on demand only, using the byte locations defined in headerMap().
+ * Implements csIReader, so that header-based trace selections (csIOSelection) can be applied to SEG-Y input.
+ *
+ * Supported sample formats: 4-byte IBM float, 4-byte IEEE float, 8-byte IEEE double, 4/2/1-byte integer.
+ * All samples are returned as 4-byte IEEE floats in platform byte order.
+ */
+class csSegyReader : public cseis_geolib::csIReader {
+ public:
+  /**
+   * @param filename  Name of SEG-Y file
+   * @param doMemoryMap  false to use standard file I/O instead of memory-mapping the file
+   */
+  csSegyReader( std::string filename, bool doMemoryMap = true );
+  virtual ~csSegyReader();
+
+  /// @return 3200-byte textual file header, converted to ASCII if required
+  std::string const& textHeader() const { return myTextHeader; }
+  csSegyFileHeader const* fileHeader() const { return &myFileHdr; }
+  /// @return Trace header byte mapping. Add custom header byte locations here before peeking header values
+  csSegyHeaderMap* headerMap() { return &myHdrMap; }
+  csSegyHeaderMap const* headerMap() const { return &myHdrMap; }
+  /// @return Number of samples. For variable-length files, maximum number of samples of all traces
+  int numSamples() const { return myNumSamples; }
+  /// @return Number of samples of given trace
+  int numSamples( int traceIndex ) const;
+  /// @return Sample interval [ms]
+  double sampleInt() const { return myFileHdr.sampleIntUS / 1000.0; }
+  /// @return true if file data is stored in non-native byte order
+  bool doSwapEndian() const { return myDoSwapEndian; }
+  bool isMemoryMapped() const { return myIsMapped; }
+
+  /**
+   * @return Pointer to raw 240-byte trace header of given trace, in file byte order, or NULL if trace does not exist.
+   * Without memory-mapping, the pointer is only valid until the next call to any read method.
+   */
+  char const* traceHeader( int traceIndex );
+  /**
+   * @return Value of given trace header, see csSegyHeaderMap
+   */
+  int headerIntValue( int traceIndex, int hdrIndex );
+  /**
+   * Read trace samples. Traces shorter than numSamples() are zero-padded.
+   * @param samples  (o) Output buffer, at least numSamples() samples
+   */
+  bool readTrace( int traceIndex, float* samples );
+  /**
+   * Read trace samples into internal, 64-byte aligned buffer
+   * @return Pointer to samples, valid until next call to readTrace() or getNextTrace(). NULL if trace cannot be read.
+   */
+  float const* readTrace( int traceIndex );
+  /**
+   * Read next trace, starting at trace index set in moveToTrace()
+   */
+  float const* getNextTrace();
+  /// @return Index of trace that will be read by the next call to getNextTrace()
+  int currentTraceIndex() const { return myCurrentTraceIndex; }
+
+  //--------------------------------------------------------------------
+  // csIReader methods
+  virtual int numTraces() const { return myNumTraces; }
+  virtual bool moveToTrace( int traceIndex );
+  virtual bool setHeaderToPeek( std::string const& headerName );
+  virtual bool setHeaderToPeek( std::string const& headerName, cseis_geolib::type_t& headerType );
+  virtual bool peekHeaderValue( cseis_geolib::csFlexHeader* value, int traceIndex );
+  virtual bool peekHeaderValues( cseis_geolib::csFlexHeader* values, int firstTraceIndex, int numTraces );
+  virtual cseis_geolib::csIReader* createScanReader() const;
+
+ private:
+  void readTextHeader();
+  void computeTraceOffsets();
+  void close();
+  /// @return Pointer to file data at given byte position, or NULL if position is beyond end of file or a read error occurred
+  char const* dataAt( csInt64_t bytePos, int numBytes );
+  /// @return Byte position of given trace in file
+  inline csInt64_t traceBytePos( int traceIndex ) const {
+    return( myTraceOffsets != NULL ? myTraceOffsets[traceIndex] : myFirstTraceBytePos + (csInt64_t)traceIndex * (csInt64_t)myTraceByteSize );
+  }
+  void convertSamples( char const* dataIn, float* samples, int numSamplesIn ) const;
+
+  std::string myFilename;
+  std::string myTextHeader;
+  csSegyFileHeader myFileHdr;
+  csSegyHeaderMap  myHdrMap;
+  bool myDoSwapEndian;
+  bool myDoMemoryMap;
+
+  int myNumSamples;
+  int myNumTraces;
+  int myTraceByteSize;
+  csInt64_t myFirstTraceBytePos;
+  /// Byte position of each trace, variable-length files only. NULL for fixed-length files
+  csInt64_t* myTraceOffsets;
+  int myCurrentTraceIndex;
+  int myPeekHdrIndex;
+
+  // File access
+  std::FILE* myFile;
+  char* myFileData;
+  csInt64_t myFileByteSize;
+  bool myIsMapped;
+  /// Read buffer, only used without memory-mapping
+  char* myReadBuffer;
+  int myReadBufferSize;
+  /// Sample buffer returned by readTrace(int)
+  char* mySampleBufferAlloc;
+  float* mySampleBuffer;
+
+  csSegyReader( csSegyReader const& obj );
+  csSegyReader& operator=( csSegyReader const& obj );
+};
+
+} // end namespace
+
+#endif
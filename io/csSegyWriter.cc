@@ -0,0 +1,136 @@
+
+
+#include "csSegyWriter.h"
+#include "geolib/csException.h"
+#include "geolib/geolib_endian.h"
+#include "geolib/geolib_platform_dependent.h"
+#include "geolib/csTimeline.h"
+#include "geolib/methods_number_conversions.h"
+#include <cstring>
+
+using namespace cseis_io;
+
+namespace {
+  static int const WRITE_BUFFER_BYTE_SIZE = 4*1024*1024;
+  /// Byte offset of number of traces in binary header (rev 2, bytes 3513-3520)
+  static int const BIN_NUM_TRACES = 312;
+}
+
+csSegyWriter::csSegyWriter( std::string filename, bool overwrite ) {
+  myFilename = filename;
+  myFile = NULL;
+  myDoSwapEndian = false;
+  myHasWrittenFileHeader = false;
+  myNumTracesWritten = 0;
+  myBuffer         = NULL;
+  myBufferSize     = 0;
+  myBufferNumBytes = 0;
+  myTraceByteSize  = 0;
+
+  if( !overwrite ) {
+    myFile = fopen( myFilename.c_str(), "rb" );
+    if( myFile != NULL ) {
+      fclose( myFile );
+      myFile = NULL;
+      throw( cseis_geolib::csException("File exists and shall NOT be overwritten: '%s'", myFilename.c_str() ) );
+    }
+  }
+  myFile = fopen( myFilename.c_str(), "wb" );
+  if( myFile == NULL ) {
+    throw( cseis_geolib::csException("Cannot open file '%s'", myFilename.c_str() ) );
+  }
+}
+csSegyWriter::~csSegyWriter() {
+  close();
+  if( myBuffer != NULL ) {
+    delete [] myBuffer;
+    myBuffer = NULL;
+  }
+}
+//--------------------------------------------------------------------
+bool csSegyWriter::writeFileHeader( csSegyFileHeader const* hdr, std::string const& textHeader, bool doEbcdic ) {
+  if( myFile == NULL || myHasWrittenFileHeader ) return false;
+  myFileHdr = *hdr;
+  if( myFileHdr.formatCode != csSegyFileHeader::FORMAT_IBM && myFileHdr.formatCode != csSegyFileHeader::FORMAT_IEEE ) {
+    throw( cseis_geolib::csException("csSegyWriter: Unsupported sample format code for writing: %d", myFileHdr.formatCode) );
+  }
+  if( myFileHdr.numSamples <= 0 || ( myFileHdr.numSamples > 65535 && myFileHdr.revision < 0x0200 ) ) {
+    throw( cseis_geolib::csException("csSegyWriter: Unsupported number of samples: %d", myFileHdr.numSamples) );
+  }
+  myFileHdr.isFixedLength        = true;
+  myFileHdr.numExtTextHeaders    = 0;
+  myFileHdr.numTracesInFile      = 0;
+  myFileHdr.firstTraceByteOffset = 0;
+  if( myFileHdr.revision < 0x0200 ) myFileHdr.numExtTraceHeaders = 0;
+  myDoSwapEndian = ( myFileHdr.isLittleEndian != cseis_geolib::isPlatformLittleEndian() );
+
+  int const textSize = csSegyFileHeader::TEXT_HEADER_BYTE_SIZE;
+  char text[csSegyFileHeader::TEXT_HEADER_BYTE_SIZE];
+  for( int i = 0; i < textSize; i++ ) {
+    char c = ( i < (int)textHeader.length() ) ? textHeader[i] : ' ';
+    text[i] = doEbcdic ? (char)cseis_geolib::char2ebcdic( c ) : c;
+  }
+  char binHdr[csSegyFileHeader::BIN_HEADER_BYTE_SIZE];
+  myFileHdr.encode( binHdr );
+  if( fwrite( text, textSize, 1, myFile ) != 1 ) return false;
+  if( fwrite( binHdr, csSegyFileHeader::BIN_HEADER_BYTE_SIZE, 1, myFile ) != 1 ) return false;
+
+  myTraceByteSize = myFileHdr.traceByteSize( myFileHdr.numSamples );
+  myBufferSize = ( WRITE_BUFFER_BYTE_SIZE / myTraceByteSize ) * myTraceByteSize;
+  if( myBufferSize < myTraceByteSize ) myBufferSize = myTraceByteSize;
+  myBuffer = new char[myBufferSize];
+  myBufferNumBytes = 0;
+  myHasWrittenFileHeader = true;
+  return true;
+}
+//--------------------------------------------------------------------
+bool csSegyWriter::writeTrace( char const* traceHdr, float const* samples ) {
+  if( myFile == NULL || !myHasWrittenFileHeader ) return false;
+  if( myBufferNumBytes + myTraceByteSize > myBufferSize ) {
+    if( !flushBuffer() ) return false;
+  }
+  char* ptr = &myBuffer[myBufferNumBytes];
+  int const trcHdrSize = csSegyFileHeader::TRACE_HEADER_BYTE_SIZE;
+  memcpy( ptr, traceHdr, trcHdrSize );
+  if( myFileHdr.numExtTraceHeaders > 0 ) {
+    memset( &ptr[trcHdrSize], 0, myFileHdr.numExtTraceHeaders * trcHdrSize );
+  }
+  ptr += trcHdrSize * ( 1 + myFileHdr.numExtTraceHeaders );
+
+  int numSamples = myFileHdr.numSamples;
+  if( myFileHdr.formatCode == csSegyFileHeader::FORMAT_IBM ) {
+    cseis_geolib::ieee2ibm( reinterpret_cast<unsigned char const*>( samples ), reinterpret_cast<unsigned char*>( ptr ), numSamples, myDoSwapEndian );
+  }
+  else if( myDoSwapEndian ) {
+    cseis_geolib::swapEndian4( reinterpret_cast<char const*>( samples ), ptr, numSamples*4 );
+  }
+  else {
+    memcpy( ptr, samples, numSamples*4 );
+  }
+  myBufferNumBytes   += myTraceByteSize;
+  myNumTracesWritten += 1;
+  return true;
+}
+//--------------------------------------------------------------------
+bool csSegyWriter::flushBuffer() {
+  if( myBufferNumBytes == 0 ) return true;
+  cseis_geolib::csTimeline::Event event( "write buffer", "io" );
+  event.setArg( myBufferNumBytes );
+  bool success = ( fwrite( myBuffer, myBufferNumBytes, 1, myFile ) == 1 );
+  myBufferNumBytes = 0;
+  return success;
+}
+bool csSegyWriter::close() {
+  if( myFile == NULL ) return true;
+  bool success = flushBuffer();
+  if( success && myHasWrittenFileHeader && myFileHdr.revision >= 0x0200 ) {
+    csInt64_t numTraces = myNumTracesWritten;
+    myFileHdr.numTracesInFile = numTraces;
+    if( myDoSwapEndian ) cseis_geolib::swapEndian8( reinterpret_cast<char*>(&numTraces), 8 );
+    success = ( fseeko64( myFile, csSegyFileHeader::TEXT_HEADER_BYTE_SIZE + BIN_NUM_TRACES, SEEK_SET ) == 0 &&
+                fwrite( &numTraces, 8, 1, myFile ) == 1 );
+  }
+  if( fclose( myFile ) != 0 ) success = false;
+  myFile = NULL;
+  return success;
+}
@@ -0,0 +1,72 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_SEGY_WRITER_H
+#define CS_SEGY_WRITER_H
+
+#include <cstdio>
+#include <string>
+#include "csSegyHeader.h"
+
+namespace cseis_io {
+
+/**
+ * Writer for SEG-Y files, revisions 0, 1 and 2
+ *
+ * Writes fixed-length traces in IBM or IEEE float format, in the byte order given in the file header.
+ * Traces are appended sequentially through a large write buffer.
+ */
+class csSegyWriter {
+ public:
+  /**
+   * @param filename  Name of output file
+   * @param overwrite true to overwrite even if file exists
+   */
+  csSegyWriter( std::string filename, bool overwrite = true );
+  ~csSegyWriter();
+  /**
+   * Write textual and binary file header
+   * Call only once before writing trace data. Only sample formats FORMAT_IBM and FORMAT_IEEE are supported for writing.
+   * @param textHeader  Textual header. Padded with blanks, or truncated, to 3200 characters
+   * @param doEbcdic    true to write textual header in EBCDIC, false for ASCII
+   */
+  bool writeFileHeader( csSegyFileHeader const* hdr, std::string const& textHeader, bool doEbcdic = true );
+  /**
+   * Write one trace
+   * @param traceHdr  Raw 240-byte trace header, in file byte order (see csSegyHeaderMap::setValue()).
+   *                  Extended trace headers (rev 2) are zero-filled.
+   * @param samples   Trace samples, numSamples as given in file header
+   */
+  bool writeTrace( char const* traceHdr, float const* samples );
+  /**
+   * Flush buffer and close file. For rev 2, the number of traces is written to the binary header.
+   */
+  bool close();
+  csSegyFileHeader const* fileHeader() const { return &myFileHdr; }
+  /// @return true if trace headers and samples are written in non-native byte order
+  bool doSwapEndian() const { return myDoSwapEndian; }
+  csInt64_t numTracesWritten() const { return myNumTracesWritten; }
+
+ private:
+  bool flushBuffer();
+
+  std::string myFilename;
+  FILE* myFile;
+  csSegyFileHeader myFileHdr;
+  bool myDoSwapEndian;
+  bool myHasWrittenFileHeader;
+  csInt64_t myNumTracesWritten;
+
+  char* myBuffer;
+  int myBufferSize;
+  int myBufferNumBytes;
+  int myTraceByteSize;
+
+  csSegyWriter( csSegyWriter const& obj );
+  csSegyWriter& operator=( csSegyWriter const& obj );
+};
+
+} // end namespace
+
+#endif
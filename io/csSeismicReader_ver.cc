@@ -11,6 +11,7 @@
 #include "csIODefines.h"
 #include "geolib/csFileUtils.h"
 #include "geolib/csFlexHeader.h"
+#include "geolib/csTimeline.h"
 #include <cstring>
 #include <limits>
 
@@ -30,6 +31,9 @@ csSeismicReader_ver::csSeismicReader_ver( std::string filename, bool enableRando
   myEnableRandomAccess = enableRandomAccess;
 
   myTempBuffer   = NULL;
+  myPeekBlockBuffer = NULL;
+  myHdrScratchBuffer    = NULL;
+  mySampleScratchBuffer = NULL;
   myByteLoc = 0;
   myIsReadFileHeader = false;
   myHeaderByteSize = 0;
@@ -118,6 +122,18 @@ csSeismicReader_ver::~csSeismicReader_ver() {
     delete [] myDataBuffer;
     myDataBuffer = NULL;
   }
+  if( myPeekBlockBuffer != NULL ) {
+    delete [] myPeekBlockBuffer;
+    myPeekBlockBuffer = NULL;
+  }
+  if( myHdrScratchBuffer != NULL ) {
+    delete [] myHdrScratchBuffer;
+    myHdrScratchBuffer = NULL;
+  }
+  if( mySampleScratchBuffer != NULL ) {
+    delete [] mySampleScratchBuffer;
+    mySampleScratchBuffer = NULL;
+  }
 }
 //----------------------------------------------------------------
 void csSeismicReader_ver::open() {
@@ -256,6 +272,49 @@ bool csSeismicReader_ver::peek( int byteOffset, int byteSize, char* buffer, int
   return success;
 }
 //--------------------------------------------------------------------
+bool csSeismicReader_ver::peekBlock( int byteOffset, int byteSize, char* buffer, int firstTraceIndex, int numTraces ) {
+  if( !myIsReadFileHeader ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver::peekBlock: File header has not been read. This is a program bug in the calling function") );
+  }
+  if( myEnableRandomAccess == false ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver::peekBlock: Random access not enabled. Set enableRandomAccess to true. This is a program bug in the calling function." ) );
+  }
+  if( myFileSize == cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver::peekBlock: File size unknown. This may be due to a compatibility problem of this compiled version of the program on the current platform." ) );
+  }
+  if( firstTraceIndex < 0 || numTraces < 0 || firstTraceIndex+numTraces > myNumTraces ) return false;
+  if( numTraces == 0 ) return true;
+  if( myPeekIsInProgress ) revertFromPeekPosition();
+
+  int maxTracesBlock = std::max( 1, MAX_PEEK_BLOCK_BYTES / myTraceByteSize );
+  if( myPeekBlockBuffer == NULL ) {
+    myPeekBlockBuffer = new char[(csInt64_t)maxTracesBlock * (csInt64_t)myTraceByteSize];
+  }
+
+  // File pointer stands at start of current trace. Move to first trace of block, read, then move back.
+  csInt64_t bytePosCurrent = (csInt64_t)myHeaderByteSize + (csInt64_t)myCurrentTraceIndex * (csInt64_t)myTraceByteSize;
+  csInt64_t bytePosFirst   = (csInt64_t)myHeaderByteSize + (csInt64_t)firstTraceIndex * (csInt64_t)myTraceByteSize;
+  myFile->clear();
+  myFile->seekg( (std::streamoff)bytePosFirst, std::ios_base::beg );
+  bool success = !myFile->fail();
+  int traceCounter = 0;
+  while( traceCounter < numTraces && success ) {
+    int numTracesRead = std::min( maxTracesBlock, numTraces - traceCounter );
+    myFile->read( myPeekBlockBuffer, (csInt64_t)numTracesRead * (csInt64_t)myTraceByteSize );
+    success = !myFile->fail();
+    for( int itrc = 0; itrc < numTracesRead && success; itrc++ ) {
+      memcpy( &buffer[(traceCounter+itrc)*byteSize], &myPeekBlockBuffer[itrc*myTraceByteSize + byteOffset], byteSize );
+    }
+    traceCounter += numTracesRead;
+  }
+  myFile->clear();
+  myFile->seekg( (std::streamoff)bytePosCurrent, std::ios_base::beg );
+  if( myFile->fail() ) {
+    throw( cseis_geolib::csException("csSeismicReader_ver::peekBlock: Unknown problem occurred when trying to reset file pointer.") );
+  }
+  return success;
+}
+//--------------------------------------------------------------------
 bool csSeismicReader_ver::readFileHeader( csSeismicIOConfig* config ) {
   if( myFile == NULL ) return false;
   if( myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver::readFileHeader: Attempt to re-read file header. This is probably a program bug in the calling function") );
@@ -425,10 +484,11 @@ bool csSeismicReader_ver::readSingleTrace( float* samples, char* hdrValueBlock,
 }
 //--------------------------------------------------------
 bool csSeismicReader_ver::readDataBuffer() {
-  myBufferCurrentTrace = 0;
-
+  cseis_geolib::csTimeline::Event event( "read buffer", "io" );
   if( myFileSize != cseis_geolib::csFileUtils::FILESIZE_UNKNOWN ) {
+    // Keep buffer exhausted at end of file, so that subsequent read calls do not return stale traces
     if( myCurrentTraceIndex == myNumTraces ) return false;
+    myBufferCurrentTrace = 0;
 
     // Set myBufferNumTraces: Number of traces to be read into buffer
     if( myCurrentTraceIndex < myLastTraceIndex ) {
@@ -450,6 +510,7 @@ bool csSeismicReader_ver::readDataBuffer() {
       return false;
     }
     myCurrentTraceIndex += myBufferNumTraces;
+    event.setArg( myBufferNumTraces );
   }
   else {
     myBufferCurrentTrace = 0;
@@ -564,8 +625,53 @@ bool csSeismicReader_ver::readTrace( float* samples, char* hdrValueBlock, int nu
     if( !success ) return false;
   }
 
-  memcpy( hdrValueBlock, &myDataBuffer[myBufferCurrentTrace*myTraceByteSize], myByteSizeHdrValueBlock );
-
+  copyBufferedTrace( samples, hdrValueBlock, numSamples );
+  myBufferCurrentTrace += 1;
+  return true;
+}
+//----------------------------------------------------------------
+int csSeismicReader_ver::readTraces( int numTraces, float* samples, size_t stride, char* hdrValueBlocks ) {
+  if( !myIsReadFileHeader ) throw( cseis_geolib::csException("csSeismicReader_ver::readTraces(): File header has not been read. This is a program bug in the calling function") );
+  if (myPeekIsInProgress ) revertFromPeekPosition();
+  if( hdrValueBlocks == NULL && myHdrScratchBuffer == NULL ) {
+    myHdrScratchBuffer = new char[myByteSizeHdrValueBlock];
+  }
+  if( samples == NULL && mySampleScratchBuffer == NULL ) {
+    mySampleScratchBuffer = new float[myNumSamples];
+  }
+  int numTracesRead = 0;
+  if( myBufferCapacityNumTraces == 1 ) {
+    while( numTracesRead < numTraces ) {
+      float* samplePtr = ( samples != NULL ) ? &samples[numTracesRead*stride] : mySampleScratchBuffer;
+      char* hdrPtr = ( hdrValueBlocks != NULL ) ? &hdrValueBlocks[numTracesRead*myByteSizeHdrValueBlock] : myHdrScratchBuffer;
+      if( !readSingleTrace( samplePtr, hdrPtr, myNumSamples ) ) break;
+      numTracesRead += 1;
+    }
+    return numTracesRead;
+  }
+  while( numTracesRead < numTraces ) {
+    if( myBufferCurrentTrace == myBufferNumTraces ) {
+      if( myFile->eof() ) break;
+      if( !readDataBuffer() ) break;
+    }
+    int numTracesCopy = std::min( numTraces-numTracesRead, myBufferNumTraces-myBufferCurrentTrace );
+    for( int itrc = 0; itrc < numTracesCopy; itrc++ ) {
+      float* samplePtr = ( samples != NULL ) ? &samples[(numTracesRead+itrc)*stride] : NULL;
+      char* hdrPtr = ( hdrValueBlocks != NULL ) ? &hdrValueBlocks[(numTracesRead+itrc)*myByteSizeHdrValueBlock] : NULL;
+      copyBufferedTrace( samplePtr, hdrPtr, myNumSamples );
+      myBufferCurrentTrace += 1;
+    }
+    numTracesRead += numTracesCopy;
+  }
+  return numTracesRead;
+}
+//----------------------------------------------------------------
+// Copy current trace from data buffer. Samples or header values are skipped if the corresponding pointer is NULL
+void csSeismicReader_ver::copyBufferedTrace( float* samples, char* hdrValueBlock, int numSamples ) {
+  if( hdrValueBlock != NULL ) {
+    memcpy( hdrValueBlock, &myDataBuffer[myBufferCurrentTrace*myTraceByteSize], myByteSizeHdrValueBlock );
+  }
+  if( samples == NULL ) return;
   // UPDATE THE FOLLOWING:
   if( myByteSizeOneSample == 4 ) {
     if( numSamples >= myNumSamples ) {
@@ -586,9 +692,6 @@ bool csSeismicReader_ver::readTrace( float* samples, char* hdrValueBlock, int nu
     //    fprintf(stderr,"readTrace, compression = %d, numSamples: %d (myNumSamples: %d)\n", myByteSizeOneSample, numSamples, myNumSamples);
     decompressBuffer( samples, numSamples );
   }
-
-  myBufferCurrentTrace += 1;
-  return true;
 }
 //----------------------------------------------------------------------
 void csSeismicReader_ver::decompressBuffer( float* samples, int numSamples ) {
@@ -33,6 +33,8 @@ class csSeismicIOConfig;
 class csSeismicReader_ver {
  public:
   static int const DEFAULT_BUFFERED_SAMPLES = 100000;
+  /// Maximum size in bytes of one read operation in peekBlock()
+  static int const MAX_PEEK_BLOCK_BYTES = 4*1024*1024;
  public:
   csSeismicReader_ver( std::string filename, bool enableRandomAccess, int numTracesBuffer = 0 );
   virtual ~csSeismicReader_ver();
@@ -41,6 +43,15 @@ class csSeismicReader_ver {
   
   virtual bool readTrace( float* samples, char* hdrValueBlock );
   virtual bool readTrace( float* samples, char* hdrValueBlock, int numSamples );
+  /**
+   * Read block of consecutive traces
+   * @param numTraces      (i) Number of traces to read
+   * @param samples        (o) Trace samples. Samples of trace i start at samples[i*stride]. Pass NULL if samples shall not be read.
+   * @param stride         (i) Number of floats between first samples of consecutive traces, must be >= numSamples()
+   * @param hdrValueBlocks (o) Trace header value blocks, one after the other. Pass NULL if headers shall not be read.
+   * @return Number of traces read. Smaller than numTraces if end of file was reached.
+   */
+  int readTraces( int numTraces, float* samples, size_t stride, char* hdrValueBlocks );
   virtual bool moveToTrace( int firstTraceIndex );
   virtual bool moveToTrace( int firstTraceIndex, int numTracesToRead );
   virtual bool moveToNextTrace();
@@ -55,6 +66,16 @@ class csSeismicReader_ver {
    * @param traceIndex (i) Trace index at which header shall be peeked. Set to < 0 to peek header in current trace
    */
   virtual bool peek( int byteOffset, int byteSize, char* buffer, int traceIndex = -1 );
+  /**
+   * Peek same bytes in a contiguous block of traces, using large sequential reads.
+   * File pointer is restored to current trace afterwards.
+   * @param byteOffset      (i) Byte offset from start of trace
+   * @param byteSize        (i) Byte size to peek
+   * @param buffer          (o) Return buffer, byteSize*numTraces bytes: Bytes of first trace, followed by bytes of second trace...
+   * @param firstTraceIndex (i) Index of first trace in block
+   * @param numTraces       (i) Number of traces in block
+   */
+  virtual bool peekBlock( int byteOffset, int byteSize, char* buffer, int firstTraceIndex, int numTraces );
   /**
    *  Reset file pointer to start of current trace, from whereever it is at the moment
    */
@@ -108,10 +129,17 @@ protected:
   void resizeDataBuffer( int newSize );
   bool readDataBuffer();
   bool readSingleTrace( float* samples, char* hdrValueBlock, int numSamples );
+  void copyBufferedTrace( float* samples, char* hdrValueBlock, int numSamples );
   bool seekg_relative( csInt64_t bytePosRelative );
   void decompressBuffer( float* samples, int numSamples );
 
   char* myTempBuffer;
+  /// Buffer used by peekBlock()
+  char* myPeekBlockBuffer;
+  /// Header buffer used by readTraces() when header values are not requested
+  char* myHdrScratchBuffer;
+  /// Sample buffer used by readTraces() when samples are not requested
+  float* mySampleScratchBuffer;
   int myByteLoc;
   bool myIsReadFileHeader;
   /// File size in bytes
@@ -6,6 +6,8 @@
 #include "geolib/csGeolibUtils.h"
 #include "geolib/csHeaderInfo.h"
 #include "csIODefines.h"
+#include "geolib/csThread.h"
+#include "geolib/csTimeline.h"
 #include <cstring>
 #include <limits>
 #include <cmath>
@@ -13,6 +15,20 @@
 using namespace cseis_io;
 using namespace std;
 
+namespace cseis_io {
+  /**
+   * Writer thread for asynchronous mode
+   */
+  class csSeismicWriterThread : public cseis_geolib::csThread {
+  public:
+    csSeismicWriterThread( csSeismicWriter_ver* writer ) : myWriter(writer) {}
+  protected:
+    void run() { myWriter->runAsyncWriter(); }
+  private:
+    csSeismicWriter_ver* myWriter;
+  };
+}
+
 csSeismicWriter_ver::csSeismicWriter_ver( std::string filename, int numTracesBuffer, int sampleByteSize, bool overwrite ) {
   cseis_io::csIODefines::createVersionString( VERSION_SEISMIC_WRITER, myVersionText );
 
@@ -35,6 +51,20 @@ csSeismicWriter_ver::csSeismicWriter_ver( std::string filename, int numTracesBuf
   myCurrentDataBufferSize = 0;
   myNumBufferTraces  = numTracesBuffer;
 
+  myNumAsyncBuffers  = 0;
+  myIsAsync          = false;
+  myAsyncBuffers     = NULL;
+  myAsyncBufferNumTraces  = NULL;
+  myAsyncByteSizeRawTrace = 0;
+  myAsyncFillIndex   = 0;
+  myAsyncWriteIndex  = 0;
+  myAsyncNumQueued   = 0;
+  myAsyncStop        = false;
+  myAsyncError       = false;
+  myAsyncMutex       = NULL;
+  myAsyncCond        = NULL;
+  myAsyncThread      = NULL;
+
   open( overwrite );
 }
 //----------------------------------------------------------------
@@ -52,6 +82,21 @@ csSeismicWriter_ver::~csSeismicWriter_ver() {
     delete [] myCompressedSampleBuffer;
     myCompressedSampleBuffer = NULL;
   }
+  if( myAsyncBuffers != NULL ) {
+    for( int ibuf = 0; ibuf < myNumAsyncBuffers; ibuf++ ) {
+      delete [] myAsyncBuffers[ibuf];
+    }
+    delete [] myAsyncBuffers;
+    delete [] myAsyncBufferNumTraces;
+    myAsyncBuffers = NULL;
+    myAsyncBufferNumTraces = NULL;
+  }
+  if( myAsyncMutex != NULL ) {
+    delete myAsyncMutex;
+    delete myAsyncCond;
+    myAsyncMutex = NULL;
+    myAsyncCond  = NULL;
+  }
 }
 //----------------------------------------------------------------
 void csSeismicWriter_ver::open( bool overwrite ) {
@@ -79,17 +124,121 @@ void csSeismicWriter_ver::open( bool overwrite ) {
   }
 }
 //----------------------------------------------------------------
-void csSeismicWriter_ver::close() {
+bool csSeismicWriter_ver::close() {
+  bool success = true;
   if( myFile != NULL ) {
-    if( myCurrentDataBufferSize != 0 ) {
+    if( myIsAsync ) {
+      // Hand over partially filled buffer, then let writer thread drain all buffers and finish
+      if( myAsyncBufferNumTraces[myAsyncFillIndex] != 0 ) {
+        submitAsyncBuffer();
+      }
+      myAsyncMutex->lock();
+      myAsyncStop = true;
+      myAsyncCond->broadcast();
+      myAsyncMutex->unlock();
+      myAsyncThread->join();
+      delete myAsyncThread;
+      myAsyncThread = NULL;
+      myIsAsync = false;
+      success = !myAsyncError;
+    }
+    else if( myCurrentDataBufferSize != 0 ) {
       // Some traces are still buffered and haven't been flushed yet --> Write them out now
-      writeCurrentDataBuffer();
+      success = writeCurrentDataBuffer();
     }
-    fclose( myFile );
+    if( fclose( myFile ) != 0 ) success = false;
     myFile = NULL;
   }
+  return success;
+}
+//----------------------------------------------------------------
+void csSeismicWriter_ver::setAsyncMode( int numBuffers ) {
+  if( myIsAsync || numBuffers < 2 ) return;
+  myNumAsyncBuffers = numBuffers;
+  if( myDataBufferSize > 0 ) {
+    // File header has already been written
+    startAsync();
+  }
+}
+void csSeismicWriter_ver::startAsync() {
+  if( myFile == NULL ) return;
+  if( myCurrentDataBufferSize != 0 ) {
+    writeCurrentDataBuffer();
+  }
+  myAsyncByteSizeRawTrace = myByteSizeHdrValueBlock + myNumSamples*(int)sizeof(float);
+  myAsyncBuffers = new char*[myNumAsyncBuffers];
+  myAsyncBufferNumTraces = new int[myNumAsyncBuffers];
+  for( int ibuf = 0; ibuf < myNumAsyncBuffers; ibuf++ ) {
+    myAsyncBuffers[ibuf] = new char[myNumBufferTraces * myAsyncByteSizeRawTrace];
+    myAsyncBufferNumTraces[ibuf] = 0;
+  }
+  myAsyncFillIndex  = 0;
+  myAsyncWriteIndex = 0;
+  myAsyncNumQueued  = 0;
+  myAsyncStop       = false;
+  myAsyncError      = false;
+  myAsyncMutex  = new cseis_geolib::csMutex();
+  myAsyncCond   = new cseis_geolib::csCondition();
+  myAsyncThread = new csSeismicWriterThread( this );
+  myIsAsync = myAsyncThread->start();
+  if( !myIsAsync ) {
+    // Thread could not be created: Continue in synchronous mode
+    delete myAsyncThread;
+    myAsyncThread = NULL;
+  }
+}
+//----------------------------------------------------------------
+// Hand over current buffer to writer thread, and wait until the next buffer is free
+bool csSeismicWriter_ver::submitAsyncBuffer() {
+  cseis_geolib::csMutexLock lock( myAsyncMutex );
+  myAsyncNumQueued += 1;
+  myAsyncCond->broadcast();
+  while( myAsyncNumQueued == myNumAsyncBuffers && !myAsyncError ) {
+    myAsyncCond->wait( myAsyncMutex );
+  }
+  myAsyncFillIndex = (myAsyncFillIndex + 1) % myNumAsyncBuffers;
+  return !myAsyncError;
+}
+//----------------------------------------------------------------
+// Writer thread: Compress and write queued buffers in order
+void csSeismicWriter_ver::runAsyncWriter() {
+  int byteSizeTrace = myByteSizeHdrValueBlock + myByteSizeSamples + myByteSizeCompression;
+  while( true ) {
+    myAsyncMutex->lock();
+    while( myAsyncNumQueued == 0 && !myAsyncStop ) {
+      myAsyncCond->wait( myAsyncMutex );
+    }
+    if( myAsyncNumQueued == 0 ) {
+      myAsyncMutex->unlock();
+      break;
+    }
+    int bufferIndex = myAsyncWriteIndex;
+    bool isError = myAsyncError;
+    myAsyncMutex->unlock();
+
+    int numTraces = myAsyncBufferNumTraces[bufferIndex];
+    if( !isError ) {
+      char const* bufferIn = myAsyncBuffers[bufferIndex];
+      for( int itrc = 0; itrc < numTraces; itrc++ ) {
+        char const* traceIn = &bufferIn[itrc*myAsyncByteSizeRawTrace];
+        encodeTrace( reinterpret_cast<float const*>( &traceIn[myByteSizeHdrValueBlock] ), traceIn, &myDataBuffer[itrc*byteSizeTrace] );
+      }
+      myCurrentDataBufferSize = numTraces * byteSizeTrace;
+      isError = !writeCurrentDataBuffer();
+    }
+
+    myAsyncMutex->lock();
+    myAsyncBufferNumTraces[bufferIndex] = 0;
+    myAsyncWriteIndex = (bufferIndex + 1) % myNumAsyncBuffers;
+    myAsyncNumQueued -= 1;
+    if( isError ) __atomic_store_n( &myAsyncError, true, __ATOMIC_RELAXED );
+    myAsyncCond->broadcast();
+    myAsyncMutex->unlock();
+  }
 }
 bool csSeismicWriter_ver::writeCurrentDataBuffer() {
+  cseis_geolib::csTimeline::Event event( "write buffer", "io" );
+  event.setArg( myCurrentDataBufferSize );
   int sizeWrite = (int)fwrite( myDataBuffer, myCurrentDataBufferSize, 1, myFile );
   bool retValue = (sizeWrite == 1);
   myCurrentDataBufferSize = 0;
@@ -130,6 +279,9 @@ bool csSeismicWriter_ver::writeFileHeader( csSeismicIOConfig const* config ) {
   }
 
   resizeDataBuffer( myNumBufferTraces * (myByteSizeSamples + myByteSizeHdrValueBlock + myByteSizeCompression) );
+  if( myNumAsyncBuffers > 1 ) {
+    startAsync();
+  }
 
 // Set super header
   appendInt(    config->numSamples );
@@ -253,30 +405,49 @@ void csSeismicWriter_ver::appendString( char const* value, int size ) {
 }
 //----------------------------------------------------------------
 bool csSeismicWriter_ver::writeTrace( float* samples, char const* hdrValueBlock ) {
-  if( myFile != NULL ) {
-    memcpy( &(myDataBuffer[myCurrentDataBufferSize]), hdrValueBlock, myByteSizeHdrValueBlock );
-    myCurrentDataBufferSize += myByteSizeHdrValueBlock;
-
-    if( myByteSizeOneSample == 4 ) {
-      memcpy( &(myDataBuffer[myCurrentDataBufferSize]), samples, myByteSizeSamples );
+  if( myFile == NULL ) {
+    return false;
+  }
+  if( myIsAsync ) {
+    // Report error of writer thread without waiting for the current buffer to fill up
+    if( __atomic_load_n( &myAsyncError, __ATOMIC_RELAXED ) ) {
+      return false;
     }
-    else {
-      float minValue;
-      float rangeValue;
-      compressData( samples, myCompressedSampleBuffer, minValue, rangeValue );
-      memcpy( &(myDataBuffer[myCurrentDataBufferSize]), &minValue, sizeof(float) );
-      memcpy( &(myDataBuffer[myCurrentDataBufferSize+sizeof(float)]), &rangeValue, sizeof(float) );
-      memcpy( &(myDataBuffer[myCurrentDataBufferSize+myByteSizeCompression]), myCompressedSampleBuffer, myByteSizeSamples );
-    }
-    myCurrentDataBufferSize += myByteSizeSamples + myByteSizeCompression;
-
-    if( myCurrentDataBufferSize == myDataBufferSize ) {
-      return writeCurrentDataBuffer();
+    int numTraces = myAsyncBufferNumTraces[myAsyncFillIndex];
+    char* traceOut = &(myAsyncBuffers[myAsyncFillIndex][numTraces*myAsyncByteSizeRawTrace]);
+    memcpy( traceOut, hdrValueBlock, myByteSizeHdrValueBlock );
+    memcpy( &traceOut[myByteSizeHdrValueBlock], samples, myNumSamples*sizeof(float) );
+    myAsyncBufferNumTraces[myAsyncFillIndex] = numTraces + 1;
+    if( numTraces + 1 == myNumBufferTraces ) {
+      return submitAsyncBuffer();
     }
     return true;
   }
+
+  encodeTrace( samples, hdrValueBlock, &(myDataBuffer[myCurrentDataBufferSize]) );
+  myCurrentDataBufferSize += myByteSizeHdrValueBlock + myByteSizeSamples + myByteSizeCompression;
+
+  if( myCurrentDataBufferSize == myDataBufferSize ) {
+    return writeCurrentDataBuffer();
+  }
+  return true;
+}
+//----------------------------------------------------------------
+// Convert one trace to output format: Trace header values, followed by (compressed) samples
+void csSeismicWriter_ver::encodeTrace( float const* samples, char const* hdrValueBlock, char* bufferOut ) {
+  memcpy( bufferOut, hdrValueBlock, myByteSizeHdrValueBlock );
+  bufferOut += myByteSizeHdrValueBlock;
+
+  if( myByteSizeOneSample == 4 ) {
+    memcpy( bufferOut, samples, myByteSizeSamples );
+  }
   else {
-    return false;
+    float minValue;
+    float rangeValue;
+    compressData( samples, myCompressedSampleBuffer, minValue, rangeValue );
+    memcpy( bufferOut, &minValue, sizeof(float) );
+    memcpy( &bufferOut[sizeof(float)], &rangeValue, sizeof(float) );
+    memcpy( &bufferOut[myByteSizeCompression], myCompressedSampleBuffer, myByteSizeSamples );
   }
 }
 
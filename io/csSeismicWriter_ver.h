@@ -11,6 +11,9 @@
 
 namespace cseis_geolib {
   class csHeaderInfo;
+  class csMutex;
+  class csCondition;
+  class csThread;
 }
 
 namespace cseis_io {
@@ -32,9 +35,22 @@ class csSeismicWriter_ver {
   csSeismicWriter_ver( std::string filename );
   csSeismicWriter_ver( std::string filename, int numTracesBuffer, int sampleByteSize = 4, bool overwrite = true );
   ~csSeismicWriter_ver();
+  /**
+   * Enable asynchronous write mode.
+   * Traces are collected in numBuffers rotating buffers. Full buffers are compressed and written to disk by a
+   * dedicated writer thread, while the calling thread continues. writeTrace() blocks only if all buffers are in use.
+   * Write errors are reported by every call to writeTrace() once the writer thread has failed, and by close().
+   * May be called before or after writeFileHeader(). Traces buffered so far are flushed first.
+   * @param numBuffers  Number of rotating data buffers, at least 2. Pass 0 or 1 to keep synchronous mode.
+   */
+  void setAsyncMode( int numBuffers );
   bool writeFileHeader( csSeismicIOConfig const* config );
   bool writeTrace( float* samples, char const* hdrValueBlock );
-  void close();
+  /**
+   * Flush all buffered traces and close file
+   * @return false if an error occurred when writing traces in asynchronous mode
+   */
+  bool close();
 public:
   short myVersionMinor;
   short myVersionMajor;
@@ -52,7 +68,12 @@ public:
   int myByteSizeCompression;
 
 private:
+  friend class csSeismicWriterThread;
   void open( bool overwrite );
+  void encodeTrace( float const* samples, char const* hdrValueBlock, char* bufferOut );
+  void startAsync();
+  bool submitAsyncBuffer();
+  void runAsyncWriter();
   void initialize();
   bool writeCurrentDataBuffer();
   void resizeDataBuffer( int newSize );
@@ -75,6 +96,25 @@ private:
   int   myNumBufferTraces;
   int   myByteSizeOneSample;
   char* myCompressedSampleBuffer;
+
+  /// Number of rotating data buffers in asynchronous mode. Synchronous mode if < 2
+  int   myNumAsyncBuffers;
+  bool  myIsAsync;
+  /// Data buffers holding uncompressed traces, filled by calling thread
+  char** myAsyncBuffers;
+  int*  myAsyncBufferNumTraces;
+  int   myAsyncByteSizeRawTrace;
+  /// Index of buffer currently filled by calling thread
+  int   myAsyncFillIndex;
+  /// Index of next buffer to be written by writer thread
+  int   myAsyncWriteIndex;
+  /// Number of buffers handed over to writer thread
+  int   myAsyncNumQueued;
+  bool  myAsyncStop;
+  bool  myAsyncError;
+  cseis_geolib::csMutex*     myAsyncMutex;
+  cseis_geolib::csCondition* myAsyncCond;
+  cseis_geolib::csThread*    myAsyncThread;
 };
 
 } // end namespace
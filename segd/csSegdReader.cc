@@ -740,8 +740,7 @@ bool csSegdReader::getNextTrace( float* trace, commonTraceHeaderStruct& comTrcHd
   if( comTrcHdr.chanTypeID == 1 || myConfig.readAuxTraces ) {  // Only read in if this is a seismic trace, or if aux traces shall be read in as well
     switch( myComFileHdr.formatCode ) {
     case 8058:
-      cseis_geolib::swapEndian4( reinterpret_cast<char*>(&myBuffer_oneRecord[bytePosData]), dataByteSize );
-      memcpy( trace, &myBuffer_oneRecord[bytePosData], dataByteSize );
+      cseis_geolib::swapEndian4( reinterpret_cast<char const*>(&myBuffer_oneRecord[bytePosData]), reinterpret_cast<char*>(trace), dataByteSize );
       break;
     case 8015:
       convertToFloat_20bit( reinterpret_cast<short*>(&myBuffer_oneRecord[bytePosData]), trace, comTrcHdr.numSamples); // Ernad:  numSamples );
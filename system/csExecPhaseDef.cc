@@ -20,6 +20,7 @@ csExecPhaseDef::csExecPhaseDef( std::string& moduleName ) {
   myIsDebug    = false;
   myTracesAreWaiting = false;
   myIsLastCall  = false;
+  myIsThreadSafe = false;
 }
 csExecPhaseDef::~csExecPhaseDef() {
 }
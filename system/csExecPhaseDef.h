@@ -116,6 +116,20 @@ public:
    * @return true if this is the last call to the module's exec phase
    */
   bool isLastCall() const;
+  /**
+   * Declare the exec phase thread-safe.
+   * Single-trace modules: Call this method in the module's init phase if the exec phase does not modify any state that is
+   * shared between traces, such as the fields stored in setVariables(), and does not rely on isLastCall().
+   * Ensemble modules: Call this method if every ensemble is processed independently of all other ensembles, and
+   * the init phase does not create resources that are shared between module instances (e.g. output files).
+   * The base system may then run the exec phase for several traces or ensembles at once, in separate threads.
+   * Ensemble modules run in separate module instances, each created by its own call to the init phase.
+   */
+  void setThreadSafe( bool isThreadSafe = true ) { myIsThreadSafe = isThreadSafe; }
+  /**
+   * @return true if module has declared its exec phase thread-safe
+   */
+  inline bool isThreadSafe() const { return myIsThreadSafe; }
 
   /// class csModule needs access to the private fields of this class
   friend class csModule;
@@ -140,6 +154,8 @@ private:
   bool myTracesAreWaiting;
   /// true if this is the last call from the base system to this module's exec phase (different from cleanup phase)
   bool myIsLastCall;
+  /// true if exec phase may be run for several traces at once
+  bool myIsThreadSafe;
 };
 
 } // namespace
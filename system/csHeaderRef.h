@@ -0,0 +1,121 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_HEADER_REF_H
+#define CS_HEADER_REF_H
+
+#include <string>
+#include <cstring>
+#include "csTraceHeader.h"
+#include "csTraceHeaderData.h"
+#include "csTraceHeaderDef.h"
+#include "geolib/csException.h"
+#include "geolib/geolib_defines.h"
+
+namespace cseis_system {
+
+/// Header type of C++ type T. Only defined for the number types that trace headers can have
+template<typename T> struct csHeaderType;
+template<> struct csHeaderType<int>       { static cseis_geolib::type_t const TYPE = cseis_geolib::TYPE_INT; };
+template<> struct csHeaderType<csInt64_t> { static cseis_geolib::type_t const TYPE = cseis_geolib::TYPE_INT64; };
+template<> struct csHeaderType<float>     { static cseis_geolib::type_t const TYPE = cseis_geolib::TYPE_FLOAT; };
+template<> struct csHeaderType<double>    { static cseis_geolib::type_t const TYPE = cseis_geolib::TYPE_DOUBLE; };
+
+/**
+ * Typed handle to one trace header
+ *
+ * Resolved once in the module's init phase, from the module's trace header definition. The handle keeps the byte location
+ * of the header value, so that reading or writing the value in the exec phase is a single memory access, without the
+ * index check and type switch of csTraceHeader::intValue(), setIntValue() etc.
+ *
+ * The header must have exactly type T: A csHeaderRef<int> can only be resolved for an int header. Use the csTraceHeader
+ * accessors for headers that need type conversion.
+ * When compiled with CS_DEBUG, every access checks that the handle has been resolved and matches the trace header.
+ *
+ * Example:
+ *  Init phase:  vars->hdrRef.resolve( env->headerDef, "trc_type" );
+ *  Exec phase:  int value = vars->hdrRef.get( trace->getTraceHeader() );
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+template<typename T> class csHeaderRef {
+public:
+  csHeaderRef() : myIndex(-1), myByteLocation(-1) {}
+  csHeaderRef( csTraceHeaderDef const* hdef, std::string const& name ) : myIndex(-1), myByteLocation(-1) {
+    resolve( hdef, name );
+  }
+  /**
+   * Resolve handle for given header. Throws csException if the header does not exist or does not have type T
+   * @param hdef  Trace header definition of module
+   * @param name  Header name
+   */
+  void resolve( csTraceHeaderDef const* hdef, std::string const& name ) {
+    if( !hdef->headerExists( name ) ) {
+      throw( cseis_geolib::csException("csHeaderRef: Trace header '%s' does not exist", name.c_str()) );
+    }
+    resolve( hdef, hdef->headerIndex( name ) );
+  }
+  /**
+   * Resolve handle for header at given index, as returned by csTraceHeaderDef::addHeader() or headerIndex()
+   */
+  void resolve( csTraceHeaderDef const* hdef, int index ) {
+    if( index < 0 || index >= hdef->numHeaders() ) {
+      throw( cseis_geolib::csException("csHeaderRef: Wrong trace header index %d", index) );
+    }
+    if( hdef->headerType( index ) != csHeaderType<T>::TYPE ) {
+      throw( cseis_geolib::csException("csHeaderRef: Trace header '%s' does not have the type of the header handle", hdef->headerName( index ).c_str()) );
+    }
+    myIndex        = index;
+    myByteLocation = hdef->computeByteLocation( index );
+  }
+  inline bool isResolved() const { return( myIndex >= 0 ); }
+  /// @return Header index
+  inline int index() const { return myIndex; }
+
+  inline T get( csTraceHeader const* hdr ) const {
+#ifdef CS_DEBUG
+    check( hdr );
+#endif
+#ifndef ARCHITECTURE_ITANIUM
+    return *(reinterpret_cast<T const*>( &hdr->myTraceHeaderData->myValueBlock[myByteLocation] ));
+#else
+    T value;
+    memcpy( &value, &hdr->myTraceHeaderData->myValueBlock[myByteLocation], sizeof(T) );
+    return value;
+#endif
+  }
+  inline void set( csTraceHeader* hdr, T value ) const {
+#ifdef CS_DEBUG
+    check( hdr );
+#endif
+    hdr->myTraceHeaderData->detach();
+#ifndef ARCHITECTURE_ITANIUM
+    *(reinterpret_cast<T*>( &hdr->myTraceHeaderData->myValueBlock[myByteLocation] )) = value;
+#else
+    memcpy( &hdr->myTraceHeaderData->myValueBlock[myByteLocation], &value, sizeof(T) );
+#endif
+  }
+
+private:
+#ifdef CS_DEBUG
+  void check( csTraceHeader const* hdr ) const {
+    if( myIndex < 0 ) {
+      throw( cseis_geolib::csException("csHeaderRef: Program bug. Header handle has not been resolved.") );
+    }
+    if( myIndex >= hdr->numHeaders() || hdr->type( myIndex ) != csHeaderType<T>::TYPE ||
+        hdr->myTraceHeaderData->myByteLocationPtr[myIndex] != myByteLocation ) {
+      throw( cseis_geolib::csException("csHeaderRef: Program bug. Header handle does not match trace header. Was it resolved from a different module's header definition?") );
+    }
+  }
+#endif
+  int myIndex;
+  /// Byte location of header value in trace header value block
+  int myByteLocation;
+};
+
+} // namespace
+
+#endif
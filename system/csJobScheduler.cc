@@ -0,0 +1,260 @@
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include "csJobScheduler.h"
+#include "csModuleProfile.h"
+#include "geolib/csException.h"
+#include "geolib/geolib_platform_dependent.h"
+
+#ifndef PLATFORM_WINDOWS
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+
+using namespace cseis_system;
+
+csJobScheduler::csJobScheduler( int numCPUs, int numMegabytes, int maxNumRetries ) {
+  myNumCPUs          = numCPUs > 0 ? numCPUs : 1;
+  myNumMegabytes     = numMegabytes > 0 ? numMegabytes : 0;
+  myMaxNumRetries    = maxNumRetries > 0 ? maxNumRetries : 0;
+  myNumCPUsUsed      = 0;
+  myNumMegabytesUsed = 0;
+  myNumRunningJobs   = 0;
+  myTimeWall         = 0.0;
+}
+csJobScheduler::~csJobScheduler() {
+  for( int i = 0; i < myJobs.size(); i++ ) {
+    delete myJobs.at(i);
+  }
+  myJobs.clear();
+}
+void csJobScheduler::addJob( std::string const& name, cseis_geolib::csVector<std::string> const& args, std::string const& logFilename,
+                             int numCPUs, int numMegabytes )
+{
+  Job* job = new Job();
+  job->name         = name;
+  job->logFilename  = logFilename;
+  job->numCPUs      = numCPUs > 0 ? numCPUs : 1;
+  job->numMegabytes = numMegabytes > 0 ? numMegabytes : 0;
+  job->status       = STATUS_WAITING;
+  job->numAttempts  = 0;
+  job->processID    = -1;
+  job->exitCode     = 0;
+  job->startTime    = 0.0;
+  job->timeWall     = 0.0;
+  job->numTraces    = -1;
+  for( int i = 0; i < args.size(); i++ ) {
+    job->args.insertEnd( args.at(i) );
+  }
+  myJobs.insertEnd( job );
+}
+//--------------------------------------------------------------------
+bool csJobScheduler::fitsIntoBudget( Job const* job ) const {
+  // Always run at least one job, even if it exceeds the budget on its own
+  if( myNumRunningJobs == 0 ) return true;
+  if( myNumCPUsUsed + job->numCPUs > myNumCPUs ) return false;
+  if( myNumMegabytes > 0 && myNumMegabytesUsed + job->numMegabytes > myNumMegabytes ) return false;
+  return true;
+}
+std::string csJobScheduler::outputFilename( Job const* job ) const {
+  return( job->logFilename + ".out" );
+}
+//--------------------------------------------------------------------
+int csJobScheduler::run( FILE* fout ) {
+#ifdef PLATFORM_WINDOWS
+  throw( cseis_geolib::csException("csJobScheduler::run: Running jobs concurrently is not supported on this platform") );
+#else
+  double timeStart = csModuleProfile::wallTime();
+  int numJobsLeft = myJobs.size();
+  while( numJobsLeft > 0 ) {
+    // Start waiting jobs in order, as long as they fit into the budget. Later jobs may not overtake a job that does not fit.
+    for( int i = 0; i < myJobs.size(); i++ ) {
+      Job* job = myJobs.at(i);
+      if( job->status != STATUS_WAITING ) continue;
+      if( !fitsIntoBudget( job ) ) break;
+      if( !startJob( job ) ) {
+        fprintf( fout, "Job %s: Could not start process: %s\n", job->name.c_str(), strerror(errno) );
+        job->status = STATUS_FAILED;
+        numJobsLeft -= 1;
+        continue;
+      }
+      fprintf( fout, "Job %s: Started (attempt %d, %d CPUs, %d MB)\n", job->name.c_str(), job->numAttempts, job->numCPUs, job->numMegabytes );
+    }
+    if( myNumRunningJobs == 0 ) break;
+
+    Job* job = waitForJob();
+    if( job->exitCode == 0 ) {
+      job->status    = STATUS_DONE;
+      job->numTraces = readNumTraces( job->logFilename );
+      numJobsLeft -= 1;
+      // Remove output file if job did not write anything to it
+      struct stat fileStat;
+      std::string filename = outputFilename( job );
+      if( stat( filename.c_str(), &fileStat ) == 0 && fileStat.st_size == 0 ) {
+        remove( filename.c_str() );
+      }
+      fprintf( fout, "Job %s: Finished successfully (%.1fs)\n", job->name.c_str(), job->timeWall );
+    }
+    else {
+      if( job->exitCode < 0 ) {
+        fprintf( fout, "Job %s: Killed by signal %d (%.1fs)", job->name.c_str(), -job->exitCode, job->timeWall );
+      }
+      else {
+        fprintf( fout, "Job %s: Failed with exit code %d (%.1fs)", job->name.c_str(), job->exitCode, job->timeWall );
+      }
+      if( job->numAttempts <= myMaxNumRetries ) {
+        job->status = STATUS_WAITING;
+        fprintf( fout, ". Job will be run again.\n" );
+      }
+      else {
+        job->status = STATUS_FAILED;
+        numJobsLeft -= 1;
+        fprintf( fout, ". See job log %s and output %s\n", job->logFilename.c_str(), outputFilename( job ).c_str() );
+      }
+    }
+  }
+  myTimeWall = csModuleProfile::wallTime() - timeStart;
+
+  int numFailed = 0;
+  for( int i = 0; i < myJobs.size(); i++ ) {
+    if( myJobs.at(i)->status != STATUS_DONE ) numFailed += 1;
+  }
+  return numFailed;
+#endif
+}
+//--------------------------------------------------------------------
+bool csJobScheduler::startJob( Job* job ) {
+#ifdef PLATFORM_WINDOWS
+  return false;
+#else
+  int numArgs = job->args.size();
+  char** argv = new char*[numArgs+1];
+  for( int i = 0; i < numArgs; i++ ) {
+    argv[i] = const_cast<char*>( job->args.at(i).c_str() );
+  }
+  argv[numArgs] = NULL;
+  std::string filename = outputFilename( job );
+  fflush( NULL );
+
+  pid_t pid = fork();
+  if( pid == 0 ) {
+    // Child process: Redirect standard output and error to job output file, then run job
+    int fd = open( filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+    if( fd >= 0 ) {
+      dup2( fd, STDOUT_FILENO );
+      dup2( fd, STDERR_FILENO );
+      close( fd );
+    }
+    execvp( argv[0], argv );
+    fprintf( stderr, "Could not run '%s': %s\n", argv[0], strerror(errno) );
+    _exit( 127 );
+  }
+  delete [] argv;
+  if( pid < 0 ) return false;
+
+  job->processID    = (int)pid;
+  job->status       = STATUS_RUNNING;
+  job->numAttempts += 1;
+  job->startTime    = csModuleProfile::wallTime();
+  myNumRunningJobs   += 1;
+  myNumCPUsUsed      += job->numCPUs;
+  myNumMegabytesUsed += job->numMegabytes;
+  return true;
+#endif
+}
+//--------------------------------------------------------------------
+csJobScheduler::Job* csJobScheduler::waitForJob() {
+#ifdef PLATFORM_WINDOWS
+  return NULL;
+#else
+  while( true ) {
+    int status = 0;
+    pid_t pid = waitpid( -1, &status, 0 );
+    if( pid < 0 ) {
+      if( errno == EINTR ) continue;
+      throw( cseis_geolib::csException("csJobScheduler: Error when waiting for jobs: %s", strerror(errno)) );
+    }
+    for( int i = 0; i < myJobs.size(); i++ ) {
+      Job* job = myJobs.at(i);
+      if( job->status != STATUS_RUNNING || job->processID != (int)pid ) continue;
+      if( WIFEXITED(status) ) {
+        job->exitCode = WEXITSTATUS(status);
+      }
+      else if( WIFSIGNALED(status) ) {
+        job->exitCode = -WTERMSIG(status);
+      }
+      else {
+        continue;  // Stopped or continued, job is still running
+      }
+      job->timeWall   = csModuleProfile::wallTime() - job->startTime;
+      job->processID  = -1;
+      myNumRunningJobs   -= 1;
+      myNumCPUsUsed      -= job->numCPUs;
+      myNumMegabytesUsed -= job->numMegabytes;
+      return job;
+    }
+  }
+#endif
+}
+//--------------------------------------------------------------------
+// Read number of traces output by the first module from exec phase summary in job log
+//
+csInt64_t csJobScheduler::readNumTraces( std::string const& logFilename ) {
+  FILE* fin = fopen( logFilename.c_str(), "r" );
+  if( fin == NULL ) return -1;
+  char buffer[1024];
+  csInt64_t numTraces = -1;
+  bool isSummary = false;
+  while( fgets( buffer, 1024, fin ) != NULL ) {
+    if( !isSummary ) {
+      isSummary = ( strstr( buffer, "Exec phase summary" ) != NULL );
+      continue;
+    }
+    int moduleIndex;
+    char moduleName[256];
+    long long numTracesIn;
+    long long numTracesOut;
+    if( sscanf( buffer, "%d %255s %lld %lld", &moduleIndex, moduleName, &numTracesIn, &numTracesOut ) == 4 && moduleIndex == 1 ) {
+      numTraces = (csInt64_t)numTracesOut;
+      break;
+    }
+  }
+  fclose( fin );
+  return numTraces;
+}
+//--------------------------------------------------------------------
+void csJobScheduler::dumpSummary( FILE* fout ) const {
+  int numDone = 0;
+  csInt64_t numTracesAll = 0;
+  double timeWallAll = 0.0;
+  fprintf( fout, "\nJob summary\n\n" );
+  fprintf( fout, "  #  %-40s %-8s %8s %12s %12s %12s  %s\n", "Job", "Status", "Attempts", "Wall time[s]", "Traces", "Traces/s", "Log" );
+  for( int i = 0; i < myJobs.size(); i++ ) {
+    Job const* job = myJobs.at(i);
+    char const* status = ( job->status == STATUS_DONE ) ? "OK" : ( job->status == STATUS_FAILED ? "FAILED" : "NOT RUN" );
+    fprintf( fout, "%3d  %-40s %-8s %8d %12.1f", i+1, job->name.c_str(), status, job->numAttempts, job->timeWall );
+    if( job->numTraces >= 0 ) {
+      fprintf( fout, " %12lld %12.0f", (long long)job->numTraces, job->timeWall > 0.0 ? (double)job->numTraces / job->timeWall : 0.0 );
+      numTracesAll += job->numTraces;
+    }
+    else {
+      fprintf( fout, " %12s %12s", "-", "-" );
+    }
+    fprintf( fout, "  %s\n", job->logFilename.c_str() );
+    if( job->status == STATUS_DONE ) numDone += 1;
+    timeWallAll += job->timeWall;
+  }
+  fprintf( fout, "\n %d of %d jobs finished successfully. Total wall time: %.1fs (sum over jobs: %.1fs)",
+           numDone, myJobs.size(), myTimeWall, timeWallAll );
+  if( myTimeWall > 0.0 && numTracesAll > 0 ) {
+    fprintf( fout, ", throughput: %.0f traces/s", (double)numTracesAll / myTimeWall );
+  }
+  fprintf( fout, "\n\n" );
+}
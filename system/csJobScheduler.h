@@ -0,0 +1,102 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_JOB_SCHEDULER_H
+#define CS_JOB_SCHEDULER_H
+
+#include <cstdio>
+#include <string>
+#include "geolib/geolib_defines.h"
+#include "geolib/csVector.h"
+
+namespace cseis_system {
+
+/**
+ * Local job scheduler
+ *
+ * Runs a list of jobs concurrently, each job in its own process, within a global budget of CPUs and memory.
+ * Each job states the number of CPUs and megabytes it needs. A job is started as soon as enough CPUs and memory
+ * are free, in the order in which jobs were added. A job that does not fit into the budget at all is run on its own.
+ *
+ * A job that fails (non-zero exit code or killed by a signal) is run again, up to the given number of retries.
+ * The standard output and error of each job are redirected to a file next to its job log. This file is removed when the job succeeds
+ * and has not written anything.
+ *
+ * Used by cseis_submit to run the flows created from a master flow and spread sheet.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csJobScheduler {
+public:
+  /**
+   * @param numCPUs        Number of CPUs available to all jobs together
+   * @param numMegabytes   Memory available to all jobs together, in megabytes. 0: No memory limit
+   * @param maxNumRetries  Maximum number of times a failed job is run again
+   */
+  csJobScheduler( int numCPUs, int numMegabytes, int maxNumRetries );
+  ~csJobScheduler();
+  /**
+   * Add job
+   * @param name          Job name, shown in progress messages and summary
+   * @param args          Command line: Program executable followed by its arguments
+   * @param logFilename   Job log written by the job. Used to find the number of traces processed
+   * @param numCPUs       Number of CPUs used by job
+   * @param numMegabytes  Memory used by job, in megabytes
+   */
+  void addJob( std::string const& name, cseis_geolib::csVector<std::string> const& args, std::string const& logFilename,
+               int numCPUs, int numMegabytes );
+  /**
+   * Run all jobs, and wait until they have finished
+   * @param fout  Stream for progress messages
+   * @return Number of jobs that failed, after all retries
+   */
+  int run( FILE* fout );
+  /// Print table of job status, run time and throughput
+  void dumpSummary( FILE* fout ) const;
+  inline int numJobs() const { return myJobs.size(); }
+
+private:
+  static int const STATUS_WAITING  = 0;
+  static int const STATUS_RUNNING  = 1;
+  static int const STATUS_DONE     = 2;
+  static int const STATUS_FAILED   = 3;
+  struct Job {
+    std::string name;
+    cseis_geolib::csVector<std::string> args;
+    std::string logFilename;
+    int numCPUs;
+    int numMegabytes;
+    int status;
+    int numAttempts;
+    int processID;
+    /// Exit code of last attempt, or negative signal number if the job was killed
+    int exitCode;
+    double startTime;
+    double timeWall;
+    /// Number of traces output by the first module, read from the job log. -1 if not found
+    csInt64_t numTraces;
+  };
+  /// Start job in new process. @return false if process could not be created
+  bool startJob( Job* job );
+  /// Wait for any running job to finish. @return finished job
+  Job* waitForJob();
+  bool fitsIntoBudget( Job const* job ) const;
+  std::string outputFilename( Job const* job ) const;
+  static csInt64_t readNumTraces( std::string const& logFilename );
+
+  cseis_geolib::csVector<Job*> myJobs;
+  int myNumCPUs;
+  int myNumMegabytes;
+  int myMaxNumRetries;
+  int myNumCPUsUsed;
+  int myNumMegabytesUsed;
+  int myNumRunningJobs;
+  double myTimeWall;
+};
+
+} // namespace
+
+#endif
@@ -2,11 +2,132 @@
 
 #include "csLogWriter.h"
 #include "geolib/csException.h"
+#include "geolib/csThread.h"
+#include "geolib/csVector.h"
+#include "geolib/geolib_defines.h"
 #include <stdarg.h>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
 
 using namespace cseis_system;
 
+namespace {
+  /// Interval at which the background thread writes out buffered messages, in milliseconds
+  int const DRAIN_INTERVAL = 100;
+
+  /// Ring buffer of one thread. Written by the owning thread only, read by the thread draining the buffer
+  struct RingBuffer {
+    char* data;
+    /// Power of 2
+    int capacity;
+    /// Total number of bytes written to buffer
+    csInt64_t head;
+    /// Total number of bytes read from buffer
+    csInt64_t tail;
+    /// Position up to which the buffer is written out in the current drain. Protected by drain mutex
+    csInt64_t headDrain;
+    RingBuffer* next;
+    /// Set when the log writer leaves asynchronous mode. The thread entry referring to the buffer is then removed
+    int isClosed;
+    /// Number of references: Log writer and thread entry. The last one deletes the buffer
+    int refCount;
+  };
+  void releaseRing( RingBuffer* ring ) {
+    if( __atomic_sub_fetch( &ring->refCount, 1, __ATOMIC_ACQ_REL ) == 0 ) {
+      delete [] ring->data;
+      delete ring;
+    }
+  }
+  /// Header of each record in ring buffer. The sequence number gives the order of records across all threads
+  struct RecordHeader {
+    csInt64_t sequence;
+    int length;
+    int reserved;
+  };
+  void copyToRing( RingBuffer* ring, csInt64_t position, char const* src, int length ) {
+    int pos   = (int)( position & (csInt64_t)( ring->capacity-1 ) );
+    int first = ( length < ring->capacity - pos ) ? length : ring->capacity - pos;
+    memcpy( &ring->data[pos], src, first );
+    if( first < length ) memcpy( ring->data, &src[first], length-first );
+  }
+  void copyFromRing( RingBuffer const* ring, csInt64_t position, char* dest, int length ) {
+    int pos   = (int)( position & (csInt64_t)( ring->capacity-1 ) );
+    int first = ( length < ring->capacity - pos ) ? length : ring->capacity - pos;
+    memcpy( dest, &ring->data[pos], first );
+    if( first < length ) memcpy( &dest[first], ring->data, length-first );
+  }
+  /// Ring buffer of calling thread for one log writer
+  struct ThreadEntry {
+    csInt64_t writerID;
+    RingBuffer* buffer;
+    ThreadEntry* next;
+  };
+
+  pthread_key_t threadKey;
+  pthread_once_t threadKeyOnce = PTHREAD_ONCE_INIT;
+  void releaseThreadEntries( void* ptr ) {
+    ThreadEntry* entry = (ThreadEntry*)ptr;
+    while( entry != NULL ) {
+      ThreadEntry* next = entry->next;
+      releaseRing( entry->buffer );
+      delete entry;
+      entry = next;
+    }
+  }
+  void createThreadKey() {
+    pthread_key_create( &threadKey, releaseThreadEntries );
+  }
+
+  /// All writers in asynchronous mode, flushed at exit
+  cseis_geolib::csMutex writerListMutex;
+  cseis_geolib::csVector<csLogWriter*> asyncWriterList;
+  csInt64_t nextWriterID = 1;
+  pthread_once_t atExitOnce = PTHREAD_ONCE_INIT;
+}
+
+namespace cseis_system {
+struct csLogWriter::AsyncState {
+  /// Unique for each asynchronous session, never re-used
+  csInt64_t id;
+  /// Sequence number of next record, over all threads
+  csInt64_t nextSequence;
+  int bufferSize;
+  /// All ring buffers. Protected by drainMutex
+  RingBuffer* firstBuffer;
+  cseis_geolib::csMutex drainMutex;
+  cseis_geolib::csMutex wakeMutex;
+  cseis_geolib::csCondition wakeCondition;
+  int isStopped;
+  DrainThread* thread;
+};
+
+/**
+ * Background thread writing buffered messages to file
+ */
+class csLogWriter::DrainThread : public cseis_geolib::csThread {
+public:
+  DrainThread( csLogWriter* log ) : myLog( log ) {}
+protected:
+  virtual void run() {
+    AsyncState* async = myLog->myAsync;
+    while( true ) {
+      {
+        cseis_geolib::csMutexLock lock( &async->wakeMutex );
+        if( !async->isStopped ) async->wakeCondition.timedWait( &async->wakeMutex, DRAIN_INTERVAL );
+      }
+      bool isStopped = ( __atomic_load_n( &async->isStopped, __ATOMIC_ACQUIRE ) != 0 );
+      if( myLog->drain() ) fflush( myLog->myLogFile );
+      if( isStopped ) break;
+    }
+  }
+private:
+  csLogWriter* myLog;
+};
+} // namespace
+
 csLogWriter::csLogWriter( char const* filename ) : myFilename( filename ), myIsOpenedLocally(false) {
+  init();
   if( myFilename != NULL ) {
     myLogFile = fopen( myFilename, "w" );
     if( myLogFile == NULL ) {
@@ -16,90 +137,319 @@ csLogWriter::csLogWriter( char const* filename ) : myFilename( filename ), myIsO
   }
 }
 csLogWriter::csLogWriter( FILE* file ) : myFilename( "Unknown" ), myIsOpenedLocally( false ) {
+  init();
   myLogFile = file;
 }
 csLogWriter::csLogWriter() {
+  init();
   myFilename = NULL;
   myIsOpenedLocally = false;
   myLogFile = stdout;
 }
+void csLogWriter::init() {
+  myLogFile = NULL;
+  myLevel   = LEVEL_INFO;
+  myAsync   = NULL;
+}
 //-----------------------------------------
 csLogWriter::~csLogWriter() {
+  setAsynchronous( false );
   if( myIsOpenedLocally && myLogFile ) {
     fclose( myLogFile );
     myLogFile = NULL;
   }
 }
 //-----------------------------------------
+bool csLogWriter::setAsynchronous( bool doAsync, int bufferSize ) {
+  if( myAsync != NULL ) {
+    // Stop background thread, write out remaining messages
+    {
+      cseis_geolib::csMutexLock lock( &myAsync->wakeMutex );
+      __atomic_store_n( &myAsync->isStopped, 1, __ATOMIC_RELEASE );
+      myAsync->wakeCondition.signal();
+    }
+    myAsync->thread->join();
+    delete myAsync->thread;
+    drain();
+    if( myLogFile ) fflush( myLogFile );
+    {
+      cseis_geolib::csMutexLock lock( &writerListMutex );
+      for( int i = 0; i < asyncWriterList.size(); i++ ) {
+        if( asyncWriterList.at(i) == this ) {
+          asyncWriterList.remove(i);
+          break;
+        }
+      }
+    }
+    // Threads remove their entries of closed ring buffers the next time they log, or when they exit
+    RingBuffer* buffer = myAsync->firstBuffer;
+    while( buffer != NULL ) {
+      RingBuffer* next = buffer->next;
+      delete [] buffer->data;
+      buffer->data = NULL;
+      __atomic_store_n( &buffer->isClosed, 1, __ATOMIC_RELEASE );
+      releaseRing( buffer );
+      buffer = next;
+    }
+    delete myAsync;
+    myAsync = NULL;
+  }
+  if( !doAsync || myLogFile == NULL ) return true;
+
+  if( myLogFile ) fflush( myLogFile );
+  int capacity = 1024;
+  while( capacity < bufferSize ) capacity *= 2;
+  AsyncState* async = new AsyncState();
+  async->bufferSize  = capacity;
+  async->firstBuffer = NULL;
+  async->isStopped   = 0;
+  async->nextSequence = 0;
+  {
+    cseis_geolib::csMutexLock lock( &writerListMutex );
+    async->id = nextWriterID++;
+  }
+  myAsync = async;
+  async->thread = new DrainThread( this );
+  if( !async->thread->start() ) {
+    delete async->thread;
+    delete async;
+    myAsync = NULL;
+    return false;
+  }
+  pthread_once( &atExitOnce, registerAtExit );
+  cseis_geolib::csMutexLock lock( &writerListMutex );
+  asyncWriterList.insertEnd( this );
+  return true;
+}
+void csLogWriter::registerAtExit() {
+  atexit( csLogWriter::flushAtExit );
+}
+void csLogWriter::flushAtExit() {
+  cseis_geolib::csMutexLock lock( &writerListMutex );
+  for( int i = 0; i < asyncWriterList.size(); i++ ) {
+    asyncWriterList.at(i)->flush();
+  }
+}
+//-----------------------------------------
+void csLogWriter::output( char const* prefix, char const* text, va_list argList, char const* suffix ) {
+  if( myAsync == NULL ) {
+    if( prefix != NULL ) fputs( prefix, myLogFile );
+    vfprintf( myLogFile, text, argList );
+    if( suffix != NULL ) fputs( suffix, myLogFile );
+    return;
+  }
+  // Format complete message into one record
+  char buffer[1024];
+  int lengthPrefix = ( prefix != NULL ) ? (int)strlen( prefix ) : 0;
+  int lengthSuffix = ( suffix != NULL ) ? (int)strlen( suffix ) : 0;
+  char* record = buffer;
+  int sizeText = (int)sizeof(buffer) - lengthPrefix - lengthSuffix;
+  va_list argCopy;
+  va_copy( argCopy, argList );
+  int lengthText = vsnprintf( sizeText > 0 ? &buffer[lengthPrefix] : NULL, sizeText > 0 ? sizeText : 0, text, argCopy );
+  va_end( argCopy );
+  if( lengthText < 0 ) return;
+  if( lengthText >= sizeText ) {
+    record = new char[lengthPrefix + lengthText + lengthSuffix + 1];
+    vsnprintf( &record[lengthPrefix], lengthText+1, text, argList );
+  }
+  if( lengthPrefix > 0 ) memcpy( record, prefix, lengthPrefix );
+  if( lengthSuffix > 0 ) memcpy( &record[lengthPrefix+lengthText], suffix, lengthSuffix );
+  writeAsync( record, lengthPrefix + lengthText + lengthSuffix );
+  if( record != buffer ) delete [] record;
+}
+//-----------------------------------------
+// Copy record to ring buffer of calling thread. No locking unless the ring buffer is full.
+//
+void csLogWriter::writeAsync( char const* record, int length ) {
+  pthread_once( &threadKeyOnce, createThreadKey );
+  ThreadEntry* firstEntry = (ThreadEntry*)pthread_getspecific( threadKey );
+  ThreadEntry* entry = NULL;
+  bool isChanged = false;
+  // Find entry of this writer, and remove entries of writers that have left asynchronous mode
+  ThreadEntry** entryPtr = &firstEntry;
+  while( *entryPtr != NULL ) {
+    ThreadEntry* entryCurrent = *entryPtr;
+    if( __atomic_load_n( &entryCurrent->buffer->isClosed, __ATOMIC_ACQUIRE ) ) {
+      *entryPtr = entryCurrent->next;
+      releaseRing( entryCurrent->buffer );
+      delete entryCurrent;
+      isChanged = true;
+      continue;
+    }
+    if( entryCurrent->writerID == myAsync->id ) entry = entryCurrent;
+    entryPtr = &entryCurrent->next;
+  }
+  if( isChanged ) pthread_setspecific( threadKey, firstEntry );
+  if( entry == NULL ) {
+    RingBuffer* newBuffer = new RingBuffer();
+    newBuffer->data     = new char[myAsync->bufferSize];
+    newBuffer->capacity = myAsync->bufferSize;
+    newBuffer->head     = 0;
+    newBuffer->tail     = 0;
+    newBuffer->headDrain = 0;
+    newBuffer->isClosed  = 0;
+    newBuffer->refCount  = 2;
+    {
+      cseis_geolib::csMutexLock lock( &myAsync->drainMutex );
+      newBuffer->next = myAsync->firstBuffer;
+      myAsync->firstBuffer = newBuffer;
+    }
+    entry = new ThreadEntry();
+    entry->writerID = myAsync->id;
+    entry->buffer   = newBuffer;
+    entry->next     = firstEntry;
+    pthread_setspecific( threadKey, entry );
+  }
+  RingBuffer* ring = entry->buffer;
+  int sizeRecord = (int)sizeof(RecordHeader) + length;
+
+  if( sizeRecord > ring->capacity ) {
+    // Record does not fit into ring buffer: Write out buffered messages, then write record directly.
+    // Records of other threads that are still being copied into their ring buffers come after this record
+    cseis_geolib::csMutexLock lock( &myAsync->drainMutex );
+    drainLocked();
+    fwrite( record, 1, length, myLogFile );
+    return;
+  }
+  csInt64_t head = ring->head;
+  while( ring->capacity - (int)( head - __atomic_load_n( &ring->tail, __ATOMIC_ACQUIRE ) ) < sizeRecord ) {
+    drain();
+  }
+  // Take sequence number only now that there is space: Waiting for space would otherwise delay this record behind later ones
+  RecordHeader recordHeader;
+  recordHeader.sequence = __atomic_fetch_add( &myAsync->nextSequence, 1, __ATOMIC_RELAXED );
+  recordHeader.length   = length;
+  copyToRing( ring, head, (char const*)&recordHeader, sizeof(RecordHeader) );
+  copyToRing( ring, head + sizeof(RecordHeader), record, length );
+  __atomic_store_n( &ring->head, head + sizeRecord, __ATOMIC_RELEASE );
+  if( head + sizeRecord - __atomic_load_n( &ring->tail, __ATOMIC_ACQUIRE ) > ring->capacity/2 ) {
+    myAsync->wakeCondition.signal();
+  }
+}
+//-----------------------------------------
+bool csLogWriter::drain() {
+  cseis_geolib::csMutexLock lock( &myAsync->drainMutex );
+  return drainLocked();
+}
+//-----------------------------------------
+// Write out records of all ring buffers, merged by sequence number.
+// Messages of one thread always appear in the order in which they were logged. Messages of different threads appear in the
+// order in which they were logged if one was logged clearly after the other, e.g. a summary written by the main thread after
+// joining worker threads comes after the workers' messages. Messages logged by different threads at nearly the same time may
+// appear in either order: A record whose sequence number was taken, but which is not yet visible in its ring buffer, is
+// written by the next drain.
+//
+bool csLogWriter::drainLocked() {
+  bool isWritten = false;
+  // Only write records that are visible now. Records added while draining are written by the next call
+  for( RingBuffer* ring = myAsync->firstBuffer; ring != NULL; ring = ring->next ) {
+    ring->headDrain = __atomic_load_n( &ring->head, __ATOMIC_ACQUIRE );
+  }
+  while( true ) {
+    RingBuffer* ringNext = NULL;
+    RecordHeader headerNext;
+    for( RingBuffer* ring = myAsync->firstBuffer; ring != NULL; ring = ring->next ) {
+      if( ring->tail == ring->headDrain ) continue;
+      RecordHeader recordHeader;
+      copyFromRing( ring, ring->tail, (char*)&recordHeader, sizeof(RecordHeader) );
+      if( ringNext == NULL || recordHeader.sequence < headerNext.sequence ) {
+        ringNext   = ring;
+        headerNext = recordHeader;
+      }
+    }
+    if( ringNext == NULL ) break;
+    int length = headerNext.length;
+    int pos    = (int)( ( ringNext->tail + sizeof(RecordHeader) ) & (csInt64_t)( ringNext->capacity-1 ) );
+    int first  = ( length < ringNext->capacity - pos ) ? length : ringNext->capacity - pos;
+    fwrite( &ringNext->data[pos], 1, first, myLogFile );
+    if( first < length ) fwrite( ringNext->data, 1, length-first, myLogFile );
+    __atomic_store_n( &ringNext->tail, ringNext->tail + sizeof(RecordHeader) + length, __ATOMIC_RELEASE );
+    isWritten = true;
+  }
+  return isWritten;
+}
+//-----------------------------------------
 void csLogWriter::line( char const* text, ... ) {
-  if( myLogFile ) {
+  if( isLevelEnabled( LEVEL_INFO ) ) {
     va_list argList;
     va_start( argList, text );
-    vfprintf( myLogFile, text, argList );
-    fprintf( myLogFile, "\n" );
+    output( NULL, text, argList, "\n" );
+    va_end( argList );
 #ifdef CS_DEBUG
-    fflush(myLogFile);
+    flush();
 #endif
   }
 }
 //-----------------------------------------
 void csLogWriter::write( char const* text, ... ) {
-  if( myLogFile ) {
+  if( isLevelEnabled( LEVEL_INFO ) ) {
     va_list argList;
     va_start( argList, text );
-    vfprintf( myLogFile, text, argList );
+    output( NULL, text, argList, NULL );
+    va_end( argList );
   #ifdef CS_DEBUG
-    fflush(myLogFile);
+    flush();
   #endif
   }
 }
 //-----------------------------------------
+void csLogWriter::debug( char const* text, ... ) {
+  if( isLevelEnabled( LEVEL_DEBUG ) ) {
+    va_list argList;
+    va_start( argList, text );
+    output( NULL, text, argList, "\n" );
+    va_end( argList );
+  }
+}
+//-----------------------------------------
 void csLogWriter::error( char const* text, ... ) {
   if( myLogFile ) {
     va_list argList;
     va_start( argList, text );
-    fprintf( myLogFile, "FATAL ERROR:\n" );
-    vfprintf( myLogFile, text, argList );
-    fprintf( myLogFile, "\n" );
+    output( "FATAL ERROR:\n", text, argList, "\n" );
+    va_end( argList );
+    flush();
   }
-  throw( cseis_geolib::csException("Fatal error occurred. See log file for details.") );  
+  throw( cseis_geolib::csException("Fatal error occurred. See log file for details.") );
 }
 void csLogWriter::error( char const* moduleName, int moduleIndex, char const* text, ... ) {
   if( myLogFile ) {
-    va_list argList;
-    va_start( argList, text );
+    char prefix[512];
     if( moduleName != NULL ) {
       if( moduleIndex > 0 ) {
-        fprintf( myLogFile, "\nFATAL ERROR in module %s (%d):\n", moduleName, moduleIndex+1 );
+        snprintf( prefix, sizeof(prefix), "\nFATAL ERROR in module %s (%d):\n", moduleName, moduleIndex+1 );
       }
       else {
-        fprintf( myLogFile, "\nFATAL ERROR in module %s:\n", moduleName );
+        snprintf( prefix, sizeof(prefix), "\nFATAL ERROR in module %s:\n", moduleName );
       }
     }
     else {
-      fprintf( myLogFile, "\nFATAL ERROR:\n" );
+      snprintf( prefix, sizeof(prefix), "\nFATAL ERROR:\n" );
     }
-    vfprintf( myLogFile, text, argList );
-    fprintf( myLogFile, "\n" );
+    va_list argList;
+    va_start( argList, text );
+    output( prefix, text, argList, "\n" );
+    va_end( argList );
+    flush();
   }
   throw( cseis_geolib::csException("Fatal error occurred. See log file for details.") );
 }
 //-----------------------------------------
 void csLogWriter::warning( char const* text, ... ) {
-  if( myLogFile ) {
+  if( isLevelEnabled( LEVEL_WARNING ) ) {
     va_list argList;
     va_start( argList, text );
-    fprintf( myLogFile, "WARNING:\n" );
-    vfprintf( myLogFile, text, argList );
-    fprintf( myLogFile, "\n" );
+    output( "WARNING:\n", text, argList, "\n" );
+    va_end( argList );
   }
 }
 //-----------------------------------------
 void csLogWriter::flush() {
   if( myLogFile ) {
+    if( myAsync != NULL ) drain();
     fflush(myLogFile);
   }
 }
 
 
-
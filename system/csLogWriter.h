@@ -7,6 +7,7 @@
 #define CS_LOG_WRITER_H
 
 #include <cstdio>
+#include <cstdarg>
 #include <string>
 
 namespace cseis_system {
@@ -20,6 +21,15 @@ namespace cseis_system {
 * The methods will not do anything if no filename was given, or the file did not open correctly
 * This is to ensure that Cseis flows will not fail even if no log file is available.
 *
+* Messages below the current log level (see setLevel()) are discarded before they are formatted.
+*
+* In asynchronous mode (see setAsynchronous()), messages are formatted into a ring buffer of the calling thread,
+* without locking, and written to file by a background thread. Messages of one thread are written in the order in which they
+* were logged. Messages logged by different threads at nearly the same time may appear in either order. Messages larger than
+* the ring buffer are written directly, after all messages buffered so far.
+* Buffered messages are written out when flush() or getFile() is called, before error() throws, when the writer is
+* destroyed, and when the program calls exit().
+*
 * @author Bjorn Olofsson
 * @date   2007
 */
@@ -43,6 +53,27 @@ public:
    */
   csLogWriter();
   ~csLogWriter();
+  /// Log levels, in increasing order of severity
+  static int const LEVEL_DEBUG   = 0;
+  static int const LEVEL_INFO    = 1;
+  static int const LEVEL_WARNING = 2;
+  static int const LEVEL_ERROR   = 3;
+  /// Default size of ring buffer of each thread in asynchronous mode, in bytes
+  static int const DEFAULT_BUFFER_SIZE = 65536;
+  /**
+  * Set log level. Messages of lower severity are discarded. Error messages are always written.
+  * line() and write() have level LEVEL_INFO. Default: LEVEL_INFO
+  */
+  void setLevel( int level ) { myLevel = level; }
+  inline int level() const { return myLevel; }
+  inline bool isLevelEnabled( int level ) const { return( myLogFile != NULL && level >= myLevel ); }
+  /**
+  * Switch asynchronous mode on or off. Messages buffered so far are written out first.
+  * @param bufferSize  Size of ring buffer of each thread, in bytes
+  * @return false if background thread could not be started. The writer remains in synchronous mode
+  */
+  bool setAsynchronous( bool doAsync, int bufferSize = DEFAULT_BUFFER_SIZE );
+  inline bool isAsynchronous() const { return( myAsync != NULL ); }
   /**
   * Print message line to log file, with terminating newline, similar to printf("...\n")
   */
@@ -70,21 +101,43 @@ public:
   */
   void warning( char const* text, ... );
   /**
-  * Flush output
+  * Print debug message line to log file. Only written if log level is LEVEL_DEBUG
+  */
+  void debug( char const* text, ... );
+  /**
+  * Flush output. In asynchronous mode, all buffered messages are written first
   */
   void flush();
   /**
-  * @return file object
+  * @return file object. In asynchronous mode, all buffered messages are written first
   */
   FILE* getFile() {
+    if( myAsync != NULL ) flush();
     return myLogFile;
   }
 private:
+  struct AsyncState;
   csLogWriter( csLogWriter const& obj );
+  void init();
+  /// Write prefix, formatted text and suffix to log file, or to ring buffer of calling thread in asynchronous mode
+  void output( char const* prefix, char const* text, va_list argList, char const* suffix );
+  void writeAsync( char const* record, int length );
+  /// Write out buffered messages of all threads. Used in asynchronous mode. @return false if there was nothing to write
+  bool drain();
+  /// Same as drain(), drain mutex already locked
+  bool drainLocked();
+  /// Flush all writers in asynchronous mode. Registered with atexit()
+  static void flushAtExit();
+  static void registerAtExit();
   std::FILE* myLogFile;
   char const* myFilename;
   /// true if file is opened within class. If yes then the file srtream will be closed during object destruction
   bool myIsOpenedLocally;
+  int myLevel;
+  /// Ring buffers and background thread. NULL in synchronous mode
+  AsyncState* myAsync;
+  class DrainThread;
+  friend class DrainThread;
 };
   
 } // namespace
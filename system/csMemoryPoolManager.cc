@@ -3,9 +3,13 @@
 #include "csMemoryPoolManager.h"
 #include "geolib/geolib_defines.h"
 #include "geolib/csException.h"
+#include "geolib/csThread.h"
 #include "csTrace.h"
 #include "csTracePool.h"
 #include "csTraceData.h"
+#include "csTraceDataAllocator.h"
+#include "csTraceSpillFile.h"
+#include "csModuleProfile.h"
 #include "csTraceHeader.h"
 #include "csTraceHeaderDef.h"
 #include "csTraceHeaderInfo.h"
@@ -22,22 +26,38 @@ csMemoryPoolManager::csMemoryPoolManager() {
 }
 void csMemoryPoolManager::init( int policy ) {
   myPolicy = policy;
-  myTracePool = new csTracePool( myPolicy );
+  myTraceDataAllocator = new csTraceDataAllocator( myPolicy );
+  myTracePool = new csTracePool( myPolicy, myTraceDataAllocator );
   myTraceHeaderInfoPool = new csTraceHeaderInfoPool();
   myMaxNumBytes = MAX_NUM_MEGABYTES * 1024L * 1024L;
-  myMaxNumBytesAllocated = 0;
+  mySpillFile = NULL;
 }
 csMemoryPoolManager::~csMemoryPoolManager() {
   if( myTracePool ) {
     delete myTracePool;
     myTracePool = NULL;
   }
+  // Delete after trace pool: Traces release their sample buffers to the allocator
+  if( myTraceDataAllocator ) {
+    delete myTraceDataAllocator;
+    myTraceDataAllocator = NULL;
+  }
+  if( mySpillFile ) {
+    delete mySpillFile;
+    mySpillFile = NULL;
+  }
   if( myTraceHeaderInfoPool ) {
     delete myTraceHeaderInfoPool;
     myTraceHeaderInfoPool = NULL;
   }
 }
 csTrace* csMemoryPoolManager::getNewTrace() {
+  // Fast path: Free trace in cache of calling thread. Re-using a trace does not add to the memory in use
+  csTrace* traceCached = myTracePool->getCachedTrace();
+  if( traceCached != NULL ) {
+    return traceCached;
+  }
+  csMutexLock lock( &myTracePool->myMutex );
   checkMemory();
   //  static int counter = 0;
   //  static int const maxCount = 1;
@@ -48,12 +68,14 @@ csTrace* csMemoryPoolManager::getNewTrace( csTraceHeaderDef const* hdefPtr, int
   csTrace* traceNew = getNewTrace();
   traceNew->getTraceHeader()->setHeaders( hdefPtr );
   traceNew->getTraceDataObject()->set( numSamples );
+  csModuleProfile::addAllocatedBytes( (csInt64_t)numSamples * sizeof(float) );
   return traceNew;
 }
 csTrace* csMemoryPoolManager::getNewTrace( csTrace const* traceOld ) {
   csTrace* traceNew = getNewTrace();
   traceNew->getTraceHeader()->copyFrom( traceOld->getTraceHeader() );
   traceNew->getTraceDataObject()->setData( traceOld->getTraceDataObject() );
+  csModuleProfile::addAllocatedBytes( (csInt64_t)traceOld->numSamples() * sizeof(float) );
   return traceNew;
 }
 csTraceHeaderInfo const* csMemoryPoolManager::getNewTraceHeaderInfo( cseis_geolib::type_t type, std::string const& name, std::string const& description ) {
@@ -66,25 +88,53 @@ csTraceHeaderInfo const* csMemoryPoolManager::getNewTraceHeaderInfo( cseis_geoli
 }
 void csMemoryPoolManager::dumpSummary( FILE* fout ) const {
   myTracePool->dumpSummary( fout );
+  myTraceDataAllocator->dumpSummary( fout );
+  csInt64_t numBytes = maxNumBytesAllocated();
   fprintf( fout," Total number of allocated (trace) memory:  %.2fkb  (= %.2fMb)\n",
-           (double)myMaxNumBytesAllocated/(1024.0), (double)myMaxNumBytesAllocated/(1024.0*1024.0) );
+           (double)numBytes/(1024.0), (double)numBytes/(1024.0*1024.0) );
+  if( mySpillFile ) {
+    mySpillFile->dumpSummary( fout );
+  }
+}
+csInt64_t csMemoryPoolManager::maxNumBytesAllocated() const {
+  return myTraceDataAllocator->maxNumBytesInUse();
+}
+csInt64_t csMemoryPoolManager::numBytesInUse() const {
+  // Free traces keep their sample buffers for re-use. These do not count as memory in use
+  return( myTraceDataAllocator->numBytesInUse() - myTracePool->numBytesFree() );
+}
+void csMemoryPoolManager::setMaxNumMegabytes( int maxNumMegabytes ) {
+  myMaxNumBytes = (csInt64_t)maxNumMegabytes * 1024L * 1024L;
+}
+void csMemoryPoolManager::setSpillDirectory( std::string const& directory ) {
+  if( mySpillFile ) {
+    delete mySpillFile;
+  }
+  mySpillFile = new csTraceSpillFile( directory );
+}
+void csMemoryPoolManager::checkSpill( csTrace* trace ) {
+  if( mySpillFile == NULL || numBytesInUse() <= myMaxNumBytes ) {
+    return;
+  }
+  trace->getTraceDataObject()->spillSamples( mySpillFile );
 }
 bool csMemoryPoolManager::checkMemory() {
   if( myTracePool->numAvailableTraces() > 1 ) {
     return true;
   }
-  csInt64_t numBytes = myTracePool->computeNumBytes();
-  if( numBytes > myMaxNumBytesAllocated ) myMaxNumBytesAllocated = numBytes;
+  csInt64_t numBytes = numBytesInUse();
   //  fprintf(stderr,"Memory usage: %d traces (%d), %fkb, max allowed: %fkb\n",
   //        myTracePool->numAvailableTraces(), myTracePool->myNumAllocatedTraces, (double)numBytes/(1024.0), (double)myMaxNumBytes/(1024.0) );
 
-  if( numBytes > myMaxNumBytes ) {
+  // Spill mode: Buffered traces are spilled to disk instead, see checkSpill()
+  if( numBytes > myMaxNumBytes && mySpillFile == NULL ) {
     throw( csException("\ncsMemoryPoolManager::checkMemory(): Bytes allocated: %fkb, max allowed: %fkb\n"\
                        "\nSeaSeis dynamically allocates traces for each module. Most trace-buffering usually occurs for multi-trace modules. " \
                        "Modules working on 'ensembles' are most prone to buffer a large amount of traces, such as sorting, stacking... " \
                        "In that respect, it is important that the user is aware of the correct setting of the 'ensemble trace header'. " \
                        "The ensemble header can be set using module 'ENS_DEFINE'. All consecutive traces for which the ensemble trace header "\
-                       "value does not change constitute one ensemble.",
+                       "value does not change constitute one ensemble. " \
+                       "If the job needs to buffer this many traces, enable spilling of buffered traces to disk (cseis_submit option -spill).",
                        (double)numBytes/(1024.0), (double)myMaxNumBytes/(1024.0) ) );
   }
   return true;
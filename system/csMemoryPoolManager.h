@@ -13,6 +13,8 @@
 namespace cseis_system {
 
   class csTracePool;
+  class csTraceDataAllocator;
+  class csTraceSpillFile;
   class csTrace;
   class csTraceHeaderInfo;
   class csTraceHeaderInfoPool;
@@ -64,6 +66,28 @@ public:
    * @param fout Output stream where dump shall be written to
    */
   void dumpSummary( FILE* fout ) const;
+  /// @return Maximum number of bytes held in trace samples at one time
+  csInt64_t maxNumBytesAllocated() const;
+  /// @return Number of bytes held in sample buffers of traces in use. Sample buffers kept by free traces in the trace pool are not included
+  csInt64_t numBytesInUse() const;
+  /**
+   * Set maximum memory held by traces. Default: MAX_NUM_MEGABYTES
+   * When this limit is exceeded, the job is aborted, unless spill mode has been enabled.
+   */
+  void setMaxNumMegabytes( int maxNumMegabytes );
+  /**
+   * Enable spill mode
+   * When the memory held by traces exceeds the maximum, the samples of traces that are buffered by a module
+   * are written to a scratch file in the given directory instead, and read back in when the module accesses them.
+   * Call before the exec phase is run.
+   * @param directory  Scratch directory
+   */
+  void setSpillDirectory( std::string const& directory );
+  /**
+   * Spill samples of buffered trace to disk if memory limit has been exceeded, and spill mode is enabled.
+   * Called for traces that have been added to the trace buffer of a module.
+   */
+  void checkSpill( csTrace* trace );
 private:
 
   csMemoryPoolManager( csMemoryPoolManager const& obj );
@@ -73,11 +97,14 @@ private:
   int myPolicy;
   /// Trace pool buffer where all seismic traces are stored
   csTracePool* myTracePool;
+  /// Allocator for sample buffers of all traces. Keeps track of the number of bytes held by traces
+  csTraceDataAllocator* myTraceDataAllocator;
   /// Trace header info pool buffer where all trace header info objects are stored
   csTraceHeaderInfoPool* myTraceHeaderInfoPool;
   /// Maximum number of bytes to allocate
   csInt64_t myMaxNumBytes;
-  csInt64_t myMaxNumBytesAllocated;
+  /// Scratch file for spilled trace samples. NULL if spill mode is disabled
+  csTraceSpillFile* mySpillFile;
 };
 
 } // namespace
@@ -3,213 +3,203 @@
 #include <string>
 #include <fstream>
 #include <cstring>
+#include <map>
 #include "csMethodRetriever.h"
+#include "csModuleProfile.h"
 #include "geolib/csException.h"
+#include "geolib/csThread.h"
 #include "geolib/csVector.h"
 #include "geolib/geolib_string_utils.h"
 #include "geolib/geolib_platform_dependent.h"
 
-#ifdef PLATFORM_WINDOWS
+// Statically linked modules: Always on Windows and Solaris. On Linux and Mac, compile with CS_STATIC_MODULES to link
+// all standard modules into the executable instead of loading them from shared libraries at run time.
+#if defined(PLATFORM_WINDOWS) || defined(PLATFORM_SOLARIS) || defined(CS_STATIC_MODULES)
+#define CS_STATIC_MODULE_LINKING 1
 #include "cseis_modules_all.h"
-#elif PLATFORM_SOLARIS
-#include "cseis_modules_all.h"
-#elif PLATFORM_LINUX
-#include "cseis_modules.h"
-#include <dlfcn.h>
-#elif PLATFORM_APPLE
+#else
 #include "cseis_modules.h"
 #include <dlfcn.h>
 #endif
 
 using namespace cseis_system;
 
-#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+namespace {
+  /// Protects module registry. Modules may be set up from several threads
+  cseis_geolib::csMutex registryMutex;
+  int numLibrariesOpened = 0;
+  int numSymbolsResolved = 0;
+  int numCacheHits = 0;
+  double timeResolve = 0.0;
+#ifdef CS_STATIC_MODULE_LINKING
+  /// Maps module name to index in method tables
+  std::map<std::string,int> methodIndexMap;
+#else
+  /// Maps shared library name to library handle
+  std::map<std::string,void*> libraryMap;
+  /// Maps shared library name + symbol name to method address. NULL if library does not define symbol
+  std::map<std::string,void*> symbolMap;
+#endif
+}
+
+void csMethodRetriever::getStatistics( int& numLibraries, int& numSymbols, int& numHits, double& timeSeconds ) {
+  cseis_geolib::csMutexLock lock( &registryMutex );
+  numLibraries = numLibrariesOpened;
+  numSymbols   = numSymbolsResolved;
+  numHits      = numCacheHits;
+  timeSeconds  = timeResolve;
+}
+
+#ifndef CS_STATIC_MODULE_LINKING
 //----------------------------------------------------------
+// Module registry: Each shared library is opened once per process, and each method is looked up once per library.
+// dlopen() and dlsym() are expensive compared to running the init phase of most modules.
 //
-void csMethodRetriever::getParamInitMethod( std::string const& name, int verMajor, int verMinor, MParamPtr& param, MInitPtr& init ) {
-  std::string nameLower = cseis_geolib::toLowerCase( name );
-  
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so.%d.%d",ptr,verMajor,verMinor);
-
-  void* handle = dlopen( soName, RTLD_LAZY );
+void* csMethodRetriever::openLibrary( std::string const& name, std::string const& soName, std::string const& versionText ) {
+  cseis_geolib::csMutexLock lock( &registryMutex );
+  std::map<std::string,void*>::const_iterator iter = libraryMap.find( soName );
+  if( iter != libraryMap.end() ) {
+    numCacheHits += 1;
+    return iter->second;
+  }
+  double timeStart = csModuleProfile::wallTime();
+  dlerror();
+  void* handle = dlopen( soName.c_str(), RTLD_LAZY );
   const char *dlopen_error = dlerror();
-  delete [] soName;
-
-  if( dlopen_error ) {
-    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist? Does version '%d.%d' exist?\nSystem message: %s\n",
-                       name.c_str(), verMajor, verMinor, dlopen_error ) );
+  timeResolve += csModuleProfile::wallTime() - timeStart;
+  if( handle == NULL || dlopen_error ) {
+    if( dlopen_error == NULL ) dlopen_error = "";
+    if( versionText.empty() ) {
+      throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist?\nSystem message: %s\n",
+                                       name.c_str(), dlopen_error ) );
+    }
+    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist? Does version '%s' exist?\nSystem message: %s\n",
+                                     name.c_str(), versionText.c_str(), dlopen_error ) );
   }
+  numLibrariesOpened += 1;
+  libraryMap[soName] = handle;
+  return handle;
+}
+void* csMethodRetriever::findMethod( std::string const& soName, void* handle, std::string const& methodName ) {
+  cseis_geolib::csMutexLock lock( &registryMutex );
+  std::string key = soName + ":" + methodName;
+  std::map<std::string,void*>::const_iterator iter = symbolMap.find( key );
+  if( iter != symbolMap.end() ) {
+    numCacheHits += 1;
+    return iter->second;
+  }
+  double timeStart = csModuleProfile::wallTime();
+  dlerror();
+  void* ptr = dlsym( handle, methodName.c_str() );
+  if( dlerror() != NULL ) ptr = NULL;
+  timeResolve += csModuleProfile::wallTime() - timeStart;
+  numSymbolsResolved += 1;
+  symbolMap[key] = ptr;
+  return ptr;
+}
+std::string csMethodRetriever::libraryName( std::string const& nameLower, int verMajor, int verMinor ) {
+  char soName[200];
+  sprintf(soName,"libmod_%s.so.%d.%d",nameLower.c_str(),verMajor,verMinor);
+  return std::string(soName);
+}
+std::string csMethodRetriever::versionText( int verMajor, int verMinor ) {
+  char text[32];
+  sprintf(text,"%d.%d",verMajor,verMinor);
+  return std::string(text);
+}
+//----------------------------------------------------------
+//
+void csMethodRetriever::getParamInitMethod( std::string const& name, int verMajor, int verMinor, MParamPtr& param, MInitPtr& init ) {
+  std::string nameLower = cseis_geolib::toLowerCase( name );
+  std::string soName = libraryName( nameLower, verMajor, verMinor );
+  void* handle = openLibrary( name, soName, versionText( verMajor, verMinor ) );
 
-  param = getParamMethod( nameLower, handle );
-  init  = getInitMethod( nameLower, handle );
-
-  //  dlclose(handle);
-  //  fprintf(stderr,"Param method pointer found: %x\n", param);
+  param = getParamMethod( nameLower, soName, handle );
+  init  = getInitMethod( nameLower, soName, handle );
 }
 //----------------------------------------------------------------------------
 //
-MParamPtr csMethodRetriever::getParamMethod( std::string const& nameLower, char const* soName ) {
-  void* handle = dlopen( soName, RTLD_LAZY );
-  const char *dlopen_error = dlerror();
-  delete [] soName;
-  if( dlopen_error ) {
-    fprintf(stdout, "Error occurred while opening shared library. ...does module '%s' exist?\nSystem message: %s\n\n",
-            nameLower.c_str(), dlopen_error );
+MParamPtr csMethodRetriever::getParamMethod( std::string const& nameLower, std::string const& soName, std::string const& versionText ) {
+  void* handle = NULL;
+  try {
+    handle = openLibrary( nameLower, soName, versionText );
+  }
+  catch( cseis_geolib::csException& e ) {
+    fprintf(stdout, "%s\n", e.getMessage());
     fflush(stdout);
-    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist?\nSystem message: %s\n",
-      				     nameLower.c_str(), dlopen_error ) );
+    throw;
   }
-  return getParamMethod( nameLower, handle );
+  return getParamMethod( nameLower, soName, handle );
 }
 MParamPtr csMethodRetriever::getParamMethod( std::string const& name ) {
   std::string nameLower = cseis_geolib::toLowerCase( name );
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so",ptr);
-  return getParamMethod( nameLower, soName );
+  return getParamMethod( nameLower, "libmod_" + nameLower + ".so", "" );
 }
 MParamPtr csMethodRetriever::getParamMethod( std::string const& name, int verMajor, int verMinor ) {
   std::string nameLower = cseis_geolib::toLowerCase( name );
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so.%d.%d",ptr,verMajor,verMinor);
-  return getParamMethod( nameLower, soName );
+  return getParamMethod( nameLower, libraryName( nameLower, verMajor, verMinor ), versionText( verMajor, verMinor ) );
 }
 MParamPtr csMethodRetriever::getParamMethod( std::string const& name, std::string versionString ) {
   std::string nameLower = cseis_geolib::toLowerCase( name );
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so.%s",ptr,versionString.c_str());
-  return getParamMethod( nameLower, soName );
+  return getParamMethod( nameLower, "libmod_" + nameLower + ".so." + versionString, versionString );
 }
 //----------------------------------------------------------------------------
 //
-MInitPtr csMethodRetriever::getInitMethod( std::string const& nameLower, void* handle  ) {
-  char* methodName = new char[200];
-  sprintf( methodName, "_init_mod_%s_", nameLower.c_str() );
-  
-  //  fprintf(stderr,"Init method name:  '%s'\n", methodName );
-
-  //  MInitPtr method = reinterpret_cast<MInitPtr>( dlsym(handle,methodName) );
+MInitPtr csMethodRetriever::getInitMethod( std::string const& nameLower, std::string const& soName, void* handle ) {
+  void* ptr = findMethod( soName, handle, "_init_mod_" + nameLower + "_" );
+  if( ptr == NULL ) {
+    throw( cseis_geolib::csException("Cannot find init definition method of module '%s' in library %s\n", nameLower.c_str(), soName.c_str() ) );
+  }
   MInitPtr method;
-  void *ptr = dlsym(handle,methodName);
   memcpy(&method, &ptr, sizeof(void *));
-
-  const char *dlsym_error = dlerror();
-  delete [] methodName;
-  if( dlsym_error ) {
-    throw( cseis_geolib::csException("Cannot find init definition method. System message:\n%s\n", dlsym_error ) );
-  }
   return method;
 }
 //----------------------------------------------------------------------------
 //
-MParamPtr csMethodRetriever::getParamMethod( std::string const& nameLower, void* handle ) {
-  char* methodName = new char[200];
-  sprintf( methodName, "_params_mod_%s_", nameLower.c_str() );
-
-  //  MParamPtr method = reinterpret_cast<MParamPtr>( dlsym(handle,methodName) );
+MParamPtr csMethodRetriever::getParamMethod( std::string const& nameLower, std::string const& soName, void* handle ) {
+  void* ptr = findMethod( soName, handle, "_params_mod_" + nameLower + "_" );
+  if( ptr == NULL ) {
+    throw( cseis_geolib::csException("Cannot find parameter definition method of module '%s' in library %s\n", nameLower.c_str(), soName.c_str() ) );
+  }
   MParamPtr method;
-  void *ptr = dlsym(handle,methodName);
   memcpy(&method, &ptr, sizeof(void *));
-
-  const char *dlsym_error = dlerror();
-
-  delete [] methodName;
-  if( dlsym_error ) {
-    throw( cseis_geolib::csException("Cannot find parameter definition method. System message:\n%s\n", dlsym_error) );
-  }
-
   return method;
 }
 //--------------------------------------------------------------------
 //
 void csMethodRetriever::getExecMethodSingleTrace( std::string const& name, int verMajor, int verMinor, MExecSingleTracePtr& exec ) {
   std::string nameLower = cseis_geolib::toLowerCase( name );
-
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so.%d.%d",ptr,verMajor,verMinor);
-
-  void* handle = dlopen( soName, RTLD_LAZY );
-  const char *dlopen_error = dlerror();
-  delete [] soName;
-
-  if( dlopen_error ) {
-    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist? Does version '%d.%d' exist?\nSystem message: %s\n",
-                       name.c_str(), verMajor, verMinor, dlopen_error ) );
+  std::string soName = libraryName( nameLower, verMajor, verMinor );
+  void* handle = openLibrary( name, soName, versionText( verMajor, verMinor ) );
+  void* ptr = findMethod( soName, handle, "_exec_mod_" + nameLower + "_" );
+  if( ptr == NULL ) {
+    throw( cseis_geolib::csException("Cannot find exec definition method of module '%s' in library %s\n", nameLower.c_str(), soName.c_str() ) );
   }
-
-  exec  = getExecMethodSingleTrace( nameLower, handle );
-
-  //  myMethodNameList.insertEnd(nameLower);
-  //  myExecList.insertEnd(exec);
+  memcpy(&exec, &ptr, sizeof(void *));
 }
 //----------------------------------------------------------
 //
 void csMethodRetriever::getExecMethodMultiTrace( std::string const& name, int verMajor, int verMinor, MExecMultiTracePtr& exec ) {
-
   std::string nameLower = cseis_geolib::toLowerCase( name );
-
-  char* soName     = new char[200];
-  char const* ptr  = nameLower.c_str();
-  sprintf(soName,"libmod_%s.so.%d.%d",ptr,verMajor,verMinor);
-
-  void* handle = dlopen( soName, RTLD_LAZY );
-  const char *dlopen_error = dlerror();
-  delete [] soName;
-
-  if( dlopen_error ) {
-    //    dlclose(handle);
-    throw( cseis_geolib::csException("Error occurred while opening shared library. ...does module '%s' exist? Does version '%d.%d' exist?\nSystem message: %s\n",
-                       name.c_str(), verMajor, verMinor, dlopen_error ) );
-  }
-
-  exec  = getExecMethodMultiTrace( nameLower, handle );
-
-  //  myMethodNameList.insertEnd(nameLower);
-  // myExecList.insertEnd(exec);
-}
-//
-//---------------------------------------------------------
-MExecSingleTracePtr csMethodRetriever::getExecMethodSingleTrace( std::string const& nameLower, void* handle  ) {
-  char* methodName = new char[200];
-  sprintf( methodName, "_exec_mod_%s_", nameLower.c_str() );
-  
-  //  fprintf(stderr,"Exec method name:  '%s'\n", methodName );
-
-  //  MExecSingleTracePtr method = reinterpret_cast<MExecSingleTracePtr>( dlsym(handle,methodName) );
-  MExecSingleTracePtr method;
-  void *ptr = dlsym(handle,methodName);
-  memcpy(&method, &ptr, sizeof(void *));
-
-  const char *dlsym_error = dlerror();
-  delete [] methodName;
-  if( dlsym_error ) {
-    throw( cseis_geolib::csException("Cannot find exec definition method. System message:\n%s\n", dlsym_error) );
+  std::string soName = libraryName( nameLower, verMajor, verMinor );
+  void* handle = openLibrary( name, soName, versionText( verMajor, verMinor ) );
+  void* ptr = findMethod( soName, handle, "_exec_mod_" + nameLower + "_" );
+  if( ptr == NULL ) {
+    throw( cseis_geolib::csException("Cannot find exec definition method of module '%s' in library %s\n", nameLower.c_str(), soName.c_str() ) );
   }
-  return method;
+  memcpy(&exec, &ptr, sizeof(void *));
 }
 //---------------------------------------------------------
-MExecMultiTracePtr csMethodRetriever::getExecMethodMultiTrace( std::string const& nameLower, void* handle  ) {
-  char* methodName = new char[200];
-  sprintf( methodName, "_exec_mod_%s_", nameLower.c_str() );
-  
-  //  fprintf(stderr,"Exec method name:  '%s'\n", methodName );
-
-  //  MExecMultiTracePtr method = reinterpret_cast<MExecMultiTracePtr>( dlsym(handle,methodName) );
-  MExecMultiTracePtr method;
-  void *ptr = dlsym(handle,methodName);
-  memcpy(&method, &ptr, sizeof(void *));
-
-  const char *dlsym_error = dlerror();
-  delete [] methodName;
-  if( dlsym_error ) {
-    throw( cseis_geolib::csException("Cannot find exec definition method. System message:\n%s\n", dlsym_error) );
+void csMethodRetriever::getExecMethodBatch( std::string const& name, int verMajor, int verMinor, MExecBatchPtr& exec ) {
+  std::string nameLower = cseis_geolib::toLowerCase( name );
+  std::string soName = libraryName( nameLower, verMajor, verMinor );
+  void* handle = openLibrary( name, soName, versionText( verMajor, verMinor ) );
+  void* ptr = findMethod( soName, handle, "_exec_batch_mod_" + nameLower + "_" );
+  exec = NULL;
+  // Batched exec method is optional: Module is run trace by trace if it is not defined
+  if( ptr != NULL ) {
+    memcpy(&exec, &ptr, sizeof(void *));
   }
-  return method;
 }
 
 #endif
@@ -225,7 +215,7 @@ std::string const* csMethodRetriever::getStandardModuleNames() {
   return NAMES;
 }
 
-#ifdef PLATFORM_WINDOWS
+#ifdef CS_STATIC_MODULE_LINKING
 
 //----------------------------------------------------------
 //
@@ -241,6 +231,9 @@ void csMethodRetriever::getParamInitMethod( std::string const& name, int verMajo
 MParamPtr csMethodRetriever::getParamMethod( std::string const& name, std::string versionString ) {
   return csMethodRetriever::getParamMethod( name );
 }
+MParamPtr csMethodRetriever::getParamMethod( std::string const& name, int verMajor, int verMinor ) {
+  return csMethodRetriever::getParamMethod( name );
+}
 MParamPtr csMethodRetriever::getParamMethod( std::string const& name ) {
   int index = getMethodIndex( name );
   if( index >= 0 ) {
@@ -266,15 +259,26 @@ void csMethodRetriever::getExecMethodMultiTrace( std::string const& name, int ve
     exec = METHODS_EXEC_MULTI[index];
   }
 }
+//----------------------------------------------------------
+// Statically linked modules are always run trace by trace
+void csMethodRetriever::getExecMethodBatch( std::string const& name, int verMajor, int verMinor, MExecBatchPtr& exec ) {
+  exec = NULL;
+}
 //--------------------------------------------------------------------
 //
 int csMethodRetriever::getMethodIndex( std::string const& name ) {
-  for( int i = 0; i < N_METHODS; i++ ) {
-    if( !name.compare(NAMES[i]) ) {
-      return i;
+  cseis_geolib::csMutexLock lock( &registryMutex );
+  if( methodIndexMap.empty() ) {
+    for( int i = 0; i < N_METHODS; i++ ) {
+      methodIndexMap[NAMES[i]] = i;
     }
   }
-  return METHOD_NOT_FOUND;
+  std::map<std::string,int>::const_iterator iter = methodIndexMap.find( name );
+  if( iter == methodIndexMap.end() ) {
+    return METHOD_NOT_FOUND;
+  }
+  numCacheHits += 1;
+  return iter->second;
 }
 #endif
 
@@ -19,6 +19,10 @@ namespace cseis_system {
 * Retrieval of module methods
 * Use static member function of this class to retrieve function pointers to the standard methods of Cseis processing modules
 *
+* Module libraries are opened once per process, and each method is looked up once. Later requests for the same module,
+* for example from other instances of the same module in one flow, are served from a cache.
+* Compile with CS_STATIC_MODULES to link all standard modules statically on Linux and Mac, as on Windows.
+*
 * @author Bjorn Olofsson
 * @date   2007
 */
@@ -46,6 +50,12 @@ public:
   * @param name (i) Module name whose method shall be retrieved
   */
   static void getExecMethodMultiTrace( std::string const& name, int verMajor, int verMinor, MExecMultiTracePtr& exec );
+  /**
+  * Retrieve function pointer to batched execution method for single-trace module
+  * @param name (i) Module name whose method shall be retrieved
+  * @param exec (o) NULL if module does not define a batched exec method
+  */
+  static void getExecMethodBatch( std::string const& name, int verMajor, int verMinor, MExecBatchPtr& exec );
 
   /**
   * NOTE: This method is only used when statically linking Cseis modules
@@ -57,18 +67,29 @@ public:
   * @return pointer to list of standard modules
   */
   static std::string const* getStandardModuleNames();
+  /**
+  * Statistics of module method retrieval in this process
+  * @param numLibraries  (o) Number of module libraries opened
+  * @param numSymbols    (o) Number of methods looked up in module libraries
+  * @param numCacheHits  (o) Number of requests served from cache
+  * @param timeSeconds   (o) Time spent opening libraries and looking up methods
+  */
+  static void getStatistics( int& numLibraries, int& numSymbols, int& numCacheHits, double& timeSeconds );
 
  private:
-  static MParamPtr getParamMethod( std::string const& name, void* handle );
-  static MInitPtr  getInitMethod( std::string const& name, void* handle );
-  static MExecSingleTracePtr getExecMethodSingleTrace( std::string const& name, void* handle );
-  static MExecMultiTracePtr getExecMethodMultiTrace( std::string const& name, void* handle );
+  static MParamPtr getParamMethod( std::string const& nameLower, std::string const& soName, void* handle );
+  static MInitPtr  getInitMethod( std::string const& nameLower, std::string const& soName, void* handle );
+  static MParamPtr getParamMethod( std::string const& nameLower, std::string const& soName, std::string const& versionText );
+  /// Open shared library, or return handle of library opened before. Throws csException if library cannot be opened
+  static void* openLibrary( std::string const& name, std::string const& soName, std::string const& versionText );
+  /// @return Address of method in library, or NULL if library does not define method
+  static void* findMethod( std::string const& soName, void* handle, std::string const& methodName );
+  static std::string libraryName( std::string const& nameLower, int verMajor, int verMinor );
+  static std::string versionText( int verMajor, int verMinor );
 
   static int getMethodIndex( std::string const& name );
   static int const METHOD_NOT_FOUND = -33;
 
-  static MParamPtr getParamMethod( std::string const& name, char const* soName );
-
   csMethodRetriever();
   ~csMethodRetriever();  
 };
@@ -13,12 +13,13 @@
 #include "csMethodRetriever.h"
 #include "csExecPhaseDef.h"
 #include "csInitExecEnv.h"
+#include "csModuleProfile.h"
 
 #include "geolib/csException.h"
+#include "geolib/csTimeline.h"
 #include "geolib/csVector.h"
 #include "geolib/csQueue.h"
 #include "geolib/csFlexNumber.h"
-#include "geolib/csTimer.h"
 #include "geolib/csTable.h"
 #include <cstdlib>
 
@@ -39,6 +40,12 @@ void csModule::init() {
   myMethodInit  = NULL;
   myMethodExecSingleTrace = NULL;
   myMethodExecMultiTrace  = NULL;
+  myMethodExecBatch       = NULL;
+  myBatchSize         = 1;
+  myBatchOutPorts     = new int[myBatchSize];
+  myBatchKeep         = new bool[myBatchSize];
+  myNumPendingTraces  = 0;
+  myFirstPendingTrace = 0;
 
   myNumTracesToBePassed     = 0;
   myTotalNumProcessedTraces = 0;
@@ -55,6 +62,7 @@ void csModule::init() {
   myNumOutputPorts         = 1;
   myNumInputPorts          = 1;
   myTimeExecPhaseCPU       = 0.0;
+  myProfile                = new csModuleProfile();
 
   myIsFinishedProcessing = false;
 
@@ -90,6 +98,10 @@ void csModule::init() {
 //---------------------------------------------------------------------
 //
 csModule::~csModule() {
+  if( myProfile != NULL ) {
+    delete myProfile;
+    myProfile = NULL;
+  }
   if( myExecPhaseDef != NULL ) {
     delete myExecPhaseDef;
     myExecPhaseDef = NULL;
@@ -129,6 +141,14 @@ csModule::~csModule() {
   if( myHelperHdrValues != NULL ) {
     delete [] myHelperHdrValues; myHelperHdrValues = NULL;
   }
+  if( myBatchOutPorts != NULL ) {
+    delete [] myBatchOutPorts;
+    myBatchOutPorts = NULL;
+  }
+  if( myBatchKeep != NULL ) {
+    delete [] myBatchKeep;
+    myBatchKeep = NULL;
+  }
 }
 //*********************************************************************
 //
@@ -171,6 +191,9 @@ void csModule::submitInitPhase( csParamManager* paramManager, csLogWriter* log,
     if( myMethodExecSingleTrace == NULL ) {
       throw( cseis_geolib::csException("Program bug: Module exec phase method not found.") );
     }
+    if( myExecPhaseDef->execType() == EXEC_TYPE_SINGLETRACE ) {
+      csMethodRetriever::getExecMethodBatch( myName, myVersion[MAJOR], myVersion[MINOR], myMethodExecBatch );
+    }
   }
   else if( myExecPhaseDef->execType() == EXEC_TYPE_MULTITRACE ) {  // Multitrace module
     if( myExecPhaseDef->traceMode == TRCMODE_UNKNOWN ) {
@@ -256,9 +279,10 @@ bool csModule::isReadyToSubmitExec( bool forceToRun ) const {
 //
 //
 bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& outPort ) {
-  cseis_geolib::csTimer timer;
-  timer.start();
+  cseis_geolib::csTimeline::Event event( myName.c_str(), "exec" );
+  csModuleProfile::Call call( myProfile );
   int nProcessedTraces = 0;
+  int firstProcessedTrace = 0;  // Index of first processed trace in gather
   myExecPhaseDef->myIsLastCall = forceToProcess;
 
   //  printf("submitExecPhase: Gather ntraces: %d  ---  Queue ntraces: %d \n", myTraceGather->numTraces(), myTraceQueue->size() );
@@ -270,36 +294,53 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
     
     if( (*myMethodExecSingleTrace)( trace, &outPort, myExecEnvPtr, log ) ) {
       nProcessedTraces = 1;
+      // In batched mode, traces read in before have not been passed on yet: New trace is the last one in the gather
+      firstProcessedTrace = myTraceGather->numTraces()-1;
     }
-    else {   // No trace has been read in
-      myTraceGather->freeAllTraces();
+    else {   // No trace has been read in. Keep traces read in before that have not been passed on yet
+      myTraceGather->freeTrace( myTraceGather->numTraces()-1 );
     }
     myIsFinishedProcessing = true;
   }
   //----------------------------------------------------------------------------------------
   else if( myExecPhaseDef->execType() == EXEC_TYPE_SINGLETRACE ) {
     //fprintf(stdout,"  Submit single trace module\n");
-    if( myTraceGather->numTraces() <= 0 ) {
-      if( !myTraceQueue->isEmpty() ) {
+    if( myNumPendingTraces > 0 ) {
+      // Traces of last batch that go to a different output port than the traces passed on before
+      nProcessedTraces = passPendingTraces( outPort );
+    }
+    else if( myBatchSize > 1 ) {
+      while( myTraceGather->numTraces() < myBatchSize && !myTraceQueue->isEmpty() ) {
         myTraceGather->addTrace( myTraceQueue->pop() );
       }
-      else {
+      if( myTraceGather->numTraces() <= 0 ) {
         return false;
       }
+      nProcessedTraces = submitExecPhaseBatch( forceToProcess, log, outPort );
     }
-    myTotalNumIncomingTraces += 1;
-    myExecPhaseDef->myIsLastCall = (forceToProcess && myTraceQueue->size() == 0);
-    bool success = true;
-    success = (*myMethodExecSingleTrace)( myTraceGather->trace(0), &outPort, myExecEnvPtr, log );
-    // If valgrind reports error in the following line (Conditional jump...depends on uninitialised value), some single-trace module
-    // has not properly returned a value. This check should really be done by compiler, but is not by default (use -Wall).
-    if( success ) {
-      nProcessedTraces = 1;
-    }
-    else {   // Trace shall be removed from flow
-      myTraceGather->freeTrace( 0 );
+    else {
+      if( myTraceGather->numTraces() <= 0 ) {
+        if( !myTraceQueue->isEmpty() ) {
+          myTraceGather->addTrace( myTraceQueue->pop() );
+        }
+        else {
+          return false;
+        }
+      }
+      myTotalNumIncomingTraces += 1;
+      myExecPhaseDef->myIsLastCall = (forceToProcess && myTraceQueue->size() == 0);
+      bool success = true;
+      success = (*myMethodExecSingleTrace)( myTraceGather->trace(0), &outPort, myExecEnvPtr, log );
+      // If valgrind reports error in the following line (Conditional jump...depends on uninitialised value), some single-trace module
+      // has not properly returned a value. This check should really be done by compiler, but is not by default (use -Wall).
+      if( success ) {
+        nProcessedTraces = 1;
+      }
+      else {   // Trace shall be removed from flow
+        myTraceGather->freeTrace( 0 );
+      }
     }
-    myIsFinishedProcessing = (myTraceQueue->size() == 0);
+    myIsFinishedProcessing = (myTraceQueue->size() == 0 && myNumPendingTraces == 0);
     //fprintf(stdout,"  num trace/queue/finished: %d %d - %d\n", myTraceGather->numTraces(), myTraceQueue->size(), myIsFinishedProcessing );
   }
   //----------------------------------------------------------------------------------------
@@ -365,12 +406,12 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
 // ******** DELETE HEADERS (if any) ON TRACES OUTPUT TO NEXT MODULE *********
 //
   if( myHeaderDef->getIndexOfHeadersToDel()->size() > 0 ) {
-    for( int itrc = 0; itrc < nProcessedTraces; itrc++ ) {
+    for( int itrc = firstProcessedTrace; itrc < firstProcessedTrace+nProcessedTraces; itrc++ ) {
       myTraceGather->trace(itrc)->getTraceHeader()->deleteHeaders( myHeaderDef );
     }
   }
 // ******** SET NUMBER OF SAMPLES FOR ALL TRACES MOVED TO FURTHER MODULES ********
-  for( int itrc = 0; itrc < nProcessedTraces; itrc++ ) {
+  for( int itrc = firstProcessedTrace; itrc < firstProcessedTrace+nProcessedTraces; itrc++ ) {
     myTraceGather->trace(itrc)->getTraceDataObject()->set( mySuperHeader->numSamples );
   }
 // **************************************************************************
@@ -379,12 +420,182 @@ bool csModule::submitExecPhase(  bool forceToProcess, csLogWriter* log, int& out
   }
   myNumTracesToBePassed     += nProcessedTraces; // Add processed traces to number of traces to be passed to next module
   myTotalNumProcessedTraces += nProcessedTraces; // Accumulate number of traces processed by this module
-  myTimeExecPhaseCPU += timer.getElapsedTime();  // Accumulate exec phase CPU time
+  myTimeExecPhaseCPU += call.stop();  // Accumulate exec phase CPU time
   return( nProcessedTraces > 0 );
 }
 //-------------------------------------------------------------------
 //
 //
+void csModule::setBatchSize( int batchSize ) {
+  if( batchSize < 1 ) batchSize = 1;
+  if( myNumPendingTraces > 0 ) {
+    throw( cseis_geolib::csException("csModule::setBatchSize(): Program bug. Batch size changed while traces are pending") );
+  }
+  delete [] myBatchOutPorts;
+  delete [] myBatchKeep;
+  myBatchSize     = batchSize;
+  myBatchOutPorts = new int[myBatchSize];
+  myBatchKeep     = new bool[myBatchSize];
+}
+int csModule::submitExecPhaseBatch( bool forceToProcess, csLogWriter* log, int& outPort ) {
+  int numTraces = myTraceGather->numTraces();
+  myTotalNumIncomingTraces += numTraces;
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    myBatchOutPorts[itrc] = 0;
+    myBatchKeep[itrc]     = true;
+  }
+  if( myMethodExecBatch != NULL ) {
+    myExecPhaseDef->myIsLastCall = (forceToProcess && myTraceQueue->size() == 0);
+    (*myMethodExecBatch)( myTraceGather, myBatchOutPorts, myBatchKeep, myExecEnvPtr, log );
+    if( myTraceGather->numTraces() != numTraces ) {
+      throw( cseis_geolib::csException("Module %s: Batched exec phase method changed the number of traces in the gather. This is a program bug in the module method.", myName.c_str()) );
+    }
+  }
+  else {
+    // Fallback for modules without batched exec method: Run single-trace exec method for each trace
+    for( int itrc = 0; itrc < numTraces; itrc++ ) {
+      myExecPhaseDef->myIsLastCall = (forceToProcess && myTraceQueue->size() == 0 && itrc == numTraces-1);
+      myBatchKeep[itrc] = (*myMethodExecSingleTrace)( myTraceGather->trace(itrc), &myBatchOutPorts[itrc], myExecEnvPtr, log );
+    }
+  }
+  // Remove traces from flow, keeping the output ports of the remaining traces in order
+  int numKept = 0;
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    if( myBatchKeep[itrc] ) {
+      myBatchOutPorts[numKept++] = myBatchOutPorts[itrc];
+    }
+  }
+  for( int itrc = numTraces-1; itrc >= 0; itrc-- ) {
+    if( !myBatchKeep[itrc] ) myTraceGather->freeTrace( itrc );
+  }
+  myNumPendingTraces  = numKept;
+  myFirstPendingTrace = 0;
+  return passPendingTraces( outPort );
+}
+int csModule::passPendingTraces( int& outPort ) {
+  if( myNumPendingTraces == 0 ) return 0;
+  outPort = myBatchOutPorts[myFirstPendingTrace];
+  int numTraces = 1;
+  while( numTraces < myNumPendingTraces && myBatchOutPorts[myFirstPendingTrace+numTraces] == outPort ) {
+    numTraces += 1;
+  }
+  myFirstPendingTrace += numTraces;
+  myNumPendingTraces  -= numTraces;
+  return numTraces;
+}
+//-------------------------------------------------------------------
+//
+//
+bool csModule::isReplicable() const {
+  return( myExecPhaseDef->execType() == EXEC_TYPE_SINGLETRACE && myExecPhaseDef->isThreadSafe() &&
+          myModuleType == MODTYPE_UNKNOWN && myMethodExecSingleTrace != NULL );
+}
+csExecPhaseEnv* csModule::createExecEnvReplica() const {
+  csExecPhaseDef* execPhaseDef = new csExecPhaseDef( *myExecPhaseDef );
+  return new csExecPhaseEnv( myHeaderDef, execPhaseDef, mySuperHeader );
+}
+void csModule::deleteExecEnvReplica( csExecPhaseEnv* env ) {
+  delete env->execPhaseDef;
+  delete env;
+}
+bool csModule::submitExecPhaseReplica( csTrace* trace, int inPort, int& outPort, csExecPhaseEnv* env, csLogWriter* log, csModuleProfile* profile ) const {
+  trace->getTraceHeader()->setHeaders( myHeaderDef, inPort );
+  trace->getTraceDataObject()->setMax( mySuperHeader->numSamples );
+  cseis_geolib::csTimeline::Event event( myName.c_str(), "exec" );
+  csModuleProfile::Call call( profile );
+  outPort = 0;
+  env->execPhaseDef->myIsLastCall = false;
+  if( !(*myMethodExecSingleTrace)( trace, &outPort, env, log ) ) {
+    trace->free();
+    call.stop();
+    return false;
+  }
+  if( myHeaderDef->getIndexOfHeadersToDel()->size() > 0 ) {
+    trace->getTraceHeader()->deleteHeaders( myHeaderDef );
+  }
+  trace->getTraceDataObject()->set( mySuperHeader->numSamples );
+  if( outPort > myNumOutputPorts ) {
+    throw( cseis_geolib::csException("csModule::submitExecPhase(): Output port number too large. This is most likely due to a program bug in the module method...") );
+  }
+  call.stop();
+  return true;
+}
+void csModule::addReplicaStatistics( long numIncomingTraces, long numProcessedTraces, csModuleProfile const* profile ) {
+  myTotalNumIncomingTraces  += numIncomingTraces;
+  myTotalNumProcessedTraces += numProcessedTraces;
+  myTimeExecPhaseCPU        += profile->timeWall();
+  myProfile->add( profile );
+}
+//-------------------------------------------------------------------
+//
+//
+bool csModule::isEnsembleReplicable() const {
+  return( myExecPhaseDef->execType() == EXEC_TYPE_MULTITRACE && myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE &&
+          mySuperHeader->numEnsembleKeys() > 0 && myExecPhaseDef->isThreadSafe() &&
+          myModuleType == MODTYPE_UNKNOWN && myMethodExecMultiTrace != NULL );
+}
+bool csModule::takeEnsemble( bool forceToRun, cseis_geolib::csVector<csTrace*>* traceList ) {
+  if( myTraceGather->numTraces() == 0 && myTraceQueue->isEmpty() ) return false;
+  if( !myIsEnsembleFull && !forceToRun ) return false;
+  if( myTraceGather->numTraces() == 0 ) {
+    // Only possible when forced to run, see isReadyToSubmitExec()
+    updateTracesEnsembleModule();
+  }
+  for( int itrc = 0; itrc < myTraceGather->numTraces(); itrc++ ) {
+    traceList->insertEnd( myTraceGather->trace( itrc ) );
+  }
+  myTraceGather->deleteTraces( 0, myTraceGather->numTraces() );
+  // Same as case 2.2 in submitExecPhase(): Move traces of next ensemble from queue to gather
+  updateTracesEnsembleModule();
+  return true;
+}
+void csModule::submitExecPhaseEnsemble( cseis_geolib::csVector<csTrace*>* traceList, cseis_geolib::csVector<int>* outPortList,
+                                        bool isLastCall, csLogWriter* log ) {
+  cseis_geolib::csTimeline::Event event( myName.c_str(), "exec" );
+  event.setArg( traceList->size() );
+  csModuleProfile::Call call( myProfile );
+  for( int itrc = 0; itrc < traceList->size(); itrc++ ) {
+    addNewTraceToGather( traceList->at(itrc), 0 );
+  }
+  traceList->clear();
+  outPortList->clear();
+  // Same as case 2 in submitExecPhase(): Run exec phase again for all traces the module wants to keep
+  while( myTraceGather->numTraces() > 0 ) {
+    int outPort = 0;
+    int numTrcToKeep = 0;
+    myExecPhaseDef->myIsLastCall = isLastCall;
+    myExecPhaseDef->myTracesAreWaiting = false;
+    myTotalNumIncomingTraces += myTraceGather->numTraces();
+
+    (*myMethodExecMultiTrace)( myTraceGather, &outPort, &numTrcToKeep, myExecEnvPtr, log );
+
+    if( numTrcToKeep > myTraceGather->numTraces() ) {
+      log->warning("Module %s: Supposed number of traces to keep is larger than number of traces in gather. This is probably due to a program bug in the module method.", myName.c_str());
+      numTrcToKeep = myTraceGather->numTraces();
+    }
+    myTotalNumIncomingTraces -= numTrcToKeep;
+    if( outPort > myNumOutputPorts ) {
+      throw( cseis_geolib::csException("csModule::submitExecPhase(): Output port number too large. This is most likely due to a program bug in the module method...") );
+    }
+    int nProcessedTraces = myTraceGather->numTraces() - numTrcToKeep;
+    for( int itrc = 0; itrc < nProcessedTraces; itrc++ ) {
+      csTrace* trace = myTraceGather->trace(itrc);
+      if( myHeaderDef->getIndexOfHeadersToDel()->size() > 0 ) {
+        trace->getTraceHeader()->deleteHeaders( myHeaderDef );
+      }
+      trace->getTraceDataObject()->set( mySuperHeader->numSamples );
+      traceList->insertEnd( trace );
+      outPortList->insertEnd( outPort );
+    }
+    myTraceGather->deleteTraces( 0, nProcessedTraces );
+    myTotalNumProcessedTraces += nProcessedTraces;
+    if( numTrcToKeep == 0 ) break;
+  }
+  myTimeExecPhaseCPU += call.stop();
+}
+//-------------------------------------------------------------------
+//
+//
 bool csModule::submitCleanupPhase(  csLogWriter* log ) {
   myExecPhaseDef->myIsCleanup = true;
   int outPortDummy = 0;
@@ -499,60 +710,61 @@ void csModule::moveTracesFrom( csModule* module, int inPort ) {
     throw( cseis_geolib::csException("csModule::moveTracesFrom: No traces passed to be moved to next module. Is that good or bad?") );
   }
 
+  for( int itrc = 0; itrc < module->myNumTracesToBePassed; itrc++ ) {
+    receiveTrace( module->myTraceGather->trace( itrc ), inPort );
+  }
+  // Remove traces from trace gather, but DO NOT FREE TRACES. Traces are freed when last module is reached.
+  // Traces can not be freed yet because they are still in use by the remaining modules.
+  module->myTraceGather->deleteTraces( 0, module->myNumTracesToBePassed );
+  module->myNumTracesToBePassed = 0;
+}
+
+//------------------------------------------------------
+//
+void csModule::receiveTrace( csTrace* trace, int inPort ) {
   // Case A) Single trace or fixed trace module
   if( myExecPhaseDef->execType() == EXEC_TYPE_SINGLETRACE || myExecPhaseDef->execType() == EXEC_TYPE_INPUT ||
       myExecPhaseDef->traceMode == TRCMODE_FIXED ) {
-    int firstTraceIndex = 0;
-    int numFixedTraces = myExecPhaseDef->numTraces;
-    // A1. Move as many traces as possible from the other 'module' to the 'trace gather'.
-    while( myTraceGather->numTraces() < numFixedTraces && firstTraceIndex < module->myNumTracesToBePassed ) {
-      addNewTraceToGather( module->myTraceGather->trace( firstTraceIndex++ ), inPort );
-      //   printf("A1. Old gather: %d, new gather: %d   --- %d (%d)\n", module->myTraceGather->numTraces(), myTraceGather->numTraces(), firstTraceIndex, module->myNumTracesToBePassed );
+    // A1. Move trace to the 'trace gather' if there is still space left
+    if( myTraceGather->numTraces() < myExecPhaseDef->numTraces ) {
+      addNewTraceToGather( trace, inPort );
     }
-    // A2. Move remaining traces to the 'trace queue'
-    for( int itrc = firstTraceIndex; itrc < module->myNumTracesToBePassed; itrc++ ) {
-      addNewTraceToQueue( module->myTraceGather->trace( itrc ), inPort );
-      //       printf("A2. Old gather: %d, new queue: %d   ---  %d\n", module->myTraceGather->numTraces(), myTraceQueue->size(), firstTraceIndex);
+    // A2. ...otherwise, move trace to the 'trace queue'
+    else {
+      addNewTraceToQueue( trace, inPort );
     }
   }
   // Case B) Ensemble trace module or module with variable number of traces
   else { // else if( myExecPhaseDef->traceMode == TRCMODE_ENSEMBLE ) {
-    // First attempt: - Move all traces to the 'trace queue'.
-    // - Next, try to move as many traces as possible from trace queue to trace gather
-
     // B1. The main case for multi-trace ensemble modules:
-    // Check whether each trace is part of the current 'trace gather'.
-    // If yes, add trace to trace gather. Otherwise, move this and all remaining traces into trace queue.
+    // Check whether trace is part of the current 'trace gather'.
+    // If yes, add trace to trace gather. Otherwise, move trace into trace queue.
     if( mySuperHeader->numEnsembleKeys() > 0 ) {
-      int firstTraceIndex = 0;
-      // 1. If next ensemble has not been found yet, keep moving traces to trace gather
-      while( firstTraceIndex < module->myNumTracesToBePassed ) {
-        csTrace* trace = module->myTraceGather->trace( firstTraceIndex );
-        //printf("moveTracesFrom: Trace is FULL: %s\n", myIsEnsembleFull ? "yes" : "no" );
-        if( myIsEnsembleFull || !traceIsPartOfCurrentEnsemble( trace ) ) {
-          //printf("moveTracesFrom: Trace is FULL or NOT part of current ensemble.  %s\n",  myName.c_str() );
-          addNewTraceToQueue( trace, inPort );
-        }
-        else { //if( traceIsPartOfCurrentEnsemble( trace ) ) {
-          //printf("moveTracesFrom: Trace is part of current ensemble.  %s\n", myName.c_str());
-          addNewTraceToGather( trace, inPort );
-        }
-        firstTraceIndex += 1;
-      }  // end while
+      if( myIsEnsembleFull || !traceIsPartOfCurrentEnsemble( trace ) ) {
+        addNewTraceToQueue( trace, inPort );
+      }
+      else {
+        addNewTraceToGather( trace, inPort );
+      }
     }
     // B2. No ensemble key set --> buffer entire data set directly into the trace gather
-    else { //if( mySuperHeader->numEnsembleKeys() == 0 ) {
-      for( int itrc = 0; itrc < module->myNumTracesToBePassed; itrc++ ) {
-        addNewTraceToGather( module->myTraceGather->trace( itrc ), inPort );
-      }
+    else {
+      addNewTraceToGather( trace, inPort );
     }
+    // Buffered trace is not accessed before the module is run: Spill to disk if memory is running short
+    myMemoryPoolManager->checkSpill( trace );
   }
-  // Remove traces from trace gather, but DO NOT FREE TRACES. Traces are freed when last module is reached.
-  // Traces can not be freed yet because they are still in use by the remaining modules.
-  module->myTraceGather->deleteTraces( 0, module->myNumTracesToBePassed );
-  module->myNumTracesToBePassed = 0;
+  myProfile->setNumBufferedTraces( myTraceGather->numTraces() + myTraceQueue->size() );
+}
+//------------------------------------------------------
+//
+void csModule::removeProcessedTraces( cseis_geolib::csVector<csTrace*>* traceList ) {
+  for( int itrc = 0; itrc < myNumTracesToBePassed; itrc++ ) {
+    traceList->insertEnd( myTraceGather->trace( itrc ) );
+  }
+  myTraceGather->deleteTraces( 0, myNumTracesToBePassed );
+  myNumTracesToBePassed = 0;
 }
-
 //------------------------------------------------------
 //
 void csModule::lastModuleTraceCleanup() {
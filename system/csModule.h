@@ -29,6 +29,7 @@ class csParamManager;
 class csParamDef;
 class csExecPhaseEnv;
 class csMemoryPoolManager;
+class csModuleProfile;
 
 /**
 * Central Cseis class
@@ -55,9 +56,66 @@ public:
   bool submitExecPhase( bool forceToProcess, csLogWriter* log, int& port );
   /// Submit exec phase. Return next port number.
   bool submitCleanupPhase( csLogWriter* log );
+  /**
+  * Set maximum number of traces that a single-trace module processes in one exec phase submission.
+  * Traces are passed to the module's batched exec method if defined, or else to the single-trace method one by one.
+  * Processed traces are passed on to the next module in blocks of traces with the same output port.
+  * @param batchSize  Number of traces (default: 1)
+  */
+  void setBatchSize( int batchSize );
 
   /// Move seismic traces from module 'module' that is connected to this module at input port 'inPort'
   void moveTracesFrom( csModule* module, int inPort );
+  /**
+   * Receive one seismic trace at input port 'inPort'.
+   * Used instead of moveTracesFrom() when the previous module runs in a different thread
+   */
+  void receiveTrace( csTrace* trace, int inPort );
+  /**
+   * Remove all processed traces from this module's trace gather, without freeing them
+   * @param traceList (o) Processed traces are appended to this list, in output order
+   */
+  void removeProcessedTraces( cseis_geolib::csVector<csTrace*>* traceList );
+  /// @return true if this module's exec phase can be run for several traces at once: Thread-safe single-trace module
+  bool isReplicable() const;
+  /**
+   * Create copy of exec phase state (exec phase definition and environment), for running the exec phase in a separate thread.
+   * Module variables are shared with the original. Delete returned object with deleteExecEnvReplica().
+   */
+  csExecPhaseEnv* createExecEnvReplica() const;
+  static void deleteExecEnvReplica( csExecPhaseEnv* env );
+  /**
+   * Submit exec phase of replicable module for one trace received at input port 'inPort',
+   * using exec phase state created by createExecEnvReplica().
+   * Module statistics are not updated, see addReplicaStatistics().
+   * @param profile (o) Exec phase profile of calling thread
+   * @return false if trace was removed from flow. The trace has been freed in this case.
+   */
+  bool submitExecPhaseReplica( csTrace* trace, int inPort, int& outPort, csExecPhaseEnv* env, csLogWriter* log, csModuleProfile* profile ) const;
+  /// Add number of traces and exec phase profile of exec phase replica to module statistics
+  void addReplicaStatistics( long numIncomingTraces, long numProcessedTraces, csModuleProfile const* profile );
+  /**
+   * @return true if this module's exec phase can be run for several ensembles at once, in separate module instances:
+   * Thread-safe multi-trace ensemble module
+   */
+  bool isEnsembleReplicable() const;
+  /**
+   * Remove next complete ensemble from this module's trace gather, without processing it.
+   * Ensemble breaks are detected in the same way as when the exec phase is submitted.
+   * @param forceToRun  true if all input traces have been received: Remaining traces form the last ensemble
+   * @param traceList (o) Traces of ensemble are appended to this list
+   * @return false if no complete ensemble is available
+   */
+  bool takeEnsemble( bool forceToRun, cseis_geolib::csVector<csTrace*>* traceList );
+  /**
+   * Submit exec phase of ensemble module for one complete ensemble, retrieved by takeEnsemble() from another instance of the same module.
+   * The exec phase is called repeatedly as long as the module keeps traces in the gather.
+   * @param traceList   (i/o) Input: Traces of ensemble. Output: Processed traces, in output order
+   * @param outPortList (o)   Output port of each processed trace
+   * @param isLastCall  true if this is the last ensemble
+   */
+  void submitExecPhaseEnsemble( cseis_geolib::csVector<csTrace*>* traceList, cseis_geolib::csVector<int>* outPortList,
+                                bool isLastCall, csLogWriter* log );
   /// Call to clean up last module in flow. Call after each exec phase submission
   void lastModuleTraceCleanup();  //...
   /// @return true if there are still unprocessed traces waiting in the trace gather
@@ -92,6 +150,8 @@ public:
   int tempNumTraces();
   /// @return CPU time used during module's exec phase
   inline double getExecPhaseCPUTime() const { return myTimeExecPhaseCPU; }
+  /// @return Exec phase profile: Wall and CPU time, latency, buffered traces, allocated memory
+  csModuleProfile const* getProfile() const { return myProfile; }
   /**
   * Set module version number
   * @param major: Major version (1-99)
@@ -108,6 +168,16 @@ private:
   void init();
   /// Retrieve module methods: Parameter definition method and init method
   void retrieveParamInitMethods();
+  /**
+  * Run exec phase of single-trace module for all traces in trace gather
+  * @return number of processed traces that are passed on first, see passPendingTraces()
+  */
+  int submitExecPhaseBatch( bool forceToProcess, csLogWriter* log, int& outPort );
+  /**
+  * Pass on processed traces from the front of the trace gather that have the same output port
+  * @return number of traces to be passed
+  */
+  int passPendingTraces( int& outPort );
   /// Maximum number of output ports
   static int const MAX_NUM_PORTS = 2;
 
@@ -135,6 +205,8 @@ private:
   csExecPhaseEnv* myExecEnvPtr;
   /// Accumulated CPU time taken by module's exec phase
   double myTimeExecPhaseCPU;
+  /// Exec phase profile
+  csModuleProfile* myProfile;
 
   //-----------------------------------------------------------------------------------------
   // Fields relating to ensemble breaks -- maybe these could be wrapped up in another class? Maybe csExecPhaseDef?
@@ -186,6 +258,18 @@ private:
   MExecSingleTracePtr myMethodExecSingleTrace;
   /// EXEC phase method for multi trace modules (function pointer)
   MExecMultiTracePtr myMethodExecMultiTrace;
+  /// Batched EXEC phase method for single trace modules (function pointer). NULL if not defined by module
+  MExecBatchPtr myMethodExecBatch;
+  /// Maximum number of traces processed in one exec phase submission of a single trace module
+  int myBatchSize;
+  /// Output port of each trace in batch
+  int* myBatchOutPorts;
+  /// Keep flag of each trace in batch
+  bool* myBatchKeep;
+  /// Processed traces at the front of the trace gather that have not been passed on yet, see passPendingTraces()
+  int myNumPendingTraces;
+  /// Index of output port of first pending trace in myBatchOutPorts
+  int myFirstPendingTrace;
   //--------------------
   // Module structure  
   //
@@ -0,0 +1,131 @@
+
+
+#include <cmath>
+#include <ctime>
+#include <pthread.h>
+#include <sys/time.h>
+#include "csModuleProfile.h"
+#include "geolib/geolib_platform_dependent.h"
+
+using namespace cseis_system;
+
+namespace {
+  /// Key to profile of module whose exec phase is running in the calling thread
+  pthread_key_t currentProfileKey;
+  pthread_once_t currentProfileKeyOnce = PTHREAD_ONCE_INIT;
+  void createCurrentProfileKey() {
+    pthread_key_create( &currentProfileKey, NULL );
+  }
+  inline cseis_system::csModuleProfile* currentProfile() {
+    pthread_once( &currentProfileKeyOnce, createCurrentProfileKey );
+    return (cseis_system::csModuleProfile*)pthread_getspecific( currentProfileKey );
+  }
+  inline void setCurrentProfile( cseis_system::csModuleProfile* profile ) {
+    pthread_once( &currentProfileKeyOnce, createCurrentProfileKey );
+    pthread_setspecific( currentProfileKey, profile );
+  }
+}
+
+//--------------------------------------------------------------------
+csModuleProfile::Call::Call( csModuleProfile* profile ) {
+  myProfile = profile;
+  myPreviousProfile = currentProfile();
+  setCurrentProfile( profile );
+  myStartWall = csModuleProfile::wallTime();
+  myStartCPU  = csModuleProfile::threadCPUTime();
+}
+csModuleProfile::Call::~Call() {
+  if( myProfile != NULL ) {
+    setCurrentProfile( myPreviousProfile );
+  }
+}
+double csModuleProfile::Call::stop() {
+  double timeWall = csModuleProfile::wallTime() - myStartWall;
+  double timeCPU  = csModuleProfile::threadCPUTime() - myStartCPU;
+  myProfile->addCall( timeWall, timeCPU );
+  setCurrentProfile( myPreviousProfile );
+  myProfile = NULL;
+  return timeWall;
+}
+//--------------------------------------------------------------------
+csModuleProfile::csModuleProfile() {
+  myNumCalls  = 0;
+  myTimeWall  = 0.0;
+  myTimeCPU   = 0.0;
+  myMaxNumBufferedTraces = 0;
+  myNumBytesAllocated    = 0;
+  myLatencyBins = new csInt64_t[NUM_BINS];
+  for( int i = 0; i < NUM_BINS; i++ ) {
+    myLatencyBins[i] = 0;
+  }
+}
+csModuleProfile::~csModuleProfile() {
+  delete [] myLatencyBins;
+}
+void csModuleProfile::addCall( double timeWall, double timeCPU ) {
+  myNumCalls += 1;
+  myTimeWall += timeWall;
+  myTimeCPU  += timeCPU;
+  double timeNano = timeWall * 1.0e9;
+  int bin = 0;
+  if( timeNano > 1.0 ) {
+    bin = (int)( log( timeNano ) / log( 2.0 ) * NUM_BINS_PER_OCTAVE );
+    if( bin >= NUM_BINS ) bin = NUM_BINS-1;
+  }
+  myLatencyBins[bin] += 1;
+}
+void csModuleProfile::add( csModuleProfile const* profile ) {
+  myNumCalls += profile->myNumCalls;
+  myTimeWall += profile->myTimeWall;
+  myTimeCPU  += profile->myTimeCPU;
+  myNumBytesAllocated += profile->myNumBytesAllocated;
+  setNumBufferedTraces( profile->myMaxNumBufferedTraces );
+  for( int i = 0; i < NUM_BINS; i++ ) {
+    myLatencyBins[i] += profile->myLatencyBins[i];
+  }
+}
+//--------------------------------------------------------------------
+double csModuleProfile::timeBlocked() const {
+  return( myTimeWall > myTimeCPU ? myTimeWall - myTimeCPU : 0.0 );
+}
+double csModuleProfile::latencyMean() const {
+  return( myNumCalls > 0 ? myTimeWall / (double)myNumCalls : 0.0 );
+}
+double csModuleProfile::latencyPercentile( double percentile ) const {
+  if( myNumCalls == 0 ) return 0.0;
+  csInt64_t numCallsBelow = (csInt64_t)ceil( percentile / 100.0 * (double)myNumCalls );
+  csInt64_t count = 0;
+  int bin = 0;
+  for( ; bin < NUM_BINS-1; bin++ ) {
+    count += myLatencyBins[bin];
+    if( count >= numCallsBelow ) break;
+  }
+  return( pow( 2.0, (double)(bin+1) / (double)NUM_BINS_PER_OCTAVE ) * 1.0e-9 );
+}
+//--------------------------------------------------------------------
+void csModuleProfile::addAllocatedBytes( csInt64_t numBytes ) {
+  csModuleProfile* profile = currentProfile();
+  if( profile != NULL ) {
+    profile->myNumBytesAllocated += numBytes;
+  }
+}
+double csModuleProfile::wallTime() {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9 );
+#else
+  struct timeval tv;
+  gettimeofday( &tv, NULL );
+  return( (double)tv.tv_sec + (double)tv.tv_usec * 1.0e-6 );
+#endif
+}
+double csModuleProfile::threadCPUTime() {
+#if defined(PLATFORM_LINUX) || defined(PLATFORM_APPLE)
+  struct timespec ts;
+  clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts );
+  return( (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9 );
+#else
+  return 0.0;
+#endif
+}
@@ -0,0 +1,102 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_MODULE_PROFILE_H
+#define CS_MODULE_PROFILE_H
+
+#include <cstdio>
+#include "geolib/geolib_defines.h"
+
+namespace cseis_system {
+
+/**
+ * Exec phase profile of one module
+ *
+ * Collects wall time, CPU time and latency of every exec phase call, the maximum number of traces buffered by the module,
+ * and the number of bytes of trace samples allocated while the exec phase was running.
+ * Time that the exec phase spent without using the CPU (wall time minus CPU time) is reported as blocked time.
+ * This is mostly time spent waiting for file I/O.
+ *
+ * Latencies are kept in a histogram with logarithmic bins, four bins per factor of two, so that percentiles can be
+ * computed without storing individual values. Percentiles are accurate to within 20%.
+ *
+ * One profile object must only be updated from one thread at a time. Worker threads keep their own profile,
+ * which is added to the module's profile when they have finished, see add().
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csModuleProfile {
+public:
+  /**
+   * Times one exec phase call. The call is recorded when stop() is called, and discarded otherwise,
+   * for example when the exec phase returns early or throws an exception.
+   */
+  class Call {
+  public:
+    Call( csModuleProfile* profile );
+    ~Call();
+    /// Record call in profile. @return wall time of call in seconds
+    double stop();
+  private:
+    csModuleProfile* myProfile;
+    csModuleProfile* myPreviousProfile;
+    double myStartWall;
+    double myStartCPU;
+  };
+
+public:
+  csModuleProfile();
+  ~csModuleProfile();
+  /// Update maximum number of traces buffered by module
+  inline void setNumBufferedTraces( int numTraces ) {
+    if( numTraces > myMaxNumBufferedTraces ) myMaxNumBufferedTraces = numTraces;
+  }
+  /// Add profile of worker thread
+  void add( csModuleProfile const* profile );
+
+  inline csInt64_t numCalls() const { return myNumCalls; }
+  inline double timeWall() const { return myTimeWall; }
+  inline double timeCPU() const { return myTimeCPU; }
+  /// @return Time in exec phase not spent on the CPU, in seconds
+  double timeBlocked() const;
+  /// @return Mean latency of exec phase calls, in seconds
+  double latencyMean() const;
+  /**
+   * @param percentile  Percentile, 0-100
+   * @return Latency of exec phase calls at given percentile, in seconds. Upper edge of histogram bin
+   */
+  double latencyPercentile( double percentile ) const;
+  inline int maxNumBufferedTraces() const { return myMaxNumBufferedTraces; }
+  inline csInt64_t numBytesAllocated() const { return myNumBytesAllocated; }
+
+  /**
+   * Add number of bytes allocated for trace samples to profile of module whose exec phase is currently running in the calling thread.
+   * Called by csMemoryPoolManager.
+   */
+  static void addAllocatedBytes( csInt64_t numBytes );
+  /// @return Current wall clock time in seconds
+  static double wallTime();
+  /// @return CPU time used by calling thread, in seconds. 0 if not supported on this platform
+  static double threadCPUTime();
+
+private:
+  static int const NUM_BINS_PER_OCTAVE = 4;
+  /// Covers latencies from 1ns to about 1 hour
+  static int const NUM_BINS = 42*NUM_BINS_PER_OCTAVE;
+  void addCall( double timeWall, double timeCPU );
+
+  csInt64_t myNumCalls;
+  double myTimeWall;
+  double myTimeCPU;
+  int myMaxNumBufferedTraces;
+  csInt64_t myNumBytesAllocated;
+  /// Histogram of latencies
+  csInt64_t* myLatencyBins;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,65 @@
+
+
+#include "csPipelineEnsembleStage.h"
+#include "csModule.h"
+
+using namespace cseis_system;
+
+csPipelineEnsembleStage::csPipelineEnsembleStage( csPipelineControl* control, csLogWriter* log,
+                                                  cseis_geolib::csVector<csModule*> const* instances, int bufferSize ) :
+  csPipelineReplicaStage( control, log, instances->size(), bufferSize ),
+  myInstances( *instances )
+{
+  myDispatchSeq = 0;
+}
+csPipelineEnsembleStage::~csPipelineEnsembleStage() {
+  join();
+}
+bool csPipelineEnsembleStage::initWorkers() {
+  return( myInstances.size() > 0 );
+}
+//--------------------------------------------------------------------
+// Stage thread
+//
+bool csPipelineEnsembleStage::dispatchInput( csPipelineItem const& item, int inPort ) {
+  // Pass on sequence number before trace is buffered, as in csPipelineStage::runChain()
+  if( item.seq > myDispatchSeq ) {
+    Slot* s = nextFreeSlot();
+    if( s == NULL ) return false;
+    s->seq = item.seq;
+    commitSlot();
+    myDispatchSeq = item.seq;
+  }
+  if( item.trace == NULL ) return true;
+  myModules.at(0)->receiveTrace( item.trace, inPort );
+  return dispatchEnsembles( false );
+}
+bool csPipelineEnsembleStage::dispatchFinish() {
+  return dispatchEnsembles( true );
+}
+bool csPipelineEnsembleStage::dispatchEnsembles( bool forceToRun ) {
+  csModule* module = myModules.at(0);
+  while( module->isReadyToSubmitExec( forceToRun ) ) {
+    Slot* s = nextFreeSlot();
+    if( s == NULL ) return false;
+    module->takeEnsemble( forceToRun, &s->traces );
+    s->seq = myDispatchSeq;
+    s->isLastCall = forceToRun;
+    commitSlot();
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+// Worker threads
+//
+void csPipelineEnsembleStage::processSlot( int workerIndex, Slot& s ) {
+  myInstances.at(workerIndex)->submitExecPhaseEnsemble( &s.traces, &s.outPorts, s.isLastCall, myLog );
+}
+void csPipelineEnsembleStage::finishWorkers() {
+  csModule* module = myModules.at(0);
+  for( int i = 0; i < myInstances.size(); i++ ) {
+    csModule const* instance = myInstances.at(i);
+    module->addReplicaStatistics( instance->numIncomingTraces(), instance->numProcessedTraces(), instance->getProfile() );
+  }
+}
+
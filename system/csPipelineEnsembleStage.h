@@ -0,0 +1,50 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_PIPELINE_ENSEMBLE_STAGE_H
+#define CS_PIPELINE_ENSEMBLE_STAGE_H
+
+#include "csPipelineReplicaStage.h"
+
+namespace cseis_system {
+
+/**
+ * Pipeline stage running several instances of one ensemble module
+ *
+ * The stage thread collects input traces in the module's trace gather, and detects ensemble breaks in the same way
+ * as in serial mode. Every complete ensemble is handed out to a pool of worker threads. Each worker owns a separate
+ * instance of the module, created by a separate call to the module's init phase (see csExecPhaseDef::setThreadSafe()).
+ * Processed ensembles are passed on to the next module strictly in input order.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csPipelineEnsembleStage : public csPipelineReplicaStage {
+public:
+  /**
+   * @param instances   Module instances, one for each worker thread. Must be of the same module as the one added
+   *                    with addModule(), but not the same object.
+   * @param bufferSize  Maximum number of ensembles and sequence markers in reorder buffer
+   */
+  csPipelineEnsembleStage( csPipelineControl* control, csLogWriter* log, cseis_geolib::csVector<csModule*> const* instances, int bufferSize );
+  virtual ~csPipelineEnsembleStage();
+
+protected:
+  virtual bool initWorkers();
+  virtual bool dispatchInput( csPipelineItem const& item, int inPort );
+  virtual bool dispatchFinish();
+  virtual void processSlot( int workerIndex, Slot& slot );
+  virtual void finishWorkers();
+
+private:
+  /// Hand out all complete ensembles from module's trace gather. Return false if stage has been aborted
+  bool dispatchEnsembles( bool forceToRun );
+  cseis_geolib::csVector<csModule*> myInstances;
+  /// Sequence number of last slot that was filled in
+  csInt64_t myDispatchSeq;
+};
+
+} // namespace
+
+#endif
@@ -0,0 +1,304 @@
+
+
+#include "csPipelineReplicaStage.h"
+#include "csModule.h"
+#include "csModuleProfile.h"
+#include "csTrace.h"
+#include "csLogWriter.h"
+#include "geolib/csException.h"
+#include "geolib/csTimeline.h"
+#include <cstdio>
+
+using namespace cseis_system;
+
+namespace cseis_system {
+  /// Worker thread: Processes slots of reorder buffer
+  class csPipelineReplicaStage::Worker : public cseis_geolib::csThread {
+  public:
+    Worker( csPipelineReplicaStage* stage, int workerIndex ) {
+      myStage = stage;
+      myWorkerIndex = workerIndex;
+    }
+    virtual ~Worker() { join(); }
+  protected:
+    virtual void run() { myStage->runWorker( myWorkerIndex ); }
+  private:
+    csPipelineReplicaStage* myStage;
+    int myWorkerIndex;
+  };
+  /// Collector thread: Passes processed traces on in input order
+  class csPipelineReplicaStage::Collector : public cseis_geolib::csThread {
+  public:
+    Collector( csPipelineReplicaStage* stage ) { myStage = stage; }
+    virtual ~Collector() { join(); }
+  protected:
+    virtual void run() { myStage->runCollector(); }
+  private:
+    csPipelineReplicaStage* myStage;
+  };
+}
+
+csPipelineReplicaStage::csPipelineReplicaStage( csPipelineControl* control, csLogWriter* log, int numReplicas, int bufferSize ) :
+  csPipelineStage( control, log )
+{
+  myNumReplicas = numReplicas;
+  myBufferSize  = ( bufferSize > 2*numReplicas ) ? bufferSize : 2*numReplicas;
+  mySlots       = new Slot[myBufferSize];
+  myNextIndex   = 0;
+  myNextWork    = 0;
+  myNextEmit    = 0;
+  myIsInputFinished = false;
+  myIsAborted   = false;
+  myStats       = new WorkerStats[numReplicas];
+  for( int i = 0; i < numReplicas; i++ ) {
+    myStats[i].numTracesIn  = 0;
+    myStats[i].numTracesOut = 0;
+    myStats[i].profile      = new csModuleProfile();
+  }
+}
+csPipelineReplicaStage::~csPipelineReplicaStage() {
+  join();
+  delete [] mySlots;
+  for( int i = 0; i < myNumReplicas; i++ ) {
+    delete myStats[i].profile;
+  }
+  delete [] myStats;
+}
+void csPipelineReplicaStage::abort() {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  myIsAborted = true;
+  myCondWork.broadcast();
+  myCondDone.broadcast();
+  myCondSpace.broadcast();
+}
+//--------------------------------------------------------------------
+// Stage thread: Hand out input items to workers
+//
+void csPipelineReplicaStage::run() {
+  cseis_geolib::csTimeline::setThreadName( std::string("dispatch ") + myModules.at(0)->getName() );
+  cseis_geolib::csVector<Worker*> workers( myNumReplicas );
+  Collector collector( this );
+  bool isStarted = initWorkers();
+  for( int i = 0; isStarted && i < myNumReplicas; i++ ) {
+    Worker* worker = new Worker( this, i );
+    if( worker->start() ) {
+      workers.insertEnd( worker );
+    }
+    else {
+      delete worker;
+      isStarted = false;
+    }
+  }
+  if( !isStarted || !collector.start() ) {
+    myControl->setError( myModuleIndex.at(0), "Cannot create threads for module replicas" );
+  }
+
+  try {
+    csPipelineItem item;
+    int inPort = 0;
+    bool isRunning = true;
+    while( isRunning && !myControl->hasError() && nextInput( item, inPort ) ) {
+      isRunning = dispatchInput( item, inPort );
+    }
+    if( isRunning && !myControl->hasError() ) {
+      dispatchFinish();
+    }
+  }
+  catch( cseis_geolib::csException& e ) {
+    myControl->setError( myModuleIndex.at(0), e.getMessage() );
+  }
+  myMutex.lock();
+  myIsInputFinished = true;
+  myCondWork.broadcast();
+  myCondDone.broadcast();
+  myMutex.unlock();
+
+  for( int i = 0; i < workers.size(); i++ ) {
+    delete workers.at(i);
+  }
+  collector.join();
+  finishWorkers();
+  if( !myControl->hasError() ) {
+    closeOutputs();
+  }
+}
+//--------------------------------------------------------------------
+csPipelineReplicaStage::Slot* csPipelineReplicaStage::nextFreeSlot() {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  while( myNextIndex - myNextEmit >= myBufferSize && !myIsAborted ) {
+    myCondSpace.wait( &myMutex );
+  }
+  if( myIsAborted ) return NULL;
+  // Slot is not visible to workers or collector until committed: Can be filled in without lock
+  Slot* s = &slot( myNextIndex );
+  s->traces.clear();
+  s->outPorts.clear();
+  s->seq = 0;
+  s->inPort = 0;
+  s->isLastCall = false;
+  return s;
+}
+void csPipelineReplicaStage::commitSlot() {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  Slot& s = slot( myNextIndex );
+  myNextIndex += 1;
+  // Sequence markers do not need processing
+  if( s.traces.size() > 0 ) {
+    s.state = SLOT_WAITING;
+    myCondWork.signal();
+  }
+  else {
+    s.state = SLOT_DONE;
+    myCondDone.signal();
+  }
+}
+//--------------------------------------------------------------------
+void csPipelineReplicaStage::runWorker( int workerIndex ) {
+  if( cseis_geolib::csTimeline::isEnabled() ) {
+    char text[32];
+    sprintf( text, "replica %d ", workerIndex+1 );
+    cseis_geolib::csTimeline::setThreadName( text + std::string( myModules.at(0)->getName() ) );
+  }
+  try {
+    while( true ) {
+      myMutex.lock();
+      while( !myIsAborted ) {
+        while( myNextWork < myNextIndex && slot( myNextWork ).state == SLOT_DONE ) {
+          myNextWork += 1;
+        }
+        if( myNextWork < myNextIndex || myIsInputFinished ) break;
+        myCondWork.wait( &myMutex );
+      }
+      if( myIsAborted || myNextWork >= myNextIndex ) {
+        myMutex.unlock();
+        break;
+      }
+      csInt64_t index = myNextWork;
+      myNextWork += 1;
+      Slot& s = slot( index );
+      s.state = SLOT_PROCESSING;
+      myMutex.unlock();
+
+      processSlot( workerIndex, s );
+
+      myMutex.lock();
+      s.state = SLOT_DONE;
+      if( index == myNextEmit ) myCondDone.signal();
+      myMutex.unlock();
+    }
+  }
+  catch( cseis_geolib::csException& e ) {
+    myControl->setError( myModuleIndex.at(0), e.getMessage() );
+  }
+  catch( ... ) {
+    myControl->setError( myModuleIndex.at(0), "Unknown exception" );
+  }
+}
+//--------------------------------------------------------------------
+void csPipelineReplicaStage::runCollector() {
+  cseis_geolib::csTimeline::setThreadName( std::string("collect ") + myModules.at(0)->getName() );
+  try {
+    while( true ) {
+      myMutex.lock();
+      csInt64_t indexEnd = myNextEmit;
+      while( !myIsAborted ) {
+        while( indexEnd < myNextIndex && slot( indexEnd ).state == SLOT_DONE ) {
+          indexEnd += 1;
+        }
+        if( indexEnd > myNextEmit || ( myIsInputFinished && myNextEmit == myNextIndex ) ) break;
+        myCondDone.wait( &myMutex );
+      }
+      bool isFinished = ( myIsAborted || indexEnd == myNextEmit );
+      csInt64_t indexStart = myNextEmit;
+      myMutex.unlock();
+      if( isFinished ) return;
+
+      // Slots are not reused before myNextEmit has been advanced: Can be read without lock
+      for( csInt64_t index = indexStart; index < indexEnd; index++ ) {
+        if( !emitSlot( slot( index ) ) ) return;
+      }
+
+      myMutex.lock();
+      myNextEmit = indexEnd;
+      // Slots that only hold sequence markers are never visited by a worker. Make sure workers do not look at
+      // slots that have already been passed on, as these may be reused for new input
+      if( myNextWork < myNextEmit ) myNextWork = myNextEmit;
+      myCondSpace.signal();
+      myMutex.unlock();
+    }
+  }
+  catch( cseis_geolib::csException& e ) {
+    myControl->setError( myModuleIndex.at(0), e.getMessage() );
+  }
+}
+//--------------------------------------------------------------------
+bool csPipelineReplicaStage::emitSlot( Slot const& s ) {
+  if( s.seq > mySeq ) {
+    mySeq = s.seq;
+    if( !sendMarkers() ) return false;
+  }
+  for( int itrc = 0; itrc < s.traces.size(); itrc++ ) {
+    csTrace* trace = s.traces.at(itrc);
+    if( myIsLastInFlow.at(0) ) {
+      trace->free();
+      continue;
+    }
+    int outPort = s.outPorts.at(itrc);
+    if( outPort >= myOutputs.size() ) {
+      throw( cseis_geolib::csException("ERROR in csRunManager:runExecPhase(): output port number exceeds number of output ports: (module #%d), %d %d %s",
+                                       myModuleIndex.at(0), outPort, myOutputs.size(), myModules.at(0)->getName()) );
+    }
+    Output const& output = myOutputs.at( outPort );
+    if( output.type == OUTPUT_QUEUE ) {
+      OutputQueue& outQueue = myOutputQueues.at( output.queueIndex );
+      csPipelineItem item;
+      item.trace = trace;
+      item.seq   = mySeq;
+      if( !outQueue.queue->push( item ) ) return false;
+      outQueue.lastSeq = mySeq;
+    }
+    else {
+      trace->free();
+    }
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+// Single-trace module
+//
+bool csPipelineReplicaStage::initWorkers() {
+  for( int i = 0; i < myNumReplicas; i++ ) {
+    myEnvs.insertEnd( myModules.at(0)->createExecEnvReplica() );
+  }
+  return true;
+}
+bool csPipelineReplicaStage::dispatchInput( csPipelineItem const& item, int inPort ) {
+  Slot* s = nextFreeSlot();
+  if( s == NULL ) return false;
+  s->seq    = item.seq;
+  s->inPort = inPort;
+  if( item.trace != NULL ) s->traces.insertEnd( item.trace );
+  commitSlot();
+  return true;
+}
+void csPipelineReplicaStage::processSlot( int workerIndex, Slot& s ) {
+  WorkerStats& stats = myStats[workerIndex];
+  csTrace* trace = s.traces.at(0);
+  int outPort = 0;
+  stats.numTracesIn += 1;
+  if( myModules.at(0)->submitExecPhaseReplica( trace, s.inPort, outPort, myEnvs.at(workerIndex), myLog, stats.profile ) ) {
+    s.outPorts.insertEnd( outPort );
+    stats.numTracesOut += 1;
+  }
+  else {
+    s.traces.clear();  // Trace has been removed from flow
+  }
+}
+void csPipelineReplicaStage::finishWorkers() {
+  for( int i = 0; i < myEnvs.size(); i++ ) {
+    csModule::deleteExecEnvReplica( myEnvs.at(i) );
+    myModules.at(0)->addReplicaStatistics( myStats[i].numTracesIn, myStats[i].numTracesOut, myStats[i].profile );
+  }
+  myEnvs.clear();
+}
+
@@ -0,0 +1,123 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_PIPELINE_REPLICA_STAGE_H
+#define CS_PIPELINE_REPLICA_STAGE_H
+
+#include "csPipelineStage.h"
+
+namespace cseis_system {
+
+class csExecPhaseEnv;
+class csModuleProfile;
+
+/**
+ * Pipeline stage running replicas of one single-trace module
+ *
+ * The exec phase of a thread-safe single-trace module (see csExecPhaseDef::setThreadSafe()) is run in a pool
+ * of worker threads, each holding its own copy of the module's exec phase state.
+ * The stage thread hands out input traces to the workers. Every trace gets a sequential index, and processed
+ * traces are collected in a reorder buffer. A separate collector thread passes them on to the next module
+ * strictly in input order, so that the output is identical to running a single copy of the module.
+ *
+ * The reorder buffer has a fixed size: No more traces are handed out while the oldest trace is still being processed.
+ *
+ * Derived classes may hand out other units of work than single traces, see csPipelineEnsembleStage.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csPipelineReplicaStage : public csPipelineStage {
+public:
+  /**
+   * @param numReplicas  Number of worker threads
+   * @param bufferSize   Maximum number of slots in reorder buffer
+   */
+  csPipelineReplicaStage( csPipelineControl* control, csLogWriter* log, int numReplicas, int bufferSize );
+  virtual ~csPipelineReplicaStage();
+  int numReplicas() const { return myNumReplicas; }
+  virtual void abort();
+
+protected:
+  virtual void run();
+
+  /// Slot in reorder buffer: One unit of work, or a sequence marker if list of traces is empty
+  struct Slot {
+    /// Input traces. After processing: Output traces, in output order
+    cseis_geolib::csVector<csTrace*> traces;
+    /// Output port of each output trace
+    cseis_geolib::csVector<int> outPorts;
+    csInt64_t seq;
+    int inPort;
+    bool isLastCall;
+    int state;
+  };
+  static int const SLOT_WAITING = 0;
+  static int const SLOT_PROCESSING = 1;
+  static int const SLOT_DONE = 2;
+
+  /**
+   * Get next free slot in reorder buffer, waiting for space if necessary. Fill in the slot, then call commitSlot().
+   * @return NULL if stage has been aborted
+   */
+  Slot* nextFreeSlot();
+  /// Make slot returned by nextFreeSlot() visible to workers and collector
+  void commitSlot();
+
+  //--------------------------------------------------------------------
+  // Methods that may be overridden by derived classes. Default implementations run a single-trace module.
+  //
+  /// Set up state of all workers before worker threads are started. Return false on error
+  virtual bool initWorkers();
+  /// Hand out one input item, by filling in reorder buffer slots. Return false if stage has been aborted
+  virtual bool dispatchInput( csPipelineItem const& item, int inPort );
+  /// Called after all input items have been handed out. Return false if stage has been aborted
+  virtual bool dispatchFinish() { return true; }
+  /// Process input traces in slot. Called from worker thread with index 'workerIndex'
+  virtual void processSlot( int workerIndex, Slot& slot );
+  /// Clean up state of all workers after worker threads have finished
+  virtual void finishWorkers();
+
+private:
+  class Worker;
+  class Collector;
+  friend class Worker;
+  friend class Collector;
+
+  void runWorker( int workerIndex );
+  void runCollector();
+  /// Pass traces in reorder buffer slot on to next module. Returns false if stage was aborted
+  bool emitSlot( Slot const& slot );
+  inline Slot& slot( csInt64_t index ) { return mySlots[index % myBufferSize]; }
+
+  int myNumReplicas;
+  int myBufferSize;
+  Slot* mySlots;
+  /// Index of next slot to be filled in
+  csInt64_t myNextIndex;
+  /// Index of next slot to be processed by a worker
+  csInt64_t myNextWork;
+  /// Index of next slot to be passed on by the collector
+  csInt64_t myNextEmit;
+  bool myIsInputFinished;
+  bool myIsAborted;
+  cseis_geolib::csMutex myMutex;
+  cseis_geolib::csCondition myCondWork;
+  cseis_geolib::csCondition myCondDone;
+  cseis_geolib::csCondition myCondSpace;
+
+  /// Exec phase state of each worker (single-trace module)
+  cseis_geolib::csVector<csExecPhaseEnv*> myEnvs;
+  /// Statistics of each worker (single-trace module)
+  struct WorkerStats {
+    long numTracesIn;
+    long numTracesOut;
+    csModuleProfile* profile;
+  };
+  WorkerStats* myStats;
+};
+
+} // namespace
+
+#endif
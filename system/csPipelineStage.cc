@@ -0,0 +1,262 @@
+
+
+#include "csPipelineStage.h"
+#include "csModule.h"
+#include "csLogWriter.h"
+#include "geolib/csException.h"
+#include "geolib/csTimeline.h"
+
+using namespace cseis_system;
+
+csPipelineControl::csPipelineControl() {
+  myHasError = 0;
+  myErrorModuleIndex = 0;
+}
+csPipelineControl::~csPipelineControl() {
+}
+void csPipelineControl::addQueue( csPipelineQueue* queue ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  myQueues.insertEnd( queue );
+}
+void csPipelineControl::addStage( csPipelineStage* stage ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  myStages.insertEnd( stage );
+}
+void csPipelineControl::setError( int moduleIndex, char const* message ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  if( hasError() ) return;
+  myErrorModuleIndex = moduleIndex;
+  myErrorMessage     = message;
+  __atomic_store_n( &myHasError, 1, __ATOMIC_RELEASE );
+  for( int i = 0; i < myQueues.size(); i++ ) {
+    myQueues.at(i)->abort();
+  }
+  for( int i = 0; i < myStages.size(); i++ ) {
+    myStages.at(i)->abort();
+  }
+}
+
+//*********************************************************************
+//
+//
+csPipelineStage::csPipelineStage( csPipelineControl* control, csLogWriter* log ) {
+  myControl = control;
+  myLog     = log;
+  mySeq     = 0;
+  myCurrentChainIndex = 0;
+}
+csPipelineStage::~csPipelineStage() {
+  join();
+}
+//--------------------------------------------------------------------
+void csPipelineStage::addModule( csModule* module, int moduleIndex, bool isLastInFlow ) {
+  myModules.insertEnd( module );
+  myModuleIndex.insertEnd( moduleIndex );
+  myIsLastInFlow.insertEnd( isLastInFlow );
+  myFirstOutput.insertEnd( myOutputs.size() );
+}
+void csPipelineStage::addOutputFree() {
+  Output output;
+  output.type       = OUTPUT_FREE;
+  output.inPort     = 0;
+  output.queueIndex = -1;
+  myOutputs.insertEnd( output );
+}
+void csPipelineStage::addOutputNextModule( int inPort ) {
+  Output output;
+  output.type       = OUTPUT_CHAIN;
+  output.inPort     = inPort;
+  output.queueIndex = -1;
+  myOutputs.insertEnd( output );
+}
+void csPipelineStage::addOutputQueue( csPipelineQueue* queue, bool sendMarkers ) {
+  Output output;
+  output.type       = OUTPUT_QUEUE;
+  output.inPort     = 0;
+  output.queueIndex = -1;
+  // Several output ports may lead to the same queue
+  for( int i = 0; i < myOutputQueues.size(); i++ ) {
+    if( myOutputQueues.at(i).queue == queue ) {
+      output.queueIndex = i;
+      break;
+    }
+  }
+  if( output.queueIndex < 0 ) {
+    OutputQueue outQueue;
+    outQueue.queue       = queue;
+    outQueue.sendMarkers = sendMarkers;
+    outQueue.lastSeq     = 0;
+    output.queueIndex = myOutputQueues.insertEnd( outQueue );
+  }
+  myOutputs.insertEnd( output );
+}
+void csPipelineStage::addInput( csPipelineQueue* queue, int inPort ) {
+  // Keep inputs sorted by input port: Lower port wins for equal sequence numbers
+  int index = 0;
+  while( index < myInputPort.size() && myInputPort.at(index) < inPort ) index++;
+  myInputs.insert( queue, index );
+  myInputPort.insert( inPort, index );
+  myIsInputOpen.insert( true, index );
+}
+//--------------------------------------------------------------------
+void csPipelineStage::run() {
+  cseis_geolib::csTimeline::setThreadName( std::string("stage ") + myModules.at(0)->getName() );
+  try {
+    if( myModules.at(0)->getExecType() == EXEC_TYPE_INPUT ) {
+      runInputModule();
+    }
+    else {
+      runChain();
+    }
+  }
+  catch( cseis_geolib::csException& e ) {
+    myControl->setError( myModuleIndex.at(myCurrentChainIndex), e.getMessage() );
+  }
+  catch( ... ) {
+    myControl->setError( myModuleIndex.at(myCurrentChainIndex), "Unknown exception" );
+  }
+}
+//--------------------------------------------------------------------
+void csPipelineStage::runInputModule() {
+  csModule* module = myModules.at(0);
+  while( !myControl->hasError() ) {
+    int outPort = 0;
+    myCurrentChainIndex = 0;
+    if( !module->submitExecPhase( false, myLog, outPort ) ) break;
+    mySeq += 1;
+    if( !sendMarkers() ) return;
+    if( !passTraces( 0, outPort ) ) return;
+  }
+  if( myControl->hasError() ) return;
+  // Input is finished: Traces that are output from now on come after all other traces, as in serial mode
+  mySeq += 1;
+  if( !sendMarkers() ) return;
+  // Force all other modules in chain to run, in flow order
+  for( int i = 1; i < myModules.size(); i++ ) {
+    if( !runModule( i, true ) ) return;
+  }
+  closeOutputs();
+}
+//--------------------------------------------------------------------
+void csPipelineStage::runChain() {
+  csPipelineItem item;
+  int inPort = 0;
+  while( nextInput( item, inPort ) ) {
+    if( item.seq > mySeq ) {
+      mySeq = item.seq;
+      if( !sendMarkers() ) return;
+    }
+    if( item.trace != NULL ) {
+      myCurrentChainIndex = 0;
+      myModules.at(0)->receiveTrace( item.trace, inPort );
+      if( !runModule( 0, false ) ) return;
+    }
+  }
+  if( myControl->hasError() ) return;
+  // All input queues are closed: Force all modules in chain to run, in flow order
+  for( int i = 0; i < myModules.size(); i++ ) {
+    if( !runModule( i, true ) ) return;
+  }
+  closeOutputs();
+}
+//--------------------------------------------------------------------
+bool csPipelineStage::runModule( int chainIndex, bool forceToRun ) {
+  csModule* module = myModules.at(chainIndex);
+  while( true ) {
+    myCurrentChainIndex = chainIndex;
+    if( !module->isReadyToSubmitExec( forceToRun ) ) return true;
+    int outPort = 0;
+    if( module->submitExecPhase( forceToRun, myLog, outPort ) ) {
+      if( !passTraces( chainIndex, outPort ) ) return false;
+    }
+    // else: No trace was output. Continue as long as module has not finished processing
+    if( module->finishedProcessing() ) return true;
+  }
+}
+//--------------------------------------------------------------------
+bool csPipelineStage::passTraces( int chainIndex, int outPort ) {
+  csModule* module = myModules.at(chainIndex);
+  if( myIsLastInFlow.at(chainIndex) ) {
+    module->lastModuleTraceCleanup();
+    return true;
+  }
+  int firstOutput = myFirstOutput.at(chainIndex);
+  int numOutputs  = ( chainIndex+1 < myModules.size() ? myFirstOutput.at(chainIndex+1) : myOutputs.size() ) - firstOutput;
+  if( outPort >= numOutputs ) {
+    throw( cseis_geolib::csException("ERROR in csRunManager:runExecPhase(): output port number exceeds number of output ports: (module #%d), %d %d %s",
+                                     myModuleIndex.at(chainIndex), outPort, numOutputs, module->getName()) );
+  }
+  Output const& output = myOutputs.at( firstOutput + outPort );
+  if( output.type == OUTPUT_FREE ) {
+    module->lastModuleTraceCleanup();
+  }
+  else if( output.type == OUTPUT_CHAIN ) {
+    myModules.at(chainIndex+1)->moveTracesFrom( module, output.inPort );
+    return runModule( chainIndex+1, false );
+  }
+  else {
+    OutputQueue& outQueue = myOutputQueues.at( output.queueIndex );
+    myTraceBuffer.clear();
+    module->removeProcessedTraces( &myTraceBuffer );
+    csPipelineItem item;
+    item.seq = mySeq;
+    for( int itrc = 0; itrc < myTraceBuffer.size(); itrc++ ) {
+      item.trace = myTraceBuffer.at(itrc);
+      if( !outQueue.queue->push( item ) ) return false;
+    }
+    outQueue.lastSeq = mySeq;
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+bool csPipelineStage::nextInput( csPipelineItem& item, int& inPort ) {
+  int numInputs = myInputs.size();
+  if( numInputs == 0 ) {
+    return false;
+  }
+  else if( numInputs == 1 ) {
+    inPort = myInputPort.at(0);
+    return myInputs.at(0)->pop( item );
+  }
+  // Wait for head item of all open inputs, pick the one with the smallest sequence number.
+  // For equal numbers, markers go first, then traces from the lower input port.
+  int indexBest = -1;
+  csPipelineItem itemBest;
+  for( int i = 0; i < numInputs; i++ ) {
+    if( !myIsInputOpen.at(i) ) continue;
+    csPipelineItem head;
+    if( !myInputs.at(i)->front( head ) ) {
+      if( myControl->hasError() ) return false;
+      myIsInputOpen.set( false, i );
+      continue;
+    }
+    if( indexBest < 0 || head.seq < itemBest.seq || ( head.seq == itemBest.seq && head.trace == NULL && itemBest.trace != NULL ) ) {
+      indexBest = i;
+      itemBest  = head;
+    }
+  }
+  if( indexBest < 0 ) return false;
+  inPort = myInputPort.at(indexBest);
+  return myInputs.at(indexBest)->pop( item );
+}
+//--------------------------------------------------------------------
+bool csPipelineStage::sendMarkers() {
+  csPipelineItem item;
+  item.trace = NULL;
+  item.seq   = mySeq;
+  for( int i = 0; i < myOutputQueues.size(); i++ ) {
+    OutputQueue& outQueue = myOutputQueues.at(i);
+    if( outQueue.sendMarkers && outQueue.lastSeq < mySeq ) {
+      if( !outQueue.queue->push( item ) ) return false;
+      outQueue.lastSeq = mySeq;
+    }
+  }
+  return true;
+}
+//--------------------------------------------------------------------
+void csPipelineStage::closeOutputs() {
+  for( int i = 0; i < myOutputQueues.size(); i++ ) {
+    myOutputQueues.at(i).queue->close();
+  }
+}
+
@@ -0,0 +1,164 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+#ifndef CS_PIPELINE_STAGE_H
+#define CS_PIPELINE_STAGE_H
+
+#include <string>
+#include "geolib/geolib_defines.h"
+#include "geolib/csThread.h"
+#include "geolib/csBoundedQueue.h"
+#include "geolib/csVector.h"
+
+namespace cseis_system {
+
+class csModule;
+class csTrace;
+class csLogWriter;
+class csPipelineStage;
+
+/**
+ * Item passed between pipeline stages: One seismic trace, or a sequence marker if trace is NULL.
+ * The sequence number is the number of input traces that had been read in when the item was output,
+ * plus one for items output after all input traces have been read in.
+ * Items on any one queue have non-decreasing sequence numbers.
+ */
+struct csPipelineItem {
+  csTrace* trace;
+  csInt64_t seq;
+};
+
+typedef cseis_geolib::csBoundedQueue<csPipelineItem> csPipelineQueue;
+
+/**
+ * Pipeline control
+ * Shared by all pipeline stages. Records the first error that occurred in any stage, and aborts all queues
+ * so that all other stages stop as well.
+ */
+class csPipelineControl {
+public:
+  csPipelineControl();
+  ~csPipelineControl();
+  /// Add queue that shall be aborted when an error occurs
+  void addQueue( csPipelineQueue* queue );
+  /// Add stage that shall be aborted when an error occurs
+  void addStage( csPipelineStage* stage );
+  /**
+   * Record error and abort all queues and stages. Only the first error is kept.
+   * @param moduleIndex  Index of module in which error occurred
+   */
+  void setError( int moduleIndex, char const* message );
+  bool hasError() const { return( __atomic_load_n( &myHasError, __ATOMIC_ACQUIRE ) != 0 ); }
+  int errorModuleIndex() const { return myErrorModuleIndex; }
+  char const* errorMessage() const { return myErrorMessage.c_str(); }
+private:
+  cseis_geolib::csMutex myMutex;
+  cseis_geolib::csVector<csPipelineQueue*> myQueues;
+  cseis_geolib::csVector<csPipelineStage*> myStages;
+  int myHasError;
+  int myErrorModuleIndex;
+  std::string myErrorMessage;
+};
+
+/**
+ * Pipeline stage
+ *
+ * Runs a linear chain of one or more adjacent modules in its own thread (pipeline exec mode, see csRunManager).
+ * Traces are received from the input queues of the first module in the chain, and passed on to the queues
+ * of modules that run in other stages. Within the chain, traces are moved between modules directly.
+ *
+ * The exec phase of each module is submitted in the same way as in serial mode: A module is run as long as it
+ * is ready to process traces. After all input queues have been closed, all modules in the chain are forced to
+ * run in flow order, to flush out buffered traces. Then the output queues are closed.
+ *
+ * A stage with more than one input queue (for example ENDIF) merges its inputs in order of sequence number,
+ * lower input port first for equal numbers. Only complete heads of all open input queues are compared,
+ * so the merged trace order does not depend on thread timing. Sequence markers keep the merge going when
+ * one branch does not receive any traces.
+ *
+ * @author Bjorn Olofsson
+ * @date 2013
+ */
+class csPipelineStage : public cseis_geolib::csThread {
+public:
+  csPipelineStage( csPipelineControl* control, csLogWriter* log );
+  virtual ~csPipelineStage();
+  /**
+   * Add module to end of chain. Modules must be added in flow order.
+   * The first module of a stage without input queues must be the input module.
+   * @param moduleIndex    Index of module in flow
+   * @param isLastInFlow   true if module is the last module in the flow
+   */
+  void addModule( csModule* module, int moduleIndex, bool isLastInFlow );
+  /// Output port of last added module: Traces are freed
+  void addOutputFree();
+  /// Output port of last added module: Traces are moved to next module in chain, at given input port
+  void addOutputNextModule( int inPort );
+  /**
+   * Output port of last added module: Traces are pushed to queue of module running in a different stage
+   * @param sendMarkers  true if sequence markers shall be sent to this queue
+   */
+  void addOutputQueue( csPipelineQueue* queue, bool sendMarkers );
+  /// Add input queue of first module in chain
+  void addInput( csPipelineQueue* queue, int inPort );
+  int numModules() const { return myModules.size(); }
+  int numInputs() const { return myInputs.size(); }
+  int moduleIndex( int chainIndex ) const { return myModuleIndex.at(chainIndex); }
+  /// Release all threads of this stage that wait for something other than a queue. Called when an error occurred
+  virtual void abort() {}
+
+protected:
+  virtual void run();
+
+  struct Output {
+    int type;
+    int inPort;
+    int queueIndex;
+  };
+  struct OutputQueue {
+    csPipelineQueue* queue;
+    bool sendMarkers;
+    csInt64_t lastSeq;
+  };
+  static int const OUTPUT_FREE  = 0;
+  static int const OUTPUT_CHAIN = 1;
+  static int const OUTPUT_QUEUE = 2;
+
+  void runInputModule();
+  void runChain();
+  /**
+   * Run module as long as it is ready to process traces
+   * @return false if stage has been aborted
+   */
+  bool runModule( int chainIndex, bool forceToRun );
+  /// Pass processed traces to next module or queue
+  bool passTraces( int chainIndex, int outPort );
+  /// Retrieve next input item. For several inputs, select item with smallest sequence number
+  bool nextInput( csPipelineItem& item, int& inPort );
+  bool sendMarkers();
+  void closeOutputs();
+
+  csPipelineControl* myControl;
+  csLogWriter* myLog;
+  cseis_geolib::csVector<csModule*> myModules;
+  cseis_geolib::csVector<int> myModuleIndex;
+  cseis_geolib::csVector<bool> myIsLastInFlow;
+  /// Index of first output of each module in chain
+  cseis_geolib::csVector<int> myFirstOutput;
+  cseis_geolib::csVector<Output> myOutputs;
+  cseis_geolib::csVector<OutputQueue> myOutputQueues;
+  cseis_geolib::csVector<csPipelineQueue*> myInputs;
+  cseis_geolib::csVector<int> myInputPort;
+  cseis_geolib::csVector<bool> myIsInputOpen;
+  /// Buffer for traces passed to output queues
+  cseis_geolib::csVector<csTrace*> myTraceBuffer;
+  /// Current sequence number: Largest sequence number received so far
+  csInt64_t mySeq;
+  /// Chain index of module that is currently run, for error reporting
+  int myCurrentChainIndex;
+};
+
+} // namespace
+
+#endif
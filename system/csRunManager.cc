@@ -12,12 +12,18 @@
 #include "csSuperHeader.h"
 #include "csMemoryPoolManager.h"
 #include "csLogWriter.h"
+#include "csPipelineStage.h"
+#include "csPipelineReplicaStage.h"
+#include "csPipelineEnsembleStage.h"
+#include "csModuleProfile.h"
+#include "geolib/csTimeline.h"
 #include "geolib/csTimer.h"
 #include "csMethodRetriever.h"
 
 #include <stdarg.h>
 #include <ctime>
 #include <cstring>
+#include <algorithm>
 
 // cseis : Geolib
 #include "geolib/csException.h"
@@ -37,6 +43,7 @@ csRunManager::csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug ) {
   myIsDebug = isDebug;
   myLog     = log;
   myModules = NULL;
+  myModuleInstances = NULL;
   myNumModules = 0;
   myNextModuleID = NULL;
   myPrevModuleID = NULL;
@@ -44,6 +51,9 @@ csRunManager::csRunManager( csLogWriter* log, int memoryPolicy, bool isDebug ) {
   myTimerCPU = new cseis_geolib::csTimer();
   myTables = NULL;
   myNumTables = 0;
+  myNumThreads = 1;
+  myNumReplicas = 1;
+  myBatchSize = 1;
 }
 csRunManager::~csRunManager() {
   if( myTables != NULL ) {
@@ -53,6 +63,7 @@ csRunManager::~csRunManager() {
     delete [] myTables;
     myTables = NULL;
   }
+  deleteModuleInstances();
   if( myModules != NULL ) {
     for( int imodule = 0; imodule < myNumModules; imodule++ ) {
       if( myModules[imodule] != NULL ) {
@@ -90,6 +101,7 @@ csRunManager::~csRunManager() {
 //
 int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_geolib::csCompareVector<cseis_system::csUserConstant>* globalConstList ) {
   myTimerCPU->start();
+  deleteModuleInstances();
   if( myModules != NULL ) {
     for( int imodule = 0; imodule < myNumModules; imodule++ ) {
       if( myModules[imodule] != NULL ) {
@@ -446,28 +458,27 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
   }
 
   //----------------------------
-  if( myIsDebug ) {
+  if( myLog->isLevelEnabled( csLogWriter::LEVEL_DEBUG ) ) {
     for( int imodule = 0; imodule < myNumModules; imodule++ ) {
       csModule* module = modules[imodule];
+      std::string prevText;
+      for( int i = 0; i < myPrevModuleID[imodule]->size(); i++ ) {
+        char text[32];
+        sprintf( text, " (%2d)", myPrevModuleID[imodule]->at(i)+1 );
+        prevText += text;
+      }
       if( myNextModuleID[imodule]->size() == 1 ) {
-        myLog->write("Module %14s:  this(%2d),  next(%2d),   prev: ",
-                     module->getName(), imodule+1, myNextModuleID[imodule]->at(0)+1 );
+        myLog->debug("Module %14s:  this(%2d),  next(%2d),   prev: %s",
+                     module->getName(), imodule+1, myNextModuleID[imodule]->at(0)+1, prevText.c_str() );
       }
       else if( myNextModuleID[imodule]->size() == 2 ) {  // Max 2 output ports
-        myLog->write("\nModule %14s:  this(%2d),  next1(%2d)  next2(%d), prev: ",
-                     module->getName(), imodule+1, myNextModuleID[imodule]->at(0)+1, myNextModuleID[imodule]->at(1)+1 );
+        myLog->debug("Module %14s:  this(%2d),  next1(%2d)  next2(%d), prev: %s",
+                     module->getName(), imodule+1, myNextModuleID[imodule]->at(0)+1, myNextModuleID[imodule]->at(1)+1, prevText.c_str() );
       }
       else {
-        myLog->write("Module %14s:  this(%2d):     prev: ",
-                     module->getName(), imodule+1 );
+        myLog->debug("Module %14s:  this(%2d):     prev: %s",
+                     module->getName(), imodule+1, prevText.c_str() );
       }
-      for( int i = 0; i < myPrevModuleID[imodule]->size(); i++ ) {
-        myLog->write(" (%2d)", myPrevModuleID[imodule]->at(i)+1 );
-      }
-      //for( int i = 0; i < module->getNumPrevModules(); i++ ) {
-      //  myLog->write(" (%2d)", module->getPrevModuleIndex(i)+1 );
-      //}
-      myLog->line("");
     }
   }
   
@@ -480,6 +491,10 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
 
   cseis_geolib::csVector<csModule const*> prevModuleList;
   cseis_geolib::csVector<csModule const*> uniqModuleList;  // List of unique modules in current flow
+  myModuleInstances = new cseis_geolib::csVector<csModule*>*[myNumModules];
+  for( int imodule = 0; imodule < myNumModules; imodule++ ) {
+    myModuleInstances[imodule] = NULL;
+  }
 
   for( int imodule = 0; imodule < myNumModules; imodule++ ) {
     csModule* module = modules[imodule];
@@ -522,6 +537,9 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
         throw( cseis_geolib::csException("Error occurred while checking module parameters. See log file for details.") );
       }
       module->submitInitPhase( &paramManager, myLog, myTables, myNumTables );
+      if( myNumReplicas > 1 && module->isEnsembleReplicable() ) {
+        createModuleInstances( imodule, userParamList[imodule], &prevModuleList );
+      }
 
       if( module->getExecType() == EXEC_TYPE_INPUT && imodule != 0 ) {
         myLog->error( module->getName(), imodule, "Only the first module in the flow can be an INPUT module." );
@@ -542,6 +560,7 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
         module = modules[imod2];
         // myLog->line("Run CLEANUP phase for module  #%-5d %s...", imod2+1, module->getName() );
         module->submitCleanupPhase( myLog );
+        submitCleanupPhaseInstances( imod2 );
       }
       for( int imod2 = 0; imod2 < myNumModules; imod2++ ) {
         for( int i = 0; i < userParamList[imod2]->size(); i++ ) {
@@ -661,7 +680,14 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
                  modules[iModule]->getHeaderDef()->numHeaders());
   }
   double timeCPUAll = myTimerCPU->getElapsedTime();
-  myLog->line( "\nInit phase processing time:  %12.6f seconds\n\n", timeCPUAll );
+  int numLibraries = 0;
+  int numSymbols   = 0;
+  int numCacheHits = 0;
+  double timeResolve = 0.0;
+  csMethodRetriever::getStatistics( numLibraries, numSymbols, numCacheHits, timeResolve );
+  myLog->line( "\nModule resolution: %d libraries opened, %d methods looked up, %d requests served from cache, %.3f ms",
+               numLibraries, numSymbols, numCacheHits, timeResolve*1000.0 );
+  myLog->line( "Init phase processing time:  %12.6f seconds\n\n", timeCPUAll );
 
   return 0;
 }
@@ -671,33 +697,247 @@ int csRunManager::runInitPhase( char const* filenameFlow, FILE* f_flow, cseis_ge
 // Exec phase processing loop
 //
 //
+void csRunManager::setNumThreads( int numThreads ) {
+  myNumThreads = numThreads;
+}
+void csRunManager::setNumReplicas( int numReplicas ) {
+  myNumReplicas = numReplicas;
+}
+void csRunManager::setBatchSize( int batchSize ) {
+  myBatchSize = std::max( batchSize, 1 );
+}
+void csRunManager::setMaxNumMegabytes( int maxNumMegabytes ) {
+  myMemoryPoolManager->setMaxNumMegabytes( maxNumMegabytes );
+}
+void csRunManager::setSpillDirectory( std::string const& directory ) {
+  myMemoryPoolManager->setSpillDirectory( directory );
+}
+void csRunManager::setProfileFilename( std::string const& filename ) {
+  myProfileFilename = filename;
+}
+void csRunManager::setTimelineFilename( std::string const& filename ) {
+  myTimelineFilename = filename;
+}
+//-------------------------------------------------------------------
+//
+void csRunManager::createModuleInstances( int imodule, cseis_geolib::csVector<csUserParam*>* userParams,
+                                          cseis_geolib::csVector<csModule const*> const* prevModuleList ) {
+  csModule const* module = myModules[imodule];
+  // Init phase output of module instances is identical to the one of the original module
+  csLogWriter silentLog( (FILE*)NULL );
+  myLog->line("Create %d instances of module #%d %s for parallel ensemble processing", myNumReplicas, imodule+1, module->getName() );
+  myModuleInstances[imodule] = new cseis_geolib::csVector<csModule*>( myNumReplicas );
+  for( int i = 0; i < myNumReplicas; i++ ) {
+    csModule* instance = new csModule( *module->getNameString(), imodule, myMemoryPoolManager );
+    myModuleInstances[imodule]->insertEnd( instance );
+    csParamManager paramManager( userParams, &silentLog );
+    if( paramManager.exists( "debug" ) ) {
+      instance->setDebugFlag( true );
+    }
+    if( paramManager.exists( "version" ) ) {
+      std::string versionString;
+      paramManager.getString( "version", &versionString );
+      int major = 0;
+      int minor = 0;
+      parseVersionString( versionString, major, minor );
+      instance->setVersion( major, minor );
+    }
+    instance->setInputPorts( prevModuleList );
+    instance->submitInitPhase( &paramManager, &silentLog, myTables, myNumTables );
+  }
+}
+bool csRunManager::submitCleanupPhaseInstances( int imodule ) {
+  bool success = true;
+  if( myModuleInstances == NULL || myModuleInstances[imodule] == NULL ) return success;
+  for( int i = 0; i < myModuleInstances[imodule]->size(); i++ ) {
+    if( !myModuleInstances[imodule]->at(i)->submitCleanupPhase( myLog ) ) success = false;
+  }
+  return success;
+}
+void csRunManager::deleteModuleInstances() {
+  if( myModuleInstances == NULL ) return;
+  for( int imodule = 0; imodule < myNumModules; imodule++ ) {
+    if( myModuleInstances[imodule] != NULL ) {
+      for( int i = 0; i < myModuleInstances[imodule]->size(); i++ ) {
+        delete myModuleInstances[imodule]->at(i);
+      }
+      delete myModuleInstances[imodule];
+    }
+  }
+  delete [] myModuleInstances;
+  myModuleInstances = NULL;
+}
+//--------------------------------------------------------------------
+void csRunManager::dumpProfile( double timeTotal ) {
+  myLog->line( "Exec phase profile\n" );
+  myLog->line( "  #  Module                 Wall time    CPU time     Blocked    Traces/s  Mean lat[ms]  p99 lat[ms]  Max buffered  Alloc[MB]" );
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    csModule const* module = myModules[iModule];
+    csModuleProfile const* profile = module->getProfile();
+    // Input modules do not have incoming traces
+    long numTraces = std::max( module->numIncomingTraces(), module->numProcessedTraces() );
+    double tracesPerSecond = ( profile->timeWall() > 0.0 ) ? (double)numTraces / profile->timeWall() : 0.0;
+    myLog->line( "%3d  %-19s %12.3f %11.3f %11.3f %11.0f %13.4f %12.4f %13d %10.2f", iModule+1, module->getName(),
+                 profile->timeWall(), profile->timeCPU(), profile->timeBlocked(), tracesPerSecond,
+                 profile->latencyMean()*1000.0, profile->latencyPercentile( 99.0 )*1000.0,
+                 profile->maxNumBufferedTraces(), (double)profile->numBytesAllocated()/(1024.0*1024.0) );
+  }
+  myLog->line( "\n------------------------------------------------------------\n" );
+  if( !myProfileFilename.empty() && !writeProfileJSON( timeTotal ) ) {
+    myLog->warning( "Cannot write exec phase profile to file '%s'", myProfileFilename.c_str() );
+  }
+}
+bool csRunManager::writeProfileJSON( double timeTotal ) {
+  FILE* fout = fopen( myProfileFilename.c_str(), "w" );
+  if( fout == NULL ) return false;
+  fprintf( fout, "{\n" );
+  fprintf( fout, "  \"totalTime\": %.6f,\n", timeTotal );
+  fprintf( fout, "  \"numThreads\": %d,\n", myNumThreads );
+  fprintf( fout, "  \"numReplicas\": %d,\n", myNumReplicas );
+  fprintf( fout, "  \"maxBytesAllocated\": %lld,\n", (long long)myMemoryPoolManager->maxNumBytesAllocated() );
+  fprintf( fout, "  \"modules\": [\n" );
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    csModule const* module = myModules[iModule];
+    csModuleProfile const* profile = module->getProfile();
+    // Input modules do not have incoming traces
+    long numTraces = std::max( module->numIncomingTraces(), module->numProcessedTraces() );
+    double tracesPerSecond = ( profile->timeWall() > 0.0 ) ? (double)numTraces / profile->timeWall() : 0.0;
+    // Module names only consist of letters, digits and underscores: No need to escape
+    fprintf( fout, "    { \"index\": %d, \"name\": \"%s\", \"tracesIn\": %ld, \"tracesOut\": %ld, \"calls\": %lld,\n",
+             iModule+1, module->getName(), module->numIncomingTraces(), module->numProcessedTraces(), (long long)profile->numCalls() );
+    fprintf( fout, "      \"wallTime\": %.6f, \"cpuTime\": %.6f, \"blockedTime\": %.6f, \"tracesPerSecond\": %.3f,\n",
+             profile->timeWall(), profile->timeCPU(), profile->timeBlocked(), tracesPerSecond );
+    fprintf( fout, "      \"latencyMean\": %.9f, \"latencyP99\": %.9f, \"maxBufferedTraces\": %d, \"bytesAllocated\": %lld }%s\n",
+             profile->latencyMean(), profile->latencyPercentile( 99.0 ), profile->maxNumBufferedTraces(),
+             (long long)profile->numBytesAllocated(), ( iModule < myNumModules-1 ) ? "," : "" );
+  }
+  fprintf( fout, "  ]\n" );
+  fprintf( fout, "}\n" );
+  return( fclose( fout ) == 0 );
+}
+//--------------------------------------------------------------------
 int csRunManager::runExecPhase() {
   csModule** modules = myModules;
 
   int returnFlag = 0;
 
-  int indexLastModule  = myNumModules-1;
-  cseis_geolib::csModuleIndexStack stack_moduleIndex( myNumModules+1 );
-
   myLog->line( "\n================================================================================\n" );
   myLog->line( "Run exec phase...\n" );
 
   if( myIsDebug ) fprintf(stdout,"--------------------------------------\n\n");
 
   myLog->flush();
+
+  if( !myTimelineFilename.empty() ) {
+    cseis_geolib::csTimeline::enable();
+    cseis_geolib::csTimeline::setThreadName( "main" );
+  }
+
+  if( ( myNumThreads != 1 || myNumReplicas > 1 ) && myNumModules > 1 && modules[0]->getExecType() == EXEC_TYPE_INPUT ) {
+    runExecPhasePipeline();
+  }
+  else {
+    runExecPhaseSerial();
+  }
+
+  // Run cleanup phase. Cleaning up allocated memory in modules
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    if( !myModules[iModule]->submitCleanupPhase( myLog ) || !submitCleanupPhaseInstances( iModule ) ) {
+      myLog->line("Error occurred during cleanup phase of module #%d %s\n", iModule+1, myModules[iModule]->getName() );
+      returnFlag = 22;
+    }
+  }
+  //
+  //
+  // END Exec processing loop
+  //
+  //***********************************************************************
+
+
+  //----------------------------------------------------------------------
+  // Dump exec phase info
+  //
+  myLog->line( "\n------------------------------------------------------------" );
+  myLog->line( "Exec phase summary\n" );
+  myLog->line( "  #  Module                Traces in  Traces out     CPU time   CPU time all" );
+
+  double timeCPUExecAll = 0.0;
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    csModule* module = modules[iModule];
+    double timeCPU  = module->getExecPhaseCPUTime();
+    timeCPUExecAll += timeCPU;
+    myLog->line( "%3d  %-19s %11d %11d %12.3f   %12.3f", iModule+1, module->getName(),
+                 module->numIncomingTraces(), module->numProcessedTraces(), timeCPU, timeCPUExecAll );
+  }
+  myLog->line( "\n------------------------------------------------------------\n" );
+
+  double timeTotal = myTimerCPU->getElapsedTime();
+  dumpProfile( timeTotal );
+
+  if( !myTimelineFilename.empty() ) {
+    cseis_geolib::csTimeline::disable();
+    if( !cseis_geolib::csTimeline::writeJSON( myTimelineFilename ) ) {
+      myLog->warning( "Cannot write exec phase timeline to file '%s'", myTimelineFilename.c_str() );
+    }
+    else if( cseis_geolib::csTimeline::numDroppedEvents() > 0 ) {
+      myLog->line( " Exec phase timeline: %lld oldest events were dropped because the event buffer was full\n",
+                   (long long)cseis_geolib::csTimeline::numDroppedEvents() );
+    }
+  }
+
+  time_t timer = time(NULL);
+  myLog->line( " Total processing time:  %12.6f seconds\n", timeTotal );
+  myLog->line( " Date: %s\n", asctime(localtime(&timer)) );
+  myLog->line( " Trace allocation summary:");
+  myMemoryPoolManager->dumpSummary( myLog->getFile() );
+  myLog->line( "\n");
+  myLog->line( "\n End of log." );  
+  myLog->line( "================================================================================" );
+
+  return returnFlag;
+}
+//--------------------------------------------------------------------
+void csRunManager::runExecPhaseSerial() {
+  csModule** modules = myModules;
+
+  int indexLastModule  = myNumModules-1;
+  cseis_geolib::csModuleIndexStack stack_moduleIndex( myNumModules+1 );
+
   int iModule = 0;
   
   try {
     bool isInputFinished = false;
     if( modules[0]->getExecType() != EXEC_TYPE_INPUT ) isInputFinished = true;
+    bool isInputExhausted = false;
+    // Traces that are handed on in blocks may reach a merging module (ENDIF, ENDSPLIT) in a different order
+    // than when handed on one by one. Keep to single traces for flows with branches, to keep the output trace order.
+    int batchSize = myBatchSize;
+    for( int i = 0; i < myNumModules; i++ ) {
+      if( myNextModuleID[i]->size() > 1 || myPrevModuleID[i]->size() > 1 ) batchSize = 1;
+    }
+    if( batchSize != myBatchSize ) {
+      myLog->line("Flow contains branches: Traces are handed from module to module one by one instead of in blocks of %d traces", myBatchSize);
+    }
+    for( int i = 1; i < myNumModules; i++ ) {
+      modules[i]->setBatchSize( batchSize );
+    }
     //---------------------------------------------------------------------
     // BIG LOOP FOR ALL INPUT TRACES
     //
     while( !isInputFinished ) {
-      // STEP (1) Read in input trace. If none is read in, set isInputFinished = true. No trace will be passed on.
+      // STEP (1) Read in up to batchSize input traces. If none is read in, set isInputFinished = true. No trace will be passed on.
       int outPort = 0;
       iModule = myNumModules;
-      if( modules[0]->submitExecPhase( isInputFinished, myLog, outPort ) ) {  // Successful submission of exec phase
+      int numTracesRead = 0;
+      while( !isInputExhausted && numTracesRead < batchSize ) {
+        if( modules[0]->submitExecPhase( isInputFinished, myLog, outPort ) ) {
+          numTracesRead += 1;
+        }
+        else {  // Do not call input module again once it has returned no trace
+          isInputExhausted = true;
+        }
+      }
+      if( numTracesRead > 0 ) {  // Successful submission of exec phase
         if( myNextModuleID[0]->size() > 0 ) {  // Only move on traces if Input module is not the only (=last) module in flow
           iModule = myNextModuleID[0]->at(0);
           modules[iModule]->moveTracesFrom( modules[0], outPort );
@@ -814,48 +1054,199 @@ int csRunManager::runExecPhase() {
   //  catch(...) {
   //  printf("Unknown exception occurred\n");
   // }
+}
+//--------------------------------------------------------------------
+// Pipeline mode: Modules are grouped into stages, each stage runs in its own thread.
+// Stages are connected by trace queues, one queue for each input port of a receiving module.
+//
+void csRunManager::runExecPhasePipeline() {
+  csModule** modules = myModules;
+  int maxNumStages = ( myNumThreads > 0 ) ? myNumThreads : myNumModules;
 
-  // Run cleanup phase. Cleaning up allocated memory in modules
+  //----------------------------------------------------------------------
+  // (1) Group adjacent modules into stages. A module can only join the stage of the previous module if
+  //     the two are connected one-to-one. Merge the two smallest neighbouring stages until the number
+  //     of stages does not exceed the number of threads.
+  //     Replicated modules always run in a stage of their own.
+  bool* isReplicated = new bool[myNumModules];
+  bool* canJoinPrev  = new bool[myNumModules];
+  bool* isStageStart = new bool[myNumModules];
+  int numReplicated = 0;
   for( int iModule = 0; iModule < myNumModules; iModule++ ) {
-    if( !myModules[iModule]->submitCleanupPhase( myLog ) ) {
-      myLog->line("Error occurred during cleanup phase of module #%d %s\n", iModule+1, myModules[iModule]->getName() );
-      returnFlag = 22;
+    isReplicated[iModule] = ( myNumReplicas > 1 && ( modules[iModule]->isReplicable() || myModuleInstances[iModule] != NULL ) );
+    if( isReplicated[iModule] ) numReplicated += 1;
+  }
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    canJoinPrev[iModule] = ( iModule > 0 && !isReplicated[iModule] && !isReplicated[iModule-1] &&
+                             myNextModuleID[iModule-1]->size() == 1 && myNextModuleID[iModule-1]->at(0) == iModule &&
+                             myPrevModuleID[iModule]->size() == 1 && myPrevModuleID[iModule]->at(0) == iModule-1 );
+    isStageStart[iModule] = true;
+  }
+  int numStages = myNumModules;
+  while( numStages-numReplicated > maxNumStages ) {
+    int startBest = -1;
+    int sizeBest  = 0;
+    int startPrev = 0;
+    for( int iModule = 1; iModule < myNumModules; iModule++ ) {
+      if( !isStageStart[iModule] ) continue;
+      if( canJoinPrev[iModule] ) {
+        int endStage = iModule+1;
+        while( endStage < myNumModules && !isStageStart[endStage] ) endStage++;
+        if( startBest < 0 || endStage-startPrev < sizeBest ) {
+          startBest = iModule;
+          sizeBest  = endStage-startPrev;
+        }
+      }
+      startPrev = iModule;
     }
+    if( startBest < 0 ) break;  // Flow branches too often, use more threads than requested
+    isStageStart[startBest] = false;
+    numStages -= 1;
+  }
+  int* stageIndex = new int[myNumModules];
+  for( int iModule = 0, iStage = -1; iModule < myNumModules; iModule++ ) {
+    if( isStageStart[iModule] ) iStage += 1;
+    stageIndex[iModule] = iStage;
   }
-  //
-  //
-  // END Exec processing loop
-  //
-  //***********************************************************************
-
 
   //----------------------------------------------------------------------
-  // Dump exec phase info
-  //
-  myLog->line( "\n------------------------------------------------------------" );
-  myLog->line( "Exec phase summary\n" );
-  myLog->line( "  #  Module                Traces in  Traces out     CPU time   CPU time all" );
+  // (2) Queues between stages
+  cseis_geolib::csVector<csPipelineQueue*> queues;
+  cseis_geolib::csVector<int> queueModuleFrom;
+  cseis_geolib::csVector<int> queueModuleTo;
+  cseis_geolib::csVector<int> queueInPort;
+  int* numStageInputs = new int[numStages];
+  for( int iStage = 0; iStage < numStages; iStage++ ) {
+    numStageInputs[iStage] = 0;
+  }
+  for( int iModule = 0; iModule < myNumModules-1; iModule++ ) {
+    for( int outPort = 0; outPort < myNextModuleID[iModule]->size(); outPort++ ) {
+      int nextModuleID = myNextModuleID[iModule]->at(outPort);
+      if( nextModuleID >= myNumModules || stageIndex[nextModuleID] == stageIndex[iModule] ) continue;
+      int inPort = 0;
+      while( myPrevModuleID[nextModuleID]->at(inPort) != iModule ) {  // Search matching input port
+        inPort++;
+      }
+      bool queueExists = false;
+      for( int iq = 0; iq < queues.size(); iq++ ) {
+        if( queueModuleTo.at(iq) == nextModuleID && queueInPort.at(iq) == inPort ) queueExists = true;
+      }
+      if( queueExists ) continue;
+      queues.insertEnd( new csPipelineQueue( PIPELINE_QUEUE_SIZE ) );
+      queueModuleFrom.insertEnd( iModule );
+      queueModuleTo.insertEnd( nextModuleID );
+      queueInPort.insertEnd( inPort );
+      numStageInputs[stageIndex[nextModuleID]] += 1;
+    }
+  }
+  // Sequence markers are only required on the way to stages that merge several inputs
+  bool* leadsToMerge = new bool[numStages];
+  for( int iStage = numStages-1; iStage >= 0; iStage-- ) {
+    leadsToMerge[iStage] = ( numStageInputs[iStage] > 1 );
+    for( int iq = 0; iq < queues.size(); iq++ ) {
+      int stageTo = stageIndex[queueModuleTo.at(iq)];
+      if( stageIndex[queueModuleFrom.at(iq)] == iStage && ( stageTo <= iStage || leadsToMerge[stageTo] ) ) {
+        leadsToMerge[iStage] = true;
+      }
+    }
+  }
 
-  double timeCPUExecAll = 0.0;
+  //----------------------------------------------------------------------
+  // (3) Set up stages
+  csPipelineControl control;
+  cseis_geolib::csVector<csPipelineStage*> stages( numStages );
   for( int iModule = 0; iModule < myNumModules; iModule++ ) {
-    csModule* module = modules[iModule];
-    double timeCPU  = module->getExecPhaseCPUTime();
-    timeCPUExecAll += timeCPU;
-    myLog->line( "%3d  %-19s %11d %11d %12.3f   %12.3f", iModule+1, module->getName(),
-                 module->numIncomingTraces(), module->numProcessedTraces(), timeCPU, timeCPUExecAll );
+    if( !isStageStart[iModule] ) continue;
+    csPipelineStage* stage = NULL;
+    if( myNumReplicas > 1 && myModuleInstances[iModule] != NULL ) {
+      stage = new csPipelineEnsembleStage( &control, myLog, myModuleInstances[iModule], PIPELINE_QUEUE_SIZE );
+    }
+    else if( isReplicated[iModule] ) {
+      stage = new csPipelineReplicaStage( &control, myLog, myNumReplicas, PIPELINE_QUEUE_SIZE );
+    }
+    else {
+      stage = new csPipelineStage( &control, myLog );
+    }
+    stages.insertEnd( stage );
+    control.addStage( stage );
+  }
+  for( int iModule = 0; iModule < myNumModules; iModule++ ) {
+    csPipelineStage* stage = stages.at( stageIndex[iModule] );
+    bool isLastModule = ( iModule == myNumModules-1 );
+    stage->addModule( modules[iModule], iModule, isLastModule );
+    if( isLastModule ) continue;
+    for( int outPort = 0; outPort < myNextModuleID[iModule]->size(); outPort++ ) {
+      int nextModuleID = myNextModuleID[iModule]->at(outPort);
+      if( nextModuleID >= myNumModules ) {
+        stage->addOutputFree();
+        continue;
+      }
+      int inPort = 0;
+      while( myPrevModuleID[nextModuleID]->at(inPort) != iModule ) {
+        inPort++;
+      }
+      if( stageIndex[nextModuleID] == stageIndex[iModule] ) {
+        stage->addOutputNextModule( inPort );
+      }
+      else {
+        for( int iq = 0; iq < queues.size(); iq++ ) {
+          if( queueModuleTo.at(iq) == nextModuleID && queueInPort.at(iq) == inPort ) {
+            stage->addOutputQueue( queues.at(iq), leadsToMerge[stageIndex[nextModuleID]] );
+            break;
+          }
+        }
+      }
+    }
+  }
+  for( int iq = 0; iq < queues.size(); iq++ ) {
+    stages.at( stageIndex[queueModuleTo.at(iq)] )->addInput( queues.at(iq), queueInPort.at(iq) );
+    control.addQueue( queues.at(iq) );
   }
-  myLog->line( "\n------------------------------------------------------------\n" );
-  
-  time_t timer = time(NULL);
-  myLog->line( " Total processing time:  %12.6f seconds\n", myTimerCPU->getElapsedTime() );
-  myLog->line( " Date: %s\n", asctime(localtime(&timer)) );
-  myLog->line( " Trace allocation summary:");
-  myMemoryPoolManager->dumpSummary( myLog->getFile() );
-  myLog->line( "\n");
-  myLog->line( "\n End of log." );  
-  myLog->line( "================================================================================" );
 
-  return returnFlag;
+  myLog->line( "Pipeline exec mode: %d threads, trace queue size %d\n", numStages, PIPELINE_QUEUE_SIZE );
+  for( int iStage = 0; iStage < numStages; iStage++ ) {
+    csPipelineStage* stage = stages.at(iStage);
+    myLog->write( "  Thread %2d:", iStage+1 );
+    for( int i = 0; i < stage->numModules(); i++ ) {
+      int iModule = stage->moduleIndex(i);
+      myLog->write( "  #%d %s", iModule+1, modules[iModule]->getName() );
+      if( isReplicated[iModule] ) myLog->write( "  (%d replicas)", myNumReplicas );
+    }
+    myLog->line( "" );
+  }
+  myLog->line( "" );
+  myLog->flush();
+
+  //----------------------------------------------------------------------
+  // (4) Run all stages, wait until all are finished
+  for( int iStage = 0; iStage < numStages; iStage++ ) {
+    if( !stages.at(iStage)->start() ) {
+      control.setError( stages.at(iStage)->moduleIndex(0), "Cannot create thread for pipeline exec mode" );
+      break;
+    }
+  }
+  for( int iStage = 0; iStage < numStages; iStage++ ) {
+    stages.at(iStage)->join();
+    delete stages.at(iStage);
+  }
+  for( int iq = 0; iq < queues.size(); iq++ ) {
+    delete queues.at(iq);
+  }
+  delete [] isReplicated;
+  delete [] canJoinPrev;
+  delete [] isStageStart;
+  delete [] stageIndex;
+  delete [] numStageInputs;
+  delete [] leadsToMerge;
+
+  if( control.hasError() ) {
+    int iModule = control.errorModuleIndex();
+    fprintf(stderr,"\nException caught while running exec phase, module #%2d %s. System message: \n%s\n",
+            iModule+1, myModules[iModule]->getName(), control.errorMessage());
+    myLog->line("\nException caught while running exec phase, module #%2d %s. System message: \n%s",
+                iModule+1, myModules[iModule]->getName(), control.errorMessage());
+    exit( -1 );
+  }
 }
 //**********************************************************************
 //
@@ -75,13 +75,86 @@ public:
   * Run execution phase for all modules
   */
   int runExecPhase();
+  /**
+  * Set number of threads used in execution phase
+  *
+  * @param numThreads  1: Run all modules in one thread (default). Deterministic mode, use for debugging.
+  *                   >1: Pipeline mode: Run modules in separate threads, connected by trace queues.
+  *                       Adjacent modules are grouped together if there are more modules than threads.
+  *                    0: Pipeline mode, one thread per module
+  */
+  void setNumThreads( int numThreads );
+  /**
+  * Set number of replicas of thread-safe single-trace and ensemble modules
+  * Modules that declare their exec phase thread-safe (see csExecPhaseDef::setThreadSafe()) are run in their own pipeline stage,
+  * with this number of worker threads processing traces in parallel. Single-trace modules process one trace at a time in each thread,
+  * ensemble modules one complete ensemble, using a separate module instance for each thread. Trace order is preserved.
+  * Replica threads are not counted in the number of threads set in setNumThreads().
+  * Call this method before runInitPhase(): Module instances are created in the init phase.
+  *
+  * @param numReplicas  1: No replication (default). >1: Run exec phase in the given number of threads.
+  */
+  void setNumReplicas( int numReplicas );
+  /**
+  * Set number of traces handed from module to module at once in serial mode, see csModule::setBatchSize()
+  * @param batchSize  1: Hand over traces one by one (default)
+  */
+  void setBatchSize( int batchSize );
+  /**
+  * Set maximum memory held by traces, see csMemoryPoolManager::setMaxNumMegabytes()
+  */
+  void setMaxNumMegabytes( int maxNumMegabytes );
+  /**
+  * Enable spilling of buffered traces to disk when the maximum memory is exceeded, see csMemoryPoolManager::setSpillDirectory()
+  * @param directory  Scratch directory in which spill file shall be created
+  */
+  void setSpillDirectory( std::string const& directory );
+  /**
+  * Write exec phase profile of all modules to file in JSON format, in addition to the profile written to the log
+  * @param filename  Name of JSON file
+  */
+  void setProfileFilename( std::string const& filename );
+  /**
+  * Record timeline of exec phase, and write it to file in Chrome trace event format, see cseis_geolib::csTimeline
+  * @param filename  Name of JSON file
+  */
+  void setTimelineFilename( std::string const& filename );
 private:
   csRunManager(csRunManager const& obj);
+  /// Run exec phase in current thread
+  void runExecPhaseSerial();
+  /// Run exec phase in pipeline mode
+  void runExecPhasePipeline();
+  /**
+  * Create and initialise module instances for running ensemble module in several threads
+  * @param imodule         Index of module, after init phase of this module has been run
+  * @param userParams      User parameters of module
+  * @param prevModuleList  Input port modules
+  */
+  void createModuleInstances( int imodule, cseis_geolib::csVector<csUserParam*>* userParams, cseis_geolib::csVector<csModule const*> const* prevModuleList );
+  /// Run cleanup phase of all module instances
+  bool submitCleanupPhaseInstances( int imodule );
+  void deleteModuleInstances();
+  /// Write exec phase profile of all modules to log, and to JSON file if set
+  void dumpProfile( double timeTotal );
+  bool writeProfileJSON( double timeTotal );
+  /// Maximum number of traces (and sequence markers) buffered between two modules in pipeline mode
+  static int const PIPELINE_QUEUE_SIZE = 64;
+  int myNumThreads;
+  int myNumReplicas;
+  /// Number of traces handed from module to module at once, in serial mode
+  int myBatchSize;
+  /// Name of JSON file for exec phase profile. Empty if not set
+  std::string myProfileFilename;
+  /// Name of JSON file for exec phase timeline. Empty if not set
+  std::string myTimelineFilename;
   csLogWriter* myLog;
   cseis_geolib::csTable const** myTables;
   int myNumTables;
   /// Array of pointers to all modules in one flow
   csModule** myModules;
+  /// Array of lists of additional module instances, for ensemble modules run in several threads. NULL for all other modules
+  cseis_geolib::csVector<csModule*>** myModuleInstances;
   /// Array of lists that hold module ID of the next successive module(s)
   cseis_geolib::csVector<int>** myNextModuleID;
   cseis_geolib::csVector<int>** myPrevModuleID;
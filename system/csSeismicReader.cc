@@ -13,16 +13,19 @@
 #include "geolib/csFlexHeader.h"
 #include "geolib/csIOSelection.h"
 #include <string>
+#include <cstring>
 
 using namespace cseis_system;
 
 csSeismicReader::csSeismicReader( std::string filename, int numTraces ) {
   bool enableRandomAccess = false;
+  myFilename = filename;
   myReader = cseis_io::csSeismicReader_ver::createReaderObject( filename, enableRandomAccess, numTraces );
   init();
 }
 
 csSeismicReader::csSeismicReader( std::string filename, bool enableRandomAccess, int numTraces ) {
+  myFilename = filename;
   myReader = cseis_io::csSeismicReader_ver::createReaderObject( filename, enableRandomAccess, numTraces );
   init();
 }
@@ -33,6 +36,8 @@ void csSeismicReader::init() {
   myHdrCheckType       = cseis_geolib::TYPE_UNKNOWN;
   myHdrCheckByteSize   = 0;
   myHdrCheckBuffer     = NULL;
+  myHdrCheckBlockBuffer    = NULL;
+  myHdrCheckBlockNumTraces = 0;
   myTrcHdrDef          = NULL;
   myIOSelection        = NULL;
 }
@@ -50,6 +55,10 @@ csSeismicReader::~csSeismicReader() {
     delete [] myHdrCheckBuffer;
     myHdrCheckBuffer = NULL;
   }
+  if( myHdrCheckBlockBuffer != NULL ) {
+    delete [] myHdrCheckBlockBuffer;
+    myHdrCheckBlockBuffer = NULL;
+  }
 }
 //--------------------------------------------------------------------
 bool csSeismicReader::readFileHeader( csSuperHeader* shdr, csTraceHeaderDef* hdef, int* hdrValueBlockSize, std::FILE* stream ) {
@@ -155,6 +164,11 @@ bool csSeismicReader::setHeaderToPeek( std::string const& headerName ) {
     myHdrCheckBuffer = NULL;
   }
   myHdrCheckBuffer = new char[myHdrCheckByteSize];
+  if( myHdrCheckBlockBuffer != NULL ) {
+    delete [] myHdrCheckBlockBuffer;
+    myHdrCheckBlockBuffer = NULL;
+  }
+  myHdrCheckBlockNumTraces = 0;
   return true;
 }
 
@@ -170,23 +184,56 @@ bool csSeismicReader::peekHeaderValue( cseis_geolib::csFlexHeader* hdrValue, int
     success = myReader->peek( myHdrCheckByteOffset, myHdrCheckByteSize, myHdrCheckBuffer, traceIndex );
   }
   if( !success ) return false;
+  setHdrCheckValue( myHdrCheckBuffer, hdrValue );
+  return true;
+}
+bool csSeismicReader::peekHeaderValues( cseis_geolib::csFlexHeader* hdrValues, int firstTraceIndex, int numTraces ) {
+  if( myHdrCheckBuffer == NULL ) {
+    throw( cseis_geolib::csException("csSeismicReader::peekHeaderValues: No header has been set for checking. This is a program bug in the calling function") );
+  }
+  if( numTraces > myHdrCheckBlockNumTraces ) {
+    if( myHdrCheckBlockBuffer != NULL ) delete [] myHdrCheckBlockBuffer;
+    myHdrCheckBlockBuffer    = new char[numTraces*myHdrCheckByteSize];
+    myHdrCheckBlockNumTraces = numTraces;
+  }
+  if( !myReader->peekBlock( myHdrCheckByteOffset, myHdrCheckByteSize, myHdrCheckBlockBuffer, firstTraceIndex, numTraces ) ) return false;
+  for( int itrc = 0; itrc < numTraces; itrc++ ) {
+    setHdrCheckValue( &myHdrCheckBlockBuffer[itrc*myHdrCheckByteSize], &hdrValues[itrc] );
+  }
+  return true;
+}
+void csSeismicReader::setHdrCheckValue( char const* buffer, cseis_geolib::csFlexHeader* hdrValue ) const {
   if( myHdrCheckType == cseis_geolib::TYPE_FLOAT ) {
-    float value = *(reinterpret_cast<float*>( myHdrCheckBuffer ));    
+    float value;
+    memcpy( &value, buffer, sizeof(float) );
     hdrValue->setFloatValue( value );
   }
   else if( myHdrCheckType == cseis_geolib::TYPE_INT ) {
-    int value = *(reinterpret_cast<int*>( myHdrCheckBuffer ));
+    int value;
+    memcpy( &value, buffer, sizeof(int) );
     hdrValue->setIntValue( value );
   }
   else if( myHdrCheckType == cseis_geolib::TYPE_DOUBLE ) {
-    double value = *(reinterpret_cast<double*>( myHdrCheckBuffer ));
+    double value;
+    memcpy( &value, buffer, sizeof(double) );
     hdrValue->setDoubleValue( value );
   }
   else if( myHdrCheckType == cseis_geolib::TYPE_STRING ) {
-    std::string text = std::string( myHdrCheckBuffer );
+    std::string text = std::string( buffer, strnlen( buffer, myHdrCheckByteSize ) );
     hdrValue->setStringValue( text );
   }
-  return true;
+}
+cseis_geolib::csIReader* csSeismicReader::createScanReader() const {
+  if( myTrcHdrDef == NULL ) return NULL;
+  csSeismicReader* reader = new csSeismicReader( myFilename, true, 1 );
+  cseis_io::csSeismicIOConfig config;
+  if( !reader->myReader->readFileHeader( &config ) ) {
+    delete reader;
+    return NULL;
+  }
+  reader->myNumTraces = config.numTraces;
+  reader->myTrcHdrDef = myTrcHdrDef;
+  return reader;
 }
 int csSeismicReader::numTracesCapacity() const {
   if( myReader == NULL ) return 0;
@@ -207,9 +254,13 @@ int csSeismicReader::numSamples() const {
 }
 
 bool csSeismicReader::setSelection( std::string const& hdrValueSelectionText, std::string const& headerName,
-                                    int sortOrder, int sortMethod )
+                                    int sortOrder, int sortMethod, bool useHeaderIndex, int numThreads )
 {
   myIOSelection = new cseis_geolib::csIOSelection( headerName, sortOrder, sortMethod );
+  myIOSelection->setNumThreads( numThreads );
+  if( useHeaderIndex ) {
+    return myIOSelection->initialize( this, hdrValueSelectionText, myFilename );
+  }
   return myIOSelection->initialize( this, hdrValueSelectionText );
 }
 
@@ -56,8 +56,11 @@ public:
    * @param headerName  Header name to select/sort on
    * @param sortOrder   csIOSelection::SORT_NONE, SORT_INCREASING, or SORT_DECREASING
    * @param sortMethod  csSortManager::SIMPLE_SORT or csSortManager::TREE_SORT
+   * @param useHeaderIndex  true if persistent header index file shall be used (and created if necessary), see csHeaderIndex
+   * @param numThreads  Number of threads used to scan trace headers
    */
-  bool setSelection( std::string const& hdrValueSelectionText, std::string const& headerName, int sortOrder, int sortMethod );
+  bool setSelection( std::string const& hdrValueSelectionText, std::string const& headerName, int sortOrder, int sortMethod,
+                     bool useHeaderIndex = false, int numThreads = 1 );
   /**
   * Read all header information.
   * The 'file' header is the one at the front of the seismic data file, giving information on...see arguments
@@ -100,6 +103,19 @@ public:
    * @return false     if something went wrong.
    */
   bool peekHeaderValue( cseis_geolib::csFlexHeader* hdrValue, int traceIndex = -1 );
+  /**
+   * Peek header values of a contiguous block of traces, using large sequential reads
+   * @param hdrValues       (o) Header values, one for each trace
+   * @param firstTraceIndex (i) Index of first trace in block
+   * @param numTraces       (i) Number of traces in block
+   * @return false     if something went wrong.
+   */
+  bool peekHeaderValues( cseis_geolib::csFlexHeader* hdrValues, int firstTraceIndex, int numTraces );
+  /**
+   * Create independent reader on the same file, for concurrent header scans.
+   * The new reader shares this reader's trace header definition.
+   */
+  cseis_geolib::csIReader* createScanReader() const;
   /** 
    * @return Number of traces in file
    */
@@ -126,13 +142,18 @@ public:
 
 private:
   void init();
+  void setHdrCheckValue( char const* buffer, cseis_geolib::csFlexHeader* hdrValue ) const;
   cseis_io::csSeismicReader_ver* myReader;
+  std::string myFilename;
   int myNumTraces;
   /// Header to check. 
   int  myHdrCheckByteOffset;
   cseis_geolib::type_t myHdrCheckType;
   int    myHdrCheckByteSize;
   char* myHdrCheckBuffer;
+  /// Buffer for block peeks
+  char* myHdrCheckBlockBuffer;
+  int   myHdrCheckBlockNumTraces;
   cseis_system::csTraceHeaderDef const* myTrcHdrDef;  // Pointer only, do not free!
   cseis_geolib::csIOSelection* myIOSelection;
 };
@@ -105,5 +105,12 @@ bool csSeismicWriter::writeTrace( float* samples, char const* hdrValueBlock ) {
     return myWriter->writeTrace( samples, myHdrTempBuffer );
   }
 }
+//--------------------------------------------------------------------
+void csSeismicWriter::setAsyncMode( int numBuffers ) {
+  myWriter->setAsyncMode( numBuffers );
+}
+bool csSeismicWriter::close() {
+  return myWriter->close();
+}
 
 
@@ -52,6 +52,16 @@ public:
    * @param hdrValueBlock (i) Buffer holding all trace header values in the format defined in the trace header definition
    */
   bool writeTrace( float* samples, char const* hdrValueBlock );
+  /**
+   * Compress and write traces in a background thread. See csSeismicWriter_ver::setAsyncMode()
+   * @param numBuffers  Number of rotating trace buffers (>= 2)
+   */
+  void setAsyncMode( int numBuffers );
+  /**
+   * Flush all buffered traces and close file
+   * @return false if an error occurred when writing buffered traces
+   */
+  bool close();
 
 private:
   cseis_io::csSeismicWriter_ver* myWriter;
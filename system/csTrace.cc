@@ -16,7 +16,10 @@ csTrace::csTrace( csTracePool* const tracePoolPtr ) :
   myIdentNumber( myIdentCounter++ )
 {
   myTraceHeader = new csTraceHeader();
-  myData        = new csTraceData();
+  myData        = new csTraceData( tracePoolPtr->myDataAllocator );
+  myPoolIndex     = -1;
+  myIsFree        = false;
+  myNextFreeTrace = NULL;
 }
 //---------------------------------------------------------
 csTrace::csTrace() :
@@ -25,6 +28,9 @@ csTrace::csTrace() :
 {
   myTraceHeader = new csTraceHeader();
   myData        = new csTraceData();
+  myPoolIndex     = -1;
+  myIsFree        = false;
+  myNextFreeTrace = NULL;
 }
 //---------------------------------------------------------
 csTrace::~csTrace() {
@@ -65,8 +71,10 @@ int csTrace::numHeaders() const {
 //--------------------------------------------------
 void csTrace::free() {
   if( myTracePoolPtr != NULL ) {
-    myTracePoolPtr->freeTrace( this );
+    // Clear header before trace is handed back: Another thread may retrieve it from the pool right away
     myTraceHeader->clear();
+    myData->discardSpilledSamples();
+    myTracePoolPtr->freeTrace( this );
   }
   else {  // TEMP
     throw cseis_geolib::csException("csTrace: ERROR, pool pointer is NULL");
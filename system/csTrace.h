@@ -73,6 +73,14 @@ public:
   int const myIdentNumber;
   /// Sequential trace counter
   static int myIdentCounter;
+private:
+  friend class csTracePool;
+  /// Index of trace in trace pool
+  int myPoolIndex;
+  /// true if trace is currently not in use
+  bool myIsFree;
+  /// Next trace in trace pool's list of free traces
+  csTrace* myNextFreeTrace;
 };
 
 } // namespace
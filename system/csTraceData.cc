@@ -1,6 +1,8 @@
 
 
 #include "csTraceData.h"
+#include "csTraceDataAllocator.h"
+#include "csTraceSpillFile.h"
 #include "geolib/csException.h"
 #include <string>
 #include <cstdio>
@@ -12,52 +14,108 @@ csTraceData::csTraceData() {
   myNumSamples = 0;
   myNumAllocatedSamples = 0;
   myDataSamples = NULL;
+  myAllocator = NULL;
+  mySpillFile = NULL;
+  mySpillOffset = 0;
+  myDoTrimOnNextCall = false;
+}
+csTraceData::csTraceData( csTraceDataAllocator* allocator ) {
+  myNumSamples = 0;
+  myNumAllocatedSamples = 0;
+  myDataSamples = NULL;
+  myAllocator = allocator;
+  mySpillFile = NULL;
+  mySpillOffset = 0;
   myDoTrimOnNextCall = false;
 }
 csTraceData::csTraceData( int numSamples ) {
   myNumSamples = numSamples;
-  myNumAllocatedSamples = numSamples;
-  myDataSamples = new float[myNumAllocatedSamples];
+  myNumAllocatedSamples = csTraceDataAllocator::paddedNumSamples( numSamples );
+  myDataSamples = csTraceDataAllocator::allocateAligned( myNumAllocatedSamples );
+  myAllocator = NULL;
+  mySpillFile = NULL;
+  mySpillOffset = 0;
   myDoTrimOnNextCall = false;
 }
 csTraceData::~csTraceData() {
+  discardSpilledSamples();
+  releaseSamples();
+}
+void csTraceData::releaseSamples() {
   if( myDataSamples ) {
-    delete [] myDataSamples;
+    if( myAllocator != NULL ) {
+      myAllocator->release( myDataSamples, myNumAllocatedSamples );
+    }
+    else {
+      csTraceDataAllocator::releaseAligned( myDataSamples );
+    }
     myDataSamples = NULL;
   }
 }
 //---------------------------------------------------------------------------
 //
+void csTraceData::spillSamples( csTraceSpillFile* spillFile ) {
+  if( mySpillFile != NULL || myDataSamples == NULL ) return;
+  mySpillOffset = spillFile->write( myDataSamples, myNumSamples );
+  mySpillFile = spillFile;
+  releaseSamples();
+  myNumAllocatedSamples = 0;
+}
+void csTraceData::restoreSamples() {
+  csTraceSpillFile* spillFile = mySpillFile;
+  mySpillFile = NULL;
+  if( myAllocator != NULL ) {
+    myDataSamples = myAllocator->allocate( myNumSamples, myNumAllocatedSamples );
+  }
+  else {
+    myNumAllocatedSamples = csTraceDataAllocator::paddedNumSamples( myNumSamples );
+    myDataSamples = csTraceDataAllocator::allocateAligned( myNumAllocatedSamples );
+  }
+  spillFile->read( mySpillOffset, myDataSamples, myNumSamples );
+}
+void csTraceData::discardSpilledSamples() {
+  if( mySpillFile != NULL ) {
+    mySpillFile->release( mySpillOffset, myNumSamples );
+    mySpillFile = NULL;
+    myNumSamples = 0;
+  }
+}
+//---------------------------------------------------------------------------
+//
 void csTraceData::setData( csTraceData const* data ) {
   if( myNumSamples != data->myNumSamples ) {
     // BUGFIX 080630: Previously, no check was made whether this data object had the same number of samples. This lead to data objects with 0 numSamples etc.
     set( data->myNumSamples );
   }
-  setData( data->myDataSamples, data->myNumSamples );
+  // Samples of source trace may have been spilled to disk
+  setData( const_cast<csTraceData*>( data )->getSamples(), data->myNumSamples );
 }
 void csTraceData::setData( float const* samples, int nSamples ) {
-  memcpy( myDataSamples, samples, std::min(nSamples,myNumSamples)*sizeof(float) );
+  memcpy( getSamples(), samples, std::min(nSamples,myNumSamples)*sizeof(float) );
 }
 void csTraceData::trim() {
   //  printf("---Trimmed from %d to %d samples\n", myNumAllocatedSamples, myNumSamples );
   myDoTrimOnNextCall = true;
 }
 void csTraceData::set( int numSamplesNew, int firstLiveSample ) {
+  if( mySpillFile != NULL ) restoreSamples();
   //  if( myDoTrimOnNextCall ) printf("Trimmed from %d to %d to %d samples\n", myNumAllocatedSamples, myNumSamples, numSamplesNew );
   if( numSamplesNew > myNumAllocatedSamples || myDoTrimOnNextCall ) {
     float* dataNew = NULL;
-    try {
-      dataNew = new float[numSamplesNew];
+    int numAllocatedSamplesNew = 0;
+    if( myAllocator != NULL ) {
+      dataNew = myAllocator->allocate( numSamplesNew, numAllocatedSamplesNew );
     }
-    catch(...) {
-      throw( cseis_geolib::csException("csTraceData::set: Unable to allocate new trace data buffer. Out of memory.") );
+    else {
+      numAllocatedSamplesNew = csTraceDataAllocator::paddedNumSamples( numSamplesNew );
+      dataNew = csTraceDataAllocator::allocateAligned( numAllocatedSamplesNew );
     }
     if( myDataSamples ) {
       memcpy( dataNew, myDataSamples, std::min( myNumSamples, numSamplesNew )*sizeof(float) );
-      delete [] myDataSamples;
+      releaseSamples();
     }
     myDataSamples = dataNew;
-    myNumAllocatedSamples = numSamplesNew;
+    myNumAllocatedSamples = numAllocatedSamplesNew;
     myNumSamples = numSamplesNew;
     myDoTrimOnNextCall = false;
   }
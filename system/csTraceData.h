@@ -7,14 +7,22 @@
 #define CS_TRACE_DATA_H
 
 #include <cstdlib>
+#include "geolib/geolib_defines.h"
 #include "geolib/csException.h"
 
 namespace cseis_system {
 
+class csTraceDataAllocator;
+class csTraceSpillFile;
+
 /**
 * Trace samples/trace data
 *
 * Manages seismic trace samples for one trace
+* Sample buffers of traces retrieved from the memory pool are provided by a csTraceDataAllocator: They are 64-byte
+* aligned, and padded to a multiple of 16 samples.
+* Samples of buffered traces may be spilled to disk (see csMemoryPoolManager::setSpillDirectory()). They are read
+* back in transparently on the next access.
 *
 * @author Bjorn Olofsson
 * @date   2007
@@ -23,9 +31,16 @@ class csTraceData {
 public:
   csTraceData();
   csTraceData( int numSamples );
+  /**
+  * @param allocator  Allocator for sample buffers. NULL: Buffers are allocated directly
+  */
+  csTraceData( csTraceDataAllocator* allocator );
   ~csTraceData();
   /// Return data samples
-  inline float* getSamples() { return myDataSamples; }
+  inline float* getSamples() {
+    if( mySpillFile != NULL ) restoreSamples();
+    return myDataSamples;
+  }
   /// Return number of samples
   inline int numSamples() const { return myNumSamples; }
   /// Return number of samples
@@ -38,15 +53,23 @@ public:
   void setData( float const* samples, int nSamples );
   inline float& operator [] ( int index ) {  // May throw exception
     if( index >= 0 && index < myNumSamples ) {
-      return myDataSamples[index];
+      return getSamples()[index];
     }
     throw cseis_geolib::csException("Wrong sample index passed to trace");
   }
   void trim();
+  /// @return true if samples are currently held in spill file
+  inline bool isSpilled() const { return mySpillFile != NULL; }
   friend class csMemoryPoolManager;
   friend class csModule;
+  friend class csTrace;
 private:
   float* myDataSamples;
+  csTraceDataAllocator* myAllocator;
+  /// Spill file holding samples, or NULL if samples are held in memory
+  csTraceSpillFile* mySpillFile;
+  /// Byte offset of samples in spill file
+  csInt64_t mySpillOffset;
   int myNumSamples;
   int myNumAllocatedSamples;
   bool myDoTrimOnNextCall;
@@ -59,6 +82,13 @@ private:
     set( numSamplesNew, 0 );
   }
   void set( int numSamplesNew, int firstLiveSample );
+  void releaseSamples();
+  /// Write samples to spill file, and release sample buffer
+  void spillSamples( csTraceSpillFile* spillFile );
+  /// Read spilled samples back into memory
+  void restoreSamples();
+  /// Drop spilled samples. Called when trace is handed back to trace pool
+  void discardSpilledSamples();
 };
 
 } // namespace
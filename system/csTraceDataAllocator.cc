@@ -0,0 +1,120 @@
+
+
+#include <cstring>
+#include <algorithm>
+#include "csTraceDataAllocator.h"
+#include "csMemoryPoolManager.h"
+#include "geolib/csException.h"
+
+using namespace cseis_system;
+
+csTraceDataAllocator::csTraceDataAllocator( int policy ) {
+  myPolicy           = policy;
+  myNumBytesInUse    = 0;
+  myMaxNumBytesInUse = 0;
+  myNumRequests      = 0;
+  myNumReusedBuffers = 0;
+}
+csTraceDataAllocator::~csTraceDataAllocator() {
+  for( int i = 0; i < mySizeClasses.size(); i++ ) {
+    SizeClass* sc = mySizeClasses.at(i);
+    while( sc->firstFreeBuffer != NULL ) {
+      float* buffer = sc->firstFreeBuffer;
+      memcpy( &sc->firstFreeBuffer, buffer, sizeof(float*) );
+      releaseAligned( buffer );
+    }
+    delete sc;
+  }
+  mySizeClasses.clear();
+}
+//----------------------------------------------------
+float* csTraceDataAllocator::allocateAligned( int numAllocatedSamples ) {
+  // Reserve room in front of the aligned buffer to keep a pointer to the original allocation
+  size_t numBytes = (size_t)numAllocatedSamples * sizeof(float) + ALIGNMENT + sizeof(char*);
+  char* bufferAlloc = NULL;
+  try {
+    bufferAlloc = new char[numBytes];
+  }
+  catch(...) {
+    throw( cseis_geolib::csException("csTraceDataAllocator: Unable to allocate new trace data buffer. Out of memory.") );
+  }
+  char* buffer = bufferAlloc + sizeof(char*);
+  size_t misalignment = (size_t)buffer % ALIGNMENT;
+  if( misalignment != 0 ) buffer += ALIGNMENT - misalignment;
+  memcpy( buffer - sizeof(char*), &bufferAlloc, sizeof(char*) );
+  return reinterpret_cast<float*>( buffer );
+}
+void csTraceDataAllocator::releaseAligned( float* samples ) {
+  char* bufferAlloc;
+  memcpy( &bufferAlloc, reinterpret_cast<char*>( samples ) - sizeof(char*), sizeof(char*) );
+  delete [] bufferAlloc;
+}
+//----------------------------------------------------
+csTraceDataAllocator::SizeClass* csTraceDataAllocator::sizeClass( int numAllocatedSamples ) {
+  for( int i = 0; i < mySizeClasses.size(); i++ ) {
+    if( mySizeClasses.at(i)->numSamples == numAllocatedSamples ) return mySizeClasses.at(i);
+  }
+  SizeClass* sc = new SizeClass();
+  sc->numSamples      = numAllocatedSamples;
+  sc->firstFreeBuffer = NULL;
+  sc->numFreeBuffers  = 0;
+  mySizeClasses.insertEnd( sc );
+  return sc;
+}
+float* csTraceDataAllocator::allocate( int numSamples, int& numAllocatedSamples ) {
+  numAllocatedSamples = paddedNumSamples( std::max( numSamples, 1 ) );
+  float* buffer = NULL;
+  {
+    cseis_geolib::csMutexLock lock( &myMutex );
+    myNumRequests += 1;
+    myNumBytesInUse += (csInt64_t)numAllocatedSamples * sizeof(float);
+    if( myNumBytesInUse > myMaxNumBytesInUse ) myMaxNumBytesInUse = myNumBytesInUse;
+    SizeClass* sc = sizeClass( numAllocatedSamples );
+    if( sc->firstFreeBuffer != NULL ) {
+      buffer = sc->firstFreeBuffer;
+      memcpy( &sc->firstFreeBuffer, buffer, sizeof(float*) );
+      sc->numFreeBuffers -= 1;
+      myNumReusedBuffers += 1;
+      return buffer;
+    }
+  }
+  try {
+    buffer = allocateAligned( numAllocatedSamples );
+  }
+  catch(...) {
+    cseis_geolib::csMutexLock lock( &myMutex );
+    myNumBytesInUse -= (csInt64_t)numAllocatedSamples * sizeof(float);
+    throw;
+  }
+  return buffer;
+}
+void csTraceDataAllocator::release( float* samples, int numAllocatedSamples ) {
+  {
+    cseis_geolib::csMutexLock lock( &myMutex );
+    myNumBytesInUse -= (csInt64_t)numAllocatedSamples * sizeof(float);
+    if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) {
+      SizeClass* sc = sizeClass( numAllocatedSamples );
+      memcpy( samples, &sc->firstFreeBuffer, sizeof(float*) );
+      sc->firstFreeBuffer = samples;
+      sc->numFreeBuffers += 1;
+      return;
+    }
+  }
+  releaseAligned( samples );
+}
+//----------------------------------------------------
+csInt64_t csTraceDataAllocator::numBytesInUse() {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  return myNumBytesInUse;
+}
+csInt64_t csTraceDataAllocator::maxNumBytesInUse() {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  return myMaxNumBytesInUse;
+}
+void csTraceDataAllocator::dumpSummary( FILE* fout ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  double reuseRate = 0.0;
+  if( myNumRequests > 0 ) reuseRate = 100.0 * (double)myNumReusedBuffers / (double)myNumRequests;
+  fprintf( fout," Trace data: %lld buffer requests, %.2f%% served by re-used buffers, %d size classes\n",
+           (long long)myNumRequests, reuseRate, mySizeClasses.size() );
+}
@@ -0,0 +1,94 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_TRACE_DATA_ALLOCATOR_H
+#define CS_TRACE_DATA_ALLOCATOR_H
+
+#include <cstdio>
+#include "geolib/geolib_defines.h"
+#include "geolib/csThread.h"
+#include "geolib/csVector.h"
+
+namespace cseis_system {
+
+/**
+* Allocator for trace sample buffers
+*
+* Sample buffers are 64-byte aligned, and their length is padded to a multiple of 64 bytes (16 samples).
+* Vectorised code may therefore process a full trace in blocks of 16 samples without special treatment of
+* the first or last samples. Padding samples are not initialised.
+*
+* Buffers are grouped in size classes, by padded length. Within one flow, nearly all traces have the same
+* number of samples, so only very few size classes are in use. Buffers that are released are kept in a list
+* of free buffers of their size class, and are handed out again for the next request of the same size class.
+* With memory pool policy POLICY_MEMORY, released buffers are returned to the system right away instead.
+*
+* The allocator keeps track of the number of bytes held in sample buffers. csMemoryPoolManager subtracts the
+* buffers kept by free traces in the trace pool, and checks the result against the maximum memory allowed.
+*
+* Buffers may be allocated and released from different threads.
+*
+* @author Bjorn Olofsson
+* @date   2013
+*/
+class csTraceDataAllocator {
+public:
+  static int const ALIGNMENT = 64;
+  static int const PADDING   = ALIGNMENT / sizeof(float);
+
+public:
+  csTraceDataAllocator( int policy );
+  ~csTraceDataAllocator();
+  /**
+  * Allocate sample buffer
+  * @param numSamples           Minimum number of samples
+  * @param numAllocatedSamples  (o) Number of samples that fit into buffer, after padding
+  * @return pointer to sample buffer
+  */
+  float* allocate( int numSamples, int& numAllocatedSamples );
+  /**
+  * Release sample buffer
+  * @param samples              Sample buffer returned by allocate()
+  * @param numAllocatedSamples  Number of allocated samples, as returned by allocate()
+  */
+  void release( float* samples, int numAllocatedSamples );
+  /// @return Number of bytes currently held in sample buffers, not including free buffers
+  csInt64_t numBytesInUse();
+  /// @return Maximum number of bytes held in sample buffers at one time
+  csInt64_t maxNumBytesInUse();
+  void dumpSummary( FILE* fout );
+
+  /// Padded number of samples
+  static inline int paddedNumSamples( int numSamples ) {
+    return( ( numSamples + PADDING - 1 ) / PADDING ) * PADDING;
+  }
+  /// Allocate sample buffer from system, without size class or byte accounting
+  static float* allocateAligned( int numAllocatedSamples );
+  /// Release sample buffer returned by allocateAligned()
+  static void releaseAligned( float* samples );
+
+private:
+  csTraceDataAllocator( csTraceDataAllocator const& obj );
+  struct SizeClass {
+    /// Padded number of samples of all buffers in this size class
+    int numSamples;
+    /// First free buffer. The list is linked through the buffers themselves
+    float* firstFreeBuffer;
+    int numFreeBuffers;
+  };
+  SizeClass* sizeClass( int numAllocatedSamples );
+
+  /// Memory pool policy: Optimised for speed or memory usage
+  int myPolicy;
+  cseis_geolib::csVector<SizeClass*> mySizeClasses;
+  csInt64_t myNumBytesInUse;
+  csInt64_t myMaxNumBytesInUse;
+  csInt64_t myNumRequests;
+  csInt64_t myNumReusedBuffers;
+  cseis_geolib::csMutex myMutex;
+};
+
+} // namespace
+#endif
@@ -53,6 +53,7 @@ void csTraceHeader::setTraceHeaderValueBlock( char const* hdrValueBlock, int byt
     fprintf(stderr,"csTraceHeader::setTraceHeaderValueBlock: Byte size error: %d > %d\n", byteSize, myTraceHeaderData->myNumBytes );
     throw( cseis_geolib::csException("csTraceHeader::setTraceHeaderValueBlock: Program bug. Incorrect byte size.") );
   }
+  myTraceHeaderData->detach();
   memcpy( myTraceHeaderData->myValueBlock, hdrValueBlock, byteSize );
 }
 //--------------------------------------------------
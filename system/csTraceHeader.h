@@ -81,6 +81,7 @@ public:
    * Dump all trace header names and values
    */
   void dump( std::FILE* stream = NULL ) const;
+  template<typename T> friend class csHeaderRef;
 private:
   /// The actual trace header values:
   csTraceHeaderData* myTraceHeaderData;
@@ -33,8 +33,13 @@ csTraceHeaderData::csTraceHeaderData() {
 //----------------------------------------------------------------------
 //
 csTraceHeaderData::~csTraceHeaderData() {
+  releaseValueBlock();
+}
+void csTraceHeaderData::releaseValueBlock() {
   if( myValueBlock ) {
-    delete [] myValueBlock;
+    if( __atomic_sub_fetch( &blockInfo()->refCount, 1, __ATOMIC_ACQ_REL ) == 0 ) {
+      delete [] ( myValueBlock - sizeof(BlockInfo) );
+    }
     myValueBlock = NULL;
   }
 }
@@ -43,7 +48,13 @@ csTraceHeaderData::~csTraceHeaderData() {
 void csTraceHeaderData::setHeaders( csTraceHeaderDef const* hdef, int inPort ) {
   int totalNumBytes = hdef->getTotalNumBytes();
   if( myNumBytes < totalNumBytes ) {
-    reallocateBytes( totalNumBytes );    
+    // Values of new headers are initialised to zero. Only reallocate if the current block is too small or shared
+    if( totalNumBytes > myNumAllocatedBytes || isShared() ) {
+      reallocateBytes( totalNumBytes > myNumAllocatedBytes ? totalNumBytes : myNumAllocatedBytes );
+    }
+    else {
+      memset( &myValueBlock[myNumBytes], 0, totalNumBytes-myNumBytes );
+    }
   }
   myNumBytes = totalNumBytes;
 
@@ -66,6 +77,7 @@ void csTraceHeaderData::deleteHeaders( csTraceHeaderDef const* hdef ) {
   }
   int numOldBytes = myNumBytes;
   int numNewBytes = myNumBytes-sumNumBytesToDel;
+  detach();
 
   char* temp_buffer = new char[numNewBytes];
   int bytePos = 0;
@@ -96,26 +108,29 @@ void csTraceHeaderData::deleteHeaders( csTraceHeaderDef const* hdef ) {
 void csTraceHeaderData::copyFrom( csTraceHeaderData const* hdr ) {
   myByteLocationPtr = hdr->myByteLocationPtr;
   myNumHeaders = hdr->myNumHeaders;
-  int newNumBytes = hdr->myNumBytes;
-
-  if( newNumBytes > myNumAllocatedBytes ) {
-    reallocateBytes( newNumBytes );
-  }
-  myNumBytes = newNumBytes;
-  memcpy( myValueBlock, hdr->myValueBlock, myNumBytes );
+  myNumBytes   = hdr->myNumBytes;
+  if( myValueBlock == hdr->myValueBlock ) return;
+
+  // Share value block of input object instead of copying it
+  __atomic_add_fetch( &hdr->blockInfo()->refCount, 1, __ATOMIC_RELAXED );
+  releaseValueBlock();
+  myValueBlock        = hdr->myValueBlock;
+  myNumAllocatedBytes = hdr->myNumAllocatedBytes;
 }
 //----------------------------------------------------------------------
+// Allocate new value block, and copy current header values into it. Also used to make a private copy of a shared value block.
 //
 void csTraceHeaderData::reallocateBytes( int numBytesToAllocate ) {
   myNumAllocatedBytes  = numBytesToAllocate;
-  char* newValueBlock = NULL;
-  newValueBlock     = new char[myNumAllocatedBytes];
+  char* newBuffer = new char[sizeof(BlockInfo) + myNumAllocatedBytes];
+  reinterpret_cast<BlockInfo*>( newBuffer )->refCount = 1;
+  char* newValueBlock = newBuffer + sizeof(BlockInfo);
   memset( newValueBlock, 0, myNumAllocatedBytes );
   if( myNumBytes != 0 ) {
     memcpy( newValueBlock, myValueBlock, myNumBytes );
   }
 
-  if( myValueBlock ) delete [] myValueBlock;
+  releaseValueBlock();
   myValueBlock = newValueBlock;
 }
 //---------------------------------------------------------------------
@@ -129,6 +144,7 @@ void csTraceHeaderData::clearMemory() {
 //---------------------------------------------------------------------
 //
 void csTraceHeaderData::setIntValue( int index, int value ) {
+  detach();
 #ifdef CS_DEBUG
   if( myByteLocationPtr[index] >= myNumBytes ) throw csException("csTraceHeaderData::setIntValue: myByteLocation is wrong...");
 #endif
@@ -142,6 +158,7 @@ void csTraceHeaderData::setIntValue( int index, int value ) {
 //---------------------------------------------------------------------
 //
 void csTraceHeaderData::setInt64Value( int index, csInt64_t value ) {
+  detach();
 #ifdef CS_DEBUG
   if( myByteLocationPtr[index] >= myNumBytes ) throw csException("csTraceHeaderData::setInt64Value: myByteLocation is wrong...");
 #endif
@@ -154,6 +171,7 @@ void csTraceHeaderData::setInt64Value( int index, csInt64_t value ) {
 //-----------------------------------------------------------
 //
 void csTraceHeaderData::setFloatValue( int index, float value ) {
+  detach();
 #ifdef CS_DEBUG
   if( myByteLocationPtr[index] >= myNumBytes ) throw csException("csTraceHeaderData::setFloatValue: myByteLocation is wrong...");
 #endif
@@ -166,6 +184,7 @@ void csTraceHeaderData::setFloatValue( int index, float value ) {
 //-----------------------------------------------------------
 //
 void csTraceHeaderData::setDoubleValue( int index, double value ) {
+  detach();
 #ifdef CS_DEBUG
   if( myByteLocationPtr[index]/4 >= myNumBytes ) throw csException("csTraceHeaderData::setDoubleValue: myByteLocation is wrong...");
 #endif
@@ -189,6 +208,7 @@ void csTraceHeaderData::setStringValue( int index, std::string value ) {
   if( oldLength < newLength ) {
     newLength = oldLength;
   }
+  detach();
   memcpy( &myValueBlock[myByteLocationPtr[index]], value.c_str(), newLength );
 }
 std::string csTraceHeaderData::stringValue( int index ) const {
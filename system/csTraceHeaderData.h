@@ -24,6 +24,9 @@ static int const DEFAULT_STRING_LENGTH = 20;
 * Manages values for all trace headers of one seismic trace
 * Header values are stored as a continuous char buffer
 *
+* The value block is reference counted. copyFrom() does not copy the header values but shares the value block of the
+* input object. The block is copied only when one of the sharing objects modifies a header value (copy-on-write).
+* Objects sharing a block may be used from different threads.
 *
 * @author Bjorn Olofsson
 * @date   2007
@@ -34,7 +37,7 @@ public:
   ~csTraceHeaderData();
   /// Set/create trace header data from trace header definition
   void setHeaders( csTraceHeaderDef const* hdef, int inPort = -1 );
-  /// Make exact copy of input object
+  /// Make exact copy of input object. The header value block is shared until either object modifies it
   void copyFrom( csTraceHeaderData const* hdr );
   //------------------------------------------------------
   void setIntValue( int index, int value );
@@ -87,11 +90,32 @@ public:
   //------------------------------------------------------
   void clear();
   void clearMemory();
+  /// @return true if header value block is shared with other trace headers
+  inline bool isShared() const {
+    return( __atomic_load_n( &blockInfo()->refCount, __ATOMIC_ACQUIRE ) > 1 );
+  }
   friend class csTraceHeader;
+  template<typename T> friend class csHeaderRef;
 
 private:
+  /// Stored in front of header value block
+  struct BlockInfo {
+    /// Number of trace header objects sharing the value block
+    int refCount;
+    /// Padding, keeps value block aligned to 8 bytes
+    int reserved;
+  };
+  inline BlockInfo* blockInfo() const {
+    return reinterpret_cast<BlockInfo*>( myValueBlock - sizeof(BlockInfo) );
+  }
+  /// Make sure value block is not shared with other trace headers. Must be called before any header value is modified
+  inline void detach() {
+    if( isShared() ) reallocateBytes( myNumAllocatedBytes );
+  }
+  /// Drop reference to value block, and free the block if it is not shared
+  void releaseValueBlock();
   void deleteHeaders( csTraceHeaderDef const* hdef );
-  /// Buffer that holds all trace header values in one chunk of memory
+  /// Buffer that holds all trace header values in one chunk of memory. Shared between copies, see copyFrom()
   char* myValueBlock;
   /// Maps the sequential header index 0,1,2... to the byte location index in the char* 'value block'
   /// Pointer to object, kept in csTraceHeaderDef
@@ -409,17 +409,30 @@ void csTraceHeaderDef::resetByteLocation() {
   myByteLocation[0] = 0;
   int numBytes = 0;
   for( int ihdr = 1; ihdr < nHeaders; ihdr++ ) {
-    csTraceHeaderInfo const* info = myTraceHeaderInfoList->at(ihdr-1);
-    if( info->type != cseis_geolib::TYPE_STRING ) {
-      numBytes += cseis_geolib::csGeolibUtils::numBytes( info->type );
-    }
-    else { // if( type == TYPE_STRING ) {
-      // BUGFIX 080704: Number of bytes for string headers were previously computed as length of description string. This was preliminary code
-      numBytes += info->nElements;
-    }
+    numBytes += headerNumBytes( ihdr-1 );
     myByteLocation[ihdr] = numBytes;
   }
 }
+int csTraceHeaderDef::computeByteLocation( int index ) const {
+  if( index < 0 || index >= numHeaders() ) {
+    throw( cseis_geolib::csException("csTraceHeaderDef::computeByteLocation: Wrong header index passed to function") );
+  }
+  int numBytes = 0;
+  for( int ihdr = 0; ihdr < index; ihdr++ ) {
+    numBytes += headerNumBytes( ihdr );
+  }
+  return numBytes;
+}
+int csTraceHeaderDef::headerNumBytes( int index ) const {
+  csTraceHeaderInfo const* info = myTraceHeaderInfoList->at(index);
+  if( info->type != cseis_geolib::TYPE_STRING ) {
+    return cseis_geolib::csGeolibUtils::numBytes( info->type );
+  }
+  else { // if( type == TYPE_STRING ) {
+    // BUGFIX 080704: Number of bytes for string headers were previously computed as length of description string. This was preliminary code
+    return info->nElements;
+  }
+}
 
 bool csTraceHeaderDef::isSystemTraceHeader( std::string const& name ) const {
   int index = 0;
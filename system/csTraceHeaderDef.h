@@ -127,6 +127,12 @@ class csTraceHeaderDef {
   int numHeaders() const;
   /// @return number of byte offset of specified header inside byte buffer
   int getByteLocation( int index ) const;
+  /**
+  * Compute byte location of specified header inside byte buffer, from the current list of headers.
+  * Unlike getByteLocation(), this can be used in the init phase, before resetByteLocation() has been called.
+  * Headers are only ever appended, so the byte location of a header does not change once it has been added.
+  */
+  int computeByteLocation( int index ) const;
   /// Return total number of bytes required to store trace header values
   inline int getTotalNumBytes() const { return myTotalNumBytes; }
   /**
@@ -157,6 +163,8 @@ class csTraceHeaderDef {
   friend class csTraceGather;
 private:
   static bool isSystemTraceHeader( int index );
+  /// Number of bytes of header value in trace header value block
+  int headerNumBytes( int index ) const;
   int addHeader_internal( cseis_geolib::type_t type, std::string const& name, std::string const& description, int nElements );
   /**
    * Delete trace header.
@@ -1,144 +1,242 @@
 
 
+
 #include <cstdlib>
 #include <cstdio>
 #include "csTracePool.h"
 #include "csMemoryPoolManager.h"
 #include "geolib/csException.h"
+#include "geolib/csTimeline.h"
+#include "geolib/csVector.h"
 #include "csTrace.h"
-#include <map>
+#include "csTraceData.h"
 
 using namespace cseis_system;
 
-csTracePool::csTracePool( int policy ) {
+namespace cseis_system {
+  /// Free traces cached by one thread. Only accessed by the owning thread, except on creation and thread exit
+  struct csTracePool::ThreadCache {
+    csTracePool* pool;
+    csTrace* firstTrace;
+    int numTraces;
+    ThreadCache* nextCache;
+  };
+}
+
+csTracePool::csTracePool( int policy, csTraceDataAllocator* allocator ) {
+  myTraces             = NULL;
+  myOldTraceArrays     = new cseis_geolib::csVector<csTrace**>();
+  myCapacity           = 0;
   myNumAllocatedTraces = 0;
-  myIndexNextFreeTrace = 0;
   myNumUsedTraces      = 0;
   myMaxNumUsedTraces   = 0;
+  myFirstFreeTrace     = NULL;
+  myNumFreeTraces      = 0;
+  myNumBytesFree       = 0;
   myPolicy             = policy;
-  myTraceIndexMap = new std::map<int,int>();
-  if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) {
-    myBlockSize = 4;
-  }
-  else {
-    myBlockSize = 1;
-  }
-  reallocate( myBlockSize );
+  myDataAllocator      = allocator;
+  myNumRequests        = 0;
+  myNumReallocations   = 0;
+  myNumCacheMisses     = 0;
+  // Memory policy: Keep only few free traces per thread, so that they are quickly available to other threads
+  myCacheCapacity      = ( myPolicy == csMemoryPoolManager::POLICY_SPEED ) ? CACHE_CAPACITY_SPEED : CACHE_CAPACITY_MEMORY;
+  myCacheBatchSize     = myCacheCapacity / 2;
+  myFirstCache         = NULL;
+  myHasCacheKey        = ( pthread_key_create( &myCacheKey, csTracePool::releaseThreadCache ) == 0 );
+  reallocate();
 }
 csTracePool::~csTracePool() {
+  // All other threads using this pool have finished by now
+  if( myHasCacheKey ) {
+    pthread_setspecific( myCacheKey, NULL );
+    pthread_key_delete( myCacheKey );
+  }
+  while( myFirstCache != NULL ) {
+    ThreadCache* cache = myFirstCache;
+    myFirstCache = cache->nextCache;
+    delete cache;
+  }
   if( myTraces != NULL ) {
     for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      if( myTraces[i] ) delete myTraces[i];
+      delete myTraces[i];
     }
     delete [] myTraces;
     myTraces = NULL;
   }
-  if( myIsTraceFree != NULL ) {
-    delete [] myIsTraceFree;
-    myIsTraceFree = NULL;
-  }
-  if( myTraceIndexMap != NULL ) {
-    delete myTraceIndexMap;
-    myTraceIndexMap = NULL;
+  for( int i = 0; i < myOldTraceArrays->size(); i++ ) {
+    delete [] myOldTraceArrays->at(i);
   }
-
+  delete myOldTraceArrays;
 }
 //----------------------------------------------------
-void csTracePool::reallocate( int numTracesNew ) {
-  csTrace** trcs = new csTrace*[numTracesNew];
-  bool* isFree = new bool[numTracesNew];
-  if( myNumAllocatedTraces > 0 ) {
-    for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      trcs[i]   = myTraces[i];
-      isFree[i] = myIsTraceFree[i];
-    }
-    delete [] myIsTraceFree;
-    delete [] myTraces;
+void csTracePool::reallocate() {
+  int capacityNew = INITIAL_CAPACITY;
+  if( myCapacity > 0 ) {
+    // Memory policy: Grow by 50% instead of doubling the trace array
+    capacityNew = ( myPolicy == csMemoryPoolManager::POLICY_SPEED ) ? 2*myCapacity : myCapacity + myCapacity/2;
   }
-
-// Only fully allocate one trace. Leave other traces to be allocated later
-  isFree[myNumAllocatedTraces] = true;
-  trcs[myNumAllocatedTraces]   = new csTrace(this);
-  myTraceIndexMap->insert(std::pair<int,int>(trcs[myNumAllocatedTraces]->getIdentNumber(),myNumAllocatedTraces) );
-  for( int i = myNumAllocatedTraces+1; i < numTracesNew; i++ ) {
-    isFree[i] = true;  // is free yet not allocated yet
-    trcs[i]   = NULL;
+  csTrace** trcs = new csTrace*[capacityNew];
+  for( int i = 0; i < myNumAllocatedTraces; i++ ) {
+    trcs[i] = myTraces[i];
   }
-
-  myTraces = trcs;
-  myIsTraceFree  = isFree;
-  myNumAllocatedTraces = numTracesNew;
+  if( myTraces != NULL ) {
+    myOldTraceArrays->insertEnd( myTraces );
+    myNumReallocations += 1;
+  }
+  __atomic_store_n( &myTraces, trcs, __ATOMIC_RELEASE );
+  myCapacity = capacityNew;
+  cseis_geolib::csTimeline::instant( "trace pool growth", "memory", capacityNew );
 }
 //----------------------------------------------------
-csInt64_t csTracePool::computeNumBytes() {
-  csInt64_t numSamples = 0;
-  for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-    if( !myIsTraceFree[i] && myTraces[i] != NULL ) {
-      numSamples += myTraces[i]->numSamples();
-    }
+//
+csTracePool::ThreadCache* csTracePool::threadCache() {
+  if( !myHasCacheKey ) return NULL;
+  ThreadCache* cache = (ThreadCache*)pthread_getspecific( myCacheKey );
+  if( cache == NULL ) {  // Mutex is locked by caller
+    cache = new ThreadCache();
+    cache->pool       = this;
+    cache->firstTrace = NULL;
+    cache->numTraces  = 0;
+    cache->nextCache  = myFirstCache;
+    myFirstCache = cache;
+    pthread_setspecific( myCacheKey, cache );
+  }
+  return cache;
+}
+void csTracePool::releaseTraces( ThreadCache* cache, int numTraces ) {
+  for( int i = 0; i < numTraces && cache->firstTrace != NULL; i++ ) {
+    csTrace* trace = cache->firstTrace;
+    cache->firstTrace = trace->myNextFreeTrace;
+    cache->numTraces -= 1;
+    trace->myNextFreeTrace = myFirstFreeTrace;
+    myFirstFreeTrace = trace;
+    myNumFreeTraces += 1;
   }
-  return( numSamples * (csInt64_t)sizeof(float) );
+}
+void csTracePool::releaseThreadCache( void* ptr ) {
+  ThreadCache* cache = (ThreadCache*)ptr;
+  csTracePool* pool = cache->pool;
+  cseis_geolib::csMutexLock lock( &pool->myMutex );
+  pool->releaseTraces( cache, cache->numTraces );
+  ThreadCache** cachePtr = &pool->myFirstCache;
+  while( *cachePtr != cache ) {
+    cachePtr = &(*cachePtr)->nextCache;
+  }
+  *cachePtr = cache->nextCache;
+  delete cache;
+}
+void csTracePool::addUsedTraces( int numTraces ) {
+  int numUsed = __atomic_add_fetch( &myNumUsedTraces, numTraces, __ATOMIC_RELAXED );
+  int maxNumUsed = __atomic_load_n( &myMaxNumUsedTraces, __ATOMIC_RELAXED );
+  while( numUsed > maxNumUsed &&
+         !__atomic_compare_exchange_n( &myMaxNumUsedTraces, &maxNumUsed, numUsed, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) ) {
+  }
+}
+void csTracePool::addFreeBytes( csTrace const* trace, bool isFree ) {
+  // The sample buffer of a free trace does not change until the trace is retrieved again
+  csInt64_t numBytes = (csInt64_t)trace->getTraceDataObject()->getNumAllocatedSamples() * (csInt64_t)sizeof(float);
+  __atomic_add_fetch( &myNumBytesFree, isFree ? numBytes : -numBytes, __ATOMIC_RELAXED );
 }
 //----------------------------------------------------
 //
 void csTracePool::freeTrace( csTrace* trace ) {
-  int identNumber = trace->getIdentNumber();
-//  bool isOK = false;
-  std::map<int,int>::iterator iter = myTraceIndexMap->find(identNumber);
-  if( iter != myTraceIndexMap->end() ) {
-    myIsTraceFree[iter->second] = true;
-    myIndexNextFreeTrace = iter->second;
+  // Trace array and number of allocated traces only grow, and old trace arrays stay valid: No lock needed
+  int index = trace->myPoolIndex;
+  if( index < 0 || index >= __atomic_load_n( &myNumAllocatedTraces, __ATOMIC_ACQUIRE ) ||
+      __atomic_load_n( &myTraces, __ATOMIC_ACQUIRE )[index] != trace || trace->myIsFree ) {
+    throw( cseis_geolib::csException("csTracePool::freeTrace: Error: Trace %d does not belong to trace pool, or has been freed already", trace->getIdentNumber()) );
   }
-  else {
-    throw( cseis_geolib::csException("csTracePool::freeTtrace: Error...") );
+  trace->myIsFree = true;
+  addUsedTraces( -1 );
+  addFreeBytes( trace, true );
+  ThreadCache* cache = myHasCacheKey ? (ThreadCache*)pthread_getspecific( myCacheKey ) : NULL;
+  if( cache == NULL ) {
+    cseis_geolib::csMutexLock lock( &myMutex );
+    cache = threadCache();
+    if( cache == NULL ) {  // No thread caches: Return trace directly to shared list
+      trace->myNextFreeTrace = myFirstFreeTrace;
+      myFirstFreeTrace = trace;
+      myNumFreeTraces += 1;
+      return;
+    }
+  }
+  trace->myNextFreeTrace = cache->firstTrace;
+  cache->firstTrace = trace;
+  cache->numTraces += 1;
+  if( cache->numTraces > myCacheCapacity ) {
+    cseis_geolib::csMutexLock lock( &myMutex );
+    releaseTraces( cache, myCacheBatchSize );
   }
-
-//  if( !isOK ) {
-//    printf("*** Free trace:  %3d %3d,  used: %3d   (NOT FOUND!!!!)\n", myIndexNextFreeTrace, myNumAllocatedTraces, myNumUsedTraces);
-//  }
-  myNumUsedTraces--;
-  //  fprintf(stdout,"******* Free trace from trace pool *******\n");
-  //  dump();
+}
+//----------------------------------------------------
+//
+csTrace* csTracePool::getCachedTrace() {
+  if( !myHasCacheKey ) return NULL;
+  ThreadCache* cache = (ThreadCache*)pthread_getspecific( myCacheKey );
+  if( cache == NULL || cache->firstTrace == NULL ) {
+    return NULL;
+  }
+  csTrace* trace = cache->firstTrace;
+  cache->firstTrace = trace->myNextFreeTrace;
+  cache->numTraces -= 1;
+  __atomic_add_fetch( &myNumRequests, 1, __ATOMIC_RELAXED );
+  trace->myIsFree = false;
+  trace->myNextFreeTrace = NULL;
+  addUsedTraces( 1 );
+  addFreeBytes( trace, false );
+  return trace;
 }
 //----------------------------------------------------
 //
 csTrace* csTracePool::getNewTrace() {
-  //  printf("*** Get new trace:  %3d %3d,   used: %3d", myIndexNextFreeTrace, myNumAllocatedTraces, myNumUsedTraces);
-  if( myTraces[myIndexNextFreeTrace] == NULL ) {
-    myTraces[myIndexNextFreeTrace] = new csTrace( this );
-    myTraceIndexMap->insert(std::pair<int,int>(myTraces[myIndexNextFreeTrace]->getIdentNumber(),myIndexNextFreeTrace));
-  }
-  csTrace* trace = myTraces[myIndexNextFreeTrace];
-//  printf(",   ID: %3d\n", myTraces[myIndexNextFreeTrace]->getIdentNumber() );
-  myIsTraceFree[myIndexNextFreeTrace] = false;
-  myNumUsedTraces++;
-  myIndexNextFreeTrace++;
-  if( myNumUsedTraces > myMaxNumUsedTraces ) myMaxNumUsedTraces= myNumUsedTraces;
-
-  if( myNumUsedTraces >= myNumAllocatedTraces ) {
-    reallocate( myNumAllocatedTraces+myBlockSize );
-    if( myPolicy == csMemoryPoolManager::POLICY_SPEED ) myBlockSize += BLOCK_SIZE_ATOM;
+  __atomic_add_fetch( &myNumRequests, 1, __ATOMIC_RELAXED );
+  myNumCacheMisses += 1;
+  ThreadCache* cache = threadCache();
+  csTrace* trace = ( cache != NULL ) ? cache->firstTrace : NULL;
+  if( trace != NULL ) {
+    cache->firstTrace = trace->myNextFreeTrace;
+    cache->numTraces -= 1;
   }
-
-  if( myIndexNextFreeTrace >= myNumAllocatedTraces || !myIsTraceFree[myIndexNextFreeTrace] ) {
-    for( int i = 0; i < myNumAllocatedTraces; i++ ) {
-      if( myIsTraceFree[i] ) {
-        myIndexNextFreeTrace = i;
-        break;
-      }
+  else if( myFirstFreeTrace != NULL ) {
+    trace = myFirstFreeTrace;
+    myFirstFreeTrace = trace->myNextFreeTrace;
+    myNumFreeTraces -= 1;
+    // Refill thread cache, so that the next requests do not need to lock the mutex
+    while( cache != NULL && cache->numTraces < myCacheBatchSize && myFirstFreeTrace != NULL ) {
+      csTrace* traceFree = myFirstFreeTrace;
+      myFirstFreeTrace = traceFree->myNextFreeTrace;
+      myNumFreeTraces -= 1;
+      traceFree->myNextFreeTrace = cache->firstTrace;
+      cache->firstTrace = traceFree;
+      cache->numTraces += 1;
     }
-    if( myIndexNextFreeTrace >= myNumAllocatedTraces || !myIsTraceFree[myIndexNextFreeTrace] ) {
-      fprintf(stderr,"ERROR in trace pool. %d %d\n", myIndexNextFreeTrace, myNumAllocatedTraces );
+  }
+  else {  // No free trace left: Allocate new trace
+    if( myNumAllocatedTraces == myCapacity ) {
+      reallocate();
     }
+    trace = new csTrace( this );
+    trace->myPoolIndex = myNumAllocatedTraces;
+    myTraces[myNumAllocatedTraces] = trace;
+    __atomic_store_n( &myNumAllocatedTraces, myNumAllocatedTraces+1, __ATOMIC_RELEASE );
   }
+  trace->myIsFree = false;
+  trace->myNextFreeTrace = NULL;
+  addUsedTraces( 1 );
+  addFreeBytes( trace, false );
   return trace;
 }
 //----------------------------------------------------
 //
 void csTracePool::dumpSummary( FILE* fout ) const {
-  std::string speed  = "SPEED";
-  std::string memory = "MEMORY";
+  double reuseRate = 0.0;
+  if( myNumRequests > 0 ) reuseRate = 100.0 * (double)( myNumRequests - myNumAllocatedTraces ) / (double)myNumRequests;
   fprintf( fout," Total number of used/allocated traces:  %d/%d\n", myMaxNumUsedTraces, myNumAllocatedTraces );
+  double cacheRate = 0.0;
+  if( myNumRequests > 0 ) cacheRate = 100.0 * (double)( myNumRequests - myNumCacheMisses ) / (double)myNumRequests;
+  fprintf( fout," Trace pool: %lld trace requests, %.2f%% served by re-used traces, %d reallocations of trace array (size %d)\n",
+           (long long)myNumRequests, reuseRate, myNumReallocations, myCapacity );
+  fprintf( fout," Trace pool: %.2f%% of requests served from thread caches (%d traces per thread)\n", cacheRate, myCacheCapacity );
 }
 void csTracePool::dump() {
   std::string speed  = "SPEED";
@@ -146,7 +244,5 @@ void csTracePool::dump() {
   fprintf(stdout,"****** TracePool dump *******\n");
   fprintf(stdout," Number of traces allocated/used/max:   %d / %d / %d\n", myNumAllocatedTraces, myNumUsedTraces, myMaxNumUsedTraces );
   fprintf(stdout," Memory pool policy used:           %s\n", myPolicy == csMemoryPoolManager::POLICY_SPEED ? speed.c_str() : memory.c_str() );
-  fprintf(stdout," Index of next free trace: %d\n", myIndexNextFreeTrace);
+  fprintf(stdout," Number of trace requests: %lld, size of trace array: %d\n", (long long)myNumRequests, myCapacity );
 }
-
-
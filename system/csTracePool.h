@@ -7,12 +7,17 @@
 #define CS_TRACE_POOL_H
 
 #include <cstdio>
-#include <map>
 #include "geolib/geolib_defines.h"
+#include "geolib/csThread.h"
+
+namespace cseis_geolib {
+  template<typename T> class csVector;
+}
 
 namespace cseis_system {
 
 class csTrace;
+class csTraceDataAllocator;
 
 /**
 * Trace pool
@@ -24,59 +29,108 @@ class csTrace;
 *
 * However, this increase in speed is bought by a greater need for memory.
 *
+* Traces may be retrieved and freed from different threads (pipeline exec mode). Each thread keeps a small cache
+* of free traces, which is accessed without locking. Only when the cache runs empty or overflows, a batch of traces
+* is moved from or to the shared list of free traces, which is protected by a mutex.
+* A trace that is freed in a different thread from the one that retrieved it simply goes into the cache of the
+* freeing thread. The size of the thread caches depends on the memory pool policy.
+* If no thread-specific key can be created, thread caches are not used, and all requests lock the mutex.
 *
 * @author Bjorn Olofsson
 * @date   2007
 */
 class csTracePool {
 public:
-  csTracePool( int policy );
+  /**
+  * @param policy     Memory pool policy
+  * @param allocator  Allocator for sample buffers of all traces in pool
+  */
+  csTracePool( int policy, csTraceDataAllocator* allocator );
   ~csTracePool();
   /**
   * @return pointer to new trace object
   */
   csTrace* getNewTrace();
+  /**
+  * Retrieve trace from cache of calling thread, without locking
+  * @return pointer to new trace object, or NULL if cache is empty: Lock mutex and call getNewTrace() instead
+  */
+  csTrace* getCachedTrace();
   friend class csTrace;
   friend class csMemoryPoolManager;
   void dumpSummary( FILE* fout ) const;
   /// For debugging purposes
   void dump();
-  int numAvailableTraces() { return myNumAllocatedTraces-myNumUsedTraces;  };
-
-protected:
-  csInt64_t computeNumBytes();
+  /// Number of free traces in shared list. Traces held in thread caches are not included
+  int numAvailableTraces() { return myNumFreeTraces;  };
+  /// @return Number of bytes in sample buffers kept by free traces, in shared list and thread caches
+  csInt64_t numBytesFree() const { return __atomic_load_n( &myNumBytesFree, __ATOMIC_RELAXED ); }
 
 private:
+  struct ThreadCache;
 
-  /// Traces
+  /// Traces. Each trace knows its own index in this array
   csTrace** myTraces;
+  /// Previous, smaller trace arrays. Kept until the pool is destroyed, so that freeTrace() can check a trace's index without locking
+  cseis_geolib::csVector<csTrace**>* myOldTraceArrays;
+  /// Size of trace array
+  int myCapacity;
   /// Number of traces that are currently in use
   int myNumUsedTraces;
   /// Maximum number of traces in use at one time
   int myMaxNumUsedTraces;
   /// Number of traces allocated in trace pool
   int myNumAllocatedTraces;
-  /// Index field, for each trace. If 'yes' for any particular trace, it means this trace is still 'free' (=available to be used)
-  bool* myIsTraceFree;
-  /// Index in trace array of a free trace
-  int myIndexNextFreeTrace;
-  /**
-   * Size of block that is allocated anew when new trace shall be allocated. Increases steadily when new traces are allocated repeatibly.
-   * Reason is to allocate some additional traces in advance to save time. This is faster than allocating each trace separately, but uses more memory
-   */
-  int myBlockSize;
+  /// First trace in shared list of free traces. The list is linked through the traces themselves
+  csTrace* myFirstFreeTrace;
+  /// Number of traces in shared list of free traces
+  int myNumFreeTraces;
+  /// Number of bytes in sample buffers kept by free traces. Free traces keep their sample buffer for re-use
+  csInt64_t myNumBytesFree;
   /// Memory pool policy: Optimised for speed or memory usage
   int myPolicy;
+  /// Allocator for sample buffers
+  csTraceDataAllocator* myDataAllocator;
+  /// Total number of calls to getNewTrace()
+  csInt64_t myNumRequests;
+  /// Number of times the trace array has been reallocated
+  int myNumReallocations;
+  /// Number of requests that could not be served from a thread cache
+  csInt64_t myNumCacheMisses;
+  /// Maximum number of traces in one thread cache
+  int myCacheCapacity;
+  /// Number of traces moved between thread cache and shared list at one time
+  int myCacheBatchSize;
+  /// Key to thread cache of calling thread
+  pthread_key_t myCacheKey;
+  /// true if thread-specific key was created, i.e. thread caches are used
+  bool myHasCacheKey;
+  /// All thread caches, linked through the caches themselves
+  ThreadCache* myFirstCache;
 
-  void reallocate( int newNumAllocatedTraces );
+  /// Enlarge trace array. The array grows geometrically, to keep the cost of copying it low
+  void reallocate();
   /**
   * 'Free' the according trace from the buffer pool
   * This does not free any memory!
   * It makes the trace buffer available again, which means the trace is free'd to be used elsewhere, see 'getNewTrace()'.
   */
   void freeTrace( csTrace* trace );
-  static int const BLOCK_SIZE_ATOM = 4;
-  std::map<int,int>* myTraceIndexMap;
+  /// Thread cache of calling thread. Created on first use
+  ThreadCache* threadCache();
+  /// Move traces from thread cache to shared list. Mutex must be locked
+  void releaseTraces( ThreadCache* cache, int numTraces );
+  /// Called when a thread exits: Return all traces in thread cache to shared list
+  static void releaseThreadCache( void* cache );
+  /// Add to number of used traces, and keep track of maximum
+  void addUsedTraces( int numTraces );
+  /// Add sample buffer of trace to, or remove from, number of bytes kept by free traces
+  void addFreeBytes( csTrace const* trace, bool isFree );
+  static int const INITIAL_CAPACITY = 16;
+  static int const CACHE_CAPACITY_SPEED  = 64;
+  static int const CACHE_CAPACITY_MEMORY = 8;
+  /// Protects shared list of free traces and trace array. Locked by csMemoryPoolManager when retrieving new traces
+  cseis_geolib::csMutex myMutex;
 };
 
 } // namespace
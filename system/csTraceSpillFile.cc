@@ -0,0 +1,99 @@
+
+
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include "csTraceSpillFile.h"
+#include "geolib/csException.h"
+#include "geolib/csTimeline.h"
+#include "geolib/geolib_platform_dependent.h"
+
+using namespace cseis_system;
+
+csTraceSpillFile::csTraceSpillFile( std::string const& directory ) {
+  myFile                 = NULL;
+  myFileSize             = 0;
+  myTotalNumBytesSpilled = 0;
+  myNumSpilledTraces     = 0;
+  myNumRestoredTraces    = 0;
+
+  std::string templateName = directory + "/cseis_spill_XXXXXX";
+  char* filename = new char[templateName.length()+1];
+  memcpy( filename, templateName.c_str(), templateName.length()+1 );
+  int fd = mkstemp( filename );
+  if( fd >= 0 ) {
+    myFilename = filename;
+    myFile = fdopen( fd, "w+b" );
+    if( myFile == NULL ) close( fd );
+    // Remove directory entry right away. File space is freed when the file is closed
+    unlink( filename );
+  }
+  delete [] filename;
+  if( myFile == NULL ) {
+    throw( cseis_geolib::csException("csTraceSpillFile: Cannot create spill file in scratch directory '%s'", directory.c_str()) );
+  }
+}
+csTraceSpillFile::~csTraceSpillFile() {
+  if( myFile != NULL ) {
+    fclose( myFile );
+    myFile = NULL;
+  }
+  for( int i = 0; i < myFreeRecords.size(); i++ ) {
+    delete myFreeRecords.at(i);
+  }
+  myFreeRecords.clear();
+}
+//----------------------------------------------------
+csTraceSpillFile::FreeRecords* csTraceSpillFile::freeRecords( int numSamples ) {
+  for( int i = 0; i < myFreeRecords.size(); i++ ) {
+    if( myFreeRecords.at(i)->numSamples == numSamples ) return myFreeRecords.at(i);
+  }
+  FreeRecords* records = new FreeRecords();
+  records->numSamples = numSamples;
+  myFreeRecords.insertEnd( records );
+  return records;
+}
+void csTraceSpillFile::releaseRecord( csInt64_t offset, int numSamples ) {
+  freeRecords( numSamples )->offsets.insertEnd( offset );
+}
+//----------------------------------------------------
+csInt64_t csTraceSpillFile::write( float const* samples, int numSamples ) {
+  cseis_geolib::csTimeline::Event event( "spill trace", "io" );
+  cseis_geolib::csMutexLock lock( &myMutex );
+  csInt64_t numBytes = (csInt64_t)numSamples * sizeof(float);
+  FreeRecords* records = freeRecords( numSamples );
+  csInt64_t offset = myFileSize;
+  if( records->offsets.size() > 0 ) {
+    offset = records->offsets.at( records->offsets.size()-1 );
+    records->offsets.remove( records->offsets.size()-1 );
+  }
+  else {
+    myFileSize += numBytes;
+  }
+  if( fseeko64( myFile, offset, SEEK_SET ) != 0 || fwrite( samples, sizeof(float), numSamples, myFile ) != (size_t)numSamples ) {
+    throw( cseis_geolib::csException("csTraceSpillFile: Error occurred when writing to spill file '%s'. Disk full?", myFilename.c_str()) );
+  }
+  myTotalNumBytesSpilled += numBytes;
+  myNumSpilledTraces     += 1;
+  return offset;
+}
+void csTraceSpillFile::read( csInt64_t offset, float* samples, int numSamples ) {
+  cseis_geolib::csTimeline::Event event( "restore trace", "io" );
+  cseis_geolib::csMutexLock lock( &myMutex );
+  if( fseeko64( myFile, offset, SEEK_SET ) != 0 || fread( samples, sizeof(float), numSamples, myFile ) != (size_t)numSamples ) {
+    throw( cseis_geolib::csException("csTraceSpillFile: Error occurred when reading from spill file '%s'", myFilename.c_str()) );
+  }
+  myNumRestoredTraces += 1;
+  releaseRecord( offset, numSamples );
+}
+void csTraceSpillFile::release( csInt64_t offset, int numSamples ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  releaseRecord( offset, numSamples );
+}
+//----------------------------------------------------
+void csTraceSpillFile::dumpSummary( FILE* fout ) {
+  cseis_geolib::csMutexLock lock( &myMutex );
+  fprintf( fout," Spill file: %lld traces spilled to disk (%.2fMb), %lld read back in. Maximum disk space used: %.2fMb\n",
+           (long long)myNumSpilledTraces, (double)myTotalNumBytesSpilled/(1024.0*1024.0),
+           (long long)myNumRestoredTraces, (double)myFileSize/(1024.0*1024.0) );
+}
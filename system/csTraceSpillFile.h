@@ -0,0 +1,75 @@
+/* Copyright (c) Colorado School of Mines, 2013.*/
+/* All rights reserved.                       */
+
+
+
+#ifndef CS_TRACE_SPILL_FILE_H
+#define CS_TRACE_SPILL_FILE_H
+
+#include <cstdio>
+#include <string>
+#include "geolib/geolib_defines.h"
+#include "geolib/csThread.h"
+#include "geolib/csVector.h"
+
+namespace cseis_system {
+
+/**
+* Scratch file holding trace samples that have been spilled to disk
+*
+* When the memory held by buffered traces exceeds the limit set in csMemoryPoolManager, the samples of newly buffered
+* traces are written to this file, and read back in when a module accesses them (see csTraceData).
+* The file is created in the given scratch directory and removed again right away, so that it disappears
+* when the program exits, even after a crash.
+*
+* The file is divided into records, one per spilled trace. Records are re-used for traces with the same number of samples.
+* Traces may be spilled and read back in from different threads.
+*
+* @author Bjorn Olofsson
+* @date   2013
+*/
+class csTraceSpillFile {
+public:
+  /**
+  * @param directory  Scratch directory in which file shall be created
+  */
+  csTraceSpillFile( std::string const& directory );
+  ~csTraceSpillFile();
+  /**
+  * Write trace samples to new record
+  * @return Byte offset of record
+  */
+  csInt64_t write( float const* samples, int numSamples );
+  /**
+  * Read trace samples from record, and release record
+  * @param offset  Byte offset of record, as returned by write()
+  */
+  void read( csInt64_t offset, float* samples, int numSamples );
+  /// Release record without reading it
+  void release( csInt64_t offset, int numSamples );
+  std::string const& filename() const { return myFilename; }
+  void dumpSummary( FILE* fout );
+
+private:
+  csTraceSpillFile( csTraceSpillFile const& obj );
+  /// Released records of one size
+  struct FreeRecords {
+    int numSamples;
+    cseis_geolib::csVector<csInt64_t> offsets;
+  };
+  FreeRecords* freeRecords( int numSamples );
+  void releaseRecord( csInt64_t offset, int numSamples );
+
+  FILE* myFile;
+  std::string myFilename;
+  /// Current file size in bytes
+  csInt64_t myFileSize;
+  cseis_geolib::csVector<FreeRecords*> myFreeRecords;
+  csInt64_t myTotalNumBytesSpilled;
+  csInt64_t myNumSpilledTraces;
+  csInt64_t myNumRestoredTraces;
+  cseis_geolib::csMutex myMutex;
+};
+
+} // namespace
+#endif
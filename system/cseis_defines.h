@@ -36,6 +36,20 @@ typedef void (*MExecMultiTracePtr) (
   int* numTrcToKeep,
   csExecPhaseEnv* env,
   csLogWriter* log );
+/**
+* Batched exec phase method of single-trace module (optional)
+* Processes a block of traces in one call. Same result as calling the single-trace exec phase method for each trace in turn.
+* The method must not add traces to or remove traces from the gather.
+* @param traceGather: Gather containing the traces of the block
+* @param ports:       Output port number of each trace
+* @param keep:        Set to false for traces that shall be removed from the flow (same as returning false from the single-trace method)
+*/
+typedef void (*MExecBatchPtr) (
+  csTraceGather* traceGather,
+  int* ports,
+  bool* keep,
+  csExecPhaseEnv* env,
+  csLogWriter* log );
 
 // Execution type for modules
 static int const EXEC_TYPE_INPUT       = 111;   // Input module
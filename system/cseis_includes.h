@@ -16,6 +16,7 @@
 #include "csTrace.h"
 #include "csTraceData.h"
 #include "csTraceHeader.h"
+#include "csHeaderRef.h"
 #include "csSuperHeader.h"
 #include "csTraceGather.h"
 #include "csParamManager.h"
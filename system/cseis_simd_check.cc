@@ -0,0 +1,201 @@
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "geolib/geolib_endian.h"
+#include "geolib/methods_number_conversions.h"
+
+using namespace cseis_geolib;
+
+namespace {
+  /// Number of values converted in one go
+  int const BLOCK_SIZE = 1 << 20;
+  /// Largest array size in bytes tested for endian swap. Covers several iterations of the widest (64 byte) SIMD loop plus all remainders
+  int const MAX_SWAP_BYTES = 320;
+  /// Largest number of values tested for remainder handling in number conversions
+  int const MAX_CONVERT_VALUES = 100;
+  /// Additional bytes at start of arrays, to test unaligned input and output
+  int const MAX_OFFSET = 8;
+
+  char const* levelName( int level ) {
+    if( level == SIMD_LEVEL_SSE2 ) return "SSE2";
+    else if( level == SIMD_LEVEL_SSSE3 ) return "SSSE3";
+    else if( level == SIMD_LEVEL_AVX2 ) return "AVX2";
+    return "none";
+  }
+  void swap( int numBytesSwap, char* array, int size ) {
+    if( numBytesSwap == 2 ) swapEndian2( array, size );
+    else if( numBytesSwap == 4 ) swapEndian4( array, size );
+    else swapEndian8( array, size );
+  }
+  void swap( int numBytesSwap, char const* arrayIn, char* arrayOut, int size ) {
+    if( numBytesSwap == 2 ) swapEndian2( arrayIn, arrayOut, size );
+    else if( numBytesSwap == 4 ) swapEndian4( arrayIn, arrayOut, size );
+    else swapEndian8( arrayIn, arrayOut, size );
+  }
+  /// Convert in place, or to output array with endian swap
+  void convert( bool isIBM2IEEE, unsigned char const* valuesIn, unsigned char* valuesOut, int numValues, bool doSwapEndian ) {
+    if( !doSwapEndian && valuesIn == valuesOut ) {
+      if( isIBM2IEEE ) ibm2ieee( valuesOut, numValues );
+      else ieee2ibm( valuesOut, numValues );
+    }
+    else {
+      if( isIBM2IEEE ) ibm2ieee( valuesIn, valuesOut, numValues, doSwapEndian );
+      else ieee2ibm( valuesIn, valuesOut, numValues, doSwapEndian );
+    }
+  }
+  int reportError( char const* text, int level, int detail1, int detail2 ) {
+    fprintf(stderr,"ERROR: %s differs from scalar code at SIMD level %s (%d, %d)\n", text, levelName(level), detail1, detail2);
+    return 1;
+  }
+}
+
+/**
+ * CSEIS SIMD check
+ *
+ * Command line tool comparing the SIMD code paths of the endian swap and IBM/IEEE number conversion methods
+ * against the scalar code (SIMD_LEVEL_NONE), at every SIMD level supported by the CPU:
+ *  - IBM to IEEE and IEEE to IBM conversion of all 2^32 bit patterns, in place and with fused endian swap
+ *  - Endian swap and number conversion of all array sizes up to a few SIMD loop iterations, at all alignments
+ * The tool only depends on geolib_endian.cc and methods_number_conversions.cc.
+ * Use option -quick to only convert every 64th block of bit patterns.
+ *
+ * @return 0 if all SIMD levels give the same result as the scalar code
+ * @author Bjorn Olofsson
+ */
+int main( int argc, char** argv ) {
+  bool isQuick = false;
+  for( int iArg = 1; iArg < argc; iArg++ ) {
+    if( !strcmp( argv[iArg], "-quick" ) ) {
+      isQuick = true;
+    }
+    else {
+      fprintf(stderr," Usage:  %s [-quick]\n", argv[0]);
+      return(-1);
+    }
+  }
+  int const maxLevel = simdLevel();
+  fprintf(stdout,"Highest SIMD level supported by CPU: %s\n", levelName(maxLevel));
+  if( maxLevel == SIMD_LEVEL_NONE ) {
+    fprintf(stdout,"Nothing to check.\n");
+    return 0;
+  }
+  int numErrors = 0;
+
+  //--------------------------------------------------------------------------------
+  // Endian swap, all sizes and alignments
+  //
+  int const bufferSize = ( MAX_SWAP_BYTES > 4*MAX_CONVERT_VALUES ? MAX_SWAP_BYTES : 4*MAX_CONVERT_VALUES ) + MAX_OFFSET;
+  char* input     = new char[bufferSize];
+  char* expected  = new char[bufferSize];
+  char* result    = new char[bufferSize];
+  srand( 1 );
+  for( int i = 0; i < bufferSize; i++ ) {
+    input[i] = (char)rand();
+  }
+  for( int numBytesSwap = 2; numBytesSwap <= 8; numBytesSwap *= 2 ) {
+    for( int size = 0; size <= MAX_SWAP_BYTES; size += numBytesSwap ) {
+      for( int offset = 0; offset < MAX_OFFSET; offset++ ) {
+        setMaxSimdLevel( SIMD_LEVEL_NONE );
+        memcpy( expected, input, bufferSize );
+        swap( numBytesSwap, &expected[offset], size );
+        for( int level = SIMD_LEVEL_SSE2; level <= maxLevel; level++ ) {
+          setMaxSimdLevel( level );
+          memcpy( result, input, bufferSize );
+          swap( numBytesSwap, &result[offset], size );
+          if( memcmp( result, expected, bufferSize ) ) numErrors += reportError( "In-place endian swap", level, numBytesSwap, size );
+          int offsetOut = (offset + 3) % MAX_OFFSET;
+          memcpy( result, input, bufferSize );
+          swap( numBytesSwap, &input[offset], &result[offsetOut], size );
+          if( memcmp( &result[offsetOut], &expected[offset], size ) ) numErrors += reportError( "Endian swap to output array", level, numBytesSwap, size );
+          memcpy( result, input, bufferSize );
+          swapEndian( &result[offset], numBytesSwap, size );
+          if( memcmp( result, expected, bufferSize ) ) numErrors += reportError( "Generic endian swap", level, numBytesSwap, size );
+        }
+      }
+    }
+  }
+  fprintf(stdout,"Endian swap checked, %d errors\n", numErrors);
+
+  //--------------------------------------------------------------------------------
+  // Number conversions, all value counts and alignments
+  //
+  for( int iconv = 0; iconv < 2; iconv++ ) {
+    bool isIBM2IEEE = ( iconv == 0 );
+    for( int numValues = 0; numValues <= MAX_CONVERT_VALUES; numValues++ ) {
+      int size = 4*numValues;
+      for( int offset = 0; offset < 4; offset++ ) {
+        for( int doSwap = 0; doSwap < 2; doSwap++ ) {
+          int offsetOut = doSwap ? (offset + 1) % 4 : offset;
+          setMaxSimdLevel( SIMD_LEVEL_NONE );
+          memcpy( expected, input, bufferSize );
+          convert( isIBM2IEEE, (unsigned char*)&input[offset], (unsigned char*)&expected[offsetOut], numValues, doSwap != 0 );
+          for( int level = SIMD_LEVEL_SSE2; level <= maxLevel; level++ ) {
+            setMaxSimdLevel( level );
+            memcpy( result, input, bufferSize );
+            convert( isIBM2IEEE, doSwap ? (unsigned char*)&input[offset] : (unsigned char*)&result[offset],
+                     (unsigned char*)&result[offsetOut], numValues, doSwap != 0 );
+            if( memcmp( &result[offsetOut], &expected[offsetOut], size ) ) {
+              numErrors += reportError( isIBM2IEEE ? "IBM to IEEE conversion" : "IEEE to IBM conversion", level, numValues, doSwap );
+            }
+          }
+        }
+      }
+    }
+  }
+  delete [] input;
+  delete [] expected;
+  delete [] result;
+  fprintf(stdout,"Number conversion of short arrays checked, %d errors\n", numErrors);
+
+  //--------------------------------------------------------------------------------
+  // Number conversions, all bit patterns
+  //
+  unsigned int* patterns   = new unsigned int[BLOCK_SIZE];
+  unsigned int* expectedIn = new unsigned int[BLOCK_SIZE];
+  unsigned int* expectedSw = new unsigned int[BLOCK_SIZE];
+  unsigned int* resultIn   = new unsigned int[BLOCK_SIZE];
+  unsigned int* resultSw   = new unsigned int[BLOCK_SIZE];
+  int const numBlocks = (int)( (1ULL << 32) / BLOCK_SIZE );
+  for( int iconv = 0; iconv < 2; iconv++ ) {
+    bool isIBM2IEEE = ( iconv == 0 );
+    int numErrorsConv = 0;
+    for( int iblock = 0; iblock < numBlocks; iblock += ( isQuick ? 64 : 1 ) ) {
+      unsigned int firstPattern = (unsigned int)iblock * (unsigned int)BLOCK_SIZE;
+      for( int i = 0; i < BLOCK_SIZE; i++ ) {
+        patterns[i] = firstPattern + (unsigned int)i;
+      }
+      setMaxSimdLevel( SIMD_LEVEL_NONE );
+      memcpy( expectedIn, patterns, BLOCK_SIZE*sizeof(unsigned int) );
+      convert( isIBM2IEEE, (unsigned char*)expectedIn, (unsigned char*)expectedIn, BLOCK_SIZE, false );
+      convert( isIBM2IEEE, (unsigned char*)patterns, (unsigned char*)expectedSw, BLOCK_SIZE, true );
+      for( int level = SIMD_LEVEL_SSE2; level <= maxLevel; level++ ) {
+        setMaxSimdLevel( level );
+        memcpy( resultIn, patterns, BLOCK_SIZE*sizeof(unsigned int) );
+        convert( isIBM2IEEE, (unsigned char*)resultIn, (unsigned char*)resultIn, BLOCK_SIZE, false );
+        convert( isIBM2IEEE, (unsigned char*)patterns, (unsigned char*)resultSw, BLOCK_SIZE, true );
+        for( int i = 0; i < BLOCK_SIZE; i++ ) {
+          if( resultIn[i] != expectedIn[i] || resultSw[i] != expectedSw[i] ) {
+            fprintf(stderr,"ERROR: %s differs from scalar code at SIMD level %s. Input: %08x, expected: %08x, result: %08x\n",
+                    isIBM2IEEE ? "IBM to IEEE conversion" : "IEEE to IBM conversion", levelName(level),
+                    patterns[i], expectedIn[i], resultIn[i]);
+            numErrorsConv += 1;
+            break;
+          }
+        }
+      }
+    }
+    fprintf(stdout,"%s of all bit patterns checked, %d errors\n", isIBM2IEEE ? "IBM to IEEE conversion" : "IEEE to IBM conversion", numErrorsConv);
+    numErrors += numErrorsConv;
+  }
+  delete [] patterns;
+  delete [] expectedIn;
+  delete [] expectedSw;
+  delete [] resultIn;
+  delete [] resultSw;
+
+  setMaxSimdLevel( maxLevel );
+  fprintf(stdout,"%s: %d errors\n", numErrors == 0 ? "SIMD check passed" : "SIMD check FAILED", numErrors);
+  return( numErrors == 0 ? 0 : 1 );
+}
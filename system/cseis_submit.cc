@@ -16,6 +16,8 @@
 #include "csParamDef.h"
 #include "csMemoryPoolManager.h"
 #include "csHelp.h"
+#include "csJobScheduler.h"
+#include "csModuleProfile.h"
 
 // From geolib:
 #include "geolib/csVector.h"
@@ -25,6 +27,7 @@
 #include "geolib/csException.h"
 #include "geolib/csStandardHeaders.h"
 #include "geolib/csGeolibUtils.h"
+#include "geolib/csThread.h"
 
 #include <sys/timeb.h>
 #include <ctime>
@@ -44,6 +47,7 @@ namespace cseis_system {
   extern std::string replaceUserConstants( char const* line, cseis_geolib::csVector<cseis_system::csUserConstant> const* list );
 }
 void check_all_modules_for_bugs();
+std::string jobFilename( std::string const& filename, std::string const& jobName );
 
 /// Error output stream
 int exitOnError( char const* text, ... );
@@ -87,6 +91,22 @@ int main( int argc, char** argv ) {
   //  char* flowOutputDir = NULL;
   char* flowOutputName= NULL;
   int memoryPolicy    = csMemoryPoolManager::POLICY_SPEED;
+  int numThreads      = 1;
+  int numReplicas     = 1;
+  int batchSize       = 1;
+  int maxNumMegabytes = (int)csMemoryPoolManager::MAX_NUM_MEGABYTES;
+  bool isMaxNumMegabytesSet = false;
+  int numJobCPUs      = -1;  // -1: Run flows one after another
+  int numJobMegabytes = 0;
+  int maxNumJobRetries = 0;
+  int numBenchmarkRuns = 0;
+  bool isLogAsync     = false;
+  int logLevel        = csLogWriter::LEVEL_INFO;
+  std::string logLevelName;
+  cseis_geolib::csVector<std::string> userConstArgs;
+  std::string spillDir = "";
+  std::string profileFilename = "";
+  std::string timelineFilename = "";
   cseis_geolib::csCompareVector<csUserConstant> globalConstList;
 
   gl_error_stream = stderr;
@@ -119,7 +139,7 @@ int main( int argc, char** argv ) {
           return(-1);
         }
         fprintf( stderr, " SeaSeis job flow submission tool.\n");
-        fprintf( stderr, " Usage:  %s -f <jobflow> [-o <joblog> | -d <joblog_dir>] [-h] [-m <name>] [-v] [-c] [-std] [-p {speed|memory} ] [-g <const_file>] [-s <spreadsheet>]\n", argv[0] );
+        fprintf( stderr, " Usage:  %s -f <jobflow> [-o <joblog> | -d <joblog_dir>] [-h] [-m <name>] [-v] [-c] [-std] [-p {speed|memory} ] [-t <num_threads>] [-w <num_workers>] [-b <batch_size>] [-M <max_megabytes>] [-spill <scratch_dir>] [-profile <json_file>] [-timeline <json_file>] [-g <const_file>] [-s <spreadsheet>] [-j <num_cpus>] [-jobmem <megabytes>] [-retry <num_retries>] [-bench_startup <num_runs>] [-log_async] [-log_level {debug|info|warning|error}]\n", argv[0] );
         fprintf( stderr, " -f <flow1> <flow2> ... : File name(s) of job flow(s) to run\n");
         fprintf( stderr, " -o [<log>|stdout]      : File name of job log (defaulted to flowname.log if not specified)\n");
         fprintf( stderr, "                        : Use 'stdout' to redirect all log file output to standard output\n");
@@ -136,16 +156,36 @@ int main( int argc, char** argv ) {
         fprintf( stderr, "                        : If <name> = .: Print short help for all available modules.\n");
         fprintf( stderr, " -run_master            : Immediately run all flows created from master flow(s)\n");
         fprintf( stderr, "                        : If not specified, the program will exit after the master flows have been created.\n");
+        fprintf( stderr, " -j <num_cpus>          : Run flows concurrently, each in its own process, using up to <num_cpus> CPUs in total. Use 0 for all CPUs.\n");
+        fprintf( stderr, "                        : Each flow uses as many CPUs as threads (option -t and -w). A summary table is printed when all flows have finished.\n");
+        fprintf( stderr, " -jobmem <megabytes>    : Memory available to all concurrent flows (option -j). Each flow reserves its maximum memory (option -M).\n");
+        fprintf( stderr, "                        : If option -M is not given, the memory is divided evenly between the flows that can run at the same time.\n");
+        fprintf( stderr, " -retry <num_retries>   : Run flows that failed again, up to <num_retries> times (option -j). Default: 0\n");
         fprintf( stderr, " -h                     : Print this page\n");
         fprintf( stderr, " -html                  : Print full help for all modules & standard trace headers in HTML.\n");
         fprintf( stderr, " -v                     : Print out version info\n");
         fprintf( stderr, " -std                   : Dump all standard trace headers\n");
         fprintf( stderr, " -c                     : Check for link problems and consistency of all modules' params(=help) methods.\n");
         fprintf( stderr, " -p [speed | memory]    : Set memory policy: Optimised for speed or memory.\n");
+        fprintf( stderr, " -t <num_threads>       : Run exec phase in pipeline mode, modules run in up to <num_threads> parallel threads.\n");
+        fprintf( stderr, "                        : Use 0 for one thread per module. Default: 1 (all modules run in one thread, deterministic)\n");
+        fprintf( stderr, " -w <num_workers>       : Run thread-safe single-trace and ensemble modules in <num_workers> parallel threads each (pipeline mode). Default: 1\n");
+        fprintf( stderr, " -b <batch_size>        : Hand traces from module to module in blocks of up to <batch_size> traces (serial mode). Default: 1\n");
+        fprintf( stderr, " -M <max_megabytes>     : Maximum memory held by traces, in megabytes. Default: %d\n", (int)csMemoryPoolManager::MAX_NUM_MEGABYTES);
+        fprintf( stderr, " -spill <scratch_dir>   : When the maximum memory is exceeded, spill traces buffered by modules to a scratch file in <scratch_dir>\n");
+        fprintf( stderr, "                        : instead of aborting the job. Spilled traces are read back in when needed.\n");
+        fprintf( stderr, " -profile <json_file>   : Write exec phase profile of all modules to <json_file>, in JSON format. The profile is always written to the log.\n");
+        fprintf( stderr, " -timeline <json_file>  : Write timeline of exec phase to <json_file>, in Chrome trace event format (view in chrome://tracing or ui.perfetto.dev).\n");
         fprintf( stderr, " -no_run                : Do not run flow. This option is useful if an individual flow file is generated using option -ff\n");
         fprintf( stderr, " -init_only             : Run init phase only.\n");
+        fprintf( stderr, " -bench_startup <num_runs> : Run init phase of flow <num_runs> times in a row, and print the time taken by each run.\n");
+        fprintf( stderr, "                        : The first run includes loading the module libraries, later runs use the cached modules.\n");
         fprintf( stderr, " -no_verbose            : Do not output information messages.\n");
+        fprintf( stderr, " -log_async             : Write job log from a background thread. Modules log into per-thread buffers without locking.\n");
+        fprintf( stderr, "                        : Buffered messages are written out at least every 100ms, on errors and at exit.\n");
+        fprintf( stderr, " -log_level <level>     : Only write log messages of given or higher severity: debug, info, warning or error. Default: info\n");
         fprintf( stderr, " -debug                 : Output extensive DEBUG information for trace flow preparation and execution.\n");
+        fprintf( stderr, "                        : Implies -log_level debug, unless another log level is given.\n");
         return(-1);
       }
       else if ( option == 'v' ) {
@@ -194,12 +234,26 @@ int main( int argc, char** argv ) {
             fprintf(stderr,"Error in command line option -D %s...", text.c_str());
           }
           globalConstList.insertEnd( csUserConstant(text.substr(0,pos),text.substr(pos+1)) );
+          userConstArgs.insertEnd( text );
           isUserConstant = true;
 
           //                                      userConstNames.insertEnd();
           //      userConstValues.insertEnd(text.substr(pos+1));
         }
       }
+      else if ( option == 'r' && !strcmp( argv[iArg], "-retry" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -retry\n");
+        }
+        char* endPtr = NULL;
+        maxNumJobRetries = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || maxNumJobRetries < 0 ) {
+          fprintf(stderr,"Invalid number of retries: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
       else if ( option == 'r' ) {
         if( !strcmp( argv[iArg], "-run_master" ) ) {
           isRunMaster = true;
@@ -231,6 +285,13 @@ int main( int argc, char** argv ) {
           //          dump_all_standard_headers();
           return(-1);
         }
+        else if( !strcmp( argv[iArg], "-spill" ) ) {
+          iArg++;
+          if( iArg == argc ) {
+            return exitOnError("Missing argument for option -spill\n");
+          }
+          spillDir = argv[iArg];
+        }
         else {
           iArg++;
           if( iArg == argc ) {
@@ -267,6 +328,34 @@ int main( int argc, char** argv ) {
         }
         ++iArg;
       }
+      else if ( option == 'l' && !strcmp( argv[iArg], "-log_async" ) ) {
+        isLogAsync = true;
+        ++iArg;
+      }
+      else if ( option == 'l' && !strcmp( argv[iArg], "-log_level" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -log_level\n");
+        }
+        logLevelName = argv[iArg];
+        if( !logLevelName.compare("debug") ) {
+          logLevel = csLogWriter::LEVEL_DEBUG;
+        }
+        else if( !logLevelName.compare("info") ) {
+          logLevel = csLogWriter::LEVEL_INFO;
+        }
+        else if( !logLevelName.compare("warning") ) {
+          logLevel = csLogWriter::LEVEL_WARNING;
+        }
+        else if( !logLevelName.compare("error") ) {
+          logLevel = csLogWriter::LEVEL_ERROR;
+        }
+        else {
+          fprintf(stderr,"Unknown log level: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
       else if ( option == 'i' ) {
         if( !strcmp( argv[iArg], "-init_only" ) ) {
           isRunExec = false;
@@ -295,6 +384,14 @@ int main( int argc, char** argv ) {
         //cseis_help( moduleName );
         return(-1);
       }
+      else if ( option == 'p' && !strcmp( argv[iArg], "-profile" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -profile\n");
+        }
+        profileFilename = argv[iArg];
+        ++iArg;
+      }
       else if ( option == 'p' ) {
         ++iArg;
         if( iArg == argc ) {
@@ -328,6 +425,107 @@ int main( int argc, char** argv ) {
         }
         ++iArg;
       }
+      else if ( option == 't' && !strcmp( argv[iArg], "-timeline" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -timeline\n");
+        }
+        timelineFilename = argv[iArg];
+        ++iArg;
+      }
+      else if ( option == 't' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        char* endPtr = NULL;
+        numThreads = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || numThreads < 0 ) {
+          fprintf(stderr,"Invalid number of threads: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
+      else if ( option == 'w' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        char* endPtr = NULL;
+        numReplicas = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || numReplicas < 1 ) {
+          fprintf(stderr,"Invalid number of worker threads: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
+      else if ( option == 'b' && !strcmp( argv[iArg], "-bench_startup" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -bench_startup\n");
+        }
+        char* endPtr = NULL;
+        numBenchmarkRuns = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || numBenchmarkRuns < 1 ) {
+          fprintf(stderr,"Invalid number of runs: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
+      else if ( option == 'b' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        char* endPtr = NULL;
+        batchSize = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || batchSize < 1 ) {
+          fprintf(stderr,"Invalid batch size: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
+      else if ( option == 'M' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        char* endPtr = NULL;
+        maxNumMegabytes = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || maxNumMegabytes < 1 ) {
+          fprintf(stderr,"Invalid maximum memory: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        isMaxNumMegabytesSet = true;
+        ++iArg;
+      }
+      else if ( option == 'j' && !strcmp( argv[iArg], "-jobmem" ) ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -jobmem\n");
+        }
+        char* endPtr = NULL;
+        numJobMegabytes = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || numJobMegabytes < 1 ) {
+          fprintf(stderr,"Invalid job memory: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        ++iArg;
+      }
+      else if ( option == 'j' ) {
+        ++iArg;
+        if( iArg == argc ) {
+          return exitOnError("Missing argument for option -%c\n", option);
+        }
+        char* endPtr = NULL;
+        numJobCPUs = (int)strtol( argv[iArg], &endPtr, 10 );
+        if( endPtr == argv[iArg] || *endPtr != '\0' || numJobCPUs < 0 ) {
+          fprintf(stderr,"Invalid number of CPUs: '%s'\n", argv[iArg] );
+          return(-1);
+        }
+        if( numJobCPUs == 0 ) numJobCPUs = cseis_geolib::csThread::numProcessors();
+        ++iArg;
+      }
       else if ( option == 'c' ) {
         check_all_modules_for_bugs();
         return(-1);
@@ -435,6 +633,128 @@ int main( int argc, char** argv ) {
     fclose( f_globalConst );
   }
 
+//---------------------------------------------------------------------------------
+// Run flows concurrently, each in its own process
+//
+  if( numJobCPUs > 0 ) {
+    if( isLogStdout ) {
+      return exitOnError("Option -o stdout cannot be used when running flows concurrently (option -j)\n");
+    }
+    int numCPUsPerJob = ( numThreads == 0 ) ? numJobCPUs : numThreads;
+    if( numReplicas > 1 ) numCPUsPerJob += numReplicas-1;
+    if( numCPUsPerJob > numJobCPUs ) numCPUsPerJob = numJobCPUs;
+    int numMegabytesPerJob = 0;
+    if( isMaxNumMegabytesSet ) {
+      numMegabytesPerJob = maxNumMegabytes;
+    }
+    else if( numJobMegabytes > 0 ) {
+      numMegabytesPerJob = numJobMegabytes / ( numJobCPUs / numCPUsPerJob );
+      if( numMegabytesPerJob < 1 ) numMegabytesPerJob = 1;
+    }
+    // Flows created from a master flow are only known at this point: Each flow needs its own log
+    if( filenameList.size() > 1 && filenameLog != NULL ) {
+      fprintf(stderr,"Warning: When running more than one flow concurrently, the option -o cannot be used.\n");
+      fprintf(stderr,"         The specified name of the output log file will be ignored.\n");
+      delete [] filenameLog;
+      filenameLog = NULL;
+    }
+    csJobScheduler scheduler( numJobCPUs, numJobMegabytes, maxNumJobRetries );
+    for( int i = 0; i < filenameList.size(); i++ ) {
+      std::string flowName = filenameList.at(i);
+      int counter = flowName.length()-1;
+      while( counter >= 0 && flowName[counter] != FORWARD_SLASH && flowName[counter] != BACK_SLASH ) counter--;
+      std::string jobName = flowName.substr( counter+1, flowName.length()-counter-6 );
+      std::string logName;
+      if( filenameLog != NULL ) {
+        logName = ( dirLog != NULL ) ? std::string(dirLog) + filenameLog : std::string(filenameLog);
+      }
+      else if( dirLog != NULL ) {
+        // Same log name as when running flows one after the other
+        logName = std::string(dirLog) + jobName;
+        if( isUserConstant ) logName += "_" + globalConstList.at(0).value;
+        logName += ".log";
+      }
+      else {
+        logName = flowName.substr( 0, flowName.length()-5 ) + ".log";
+      }
+      cseis_geolib::csVector<std::string> args;
+      char text[32];
+      args.insertEnd( argv[0] );
+      args.insertEnd( "-f" );
+      args.insertEnd( flowName );
+      args.insertEnd( "-o" );
+      args.insertEnd( logName );
+      args.insertEnd( "-no_verbose" );
+      if( memoryPolicy == csMemoryPoolManager::POLICY_MEMORY ) {
+        args.insertEnd( "-p" );
+        args.insertEnd( "memory" );
+      }
+      sprintf( text, "%d", numThreads );
+      args.insertEnd( "-t" );
+      args.insertEnd( text );
+      sprintf( text, "%d", numReplicas );
+      args.insertEnd( "-w" );
+      args.insertEnd( text );
+      sprintf( text, "%d", batchSize );
+      args.insertEnd( "-b" );
+      args.insertEnd( text );
+      if( numMegabytesPerJob > 0 ) {
+        sprintf( text, "%d", numMegabytesPerJob );
+        args.insertEnd( "-M" );
+        args.insertEnd( text );
+      }
+      if( !spillDir.empty() ) {
+        args.insertEnd( "-spill" );
+        args.insertEnd( spillDir );
+      }
+      if( !profileFilename.empty() ) {
+        args.insertEnd( "-profile" );
+        args.insertEnd( jobFilename( profileFilename, jobName ) );
+      }
+      if( !timelineFilename.empty() ) {
+        args.insertEnd( "-timeline" );
+        args.insertEnd( jobFilename( timelineFilename, jobName ) );
+      }
+      if( isGlobalConst ) {
+        args.insertEnd( "-g" );
+        args.insertEnd( filenameGlobalConst );
+      }
+      if( isDebug ) args.insertEnd( "-debug" );
+      if( isLogAsync ) args.insertEnd( "-log_async" );
+      if( !logLevelName.empty() ) {
+        args.insertEnd( "-log_level" );
+        args.insertEnd( logLevelName );
+      }
+      if( !isRunExec ) args.insertEnd( "-init_only" );
+      // User constants must come last
+      if( userConstArgs.size() > 0 ) {
+        args.insertEnd( "-D" );
+        for( int iconst = 0; iconst < userConstArgs.size(); iconst++ ) {
+          args.insertEnd( userConstArgs.at(iconst) );
+        }
+      }
+      scheduler.addJob( jobName, args, logName, numCPUsPerJob, numMegabytesPerJob );
+    }
+    if( isVerbose ) {
+      fprintf(stderr,"Run %d flows concurrently, using up to %d CPUs (%d per flow)", scheduler.numJobs(), numJobCPUs, numCPUsPerJob);
+      if( numJobMegabytes > 0 ) fprintf(stderr," and %d MB (%d per flow)", numJobMegabytes, numMegabytesPerJob);
+      fprintf(stderr,"\n");
+    }
+    int numFailed = 0;
+    try {
+      numFailed = scheduler.run( stderr );
+    }
+    catch( cseis_geolib::csException& exc ) {
+      return exitOnError("%s\n", exc.getMessage());
+    }
+    scheduler.dumpSummary( stderr );
+    if( dirLog ) {
+      delete [] dirLog;
+      dirLog = NULL;
+    }
+    return( numFailed == 0 ? 0 : 1 );
+  }
+
 //---------------------------------------------------------------------------------
 // Run flow(s)
 //
@@ -519,10 +839,28 @@ int main( int argc, char** argv ) {
       fprintf(stderr,"Could not open output log file '%s'\n", filenameLog );
       return -1;
     }
+    // Option -debug also writes debug messages to the log, unless a log level was given explicitly
+    f_log->setLevel( ( isDebug && logLevelName.empty() ) ? csLogWriter::LEVEL_DEBUG : logLevel );
+    if( isLogAsync && !f_log->setAsynchronous( true ) ) {
+      fprintf(stderr,"Could not start log writer thread, writing log synchronously\n" );
+    }
 
     //--------------------------------------------------------------------------------
     try {
       csRunManager runManager( f_log, memoryPolicy, isDebug );
+      runManager.setNumThreads( numThreads );
+      runManager.setNumReplicas( numReplicas );
+      runManager.setBatchSize( batchSize );
+      runManager.setMaxNumMegabytes( maxNumMegabytes );
+      if( !spillDir.empty() ) {
+        runManager.setSpillDirectory( spillDir );
+      }
+      if( !profileFilename.empty() ) {
+        runManager.setProfileFilename( profileFilename );
+      }
+      if( !timelineFilename.empty() ) {
+        runManager.setTimelineFilename( timelineFilename );
+      }
       if( isOutputFlow ) {
         FILE* f_flow_in;
         FILE* f_flow_out;
@@ -538,7 +876,31 @@ int main( int argc, char** argv ) {
         fclose(f_flow_out);
         fclose(f_flow_in);
       }
-      if( isRunFlow ) {
+      if( isRunFlow && numBenchmarkRuns > 0 ) {
+        // Startup benchmark: Time init phase of repeated runs of the same flow. Only the first run opens the module libraries.
+        double timeFirst = 0.0;
+        double timeSum   = 0.0;
+        for( int irun = 0; irun < numBenchmarkRuns && returnFlag == 0; irun++ ) {
+          rewind( f_flow );
+          double timeStart = csModuleProfile::wallTime();
+          csRunManager benchManager( f_log, memoryPolicy, isDebug );
+          returnFlag = benchManager.runInitPhase( filenameFlow, f_flow, &globalConstList );
+          double timeRun = csModuleProfile::wallTime() - timeStart;
+          fprintf(stderr,"Startup run %4d: %10.3f ms\n", irun+1, timeRun*1000.0);
+          if( irun == 0 ) timeFirst = timeRun;
+          else timeSum += timeRun;
+        }
+        int numLibraries = 0;
+        int numSymbols   = 0;
+        int numCacheHits = 0;
+        double timeResolve = 0.0;
+        csMethodRetriever::getStatistics( numLibraries, numSymbols, numCacheHits, timeResolve );
+        fprintf(stderr,"Startup benchmark: First run %.3f ms", timeFirst*1000.0);
+        if( numBenchmarkRuns > 1 ) fprintf(stderr,", mean of later runs %.3f ms", timeSum*1000.0/(double)(numBenchmarkRuns-1));
+        fprintf(stderr,"\nModule resolution: %d libraries opened, %d methods looked up, %d requests served from cache, %.3f ms\n",
+                numLibraries, numSymbols, numCacheHits, timeResolve*1000.0);
+      }
+      else if( isRunFlow ) {
         returnFlag = runManager.runInitPhase( filenameFlow, f_flow, &globalConstList );
         if( returnFlag == 0 && isRunExec ) {
           returnFlag = runManager.runExecPhase();    
@@ -587,6 +949,16 @@ int exitOnError( char const* text, ... ) {
   return(-1);
 }
 
+/// Insert job name in front of file name extension, so that concurrent jobs write to different files
+std::string jobFilename( std::string const& filename, std::string const& jobName ) {
+  int posDot   = (int)filename.find_last_of( '.' );
+  int posSlash = (int)filename.find_last_of( "/\\" );
+  if( posDot == (int)std::string::npos || posDot < posSlash ) {
+    return( filename + "_" + jobName );
+  }
+  return( filename.substr( 0, posDot ) + "_" + jobName + filename.substr( posDot ) );
+}
+
 void check_all_modules_for_bugs() {
   /*
   FILE* fin = fopen( filename, "r" );